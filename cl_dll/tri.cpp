@@ -293,10 +293,8 @@ void CL_DLLEXPORT HUD_DrawTransparentTriangles( void )
 
 		gEngfuncs.pTriAPI->SpriteTexture(WhiteSpriteModel, 0);
 
-		for (const auto& trigitr : triggers)
+		for (const auto& trig : triggers)
 		{
-			const auto& trig = trigitr.second;
-
 			auto corner1 = VectorFromArray(trig.Corner1);
 			auto corner2 = VectorFromArray(trig.Corner2);
 
@@ -348,10 +346,8 @@ void CL_DLLEXPORT HUD_DrawTransparentTriangles( void )
 		gEngfuncs.pTriAPI->RenderMode(kRenderNormal);
 		gEngfuncs.pTriAPI->Color4f(1, 0, 0, 1);
 
-		for (const auto& camitr : cameras)
+		for (const auto& cam : cameras)
 		{
-			const auto& cam = camitr.second;
-
 			/*
 				Don't render cams that are in the primary view.
 			*/
@@ -470,10 +466,8 @@ void HUD_DrawOrthoTriangles()
 	{
 		const auto& cameras = Cam::GetAllCameras();
 
-		for (auto& camitr : cameras)
+		for (auto& cam : cameras)
 		{
-			auto& cam = camitr.second;
-
 			if (cam.InPreview)
 			{
 				continue;
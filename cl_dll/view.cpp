@@ -481,6 +481,14 @@ typedef struct
 	int CurrentAngle;
 } viewinterp_t;
 
+/*
+	CRASH FORT:
+*/
+namespace Cam
+{
+	void OnCalcRefdef(ref_params_s* params);
+}
+
 /*
 ==================
 V_CalcRefdef
@@ -827,6 +835,11 @@ void V_CalcNormalRefdef ( struct ref_params_s *pparams )
 		}
 	}
 
+	/*
+		CRASH FORT:
+	*/
+	Cam::OnCalcRefdef(pparams);
+
 	lasttime = pparams->time;
 
 	v_origin = pparams->vieworg;
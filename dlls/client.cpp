@@ -135,6 +135,16 @@ void ClientDisconnect( edict_t *pEntity )
 	UTIL_SetOrigin ( &pEntity->v, pEntity->v.origin );
 
 	g_pGameRules->ClientDisconnected( pEntity );
+
+	/*
+		CRASH FORT:
+	*/
+	CBasePlayer *pPlayer = (CBasePlayer *)GET_PRIVATE(pEntity);
+
+	if (pPlayer)
+	{
+		Cam::OnPlayerDisconnect(pPlayer);
+	}
 }
 
 
@@ -849,6 +859,11 @@ void StartFrame( void )
 
 	gpGlobals->teamplay = teamplay.value;
 	g_ulFrameCount++;
+
+	/*
+		CRASH FORT:
+	*/
+	Cam::OnServerFrame();
 }
 
 void ClientPrecache( void )
@@ -207,6 +207,7 @@ void LinkUserMessages( void )
 
 	HLCamMessage::CreateCamera = REG_USER_MSG("CamCreate", -1);
 	HLCamMessage::CreateTrigger = REG_USER_MSG("TrgCreate", -1);
+	HLCamMessage::MapSync = REG_USER_MSG("CamSync", -1);
 	
 	HLCamMessage::RemoveCamera = REG_USER_MSG("CamRem", 2);
 	HLCamMessage::RemoveTrigger = REG_USER_MSG("TrgRem", 2);
@@ -223,7 +224,7 @@ void LinkUserMessages( void )
 	HLCamMessage::CameraAdjust = REG_USER_MSG("CamCA", -1);
 	HLCamMessage::CameraPreview = REG_USER_MSG("CamPW", 3);
 
-	HLCamMessage::CameraSwitch = REG_USER_MSG("CamSwitch", 6);
+	HLCamMessage::CameraSwitch = REG_USER_MSG("CamSwitch", 8);
 
 	HLCamMessage::EnemyPing_TargetSwitched = REG_USER_MSG("CamEnPng", -1);
 
@@ -3136,6 +3137,7 @@ int CBasePlayer::Restore( CRestore &restore )
 		CRASH FORT:
 	*/
 	Cam::RestoreData camrestore;
+	camrestore.PlayerIndex = entindex();
 	camrestore.TriggerID = LastTriggerID;
 	Cam::Restore(camrestore);
 
@@ -2140,26 +2140,10 @@ void CTriggerChangeTarget::Use( CBaseEntity *pActivator, CBaseEntity *pCaller, U
 */
 #include "triggers.h"
 #include "HLCam Server\Server.hpp"
+#include "Shared\Math\Easing.hpp"
 
 LINK_ENTITY_TO_CLASS(trigger_camera, CTriggerCamera);
 
-namespace
-{
-	namespace Interpolate
-	{
-		float Linear(float start, float end, float time)
-		{
-			return (1.0f - time) * start + time * end;
-		}
-
-		float Smooth(float start, float end, float time)
-		{
-			float time2 = (1.0f - std::cos(time * M_PI)) / 2.0f;
-			return (start * (1.0f - time2) + end * time2);
-		}
-	}
-}
-
 void CTriggerCamera::Spawn(void)
 {
 	pev->movetype = MOVETYPE_NOCLIP;
@@ -2208,7 +2192,7 @@ void CTriggerCamera::Use(CBaseEntity* activator, CBaseEntity* caller, USE_TYPE u
 		!Cam::IsInEditMode() &&
 		usetype == USE_ON)
 	{
-		Cam::NamedCameraActivate(HLCam.ID);
+		Cam::NamedCameraActivate(HLCam.ID, activator);
 	}
 
 	/*
@@ -2221,6 +2205,12 @@ void CTriggerCamera::Use(CBaseEntity* activator, CBaseEntity* caller, USE_TYPE u
 	{
 		SetThink(nullptr);
 
+		/*
+			Would otherwise keep drifting when used again.
+		*/
+		pev->velocity = g_vecZero;
+		pev->avelocity = g_vecZero;
+
 		/*
 			Full restore.
 		*/
@@ -2247,11 +2237,6 @@ void CTriggerCamera::Use(CBaseEntity* activator, CBaseEntity* caller, USE_TYPE u
 
 	PlayerHandle = activator;
 
-	/*
-		Skip worldspawn and all players.
-	*/
-	const auto startedict = g_engfuncs.pfnPEntityOfEntIndex(32);
-
 	switch (HLCam.LookType)
 	{
 		case Cam::Shared::CameraLookType::AtPlayer:
@@ -2268,11 +2253,11 @@ void CTriggerCamera::Use(CBaseEntity* activator, CBaseEntity* caller, USE_TYPE u
 
 		case Cam::Shared::CameraLookType::AtTarget:
 		{
-			edict_t* targetedict = FIND_ENTITY_BY_TARGETNAME(startedict, HLCam.LookTargetData.Name.c_str());
+			auto target = Cam::FindTargetEntity(HLCam.LookTargetData.Name);
 
-			if (targetedict)
+			if (target)
 			{
-				TargetHandle = CBaseEntity::Instance(targetedict);
+				TargetHandle = target;
 			}
 
 			else
@@ -2287,11 +2272,11 @@ void CTriggerCamera::Use(CBaseEntity* activator, CBaseEntity* caller, USE_TYPE u
 
 	if (HLCam.UseAttachment)
 	{
-		edict_t* targetedict = FIND_ENTITY_BY_TARGETNAME(startedict, HLCam.AttachmentData.Name.c_str());
+		auto target = Cam::FindTargetEntity(HLCam.AttachmentData.Name);
 
-		if (targetedict)
+		if (target)
 		{
-			AttachmentEntity = CBaseEntity::Instance(targetedict);
+			AttachmentEntity = target;
 		}
 
 		else
@@ -2328,32 +2313,23 @@ void CTriggerCamera::Use(CBaseEntity* activator, CBaseEntity* caller, USE_TYPE u
 	SetPlayerFOV(HLCam.FOV);
 }
 
+/*
+	Only thinks while there is something to update. Zooms are stepped every frame,
+	tracking and attachments at the track rate with the engine carrying the
+	camera along its velocities in between. Fixed cameras stop thinking.
+*/
 void CTriggerCamera::CameraThink()
 {
-	if (HLCam.LookType == Cam::Shared::CameraLookType::AtAngle)
-	{
-		ZoomAddon();
-		
-		pev->nextthink = gpGlobals->time;
-		return;
-	}
+	const auto interval = Cam::GetCameraTrackInterval();
 
-	if (HLCam.LookType == Cam::Shared::CameraLookType::AtPlayer ||
-		HLCam.LookType == Cam::Shared::CameraLookType::AtTarget)
-	{
-		if (TargetHandle == nullptr)
-		{
-			g_engfuncs.pfnAlertMessage(at_console, "CTriggerCamera::CameraThink with invalid TargetHandle\n");
-			SetThink(nullptr);
-			return;
-		}
-	}
+	bool needstracking = false;
 
 	if (HLCam.UseAttachment)
 	{
 		if (AttachmentEntity == nullptr)
 		{
 			g_engfuncs.pfnAlertMessage(at_console, "CTriggerCamera::CameraThink with invalid AttachmentEntity\n");
+			pev->velocity = g_vecZero;
 		}
 
 		else
@@ -2362,10 +2338,55 @@ void CTriggerCamera::CameraThink()
 			pev->origin.x += HLCam.AttachmentData.Offset.x;
 			pev->origin.y += HLCam.AttachmentData.Offset.y;
 			pev->origin.z += HLCam.AttachmentData.Offset.z;
+
+			pev->velocity = AttachmentEntity->pev->velocity;
+
+			needstracking = true;
 		}
 	}
 
-	Vector goalvec = UTIL_VecToAngles(TargetHandle->pev->origin - pev->origin);
+	if (HLCam.LookType == Cam::Shared::CameraLookType::AtPlayer ||
+		HLCam.LookType == Cam::Shared::CameraLookType::AtTarget)
+	{
+		if (TargetHandle == nullptr)
+		{
+			g_engfuncs.pfnAlertMessage(at_console, "CTriggerCamera::CameraThink with invalid TargetHandle\n");
+			SetThink(nullptr);
+			return;
+		}
+
+		TrackTarget(interval);
+		needstracking = true;
+	}
+
+	ZoomAddon();
+
+	if (IsZooming())
+	{
+		pev->nextthink = gpGlobals->time;
+	}
+
+	else if (needstracking)
+	{
+		pev->nextthink = gpGlobals->time + interval;
+	}
+
+	else
+	{
+		SetThink(nullptr);
+	}
+}
+
+/*
+	Turns toward where the target will be at the next think, the engine
+	keeps turning at the set speed until then.
+*/
+void CTriggerCamera::TrackTarget(float interval)
+{
+	auto targetpos = TargetHandle->pev->origin + TargetHandle->pev->velocity * interval;
+	auto viewpos = pev->origin + pev->velocity * interval;
+
+	Vector goalvec = UTIL_VecToAngles(targetpos - viewpos);
 	goalvec.x = -goalvec.x;
 
 	if (pev->angles.y > 360)
@@ -2403,6 +2424,15 @@ void CTriggerCamera::CameraThink()
 
 	float endspeed = HLCam.MaxSpeed / 100.0f;
 
+	/*
+		Any faster and the camera turns past the goal before the
+		next think corrects it, which shows as shaking.
+	*/
+	if (endspeed > 1.0f / interval)
+	{
+		endspeed = 1.0f / interval;
+	}
+
 	if (HLCam.PlaneType == Cam::Shared::CameraPlaneType::Both)
 	{
 		pev->avelocity.x = dirx * endspeed;
@@ -2420,10 +2450,11 @@ void CTriggerCamera::CameraThink()
 		pev->avelocity.x = 0;
 		pev->avelocity.y = diry * endspeed;
 	}
+}
 
-	ZoomAddon();
-
-	pev->nextthink = gpGlobals->time;
+bool CTriggerCamera::IsZooming() const
+{
+	return HLCam.ZoomType != Cam::Shared::CameraZoomType::None && !ReachedEndZoom;
 }
 
 void CTriggerCamera::ZoomAddon()
@@ -2436,15 +2467,7 @@ void CTriggerCamera::ZoomAddon()
 		if (HLCam.ZoomType == Cam::Shared::CameraZoomType::ZoomIn ||
 			HLCam.ZoomType == Cam::Shared::CameraZoomType::ZoomOut)
 		{
-			if (HLCam.ZoomData.InterpMethod == Cam::Shared::CameraAngleType::Linear)
-			{
-				CurrentZoomFOV = Interpolate::Linear(HLCam.FOV, HLCam.ZoomData.EndFov, ratio);
-			}
-
-			else if (HLCam.ZoomData.InterpMethod == Cam::Shared::CameraAngleType::Smooth)
-			{
-				CurrentZoomFOV = Interpolate::Smooth(HLCam.FOV, HLCam.ZoomData.EndFov, ratio);
-			}
+			CurrentZoomFOV = Utility::Easing::Interpolate(HLCam.ZoomData.InterpMethod, HLCam.FOV, HLCam.ZoomData.EndFov, ratio);
 		}
 
 		if (ratio > 1.0f)
@@ -13,7 +13,9 @@ public:
 	
 	void EXPORT CameraThink();
 	
+	void TrackTarget(float interval);
 	void ZoomAddon();
+	bool IsZooming() const;
 	
 	virtual int	ObjectCaps() override
 	{
@@ -0,0 +1,390 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <cstdlib>
+#include "boost/interprocess/ipc/message_queue.hpp"
+#include "Shared/Interprocess/Interprocess.hpp"
+#include "Shared/Map/MapBatch.hpp"
+#include "Shared/Shared.hpp"
+
+/*
+	Makes camera edits from a script in the game being edited. They go
+	as one batch, which the game makes whole in one frame or rejects.
+
+	HLCamBatch [options] [script]
+
+	Reads standard input without a script. One edit per line,
+	the value is the rest of the line:
+
+		<camera ID> <field> <value>
+
+		12 FOV 70
+		12 LookType At target
+		12 LookTargetName boss_door
+		40 AttachmentOffset 0 0 16
+
+	Fields are named as in map files. Empty lines and lines
+	starting with # are skipped. Exits with 1 if the batch
+	was not made.
+
+	-check				Only reads the script, nothing is sent
+	-timeout <seconds>	How long to wait for the game, 5 by default
+*/
+namespace
+{
+	struct Settings
+	{
+		std::string ScriptPath;
+
+		bool CheckOnly = false;
+		double Timeout = 5;
+	};
+
+	/*
+		Edits as they are sent, with the line each came from.
+	*/
+	struct Script
+	{
+		std::string Source;
+
+		Utility::BinaryBuffer Edits;
+		std::vector<size_t> Lines;
+	};
+
+	std::string Trim(const std::string& text)
+	{
+		auto start = text.find_first_not_of(" \t\r");
+
+		if (start == std::string::npos)
+		{
+			return {};
+		}
+
+		auto end = text.find_last_not_of(" \t\r");
+
+		return text.substr(start, end - start + 1);
+	}
+
+	/*
+		Goes through the whole script so every error
+		is reported at once.
+	*/
+	bool ReadScript(std::istream& input, Script& script)
+	{
+		auto ret = true;
+
+		std::string line;
+		size_t linenumber = 0;
+
+		while (std::getline(input, line))
+		{
+			linenumber++;
+			line = Trim(line);
+
+			if (line.empty() || line[0] == '#')
+			{
+				continue;
+			}
+
+			std::istringstream stream(line);
+
+			std::string idtext;
+			std::string field;
+
+			stream >> idtext >> field;
+
+			std::string value;
+			std::getline(stream, value);
+
+			std::string error;
+
+			if (idtext.find_first_not_of("0123456789") != std::string::npos || field.empty())
+			{
+				error = "Expected <camera ID> <field> <value>";
+			}
+
+			else
+			{
+				auto cameraid = static_cast<uint32_t>(std::strtoul(idtext.c_str(), nullptr, 10));
+
+				if (Cam::Shared::MapBatch::WriteEdit(script.Edits, cameraid, field, Trim(value), error))
+				{
+					script.Lines.push_back(linenumber);
+					continue;
+				}
+			}
+
+			std::cout << script.Source << "(" << linenumber << "): " << error << std::endl;
+			ret = false;
+		}
+
+		return ret;
+	}
+
+	double GetElapsedMilliseconds(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	/*
+		Made for the batch with "batchid" as its name. One of the same name
+		was left behind by a script that did not finish, it is made again.
+	*/
+	bool StartResultServer(Shared::Interprocess::Server& server, uint32_t batchid)
+	{
+		namespace Interprocess = Shared::Interprocess;
+
+		auto name = Cam::Shared::MapBatch::GetResultConnectionName(batchid);
+
+		for (size_t i = 0; i < 2; i++)
+		{
+			try
+			{
+				server.Start(name, Interprocess::Config::TransportType::MessageQueue);
+				return true;
+			}
+
+			catch (const boost::interprocess::interprocess_exception& error)
+			{
+				server.Stop();
+
+				if (i != 0 || error.get_error_code() != boost::interprocess::error_code_t::already_exists_error)
+				{
+					std::cout << "Could not make a connection for the result: \"" << error.what() << "\"" << std::endl;
+					return false;
+				}
+			}
+		}
+
+		return false;
+	}
+
+	int SendScript(const Script& script, const Settings& settings)
+	{
+		namespace Interprocess = Shared::Interprocess;
+		namespace MapBatch = Cam::Shared::MapBatch;
+
+		/*
+			Names the connection the result comes back on, and is repeated in it.
+		*/
+		auto batchid = static_cast<uint32_t>(std::chrono::system_clock::now().time_since_epoch().count());
+
+		/*
+			The game's connection is a message queue, which takes
+			no message larger than this however long it is waited on.
+		*/
+		auto size = sizeof(batchid) + script.Edits.GetSize();
+		auto maxsize = Interprocess::Config::MaxMessageSize - sizeof(Interprocess::Config::MessageType);
+
+		if (size > maxsize)
+		{
+			std::cout << "Batch of " << size << " bytes is larger than the " << maxsize << " the game takes at once, split the script" << std::endl;
+			return 1;
+		}
+
+		Interprocess::Client batchclient;
+
+		try
+		{
+			batchclient.Connect(MapBatch::ScriptConnectionName);
+		}
+
+		catch (const boost::interprocess::interprocess_exception& error)
+		{
+			std::cout << "Could not connect to the game, it has to be in edit mode: \"" << error.what() << "\"" << std::endl;
+			return 1;
+		}
+
+		Interprocess::Server resultserver;
+
+		if (!StartResultServer(resultserver, batchid))
+		{
+			return 1;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		auto deadline = start + std::chrono::milliseconds(static_cast<int64_t>(settings.Timeout * 1000));
+
+		auto sent = false;
+
+		/*
+			The game empties a full connection every time it looks for messages.
+		*/
+		while (!sent && std::chrono::steady_clock::now() < deadline)
+		{
+			auto dest = batchclient.BeginWrite(Cam::Shared::Messages::App::Camera_ApplyBatch, size);
+
+			if (dest)
+			{
+				std::memcpy(dest, &batchid, sizeof(batchid));
+				std::memcpy(dest + sizeof(batchid), script.Edits.GetData(), script.Edits.GetSize());
+
+				sent = batchclient.EndWrite(size);
+			}
+
+			if (!sent)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		}
+
+		if (!sent)
+		{
+			std::cout << "Batch of " << size << " bytes did not fit in the game's connection in time" << std::endl;
+			return 1;
+		}
+
+		Interprocess::Config::MessageType message;
+		Utility::BinaryBufferView data;
+
+		MapBatch::Result result;
+		auto answered = false;
+
+		while (!answered)
+		{
+			auto now = std::chrono::steady_clock::now();
+
+			if (now >= deadline)
+			{
+				break;
+			}
+
+			auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now) + std::chrono::milliseconds(1);
+
+			if (!resultserver.ReadTimed(message, data, wait) || message != Cam::Shared::Messages::Game::OnBatchApplied)
+			{
+				continue;
+			}
+
+			answered = Cam::Shared::Schema::Decode(data, result) && result.BatchID == batchid;
+		}
+
+		if (!answered)
+		{
+			std::cout << "No answer from the game in " << settings.Timeout << " seconds, the batch may still be made" << std::endl;
+			return 1;
+		}
+
+		if (result.Applied)
+		{
+			std::cout << "Made " << result.EditCount << " edits, " << result.CameraCount << " cameras changed in " << GetElapsedMilliseconds(start) << " ms" << std::endl;
+			return 0;
+		}
+
+		std::cout << "Nothing changed, ";
+
+		if (result.FailedEdit < script.Lines.size())
+		{
+			std::cout << script.Source << "(" << script.Lines[result.FailedEdit] << "): ";
+		}
+
+		std::cout << result.Error << std::endl;
+
+		return 1;
+	}
+
+	void PrintUsage()
+	{
+		std::cout << "HLCamBatch [options] [script]" << std::endl;
+		std::cout << std::endl;
+		std::cout << "  One edit per line: <camera ID> <field> <value>" << std::endl;
+		std::cout << "  Reads standard input without a script" << std::endl;
+		std::cout << std::endl;
+		std::cout << "  -check             Only read the script, nothing is sent" << std::endl;
+		std::cout << "  -timeout <seconds> How long to wait for the game, 5 by default" << std::endl;
+	}
+
+	bool ParseArgs(int argc, char* argv[], Settings& settings)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			std::string arg = argv[i];
+			auto hasvalue = i + 1 < argc;
+
+			if (arg == "-check")
+			{
+				settings.CheckOnly = true;
+			}
+
+			else if (arg == "-timeout" && hasvalue)
+			{
+				settings.Timeout = std::strtod(argv[++i], nullptr);
+			}
+
+			else if (!arg.empty() && arg[0] == '-')
+			{
+				return false;
+			}
+
+			else if (settings.ScriptPath.empty())
+			{
+				settings.ScriptPath = std::move(arg);
+			}
+
+			else
+			{
+				return false;
+			}
+		}
+
+		return settings.Timeout > 0;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	Settings settings;
+
+	if (!ParseArgs(argc, argv, settings))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	Script script;
+	auto read = false;
+
+	if (settings.ScriptPath.empty())
+	{
+		script.Source = "stdin";
+		read = ReadScript(std::cin, script);
+	}
+
+	else
+	{
+		std::ifstream file(settings.ScriptPath);
+
+		if (!file)
+		{
+			std::cout << "Could not read \"" << settings.ScriptPath << "\"" << std::endl;
+			return 1;
+		}
+
+		script.Source = settings.ScriptPath;
+		read = ReadScript(file, script);
+	}
+
+	if (!read)
+	{
+		return 1;
+	}
+
+	if (settings.CheckOnly)
+	{
+		std::cout << script.Lines.size() << " edits" << std::endl;
+		return 0;
+	}
+
+	if (script.Lines.empty())
+	{
+		std::cout << "No edits in " << script.Source << std::endl;
+		return 0;
+	}
+
+	return SendScript(script, settings);
+}
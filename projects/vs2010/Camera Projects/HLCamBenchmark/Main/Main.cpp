@@ -0,0 +1,1702 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <new>
+#include <limits>
+#include "boost/interprocess/ipc/message_queue.hpp"
+#include "Shared/Map/MapFile.hpp"
+#include "Shared/Interprocess/Interprocess.hpp"
+#include "Shared/Math/Easing.hpp"
+#include "Shared/Spatial/TriggerLocator.hpp"
+#include "Shared/Binary Buffer/BinaryStream.hpp"
+#include "Shared/Interprocess/Snapshot.hpp"
+#include "Shared/Map/MapSchema.hpp"
+
+/*
+	Every allocation in the program goes through here so the
+	trigger benchmark can tell if a frame allocated anything.
+*/
+namespace
+{
+	std::atomic<size_t> AllocationCount(0);
+}
+
+void* operator new(size_t size)
+{
+	AllocationCount++;
+
+	if (auto ret = std::malloc(size ? size : 1))
+	{
+		return ret;
+	}
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+/*
+	What C++14 compilers call when the size is known.
+*/
+void operator delete(void* pointer, size_t /*size*/) noexcept
+{
+	std::free(pointer);
+}
+
+/*
+	Standalone timings for the parts of the mod that run outside the engine.
+
+	HLCamBenchmark <test> [arguments]
+*/
+namespace
+{
+	using ClockType = std::chrono::high_resolution_clock;
+
+	using namespace std::literals::chrono_literals;
+
+	std::string ProgramPath;
+
+	double GetElapsedMilliseconds(ClockType::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(ClockType::now() - start).count();
+	}
+
+	/*
+		Random cameras spread over a map sized area, each with a few triggers.
+	*/
+	Cam::Shared::MapData CreateSyntheticMap(size_t cameracount)
+	{
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> position(-4096, 4096);
+		std::uniform_real_distribution<float> size(32, 512);
+
+		Cam::Shared::MapData ret;
+		ret.Cameras.resize(cameracount);
+
+		for (size_t i = 0; i < cameracount; i++)
+		{
+			auto& cam = ret.Cameras[i];
+
+			cam.Position = {position(random), position(random), position(random)};
+			cam.Angle = {0, position(random) / 32.0f, 0};
+
+			if (i % 8 == 0)
+			{
+				cam.LookType = Cam::Shared::CameraLookType::AtTarget;
+				cam.LookTargetName = "target_" + std::to_string(i);
+			}
+
+			cam.Triggers.resize(1 + i % 4);
+
+			for (auto& trig : cam.Triggers)
+			{
+				trig.Corner1 = {position(random), position(random), position(random)};
+				trig.Corner2 = {trig.Corner1.X + size(random), trig.Corner1.Y + size(random), trig.Corner1.Z + size(random)};
+			}
+		}
+
+		return ret;
+	}
+
+	/*
+		Time to get a map into memory the way the game does on level change.
+		Argument is either a JSON map or a camera count to generate.
+	*/
+	int BenchmarkMapLoad(int argc, char* argv[])
+	{
+		namespace MapFile = Cam::Shared::MapFile;
+
+		if (argc < 1)
+		{
+			std::cout << "mapload <map.json | cameracount> [iterations]" << std::endl;
+			return 1;
+		}
+
+		std::string input = argv[0];
+		size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100;
+
+		std::string jsonpath = "mapload_bench.json";
+		std::string binarypath = "mapload_bench.hlcb";
+
+		Cam::Shared::MapData mapdata;
+
+		if (input.find_first_not_of("0123456789") == std::string::npos)
+		{
+			mapdata = CreateSyntheticMap(std::strtoul(input.c_str(), nullptr, 10));
+		}
+
+		else
+		{
+			std::vector<char> bytes;
+			std::string error;
+
+			if (!MapFile::ReadAllBytes(input.c_str(), bytes) || !MapFile::ReadJSON(bytes.data(), mapdata, error))
+			{
+				std::cout << "Could not load \"" << input << "\" " << error << std::endl;
+				return 1;
+			}
+		}
+
+		auto text = MapFile::WriteJSON(mapdata);
+		MapFile::WriteAllBytes(jsonpath.c_str(), text.data(), text.size());
+
+		MapFile::FileStamp stamp;
+		MapFile::GetFileStamp(jsonpath.c_str(), stamp);
+
+		std::vector<char> binary;
+		MapFile::Binary::Write(mapdata, stamp, binary);
+		MapFile::WriteAllBytes(binarypath.c_str(), binary.data(), binary.size());
+
+		size_t triggercount = 0;
+
+		for (const auto& cam : mapdata.Cameras)
+		{
+			triggercount += cam.Triggers.size();
+		}
+
+		std::cout << mapdata.Cameras.size() << " cameras, " << triggercount << " triggers" << std::endl;
+		std::cout << "JSON " << text.size() << " bytes, binary " << binary.size() << " bytes" << std::endl;
+
+		/*
+			Both paths end with the whole map in memory, cameras, triggers
+			and strings, so neither gets away with less work than the other.
+		*/
+		Cam::Shared::MapData jsonloaded;
+		Cam::Shared::MapData binaryloaded;
+
+		auto jsonstart = ClockType::now();
+
+		for (size_t i = 0; i < iterations; i++)
+		{
+			std::vector<char> bytes;
+			MapFile::ReadAllBytes(jsonpath.c_str(), bytes);
+
+			Cam::Shared::MapData loaded;
+			std::string error;
+			MapFile::ReadJSON(bytes.data(), loaded, error);
+
+			jsonloaded = std::move(loaded);
+		}
+
+		auto jsontime = GetElapsedMilliseconds(jsonstart) / iterations;
+
+		auto binarystart = ClockType::now();
+
+		for (size_t i = 0; i < iterations; i++)
+		{
+			MapFile::BinaryMap binarymap;
+			std::string error;
+
+			if (!binarymap.Open(binarypath.c_str(), error) || !binarymap.IsCurrent(jsonpath.c_str()))
+			{
+				std::cout << "Compiled map rejected: " << error << std::endl;
+				return 1;
+			}
+
+			Cam::Shared::MapData loaded;
+			binarymap.ToMapData(loaded);
+
+			binaryloaded = std::move(loaded);
+		}
+
+		auto binarytime = GetElapsedMilliseconds(binarystart) / iterations;
+
+		if (MapFile::WriteJSON(jsonloaded) != MapFile::WriteJSON(binaryloaded))
+		{
+			std::cout << "JSON and binary loads differ" << std::endl;
+			return 1;
+		}
+
+		std::printf("JSON load:   %.4f ms\n", jsontime);
+		std::printf("Binary load: %.4f ms\n", binarytime);
+		std::printf("Speedup:     %.1fx\n", binarytime > 0 ? jsontime / binarytime : 0.0);
+
+		std::remove(jsonpath.c_str());
+		std::remove(binarypath.c_str());
+
+		return 0;
+	}
+
+	namespace Latency
+	{
+		enum : Shared::Interprocess::Config::MessageType
+		{
+			Ping,
+			Quit,
+		};
+
+		constexpr auto ReplyWaitTime = 5000ms;
+	}
+
+	/*
+		Replaces a queue left behind by a run that did not exit cleanly.
+	*/
+	bool StartQueue(Shared::Interprocess::Server& server, const char* name)
+	{
+		boost::interprocess::message_queue::remove(name);
+
+		try
+		{
+			server.Start(name);
+		}
+
+		catch (const boost::interprocess::interprocess_exception& error)
+		{
+			std::cout << "Could not start \"" << name << "\": " << error.what() << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	/*
+		The other process creates its queue when it gets around to it.
+	*/
+	bool ConnectQueue(Shared::Interprocess::Client& client, const char* name)
+	{
+		auto start = ClockType::now();
+
+		while (true)
+		{
+			try
+			{
+				client.Connect(name);
+				return true;
+			}
+
+			catch (const boost::interprocess::interprocess_exception&)
+			{
+				client.Disconnect();
+			}
+
+			if (ClockType::now() - start > 10s)
+			{
+				std::cout << "Could not connect to \"" << name << "\"" << std::endl;
+				return false;
+			}
+
+			std::this_thread::sleep_for(10ms);
+		}
+	}
+
+	/*
+		"poll" waits the way the message threads did before they blocked
+		on the queue, checking it every millisecond.
+	*/
+	bool ReadReply(Shared::Interprocess::Peer& peer, Shared::Interprocess::Config::MessageType& message, Utility::BinaryBuffer& data, bool poll)
+	{
+		auto start = ClockType::now();
+
+		while (ClockType::now() - start < Latency::ReplyWaitTime)
+		{
+			if (poll)
+			{
+				if (peer.TryRead(message, data))
+				{
+					return true;
+				}
+
+				std::this_thread::sleep_for(1ms);
+			}
+
+			else if (peer.ReadTimed(message, data, Latency::ReplyWaitTime))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/*
+		Takes the editor's side of the queues and answers every ping.
+		Started by "ipclatency", not meant to be run by hand.
+	*/
+	int BenchmarkIPCEcho(int argc, char* argv[])
+	{
+		auto poll = argc > 0 && argv[0] == std::string("poll");
+
+		Shared::Interprocess::Server appserver;
+		Shared::Interprocess::Client gameclient;
+
+		if (!StartQueue(appserver, "HLCAM_APP") || !ConnectQueue(gameclient, "HLCAM_GAME"))
+		{
+			return 1;
+		}
+
+		while (true)
+		{
+			Shared::Interprocess::Config::MessageType message;
+			Utility::BinaryBuffer data;
+
+			if (!ReadReply(gameclient, message, data, poll) || message == Latency::Quit)
+			{
+				break;
+			}
+
+			auto sequence = data.GetValue<uint32_t>();
+			appserver.Write(Latency::Ping, Utility::BinaryBufferHelp::CreatePacket(sequence));
+		}
+
+		return 0;
+	}
+
+	/*
+		Round trip of a message between two processes over the same queues
+		the game and editor use, so neither of them can be running.
+	*/
+	int BenchmarkIPCLatency(int argc, char* argv[])
+	{
+		size_t iterations = argc > 0 ? std::strtoul(argv[0], nullptr, 10) : 1000;
+		auto poll = argc > 1 && argv[1] == std::string("poll");
+
+		if (iterations == 0)
+		{
+			std::cout << "ipclatency [iterations] [poll]" << std::endl;
+			return 1;
+		}
+
+		Shared::Interprocess::Server gameserver;
+		Shared::Interprocess::Client appclient;
+
+		if (!StartQueue(gameserver, "HLCAM_GAME"))
+		{
+			return 1;
+		}
+
+		auto command = "\"" + ProgramPath + "\" ipcecho" + (poll ? " poll" : "");
+
+		#ifdef _WIN32
+		/*
+			cmd.exe drops the first and last quote of the line.
+		*/
+		command = "\"" + command + "\"";
+		#endif
+
+		std::thread echothread([command]
+		{
+			std::system(command.c_str());
+		});
+
+		auto ret = 0;
+
+		if (ConnectQueue(appclient, "HLCAM_APP"))
+		{
+			const size_t warmup = 100;
+
+			std::vector<double> times;
+			times.reserve(iterations);
+
+			for (uint32_t sequence = 0; sequence < warmup + iterations; sequence++)
+			{
+				auto start = ClockType::now();
+
+				gameserver.Write(Latency::Ping, Utility::BinaryBufferHelp::CreatePacket(sequence));
+
+				Shared::Interprocess::Config::MessageType message;
+				Utility::BinaryBuffer data;
+
+				if (!ReadReply(appclient, message, data, poll) || data.GetValue<uint32_t>() != sequence)
+				{
+					std::cout << "No reply to ping " << sequence << std::endl;
+					ret = 1;
+
+					break;
+				}
+
+				if (sequence >= warmup)
+				{
+					times.push_back(std::chrono::duration<double, std::micro>(ClockType::now() - start).count());
+				}
+			}
+
+			if (ret == 0)
+			{
+				std::sort(times.begin(), times.end());
+
+				double total = 0;
+
+				for (auto time : times)
+				{
+					total += time;
+				}
+
+				auto percentile = [&times](double fraction)
+				{
+					return times[static_cast<size_t>(fraction * (times.size() - 1))];
+				};
+
+				std::cout << times.size() << " round trips, " << (poll ? "polling" : "blocking") << std::endl;
+				std::printf("Min:     %.1f us\n", times.front());
+				std::printf("Average: %.1f us\n", total / times.size());
+				std::printf("p50:     %.1f us\n", percentile(0.5));
+				std::printf("p99:     %.1f us\n", percentile(0.99));
+				std::printf("Max:     %.1f us\n", times.back());
+			}
+		}
+
+		else
+		{
+			ret = 1;
+		}
+
+		/*
+			Queued even if the echo never connected, it reads it when it does.
+		*/
+		gameserver.Write(Latency::Quit);
+
+		echothread.join();
+
+		return ret;
+	}
+
+	/*
+		Times "curve" over "samples" evenly spaced points, "checksum" keeps
+		the compiler from dropping the calls.
+	*/
+	template <typename Curve>
+	double TimeCurve(Curve&& curve, size_t samples, size_t passes, double& checksum)
+	{
+		auto start = ClockType::now();
+
+		for (size_t pass = 0; pass < passes; pass++)
+		{
+			for (size_t i = 0; i < samples; i++)
+			{
+				checksum += curve(static_cast<float>(i) / (samples - 1));
+			}
+		}
+
+		return GetElapsedMilliseconds(start) * 1000000.0 / (samples * passes);
+	}
+
+	int BenchmarkEasing(int argc, char* argv[])
+	{
+		size_t passes = argc > 0 ? std::strtoul(argv[0], nullptr, 10) : 1000;
+
+		if (passes == 0)
+		{
+			std::cout << "easing [passes]" << std::endl;
+			return 1;
+		}
+
+		const size_t samples = 10000;
+
+		/*
+			What zooms used before the tables.
+		*/
+		auto cossmooth = [](float time)
+		{
+			return (1.0f - std::cos(time * 3.14159265f)) / 2.0f;
+		};
+
+		auto powexponential = [](float time)
+		{
+			auto in = [](float value)
+			{
+				return (std::pow(2.0f, value * 10.0f) - 1.0f) / 1023.0f;
+			};
+
+			return time < 0.5f ? in(time * 2.0f) / 2.0f : 1.0f - in(2.0f - time * 2.0f) / 2.0f;
+		};
+
+		double smootherror = 0;
+		double exponentialerror = 0;
+
+		/*
+			Cubic with both slopes at 1 is a straight line, and with
+			both at 0 the smoothstep curve 3t^2 - 2t^3.
+		*/
+		double cubicerror = 0;
+
+		for (size_t i = 0; i < samples; i++)
+		{
+			auto time = static_cast<float>(i) / (samples - 1);
+
+			smootherror = std::max(smootherror, static_cast<double>(std::abs(cossmooth(time) - Utility::Easing::Smooth(time))));
+			exponentialerror = std::max(exponentialerror, static_cast<double>(std::abs(powexponential(time) - Utility::Easing::Exponential(time))));
+
+			auto smoothstep = time * time * (3.0f - 2.0f * time);
+
+			cubicerror = std::max(cubicerror, static_cast<double>(std::abs(Utility::Easing::Cubic(time, 1.0f, 1.0f) - time)));
+			cubicerror = std::max(cubicerror, static_cast<double>(std::abs(Utility::Easing::Cubic(time, 0.0f, 0.0f) - smoothstep)));
+		}
+
+		double checksum = 0;
+
+		auto coscost = TimeCurve(cossmooth, samples, passes, checksum);
+		auto smoothcost = TimeCurve(&Utility::Easing::Smooth, samples, passes, checksum);
+		auto powcost = TimeCurve(powexponential, samples, passes, checksum);
+		auto exponentialcost = TimeCurve(&Utility::Easing::Exponential, samples, passes, checksum);
+
+		auto cubiccost = TimeCurve([](float time)
+		{
+			return Utility::Easing::Cubic(time, 0.5f, 2.0f);
+		}, samples, passes, checksum);
+
+		std::cout << samples * passes << " evaluations per curve (checksum " << checksum << ")" << std::endl;
+		std::printf("Smooth, std::cos:       %.2f ns\n", coscost);
+		std::printf("Smooth, table:          %.2f ns, max error %.2e\n", smoothcost, smootherror);
+		std::printf("Exponential, std::pow:  %.2f ns\n", powcost);
+		std::printf("Exponential, table:     %.2f ns, max error %.2e\n", exponentialcost, exponentialerror);
+		std::printf("Cubic:                  %.2f ns, max error %.2e\n", cubiccost, cubicerror);
+
+		return cubicerror < 1e-5 ? 0 : 1;
+	}
+
+	namespace Triggers
+	{
+		/*
+			Same as the game, 320 units a second at 60 frames.
+		*/
+		const float PlayerSpeed = 320.0f / 60.0f;
+
+		const float HullHalfWidth = 16;
+		const float HullHalfHeight = 36;
+
+		const float CellSize = 256;
+
+		/*
+			Space between triggers so some players are outside all of them.
+		*/
+		const float CellGap = 8;
+
+		/*
+			Same as the game uses for its trigger graph.
+		*/
+		const float GraphMargin = 32;
+
+		struct PlayerPath
+		{
+			std::vector<std::vector<Cam::Shared::MapVector>> Frames;
+		};
+
+		size_t GetGridSide(size_t triggercount)
+		{
+			return static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(triggercount))));
+		}
+
+		/*
+			Rooms laid out in a square, IDs start at 1 like the game's.
+			A negative gap has neighbouring rooms overlap.
+		*/
+		std::vector<std::pair<Utility::AABBTree::IDType, Utility::AABB>> CreateGrid(size_t triggercount, float gap = CellGap)
+		{
+			std::vector<std::pair<Utility::AABBTree::IDType, Utility::AABB>> ret;
+			ret.reserve(triggercount);
+
+			auto side = GetGridSide(triggercount);
+
+			for (size_t i = 0; i < triggercount; i++)
+			{
+				Utility::AABB box;
+
+				box.Min[0] = (i % side) * CellSize;
+				box.Min[1] = (i / side) * CellSize;
+				box.Min[2] = 0;
+
+				box.Max[0] = box.Min[0] + CellSize - gap;
+				box.Max[1] = box.Min[1] + CellSize - gap;
+				box.Max[2] = CellSize;
+
+				ret.emplace_back(i + 1, box);
+			}
+
+			return ret;
+		}
+
+		/*
+			Players wander about the grid, turning a little every frame
+			and back into it from the edges.
+		*/
+		PlayerPath CreateRandomWalk(size_t triggercount, size_t playercount, size_t framecount)
+		{
+			std::mt19937 random(1);
+
+			auto extent = GetGridSide(triggercount) * CellSize;
+
+			std::uniform_real_distribution<float> start(0, extent);
+			std::uniform_real_distribution<float> turn(-0.2f, 0.2f);
+			std::uniform_real_distribution<float> heading(0, 6.2831853f);
+
+			std::vector<Cam::Shared::MapVector> positions(playercount);
+			std::vector<float> headings(playercount);
+
+			for (size_t i = 0; i < playercount; i++)
+			{
+				positions[i] = {start(random), start(random), CellSize / 2};
+				headings[i] = heading(random);
+			}
+
+			PlayerPath ret;
+			ret.Frames.resize(framecount);
+
+			for (auto& frame : ret.Frames)
+			{
+				for (size_t i = 0; i < playercount; i++)
+				{
+					auto& pos = positions[i];
+					auto& dir = headings[i];
+
+					dir += turn(random);
+
+					pos.X += std::cos(dir) * PlayerSpeed;
+					pos.Y += std::sin(dir) * PlayerSpeed;
+
+					if (pos.X < 0 || pos.X > extent || pos.Y < 0 || pos.Y > extent)
+					{
+						pos.X = std::fmin(std::fmax(pos.X, 0.0f), extent);
+						pos.Y = std::fmin(std::fmax(pos.Y, 0.0f), extent);
+
+						dir += 3.14159265f;
+					}
+				}
+
+				frame = positions;
+			}
+
+			return ret;
+		}
+
+		/*
+			One frame per line, "x y z" for every player in turn.
+		*/
+		bool ReadPath(const char* filename, PlayerPath& path)
+		{
+			std::ifstream file(filename);
+
+			if (!file)
+			{
+				return false;
+			}
+
+			std::string line;
+
+			while (std::getline(file, line))
+			{
+				std::istringstream stream(line);
+				std::vector<Cam::Shared::MapVector> frame;
+
+				Cam::Shared::MapVector pos;
+
+				while (stream >> pos.X >> pos.Y >> pos.Z)
+				{
+					frame.push_back(pos);
+				}
+
+				if (!frame.empty())
+				{
+					path.Frames.push_back(std::move(frame));
+				}
+			}
+
+			return !path.Frames.empty();
+		}
+
+		int Run(size_t triggercount, const PlayerPath& path)
+		{
+			namespace Locator = Utility::TriggerLocator;
+
+			auto items = CreateGrid(triggercount);
+
+			auto buildstart = ClockType::now();
+
+			Utility::AABBTree tree;
+			tree.Build(items);
+
+			Utility::BoxArray bounds;
+
+			for (const auto& item : items)
+			{
+				bounds.Set(item.first, item.second);
+			}
+
+			auto treetime = GetElapsedMilliseconds(buildstart);
+
+			auto graphstart = ClockType::now();
+
+			Utility::BoxGraph graph;
+			graph.Build(tree, bounds, GraphMargin);
+
+			auto graphtime = GetElapsedMilliseconds(graphstart);
+
+			auto playercount = path.Frames.front().size();
+
+			std::vector<Locator::Request> requests(playercount);
+			std::vector<size_t> players(playercount);
+
+			/*
+				What the game keeps per player, 0 is no trigger.
+			*/
+			std::vector<size_t> activeids(playercount, 0);
+			std::vector<Cam::Shared::MapVector> lastpositions(playercount, {-1, -1, -1});
+
+			std::vector<double> times;
+			times.reserve(path.Frames.size());
+
+			Locator::Counters counters;
+
+			size_t idleskips = 0;
+			size_t searchedhits = 0;
+			size_t switches = 0;
+
+			auto allocationstart = AllocationCount.load();
+
+			for (const auto& frame : path.Frames)
+			{
+				auto framestart = ClockType::now();
+
+				size_t requestcount = 0;
+
+				for (size_t i = 0; i < playercount && i < frame.size(); i++)
+				{
+					const auto& pos = frame[i];
+					auto& lastpos = lastpositions[i];
+
+					/*
+						Same as the game, players that did not move keep their trigger.
+					*/
+					if (pos.X == lastpos.X && pos.Y == lastpos.Y && pos.Z == lastpos.Z)
+					{
+						idleskips++;
+						continue;
+					}
+
+					lastpos = pos;
+
+					auto& request = requests[requestcount];
+					players[requestcount] = i;
+					requestcount++;
+
+					request.Box.Min[0] = pos.X - HullHalfWidth;
+					request.Box.Min[1] = pos.Y - HullHalfWidth;
+					request.Box.Min[2] = pos.Z - HullHalfHeight;
+
+					request.Box.Max[0] = pos.X + HullHalfWidth;
+					request.Box.Max[1] = pos.Y + HullHalfWidth;
+					request.Box.Max[2] = pos.Z + HullHalfHeight;
+
+					request.HasActive = activeids[i] != 0;
+					request.ActiveID = activeids[i];
+				}
+
+				Locator::Locate(tree, bounds, graph, requests.data(), requestcount, counters);
+
+				for (size_t i = 0; i < requestcount; i++)
+				{
+					const auto& request = requests[i];
+
+					if (request.Result == Locator::ResultType::Searched)
+					{
+						searchedhits++;
+					}
+
+					if (request.Result == Locator::ResultType::Neighbour ||
+						request.Result == Locator::ResultType::Searched)
+					{
+						auto& activeid = activeids[players[i]];
+
+						if (activeid != request.FoundID)
+						{
+							activeid = request.FoundID;
+							switches++;
+						}
+					}
+				}
+
+				times.push_back(std::chrono::duration<double, std::micro>(ClockType::now() - framestart).count());
+			}
+
+			auto allocations = AllocationCount.load() - allocationstart;
+
+			std::sort(times.begin(), times.end());
+
+			double total = 0;
+
+			for (auto time : times)
+			{
+				total += time;
+			}
+
+			auto lookups = counters.ActiveHits + counters.NeighbourHits + counters.Misses;
+
+			std::cout << triggercount << " triggers, " << playercount << " players, " << times.size() << " frames" << std::endl;
+			std::printf("Build:      tree %.2f ms, graph %.2f ms, %u links\n", treetime, graphtime, static_cast<unsigned>(graph.GetLinkCount()));
+			std::printf("Frame:      average %.2f us, p99 %.2f us, max %.2f us\n", total / times.size(), times[static_cast<size_t>(0.99 * (times.size() - 1))], times.back());
+			std::printf("Per lookup: %.1f ns\n", lookups ? total * 1000.0 / lookups : 0.0);
+
+			std::printf
+			(
+				"Lookups:    %u active, %u neighbour, %u searched, %u outside, %u idle\n",
+				static_cast<unsigned>(counters.ActiveHits),
+				static_cast<unsigned>(counters.NeighbourHits),
+				static_cast<unsigned>(searchedhits),
+				static_cast<unsigned>(counters.EmptyMisses),
+				static_cast<unsigned>(idleskips)
+			);
+
+			std::printf("Searches:   %u batched\n", static_cast<unsigned>(counters.BatchedSearches));
+			std::printf("Switches:   %u\n", static_cast<unsigned>(switches));
+			std::printf("Allocated:  %u times in %u frames\n", static_cast<unsigned>(allocations), static_cast<unsigned>(times.size()));
+
+			return 0;
+		}
+	}
+
+	namespace TriggerPick
+	{
+		/*
+			The client's way of predicting the trigger, every box is tested.
+			0 is no trigger.
+		*/
+		size_t PickAll(const std::vector<std::pair<Utility::AABBTree::IDType, Utility::AABB>>& items, size_t activeid, const Utility::AABB& box)
+		{
+			const Utility::AABB* active = nullptr;
+
+			for (const auto& item : items)
+			{
+				if (item.first == activeid)
+				{
+					active = &item.second;
+				}
+			}
+
+			if (active && active->Intersects(box))
+			{
+				return activeid;
+			}
+
+			size_t neighbour = 0;
+			size_t other = 0;
+
+			for (const auto& item : items)
+			{
+				if (!item.second.Intersects(box))
+				{
+					continue;
+				}
+
+				auto isneighbour = false;
+
+				if (active)
+				{
+					auto reach = *active;
+
+					for (size_t i = 0; i < 3; i++)
+					{
+						reach.Min[i] -= Triggers::GraphMargin;
+						reach.Max[i] += Triggers::GraphMargin;
+					}
+
+					isneighbour = reach.Intersects(item.second);
+				}
+
+				auto& lowest = isneighbour ? neighbour : other;
+
+				if (lowest == 0 || item.first < lowest)
+				{
+					lowest = item.first;
+				}
+			}
+
+			return neighbour != 0 ? neighbour : other;
+		}
+	}
+
+	/*
+		Per frame cost of finding the trigger of every player, the part of
+		the server that runs every frame whether or not anyone switches.
+	*/
+	int BenchmarkTriggers(int argc, char* argv[])
+	{
+		if (argc < 1)
+		{
+			std::cout << "triggers <triggercount | sweep> [players] [frames] [path.txt]" << std::endl;
+			return 1;
+		}
+
+		std::vector<size_t> counts;
+
+		if (argv[0] == std::string("sweep"))
+		{
+			counts = {100, 1000, 10000, 100000};
+		}
+
+		else
+		{
+			counts.push_back(std::strtoul(argv[0], nullptr, 10));
+		}
+
+		size_t playercount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 32;
+		size_t framecount = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10000;
+
+		if (counts.front() == 0 || playercount == 0 || framecount == 0)
+		{
+			std::cout << "Counts have to be above 0" << std::endl;
+			return 1;
+		}
+
+		Triggers::PlayerPath recorded;
+
+		if (argc > 3 && !Triggers::ReadPath(argv[3], recorded))
+		{
+			std::cout << "Could not read \"" << argv[3] << "\"" << std::endl;
+			return 1;
+		}
+
+		for (auto count : counts)
+		{
+			if (recorded.Frames.empty())
+			{
+				Triggers::Run(count, Triggers::CreateRandomWalk(count, playercount, framecount));
+			}
+
+			else
+			{
+				Triggers::Run(count, recorded);
+			}
+
+			std::cout << std::endl;
+		}
+
+		return 0;
+	}
+
+	namespace RayPick
+	{
+		Utility::AABB MakeBox(float minx, float miny, float minz, float maxx, float maxy, float maxz)
+		{
+			return {{minx, miny, minz}, {maxx, maxy, maxz}};
+		}
+
+		/*
+			Same rule as the tree, one box at a time.
+		*/
+		bool CastAll(const std::vector<std::pair<Utility::AABBTree::IDType, Utility::AABB>>& items, const float* origin, const float* direction, float maxdistance, Utility::AABBTree::RayHit& hit)
+		{
+			auto best = maxdistance;
+			auto found = false;
+
+			for (const auto& item : items)
+			{
+				float entry = 0;
+				float exit = std::numeric_limits<float>::max();
+
+				for (size_t i = 0; i < 3; i++)
+				{
+					auto dir = direction[i];
+
+					if (std::abs(dir) < 1e-20f)
+					{
+						dir = dir < 0 ? -1e-20f : 1e-20f;
+					}
+
+					auto t1 = (item.second.Min[i] - origin[i]) / dir;
+					auto t2 = (item.second.Max[i] - origin[i]) / dir;
+
+					entry = std::max(entry, std::min(t1, t2));
+					exit = std::min(exit, std::max(t1, t2));
+				}
+
+				if (entry > std::min(exit, best))
+				{
+					continue;
+				}
+
+				auto distance = entry > 0 ? entry : std::min(exit, maxdistance);
+
+				if (distance > best || (found && distance == best && entry <= 0))
+				{
+					continue;
+				}
+
+				best = distance;
+				hit.ID = item.first;
+				hit.Distance = distance;
+				found = true;
+			}
+
+			return found;
+		}
+
+		struct Case
+		{
+			const char* Name;
+
+			float Origin[3];
+			float Direction[3];
+			float MaxDistance;
+
+			Utility::AABBTree::IDType ExpectedID;
+		};
+	}
+
+	/*
+		Picking triggers from inside other triggers, checked against
+		fixed nested and overlapping boxes and then against testing
+		every box of random overlapping ones.
+	*/
+	int BenchmarkRayCast(int argc, char* argv[])
+	{
+		size_t boxcount = argc > 0 ? std::strtoul(argv[0], nullptr, 10) : 2000;
+		size_t raycount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+
+		if (boxcount == 0 || raycount == 0)
+		{
+			std::cout << "Counts have to be above 0" << std::endl;
+			return 1;
+		}
+
+		using RayPick::MakeBox;
+
+		std::vector<std::pair<Utility::AABBTree::IDType, Utility::AABB>> items =
+		{
+			{1, MakeBox(-1000, -1000, -1000, 1000, 1000, 1000)},
+			{2, MakeBox(100, -50, -50, 200, 50, 50)},
+			{3, MakeBox(150, -50, -50, 300, 50, 50)},
+			{4, MakeBox(-400, 500, -50, -300, 600, 50)},
+		};
+
+		const RayPick::Case cases[] =
+		{
+			{"nested ahead", {0, 0, 0}, {1, 0, 0}, 2000, 2},
+			{"only the outer", {0, 0, 0}, {-1, 0, 0}, 2000, 1},
+			{"outer past search distance", {0, 0, 0}, {-1, 0, 0}, 512, 1},
+			{"inside overlapping, first left", {170, 0, 0}, {1, 0, 0}, 2000, 2},
+			{"overlapping entered before left", {120, 0, 0}, {1, 0, 0}, 2000, 3},
+			{"from outside all", {-2000, 0, 0}, {1, 0, 0}, 2000, 1},
+			{"nested to the side", {-350, 0, 0}, {0, 1, 0}, 2000, 4},
+		};
+
+		Utility::AABBTree tree;
+		tree.Build(items);
+
+		auto failures = 0;
+
+		for (const auto& test : cases)
+		{
+			Utility::AABBTree::RayHit hit;
+
+			if (!tree.RayCast(test.Origin, test.Direction, test.MaxDistance, hit) || hit.ID != test.ExpectedID)
+			{
+				std::cout << "Failed \"" << test.Name << "\", expected " << test.ExpectedID << std::endl;
+				failures++;
+			}
+		}
+
+		std::mt19937 random(1);
+
+		std::uniform_real_distribution<float> position(-2000, 2000);
+		std::uniform_real_distribution<float> size(16, 1024);
+		std::uniform_real_distribution<float> direction(-1, 1);
+
+		items.clear();
+
+		for (size_t i = 0; i < boxcount; i++)
+		{
+			auto x = position(random);
+			auto y = position(random);
+			auto z = position(random);
+
+			items.emplace_back(i + 1, MakeBox(x, y, z, x + size(random), y + size(random), z + size(random)));
+		}
+
+		tree.Build(items);
+
+		std::vector<float> rays(raycount * 6);
+
+		for (size_t i = 0; i < raycount; i++)
+		{
+			auto ray = &rays[i * 6];
+
+			ray[0] = position(random);
+			ray[1] = position(random);
+			ray[2] = position(random);
+
+			ray[3] = direction(random);
+			ray[4] = direction(random);
+			ray[5] = direction(random);
+		}
+
+		size_t hits = 0;
+		size_t mismatches = 0;
+
+		auto start = ClockType::now();
+
+		for (size_t i = 0; i < raycount; i++)
+		{
+			auto ray = &rays[i * 6];
+
+			Utility::AABBTree::RayHit hit;
+
+			if (tree.RayCast(ray, ray + 3, 512, hit))
+			{
+				hits++;
+			}
+		}
+
+		auto treetime = GetElapsedMilliseconds(start);
+
+		for (size_t i = 0; i < raycount; i++)
+		{
+			auto ray = &rays[i * 6];
+
+			Utility::AABBTree::RayHit treehit;
+			Utility::AABBTree::RayHit allhit;
+
+			auto treefound = tree.RayCast(ray, ray + 3, 512, treehit);
+			auto allfound = RayPick::CastAll(items, ray, ray + 3, 512, allhit);
+
+			/*
+				Boxes at the same distance can go either way.
+			*/
+			if (treefound != allfound || (treefound && treehit.ID != allhit.ID && std::abs(treehit.Distance - allhit.Distance) > 0.01f))
+			{
+				mismatches++;
+			}
+		}
+
+		std::cout << boxcount << " boxes, " << raycount << " rays, " << hits << " hits" << std::endl;
+		std::printf("Per ray:    %.1f ns\n", treetime * 1000000.0 / raycount);
+		std::printf("Fixed:      %u of %u failed\n", static_cast<unsigned>(failures), static_cast<unsigned>(sizeof(cases) / sizeof(cases[0])));
+		std::printf("Random:     %u differ from testing every box\n", static_cast<unsigned>(mismatches));
+
+		return failures == 0 && mismatches == 0 ? 0 : 1;
+	}
+
+	/*
+		Players walking through rooms that overlap their neighbours
+		have to end up in the trigger the client predicts for them.
+	*/
+	int BenchmarkTriggerPick(int argc, char* argv[])
+	{
+		namespace Locator = Utility::TriggerLocator;
+
+		size_t triggercount = argc > 0 ? std::strtoul(argv[0], nullptr, 10) : 400;
+		size_t playercount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 32;
+		size_t framecount = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10000;
+
+		if (triggercount == 0 || playercount == 0 || framecount == 0)
+		{
+			std::cout << "Counts have to be above 0" << std::endl;
+			return 1;
+		}
+
+		/*
+			Wider than the player so some stand in four rooms at once.
+		*/
+		auto items = Triggers::CreateGrid(triggercount, -48);
+		auto path = Triggers::CreateRandomWalk(triggercount, playercount, framecount);
+
+		Utility::AABBTree tree;
+		tree.Build(items);
+
+		Utility::BoxArray bounds;
+
+		for (const auto& item : items)
+		{
+			bounds.Set(item.first, item.second);
+		}
+
+		Utility::BoxGraph graph;
+		graph.Build(tree, bounds, Triggers::GraphMargin);
+
+		std::vector<Locator::Request> requests(playercount);
+		std::vector<size_t> activeids(playercount, 0);
+
+		Locator::Counters counters;
+
+		size_t mismatches = 0;
+
+		for (const auto& frame : path.Frames)
+		{
+			for (size_t i = 0; i < playercount; i++)
+			{
+				const auto& pos = frame[i];
+				auto& request = requests[i];
+
+				request.Box.Min[0] = pos.X - Triggers::HullHalfWidth;
+				request.Box.Min[1] = pos.Y - Triggers::HullHalfWidth;
+				request.Box.Min[2] = pos.Z - Triggers::HullHalfHeight;
+
+				request.Box.Max[0] = pos.X + Triggers::HullHalfWidth;
+				request.Box.Max[1] = pos.Y + Triggers::HullHalfWidth;
+				request.Box.Max[2] = pos.Z + Triggers::HullHalfHeight;
+
+				request.HasActive = activeids[i] != 0;
+				request.ActiveID = activeids[i];
+			}
+
+			Locator::Locate(tree, bounds, graph, requests.data(), playercount, counters);
+
+			for (size_t i = 0; i < playercount; i++)
+			{
+				const auto& request = requests[i];
+				auto expected = TriggerPick::PickAll(items, activeids[i], request.Box);
+
+				/*
+					Outside every trigger the player keeps the one they had.
+				*/
+				auto found = request.Result == Locator::ResultType::None ? activeids[i] : request.FoundID;
+
+				if (expected == 0)
+				{
+					expected = activeids[i];
+				}
+
+				if (found != expected)
+				{
+					mismatches++;
+				}
+
+				activeids[i] = found;
+			}
+		}
+
+		std::cout << triggercount << " triggers, " << playercount << " players, " << path.Frames.size() << " frames" << std::endl;
+
+		std::printf
+		(
+			"Lookups:    %u active, %u neighbour, %u searched\n",
+			static_cast<unsigned>(counters.ActiveHits),
+			static_cast<unsigned>(counters.NeighbourHits),
+			static_cast<unsigned>(counters.Misses - counters.EmptyMisses)
+		);
+
+		std::printf("Differ:     %u from the client's prediction\n", static_cast<unsigned>(mismatches));
+
+		return mismatches == 0 ? 0 : 1;
+	}
+
+	namespace BinaryFile
+	{
+		/*
+			Something like a camera, a string every so often like names.
+		*/
+		const size_t RecordSize = 21;
+		const size_t NameInterval = 16;
+
+		void WriteRecords(Utility::BinaryBuffer& buffer, size_t count)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				buffer << static_cast<int16_t>(i);
+				buffer << static_cast<uint16_t>(i * 3);
+				buffer << static_cast<int32_t>(i * 7);
+
+				buffer << static_cast<float>(i) * 0.5f;
+				buffer << static_cast<float>(i) * 0.25f;
+				buffer << static_cast<float>(i) * 0.125f;
+
+				buffer << static_cast<unsigned char>(i);
+
+				if (i % NameInterval == 0)
+				{
+					buffer << "camera_" + std::to_string(i);
+				}
+			}
+		}
+
+		double ReadRecords(Utility::BinaryBuffer& buffer, size_t count)
+		{
+			double ret = 0;
+			std::string name;
+
+			for (size_t i = 0; i < count; i++)
+			{
+				ret += buffer.GetValue<int16_t>();
+				ret += buffer.GetValue<uint16_t>();
+				ret += buffer.GetValue<int32_t>();
+
+				ret += buffer.GetValue<float>();
+				ret += buffer.GetValue<float>();
+				ret += buffer.GetValue<float>();
+
+				ret += buffer.GetValue<unsigned char>();
+
+				if (i % NameInterval == 0)
+				{
+					buffer >> name;
+					ret += name.size();
+				}
+			}
+
+			return ret;
+		}
+
+		void PrintResult(const char* name, double milliseconds, size_t bytes)
+		{
+			std::printf("%-28s %9.1f ms %8.1f MB/s\n", name, milliseconds, bytes / (1024.0 * 1024.0) / (milliseconds / 1000.0));
+		}
+	}
+
+	/*
+		Reading and writing a large file through BinaryBuffer a value at
+		a time against doing it a block at a time.
+	*/
+	int BenchmarkBinaryFile(int argc, char* argv[])
+	{
+		size_t megabytes = argc > 0 ? std::strtoul(argv[0], nullptr, 10) : 100;
+		size_t blocksize = argc > 1 ? std::strtoul(argv[1], nullptr, 10) * 1024 : 64 * 1024;
+
+		if (megabytes == 0 || blocksize == 0)
+		{
+			std::cout << "binaryfile [megabytes] [blocksize kb]" << std::endl;
+			return 1;
+		}
+
+		const char* path = "binaryfile_bench.bin";
+
+		auto count = megabytes * 1024 * 1024 / BinaryFile::RecordSize;
+
+		Utility::BinaryStreamSettings settings;
+		settings.BlockSize = blocksize;
+
+		size_t filesize;
+
+		{
+			auto start = ClockType::now();
+
+			std::ofstream file(path, std::ios::binary | std::ios::trunc);
+			Utility::BinaryBuffer buffer;
+
+			BinaryFile::WriteRecords(buffer, count);
+			buffer.SaveToFile(file);
+
+			filesize = buffer.GetSize();
+
+			BinaryFile::PrintResult("Write, in memory then save", GetElapsedMilliseconds(start), filesize);
+		}
+
+		{
+			auto start = ClockType::now();
+
+			std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+			{
+				Utility::BinaryBuffer buffer(file, settings);
+				BinaryFile::WriteRecords(buffer, count);
+			}
+
+			file.close();
+
+			BinaryFile::PrintResult("Write, blocks", GetElapsedMilliseconds(start), filesize);
+		}
+
+		std::cout << count << " records, " << filesize << " bytes, " << blocksize / 1024 << " KB blocks" << std::endl;
+
+		double checksums[3];
+
+		{
+			auto start = ClockType::now();
+
+			std::ifstream file(path, std::ios::binary);
+			Utility::BinaryBuffer buffer(file);
+
+			checksums[0] = BinaryFile::ReadRecords(buffer, count);
+
+			BinaryFile::PrintResult("Read, per value", GetElapsedMilliseconds(start), filesize);
+		}
+
+		for (size_t i = 1; i < 3; i++)
+		{
+			settings.ReadAhead = i == 2;
+
+			auto start = ClockType::now();
+
+			std::ifstream file(path, std::ios::binary);
+			Utility::BinaryBuffer buffer(file, settings);
+
+			checksums[i] = BinaryFile::ReadRecords(buffer, count);
+
+			BinaryFile::PrintResult(settings.ReadAhead ? "Read, blocks with read ahead" : "Read, blocks", GetElapsedMilliseconds(start), filesize);
+		}
+
+		std::remove(path);
+
+		if (checksums[0] != checksums[1] || checksums[0] != checksums[2])
+		{
+			std::cout << "Reads disagree: " << checksums[0] << " " << checksums[1] << " " << checksums[2] << std::endl;
+			return 1;
+		}
+
+		return 0;
+	}
+
+	namespace MapSync
+	{
+		enum : Shared::Interprocess::Config::MessageType
+		{
+			Whole,
+			Chunk,
+		};
+
+		const char* ConnectionName = "HLCAM_BENCH_SYNC";
+
+		struct Timings
+		{
+			double Encode = 0;
+			double Compress = 0;
+			double Transfer = 0;
+			double Decode = 0;
+			double Total = 0;
+		};
+
+		void PrintResult(const char* name, const Timings& timings, size_t iterations)
+		{
+			std::printf("%s\n", name);
+			std::printf("  Encode:                      %8.3f ms\n", timings.Encode / iterations);
+			std::printf("  Compress:                    %8.3f ms\n", timings.Compress / iterations);
+			std::printf("  Send, reassemble, expand:    %8.3f ms\n", timings.Transfer / iterations);
+			std::printf("  Decode:                      %8.3f ms\n", timings.Decode / iterations);
+			std::printf("  Total:                       %8.3f ms\n", timings.Total / iterations);
+		}
+	}
+
+	/*
+		Time from having the map to the editor having all of it, as one
+		message and as a compressed snapshot in chunks. Both ends are in
+		this process, on the transport the game uses unless "queue".
+	*/
+	int BenchmarkMapSync(int argc, char* argv[])
+	{
+		namespace Schema = Cam::Shared::Schema;
+		namespace Interprocess = Shared::Interprocess;
+
+		size_t cameracount = argc > 0 ? std::strtoul(argv[0], nullptr, 10) : 10000;
+		size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20;
+		auto usequeue = argc > 2 && argv[2] == std::string("queue");
+
+		if (cameracount == 0 || iterations == 0)
+		{
+			std::cout << "mapsync [cameracount] [iterations] [queue]" << std::endl;
+			return 1;
+		}
+
+		auto map = CreateSyntheticMap(cameracount);
+		Cam::Shared::MapFile::AssignIDs(map);
+
+		Schema::MapSnapshot snapshot;
+		snapshot.Name = "synthetic";
+		snapshot.Cameras = std::move(map.Cameras);
+
+		size_t triggercount = 0;
+
+		for (const auto& cam : snapshot.Cameras)
+		{
+			triggercount += cam.Triggers.size();
+		}
+
+		auto transport = usequeue ? Interprocess::Config::TransportType::MessageQueue : Interprocess::Config::TransportType::SharedRing;
+
+		Interprocess::Server server;
+		Interprocess::Client client;
+
+		boost::interprocess::message_queue::remove(MapSync::ConnectionName);
+
+		try
+		{
+			server.Start(MapSync::ConnectionName, transport);
+		}
+
+		catch (const boost::interprocess::interprocess_exception& error)
+		{
+			std::cout << "Could not start \"" << MapSync::ConnectionName << "\": " << error.what() << std::endl;
+			return 1;
+		}
+
+		if (!ConnectQueue(client, MapSync::ConnectionName))
+		{
+			return 1;
+		}
+
+		std::cout << cameracount << " cameras, " << triggercount << " triggers, " << (usequeue ? "message queue" : "shared ring") << std::endl;
+
+		Interprocess::Config::MessageType message;
+		Utility::BinaryBufferView view;
+
+		{
+			MapSync::Timings timings;
+			size_t size = 0;
+
+			auto fits = true;
+
+			for (size_t i = 0; i < iterations && fits; i++)
+			{
+				auto start = ClockType::now();
+
+				auto data = server.AcquireBuffer();
+				Schema::EncodePacket(data, snapshot);
+				size = data.GetSize();
+
+				timings.Encode += GetElapsedMilliseconds(start);
+
+				auto transferstart = ClockType::now();
+
+				/*
+					The queue throws on messages over its size.
+				*/
+				try
+				{
+					fits = server.Write(MapSync::Whole, std::move(data)) && client.TryRead(message, view);
+				}
+
+				catch (const boost::interprocess::interprocess_exception&)
+				{
+					fits = false;
+				}
+
+				if (!fits)
+				{
+					break;
+				}
+
+				timings.Transfer += GetElapsedMilliseconds(transferstart);
+
+				auto decodestart = ClockType::now();
+
+				Schema::MapSnapshot received;
+				Schema::Decode(view, received);
+
+				timings.Decode += GetElapsedMilliseconds(decodestart);
+				timings.Total += GetElapsedMilliseconds(start);
+			}
+
+			if (fits)
+			{
+				std::cout << std::endl;
+				MapSync::PrintResult("One message", timings, iterations);
+				std::printf("  Size:                        %8zu bytes\n", size);
+			}
+
+			else
+			{
+				std::cout << std::endl << "One message: " << size << " bytes does not fit the transport" << std::endl;
+			}
+		}
+
+		{
+			MapSync::Timings timings;
+			Interprocess::Snapshot::Stats stats;
+
+			Interprocess::SnapshotReader reader;
+
+			for (uint32_t i = 0; i < iterations; i++)
+			{
+				auto start = ClockType::now();
+
+				Utility::BinaryBuffer data;
+				Schema::EncodePacket(data, snapshot);
+
+				timings.Encode += GetElapsedMilliseconds(start);
+
+				Interprocess::SnapshotWriter writer(i, data);
+
+				stats = writer.GetStats();
+				timings.Compress += stats.CompressMilliseconds;
+
+				auto transferstart = ClockType::now();
+				auto result = Interprocess::SnapshotReader::Result::Incomplete;
+
+				/*
+					Chunks that don't fit wait for the reader, as they
+					would wait for the next frame in the game.
+				*/
+				while (result == Interprocess::SnapshotReader::Result::Incomplete)
+				{
+					writer.WriteChunks(server, MapSync::Chunk);
+
+					while (result == Interprocess::SnapshotReader::Result::Incomplete && client.TryRead(message, view))
+					{
+						result = reader.Add(view);
+					}
+				}
+
+				if (result != Interprocess::SnapshotReader::Result::Complete)
+				{
+					std::cout << "Snapshot " << i << " failed" << std::endl;
+					return 1;
+				}
+
+				timings.Transfer += GetElapsedMilliseconds(transferstart);
+
+				auto decodestart = ClockType::now();
+
+				Schema::MapSnapshot received;
+
+				if (!Schema::Decode(reader.GetData(), received) || received.Cameras.size() != cameracount)
+				{
+					std::cout << "Snapshot " << i << " decoded wrong" << std::endl;
+					return 1;
+				}
+
+				timings.Decode += GetElapsedMilliseconds(decodestart);
+				timings.Total += GetElapsedMilliseconds(start);
+			}
+
+			std::cout << std::endl;
+			MapSync::PrintResult("Compressed snapshot", timings, iterations);
+			std::printf("  Size:                        %8zu bytes, %zu compressed (%.0f%%) in %zu chunks\n", stats.Size, stats.CompressedSize, 100.0 * stats.CompressedSize / (stats.Size ? stats.Size : 1), stats.ChunkCount);
+		}
+
+		return 0;
+	}
+
+	struct BenchmarkEntry
+	{
+		const char* Name;
+		int(*Function)(int argc, char* argv[]);
+	};
+
+	const BenchmarkEntry Benchmarks[] =
+	{
+		{"mapload", BenchmarkMapLoad},
+		{"ipclatency", BenchmarkIPCLatency},
+		{"ipcecho", BenchmarkIPCEcho},
+		{"easing", BenchmarkEasing},
+		{"triggers", BenchmarkTriggers},
+		{"triggerpick", BenchmarkTriggerPick},
+		{"raycast", BenchmarkRayCast},
+		{"binaryfile", BenchmarkBinaryFile},
+		{"mapsync", BenchmarkMapSync},
+	};
+}
+
+int main(int argc, char* argv[])
+{
+	ProgramPath = argv[0];
+
+	if (argc > 1)
+	{
+		for (const auto& entry : Benchmarks)
+		{
+			if (entry.Name == std::string(argv[1]))
+			{
+				return entry.Function(argc - 2, argv + 2);
+			}
+		}
+	}
+
+	std::cout << "HLCamBenchmark <test> [arguments]" << std::endl;
+
+	for (const auto& entry : Benchmarks)
+	{
+		std::cout << "\t" << entry.Name << std::endl;
+	}
+
+	return 1;
+}
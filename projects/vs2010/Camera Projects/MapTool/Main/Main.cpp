@@ -0,0 +1,507 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include "Shared/Map/MapFile.hpp"
+#include "Shared/Map/MapCheck.hpp"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <dirent.h>
+#endif
+
+/*
+	Offline converter between the editable JSON camera maps and
+	the compiled format the game loads.
+
+	MapTool compile <map.json> [map.hlcb]
+	MapTool decompile <map.hlcb> [map.json]
+
+	Checking and building many maps at once, for content builds.
+	Arguments are map files or directories of them. Exits with
+	1 if any map has errors, or warnings with -strict.
+
+	MapTool check [options] <map.json | directory>...
+	MapTool build [options] <map.json | directory>...
+
+	-bsp <directory>	Checks names against <directory>/<map>.bsp
+	-out <directory>	Where built maps go, next to their source by default
+	-threads <count>	Maps processed at once, all cores by default
+	-strict				Warnings fail a map as well
+*/
+namespace
+{
+	std::string ReplaceExtension(const std::string& path, const char* extension)
+	{
+		auto dot = path.find_last_of('.');
+		auto slash = path.find_last_of("\\/");
+
+		if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+		{
+			return path + extension;
+		}
+
+		return path.substr(0, dot) + extension;
+	}
+
+	bool Compile(const std::string& input, const std::string& output)
+	{
+		namespace MapFile = Cam::Shared::MapFile;
+
+		std::vector<char> bytes;
+
+		if (!MapFile::ReadAllBytes(input.c_str(), bytes))
+		{
+			std::cout << "Could not read \"" << input << "\"" << std::endl;
+			return false;
+		}
+
+		Cam::Shared::MapData mapdata;
+		std::string error;
+
+		if (!MapFile::ReadJSON(bytes.data(), mapdata, error))
+		{
+			std::cout << error << " in \"" << input << "\"" << std::endl;
+			return false;
+		}
+
+		MapFile::FileStamp stamp;
+		MapFile::GetFileStamp(input.c_str(), stamp);
+
+		std::vector<char> binary;
+		MapFile::Binary::Write(mapdata, stamp, binary);
+
+		if (!MapFile::WriteAllBytes(output.c_str(), binary.data(), binary.size()))
+		{
+			std::cout << "Could not write \"" << output << "\"" << std::endl;
+			return false;
+		}
+
+		std::cout << "Compiled " << mapdata.Cameras.size() << " cameras to \"" << output << "\"" << std::endl;
+		return true;
+	}
+
+	std::string GetFileName(const std::string& path)
+	{
+		auto slash = path.find_last_of("\\/");
+
+		if (slash == std::string::npos)
+		{
+			return path;
+		}
+
+		return path.substr(slash + 1);
+	}
+
+	bool EndsWith(const std::string& string, const char* suffix)
+	{
+		auto length = std::char_traits<char>::length(suffix);
+		return string.size() >= length && string.compare(string.size() - length, length, suffix) == 0;
+	}
+
+	/*
+		Files directly in "directory" ending with ".json", sorted so
+		output is the same between runs. False if it isn't a directory.
+	*/
+	bool ListMapFiles(const std::string& directory, std::vector<std::string>& files)
+	{
+		std::vector<std::string> names;
+
+		#ifdef _WIN32
+		WIN32_FIND_DATAA data;
+		auto handle = FindFirstFileA((directory + "\\*.json").c_str(), &data);
+
+		if (handle == INVALID_HANDLE_VALUE)
+		{
+			return GetFileAttributesA(directory.c_str()) != INVALID_FILE_ATTRIBUTES &&
+				   (GetFileAttributesA(directory.c_str()) & FILE_ATTRIBUTE_DIRECTORY);
+		}
+
+		do
+		{
+			if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+			{
+				names.push_back(data.cFileName);
+			}
+		}
+		while (FindNextFileA(handle, &data));
+
+		FindClose(handle);
+		#else
+		auto dir = opendir(directory.c_str());
+
+		if (!dir)
+		{
+			return false;
+		}
+
+		while (auto entry = readdir(dir))
+		{
+			std::string name = entry->d_name;
+
+			if (EndsWith(name, ".json"))
+			{
+				names.push_back(std::move(name));
+			}
+		}
+
+		closedir(dir);
+		#endif
+
+		std::sort(names.begin(), names.end());
+
+		for (const auto& name : names)
+		{
+			files.push_back(directory + "/" + name);
+		}
+
+		return true;
+	}
+
+	struct BatchSettings
+	{
+		bool Build = false;
+		bool Strict = false;
+
+		std::string BSPDirectory;
+		std::string OutputDirectory;
+
+		size_t Threads = 0;
+	};
+
+	/*
+		Output of one map, printed once all are done so
+		lines from different maps don't interleave.
+	*/
+	struct BatchResult
+	{
+		std::string Output;
+
+		size_t Errors = 0;
+		size_t Warnings = 0;
+
+		bool Failed = false;
+	};
+
+	void ProcessMap(const std::string& input, const BatchSettings& settings, BatchResult& result)
+	{
+		namespace MapFile = Cam::Shared::MapFile;
+
+		std::ostringstream output;
+
+		auto finish = [&](bool failed)
+		{
+			result.Failed = failed;
+			result.Output = output.str();
+		};
+
+		std::vector<char> bytes;
+
+		if (!MapFile::ReadAllBytes(input.c_str(), bytes))
+		{
+			output << input << ": error: Could not read file\n";
+			result.Errors++;
+
+			finish(true);
+			return;
+		}
+
+		Cam::Shared::MapData mapdata;
+		std::string error;
+
+		if (!MapFile::ReadJSONUnnumbered(bytes.data(), mapdata, error))
+		{
+			output << input << ": error: " << error << "\n";
+			result.Errors++;
+
+			finish(true);
+			return;
+		}
+
+		MapFile::EntityNames names;
+		auto hasnames = false;
+
+		if (!settings.BSPDirectory.empty())
+		{
+			auto mapname = ReplaceExtension(GetFileName(input), "");
+			auto bsppath = settings.BSPDirectory + "/" + mapname + ".bsp";
+
+			hasnames = MapFile::ReadBSPEntityNames(bsppath.c_str(), names, error);
+
+			if (!hasnames)
+			{
+				output << input << ": warning: " << error << " \"" << bsppath << "\", names are not checked\n";
+				result.Warnings++;
+			}
+		}
+
+		std::vector<MapFile::MapIssue> issues;
+		MapFile::CheckMap(mapdata, hasnames ? &names : nullptr, issues);
+
+		for (const auto& issue : issues)
+		{
+			if (issue.Severity == MapFile::MapIssue::SeverityType::Error)
+			{
+				output << input << ": error: " << issue.Message << "\n";
+				result.Errors++;
+			}
+
+			else
+			{
+				output << input << ": warning: " << issue.Message << "\n";
+				result.Warnings++;
+			}
+		}
+
+		auto failed = result.Errors != 0 || (settings.Strict && result.Warnings != 0);
+
+		if (failed || !settings.Build)
+		{
+			finish(failed);
+			return;
+		}
+
+		MapFile::AssignIDs(mapdata);
+
+		MapFile::FileStamp stamp;
+		MapFile::GetFileStamp(input.c_str(), stamp);
+
+		std::vector<char> binary;
+		MapFile::Binary::Write(mapdata, stamp, binary);
+
+		auto outputpath = ReplaceExtension(input, ".hlcb");
+
+		if (!settings.OutputDirectory.empty())
+		{
+			outputpath = settings.OutputDirectory + "/" + GetFileName(outputpath);
+		}
+
+		if (!MapFile::WriteAllBytes(outputpath.c_str(), binary.data(), binary.size()))
+		{
+			output << outputpath << ": error: Could not write file\n";
+			result.Errors++;
+
+			finish(true);
+			return;
+		}
+
+		finish(false);
+	}
+
+	int RunBatch(const std::vector<std::string>& inputs, const BatchSettings& settings)
+	{
+		std::vector<std::string> files;
+
+		for (const auto& input : inputs)
+		{
+			if (!ListMapFiles(input, files))
+			{
+				files.push_back(input);
+			}
+		}
+
+		if (files.empty())
+		{
+			std::cout << "No camera maps found" << std::endl;
+			return 1;
+		}
+
+		auto starttime = std::chrono::steady_clock::now();
+
+		std::vector<BatchResult> results(files.size());
+		std::atomic<size_t> nextfile(0);
+
+		auto worker = [&]()
+		{
+			while (true)
+			{
+				auto index = nextfile++;
+
+				if (index >= files.size())
+				{
+					break;
+				}
+
+				ProcessMap(files[index], settings, results[index]);
+			}
+		};
+
+		auto threadcount = settings.Threads;
+
+		if (threadcount == 0)
+		{
+			threadcount = std::max(std::thread::hardware_concurrency(), 1u);
+		}
+
+		threadcount = std::min(threadcount, files.size());
+
+		/*
+			This thread works as well.
+		*/
+		std::vector<std::thread> threads;
+
+		for (size_t i = 1; i < threadcount; i++)
+		{
+			threads.emplace_back(worker);
+		}
+
+		worker();
+
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+
+		auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - starttime).count();
+
+		size_t errors = 0;
+		size_t warnings = 0;
+		size_t failed = 0;
+
+		for (const auto& result : results)
+		{
+			std::cout << result.Output;
+
+			errors += result.Errors;
+			warnings += result.Warnings;
+			failed += result.Failed;
+		}
+
+		std::cout << (settings.Build ? "Built " : "Checked ") << files.size() - failed << " of " << files.size() << " camera maps, ";
+		std::cout << errors << " errors, " << warnings << " warnings (" << elapsed << " ms, " << threadcount << " threads)" << std::endl;
+
+		return failed == 0 ? 0 : 1;
+	}
+
+	bool Decompile(const std::string& input, const std::string& output)
+	{
+		namespace MapFile = Cam::Shared::MapFile;
+
+		Cam::Shared::MapData mapdata;
+
+		{
+			MapFile::BinaryMap binarymap;
+			std::string error;
+
+			if (!binarymap.Open(input.c_str(), error))
+			{
+				std::cout << error << " in \"" << input << "\"" << std::endl;
+				return false;
+			}
+
+			binarymap.ToMapData(mapdata);
+		}
+
+		auto text = MapFile::WriteJSON(mapdata);
+
+		if (!MapFile::WriteAllBytes(output.c_str(), text.data(), text.size()))
+		{
+			std::cout << "Could not write \"" << output << "\"" << std::endl;
+			return false;
+		}
+
+		std::cout << "Decompiled " << mapdata.Cameras.size() << " cameras to \"" << output << "\"" << std::endl;
+		return true;
+	}
+
+	void PrintUsage()
+	{
+		std::cout << "MapTool compile <map.json> [map.hlcb]" << std::endl;
+		std::cout << "MapTool decompile <map.hlcb> [map.json]" << std::endl;
+		std::cout << "MapTool check [options] <map.json | directory>..." << std::endl;
+		std::cout << "MapTool build [options] <map.json | directory>..." << std::endl;
+		std::cout << std::endl;
+		std::cout << "  -bsp <directory>   Check names against <directory>/<map>.bsp" << std::endl;
+		std::cout << "  -out <directory>   Where built maps go, next to their source by default" << std::endl;
+		std::cout << "  -threads <count>   Maps processed at once, all cores by default" << std::endl;
+		std::cout << "  -strict            Warnings fail a map as well" << std::endl;
+	}
+
+	bool ParseBatchArgs(int argc, char* argv[], BatchSettings& settings, std::vector<std::string>& inputs)
+	{
+		for (int i = 2; i < argc; i++)
+		{
+			std::string arg = argv[i];
+			auto hasvalue = i + 1 < argc;
+
+			if (arg == "-strict")
+			{
+				settings.Strict = true;
+			}
+
+			else if (arg == "-bsp" && hasvalue)
+			{
+				settings.BSPDirectory = argv[++i];
+			}
+
+			else if (arg == "-out" && hasvalue)
+			{
+				settings.OutputDirectory = argv[++i];
+			}
+
+			else if (arg == "-threads" && hasvalue)
+			{
+				settings.Threads = std::strtoul(argv[++i], nullptr, 10);
+			}
+
+			else if (!arg.empty() && arg[0] == '-')
+			{
+				return false;
+			}
+
+			else
+			{
+				inputs.push_back(std::move(arg));
+			}
+		}
+
+		return !inputs.empty();
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	std::string command = argv[1];
+	std::string input = argv[2];
+
+	if (command == "compile")
+	{
+		auto output = argc > 3 ? argv[3] : ReplaceExtension(input, ".hlcb");
+		return Compile(input, output) ? 0 : 1;
+	}
+
+	else if (command == "decompile")
+	{
+		auto output = argc > 3 ? argv[3] : ReplaceExtension(input, ".json");
+		return Decompile(input, output) ? 0 : 1;
+	}
+
+	else if (command == "check" || command == "build")
+	{
+		BatchSettings settings;
+		settings.Build = command == "build";
+
+		std::vector<std::string> inputs;
+
+		if (ParseBatchArgs(argc, argv, settings, inputs))
+		{
+			return RunBatch(inputs, settings);
+		}
+	}
+
+	PrintUsage();
+	return 1;
+}
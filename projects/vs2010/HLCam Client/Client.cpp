@@ -9,45 +9,56 @@
 #include "parsemsg.h"
 #include "pm_defs.h"
 #include "event_api.h"
+#include "ref_params.h"
 
 namespace
 {
 	struct HLCamClient
 	{
-		std::unordered_map<size_t, Cam::ClientCamera> Cameras;
-		std::unordered_map<size_t, Cam::ClientTrigger> Triggers;
+		Utility::SlotMap<Cam::ClientCamera> Cameras;
+		Utility::SlotMap<Cam::ClientTrigger> Triggers;
 
 		bool InEditMode = false;
 
-		Cam::ClientTrigger* CurrentHighlightTrigger = nullptr;
+		/*
+			Handles rather than pointers, the items move when others
+			are added or removed.
+		*/
+		Utility::SlotHandle CurrentHighlightTrigger;
 
-		Cam::ClientTrigger* CurrentSelectionTrigger = nullptr;
-		Cam::ClientCamera* CurrentSelectionCamera = nullptr;
+		Utility::SlotHandle CurrentSelectionTrigger;
+		Utility::SlotHandle CurrentSelectionCamera;
 
-		Cam::ClientCamera* CurrentAdjustingCamera = nullptr;
+		Utility::SlotHandle CurrentAdjustingCamera;
 
-		Cam::ClientTrigger* FindTriggerByID(size_t id)
+		Cam::ClientTrigger* GetHighlightTrigger()
 		{
-			auto it = Triggers.find(id);
+			return Triggers.Get(CurrentHighlightTrigger);
+		}
 
-			if (it != Triggers.end())
-			{
-				return &it->second;
-			}
+		Cam::ClientTrigger* GetSelectionTrigger()
+		{
+			return Triggers.Get(CurrentSelectionTrigger);
+		}
 
-			return nullptr;
+		Cam::ClientCamera* GetSelectionCamera()
+		{
+			return Cameras.Get(CurrentSelectionCamera);
 		}
 
-		Cam::ClientCamera* FindCameraByID(size_t id)
+		Cam::ClientCamera* GetAdjustingCamera()
 		{
-			auto it = Cameras.find(id);
+			return Cameras.Get(CurrentAdjustingCamera);
+		}
 
-			if (it != Cameras.end())
-			{
-				return &it->second;
-			}
+		Cam::ClientTrigger* FindTriggerByID(size_t id)
+		{
+			return Triggers.Find(id);
+		}
 
-			return nullptr;
+		Cam::ClientCamera* FindCameraByID(size_t id)
+		{
+			return Cameras.Find(id);
 		}
 
 		Cam::ClientCamera* GetLinkedCamera(Cam::ClientTrigger& trigger)
@@ -57,7 +68,7 @@ namespace
 
 		void RemoveTriggerFromID(size_t triggerid)
 		{
-			Triggers.erase(triggerid);
+			Triggers.Remove(triggerid);
 		}
 
 		/*
@@ -82,7 +93,7 @@ namespace
 				}
 			}
 
-			Cameras.erase(camera->ID);
+			Cameras.Remove(camera->ID);
 		}
 
 		Cam::Shared::StateType CurrentState = Cam::Shared::StateType::Inactive;
@@ -94,6 +105,37 @@ namespace
 		*/
 		Vector ActiveCameraPosition{0, 0, 0};
 
+		bool HasServerCamera = false;
+		size_t ServerCameraID;
+
+		/*
+			Camera switches made from the predicted player origin,
+			shown before the server's switch gets here.
+		*/
+		struct PredictionData
+		{
+			/*
+				Trigger the player is in as far as the client can tell,
+				kept the same way the server keeps its own.
+			*/
+			bool HasTrigger = false;
+			size_t TriggerID;
+
+			/*
+				The view is at this camera until the server agrees
+				or takes too long to.
+			*/
+			bool Pending = false;
+			size_t CameraID;
+			float StartTime;
+
+			/*
+				The server's view entity can arrive a little after its message.
+			*/
+			bool Confirmed = false;
+			float ConfirmTime;
+		} Prediction;
+
 		struct AimGuideData
 		{
 			~AimGuideData()
@@ -188,6 +230,28 @@ namespace
 	};
 
 	static HLCamClient TheCamClient;
+
+	/*
+		Kept across map changes, unlike the rest of the client.
+	*/
+	struct PredictionStatsData
+	{
+		size_t Predicted = 0;
+		size_t Confirmed = 0;
+
+		/*
+			Predictions the server did not agree with in time.
+		*/
+		size_t Mispredicted = 0;
+
+		/*
+			Switches the server made on its own, such as named
+			cameras fired by the map.
+		*/
+		size_t Unpredicted = 0;
+	};
+
+	static PredictionStatsData PredictionStats;
 }
 
 namespace
@@ -410,23 +474,25 @@ namespace Cam
 
 			{
 				Menu::MenuQueueItem item;
-				item.Text = "Cameras: " + std::to_string(TheCamClient.Cameras.size());
+				item.Text = "Cameras: " + std::to_string(TheCamClient.Cameras.GetCount());
 
 				builder.AddItem(std::move(item));
 			}
 
 			{
 				Menu::MenuQueueItem item;
-				item.Text = "Triggers: " + std::to_string(TheCamClient.Triggers.size());
+				item.Text = "Triggers: " + std::to_string(TheCamClient.Triggers.GetCount());
 
 				builder.AddItem(std::move(item));
 			}
 
-			if (TheCamClient.CurrentSelectionCamera)
+			auto selectioncam = TheCamClient.GetSelectionCamera();
+
+			if (selectioncam)
 			{
 				builder.AddEmptySpace();
 
-				const auto& curcam = TheCamClient.CurrentSelectionCamera;
+				const auto& curcam = selectioncam;
 
 				{
 					Menu::MenuQueueItem item;
@@ -444,11 +510,13 @@ namespace Cam
 				}
 			}
 
-			if (TheCamClient.CurrentSelectionTrigger)
+			auto selectiontrig = TheCamClient.GetSelectionTrigger();
+
+			if (selectiontrig)
 			{
 				builder.AddEmptySpace();
 
-				const auto& curtrig = TheCamClient.CurrentSelectionTrigger;
+				const auto& curtrig = selectiontrig;
 
 				{
 					Menu::MenuQueueItem item;
@@ -465,11 +533,13 @@ namespace Cam
 				}
 			}
 
-			if (TheCamClient.CurrentHighlightTrigger)
+			auto highlighttrig = TheCamClient.GetHighlightTrigger();
+
+			if (highlighttrig)
 			{
 				builder.AddEmptySpace();
 
-				const auto& curtrig = TheCamClient.CurrentHighlightTrigger;
+				const auto& curtrig = highlighttrig;
 
 				{
 					Menu::MenuQueueItem item;
@@ -559,7 +629,7 @@ int HLCamClient_OnCameraCreatedMessage(const char* name, int size, void* buffer)
 		strcpy_s(newcam.Name, READ_STRING());
 	}
 
-	TheCamClient.Cameras[newcam.ID] = std::move(newcam);
+	TheCamClient.Cameras.Insert(newcam.ID, std::move(newcam));
 
 	return 1;
 }
@@ -585,7 +655,7 @@ int HLCamClient_OnTriggerCreatedMessage(const char* name, int size, void* buffer
 			TheCamClient.CurrentTriggerID = newtrig.ID;
 			TheCamClient.CurrentState = Cam::Shared::StateType::NeedsToCreateTriggerCorner1;
 
-			TheCamClient.Triggers[newtrig.ID] = std::move(newtrig);
+			TheCamClient.Triggers.Insert(newtrig.ID, std::move(newtrig));
 			break;
 		}
 
@@ -620,6 +690,102 @@ int HLCamClient_OnTriggerCreatedMessage(const char* name, int size, void* buffer
 	return 1;
 }
 
+/*
+	Existing map items, the server has already sent their cameras
+	before any of their triggers.
+*/
+int HLCamClient_OnMapSyncMessage(const char* name, int size, void* buffer)
+{
+	BEGIN_READ(buffer, size);
+
+	auto cameracount = READ_BYTE();
+
+	for (int i = 0; i < cameracount; i++)
+	{
+		Cam::ClientCamera newcam;
+
+		newcam.ID = READ_SHORT();
+		newcam.IsNamed = READ_BYTE();
+
+		newcam.Position[0] = READ_COORD();
+		newcam.Position[1] = READ_COORD();
+		newcam.Position[2] = READ_COORD();
+
+		newcam.Angle[0] = READ_COORD();
+		newcam.Angle[1] = READ_COORD();
+		newcam.Angle[2] = READ_COORD();
+
+		newcam.LookType = static_cast<Cam::Shared::CameraLookType>(READ_BYTE());
+		newcam.ZoomType = static_cast<Cam::Shared::CameraZoomType>(READ_BYTE());
+		newcam.UseAttachment = READ_BYTE() != 0;
+
+		if (newcam.IsNamed)
+		{
+			strcpy_s(newcam.Name, READ_STRING());
+		}
+
+		/*
+			Cameras already known are resent when they change,
+			their triggers are not necessarily part of it.
+		*/
+		auto existingcam = TheCamClient.FindCameraByID(newcam.ID);
+
+		if (existingcam)
+		{
+			newcam.LinkedTriggerIDs = std::move(existingcam->LinkedTriggerIDs);
+		}
+
+		TheCamClient.Cameras.Insert(newcam.ID, std::move(newcam));
+	}
+
+	auto triggercount = READ_BYTE();
+
+	for (int i = 0; i < triggercount; i++)
+	{
+		Cam::ClientTrigger newtrig;
+
+		newtrig.ID = READ_SHORT();
+		newtrig.LinkedCameraID = READ_SHORT();
+
+		newtrig.Corner1[0] = READ_COORD();
+		newtrig.Corner1[1] = READ_COORD();
+		newtrig.Corner1[2] = READ_COORD();
+
+		newtrig.Corner2[0] = READ_COORD();
+		newtrig.Corner2[1] = READ_COORD();
+		newtrig.Corner2[2] = READ_COORD();
+
+		auto existingtrig = TheCamClient.FindTriggerByID(newtrig.ID);
+
+		if (existingtrig && existingtrig->LinkedCameraID != newtrig.LinkedCameraID)
+		{
+			auto oldcam = TheCamClient.FindCameraByID(existingtrig->LinkedCameraID);
+
+			if (oldcam)
+			{
+				auto& oldids = oldcam->LinkedTriggerIDs;
+				oldids.erase(std::remove(oldids.begin(), oldids.end(), newtrig.ID), oldids.end());
+			}
+		}
+
+		auto linkedcam = TheCamClient.FindCameraByID(newtrig.LinkedCameraID);
+
+		if (linkedcam)
+		{
+			auto& ids = linkedcam->LinkedTriggerIDs;
+
+			if (std::find(ids.begin(), ids.end(), newtrig.ID) == ids.end())
+			{
+				ids.push_back(newtrig.ID);
+			}
+		}
+
+		TheCamClient.Triggers.Insert(newtrig.ID, std::move(newtrig));
+	}
+
+	return 1;
+}
+
 int HLCamClient_OnCameraRemovedMessage(const char* name, int size, void* buffer)
 {
 	BEGIN_READ(buffer, size);
@@ -651,8 +817,13 @@ int HLCamClient_OnItemHighlightedStartMessage(const char* name, int size, void*
 
 	if (type == 0)
 	{
-		TheCamClient.CurrentHighlightTrigger = TheCamClient.FindTriggerByID(itemid);
-		TheCamClient.CurrentHighlightTrigger->Highlighted = true;
+		auto trigger = TheCamClient.FindTriggerByID(itemid);
+
+		if (trigger)
+		{
+			trigger->Highlighted = true;
+			TheCamClient.CurrentHighlightTrigger = TheCamClient.Triggers.GetHandle(itemid);
+		}
 	}
 
 	return 1;
@@ -660,12 +831,15 @@ int HLCamClient_OnItemHighlightedStartMessage(const char* name, int size, void*
 
 int HLCamClient_OnItemHighlightedEndMessage(const char* name, int size, void* buffer)
 {
-	if (TheCamClient.CurrentHighlightTrigger)
+	auto trigger = TheCamClient.GetHighlightTrigger();
+
+	if (trigger)
 	{
-		TheCamClient.CurrentHighlightTrigger->Highlighted = false;
-		TheCamClient.CurrentHighlightTrigger = nullptr;
+		trigger->Highlighted = false;
 	}
 
+	TheCamClient.CurrentHighlightTrigger = Utility::SlotHandle();
+
 	return 1;
 }
 
@@ -678,14 +852,24 @@ int HLCamClient_ItemSelectedStart(const char* name, int size, void* buffer)
 
 	if (type == 0)
 	{
-		TheCamClient.CurrentSelectionTrigger = TheCamClient.FindTriggerByID(itemid);
-		TheCamClient.CurrentSelectionTrigger->Selected = true;
+		auto trigger = TheCamClient.FindTriggerByID(itemid);
+
+		if (trigger)
+		{
+			trigger->Selected = true;
+			TheCamClient.CurrentSelectionTrigger = TheCamClient.Triggers.GetHandle(itemid);
+		}
 	}
 
 	else if (type == 1)
 	{
-		TheCamClient.CurrentSelectionCamera = TheCamClient.FindCameraByID(itemid);
-		TheCamClient.CurrentSelectionCamera->Selected = true;
+		auto camera = TheCamClient.FindCameraByID(itemid);
+
+		if (camera)
+		{
+			camera->Selected = true;
+			TheCamClient.CurrentSelectionCamera = TheCamClient.Cameras.GetHandle(itemid);
+		}
 	}
 
 	return 1;
@@ -693,18 +877,22 @@ int HLCamClient_ItemSelectedStart(const char* name, int size, void* buffer)
 
 int HLCamClient_ItemSelectedEnd(const char* name, int size, void* buffer)
 {
-	if (TheCamClient.CurrentSelectionTrigger)
+	auto trigger = TheCamClient.GetSelectionTrigger();
+	auto camera = TheCamClient.GetSelectionCamera();
+
+	if (trigger)
 	{
-		TheCamClient.CurrentSelectionTrigger->Selected = false;
-		TheCamClient.CurrentSelectionTrigger = nullptr;
+		trigger->Selected = false;
 	}
 
-	else if (TheCamClient.CurrentSelectionCamera)
+	if (camera)
 	{
-		TheCamClient.CurrentSelectionCamera->Selected = false;
-		TheCamClient.CurrentSelectionCamera = nullptr;
+		camera->Selected = false;
 	}
 
+	TheCamClient.CurrentSelectionTrigger = Utility::SlotHandle();
+	TheCamClient.CurrentSelectionCamera = Utility::SlotHandle();
+
 	return 1;
 }
 
@@ -720,8 +908,13 @@ int HLCamClient_CameraAdjust(const char* name, int size, void* buffer)
 
 		auto cameraid = READ_SHORT();
 
-		TheCamClient.CurrentAdjustingCamera = TheCamClient.FindCameraByID(cameraid);
-		TheCamClient.CurrentAdjustingCamera->Adjusting = true;
+		auto camera = TheCamClient.FindCameraByID(cameraid);
+
+		if (camera)
+		{
+			camera->Adjusting = true;
+			TheCamClient.CurrentAdjustingCamera = TheCamClient.Cameras.GetHandle(cameraid);
+		}
 	}
 
 	else if (state == 1)
@@ -730,16 +923,22 @@ int HLCamClient_CameraAdjust(const char* name, int size, void* buffer)
 
 		auto cameraid = READ_SHORT();
 
-		TheCamClient.CurrentAdjustingCamera->Position[0] = READ_COORD();
-		TheCamClient.CurrentAdjustingCamera->Position[1] = READ_COORD();
-		TheCamClient.CurrentAdjustingCamera->Position[2] = READ_COORD();
+		auto camera = TheCamClient.GetAdjustingCamera();
+
+		if (camera)
+		{
+			camera->Position[0] = READ_COORD();
+			camera->Position[1] = READ_COORD();
+			camera->Position[2] = READ_COORD();
+
+			camera->Angle[0] = READ_COORD();
+			camera->Angle[1] = READ_COORD();
+			camera->Angle[2] = READ_COORD();
 
-		TheCamClient.CurrentAdjustingCamera->Angle[0] = READ_COORD();
-		TheCamClient.CurrentAdjustingCamera->Angle[1] = READ_COORD();
-		TheCamClient.CurrentAdjustingCamera->Angle[2] = READ_COORD();
+			camera->Adjusting = false;
+		}
 
-		TheCamClient.CurrentAdjustingCamera->Adjusting = false;
-		TheCamClient.CurrentAdjustingCamera = nullptr;
+		TheCamClient.CurrentAdjustingCamera = Utility::SlotHandle();
 	}
 
 	return 1;
@@ -771,10 +970,34 @@ int HLCamClient_CameraSwitch(const char* name, int size, void* buffer)
 {
 	BEGIN_READ(buffer, size);
 
+	size_t cameraid = READ_SHORT();
+
 	TheCamClient.ActiveCameraPosition.x = READ_COORD();
 	TheCamClient.ActiveCameraPosition.y = READ_COORD();
 	TheCamClient.ActiveCameraPosition.z = READ_COORD();
 
+	TheCamClient.HasServerCamera = true;
+	TheCamClient.ServerCameraID = cameraid;
+
+	auto& prediction = TheCamClient.Prediction;
+
+	/*
+		A different camera can be a switch the server made before catching
+		up to the prediction, so that is left to time out on its own.
+	*/
+	if (prediction.Pending && !prediction.Confirmed && prediction.CameraID == cameraid)
+	{
+		prediction.Confirmed = true;
+		prediction.ConfirmTime = gEngfuncs.GetClientTime();
+
+		PredictionStats.Confirmed++;
+	}
+
+	else if (!prediction.Pending)
+	{
+		PredictionStats.Unpredicted++;
+	}
+
 	return 1;
 }
 
@@ -850,7 +1073,212 @@ namespace
 			}
 		}
 
+		void PrintPredictionStats()
+		{
+			const auto& stats = PredictionStats;
+
+			gEngfuncs.Con_Printf("HLCAM: %u predicted, %u confirmed, %u mispredicted\n",
+								 static_cast<unsigned>(stats.Predicted),
+								 static_cast<unsigned>(stats.Confirmed),
+								 static_cast<unsigned>(stats.Mispredicted));
+
+			gEngfuncs.Con_Printf("HLCAM: %u switches by the server alone\n",
+								 static_cast<unsigned>(stats.Unpredicted));
+		}
+
 		cvar_t* UseAimSpot;
+		cvar_t* PredictSwitches;
+	}
+}
+
+namespace
+{
+	namespace Prediction
+	{
+		/*
+			Longer than a round trip to most servers. A prediction
+			not confirmed by then is taken as wrong.
+		*/
+		const float ConfirmWaitTime = 0.5f;
+
+		/*
+			Time for the server's view entity to follow its message.
+		*/
+		const float HandOverTime = 0.1f;
+
+		/*
+			Same as the server's trigger graph, triggers this close
+			to the current one are tried before any other.
+		*/
+		const float NeighbourMargin = 32;
+
+		bool TriggerOverlaps(const Cam::ClientTrigger& trigger, const float* mins, const float* maxs)
+		{
+			for (size_t i = 0; i < 3; i++)
+			{
+				auto low = fmin(trigger.Corner1[i], trigger.Corner2[i]);
+				auto high = fmax(trigger.Corner1[i], trigger.Corner2[i]);
+
+				if (low > maxs[i] || high < mins[i])
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		/*
+			The view is only known here for cameras that look one way
+			from where they stand, others follow the player or an entity.
+		*/
+		bool IsPredictable(const Cam::ClientCamera& camera)
+		{
+			return camera.LookType == Cam::Shared::CameraLookType::AtAngle &&
+				   camera.ZoomType == Cam::Shared::CameraZoomType::None &&
+				   !camera.UseAttachment;
+		}
+
+		bool IsNeighbour(const Cam::ClientTrigger& current, const Cam::ClientTrigger& other)
+		{
+			float mins[3];
+			float maxs[3];
+
+			for (size_t i = 0; i < 3; i++)
+			{
+				mins[i] = fmin(current.Corner1[i], current.Corner2[i]) - NeighbourMargin;
+				maxs[i] = fmax(current.Corner1[i], current.Corner2[i]) + NeighbourMargin;
+			}
+
+			return TriggerOverlaps(other, mins, maxs);
+		}
+
+		void Reset()
+		{
+			TheCamClient.Prediction = HLCamClient::PredictionData();
+		}
+
+		/*
+			Same steps the server takes with the player's bounds: stay in the
+			current trigger while touching it, otherwise take the neighbour
+			with the lowest ID, otherwise the lowest ID of any other one.
+		*/
+		void Update(const float* origin, float time)
+		{
+			auto& prediction = TheCamClient.Prediction;
+
+			if (prediction.Pending)
+			{
+				if (prediction.Confirmed)
+				{
+					if (time - prediction.ConfirmTime > HandOverTime)
+					{
+						prediction.Pending = false;
+					}
+				}
+
+				else if (time - prediction.StartTime > ConfirmWaitTime)
+				{
+					prediction.Pending = false;
+					PredictionStats.Mispredicted++;
+				}
+			}
+
+			float mins[3];
+			float maxs[3];
+
+			auto hull = gEngfuncs.pEventAPI->EV_LocalPlayerDucking() ? 1 : 0;
+			gEngfuncs.pEventAPI->EV_LocalPlayerBounds(hull, mins, maxs);
+
+			/*
+				The server's absolute bounds are one unit larger all around.
+			*/
+			for (size_t i = 0; i < 3; i++)
+			{
+				mins[i] += origin[i] - 1;
+				maxs[i] += origin[i] + 1;
+			}
+
+			Cam::ClientTrigger* current = nullptr;
+
+			if (prediction.HasTrigger)
+			{
+				current = TheCamClient.FindTriggerByID(prediction.TriggerID);
+
+				if (current && TriggerOverlaps(*current, mins, maxs))
+				{
+					return;
+				}
+			}
+
+			Cam::ClientTrigger* neighbour = nullptr;
+			Cam::ClientTrigger* other = nullptr;
+
+			for (auto& trig : TheCamClient.Triggers)
+			{
+				if (!TriggerOverlaps(trig, mins, maxs))
+				{
+					continue;
+				}
+
+				auto& lowest = current && IsNeighbour(*current, trig) ? neighbour : other;
+
+				if (!lowest || trig.ID < lowest->ID)
+				{
+					lowest = &trig;
+				}
+			}
+
+			auto found = neighbour ? neighbour : other;
+
+			/*
+				Outside every trigger the server keeps the camera it had.
+			*/
+			if (!found)
+			{
+				return;
+			}
+
+			prediction.HasTrigger = true;
+			prediction.TriggerID = found->ID;
+
+			auto camera = TheCamClient.GetLinkedCamera(*found);
+
+			if (!camera)
+			{
+				return;
+			}
+
+			if (prediction.Pending)
+			{
+				if (prediction.CameraID == camera->ID)
+				{
+					return;
+				}
+			}
+
+			else if (TheCamClient.HasServerCamera && TheCamClient.ServerCameraID == camera->ID)
+			{
+				return;
+			}
+
+			/*
+				Others wait for the server's switch, the camera
+				predicted before is not the one it switches to.
+			*/
+			if (!IsPredictable(*camera))
+			{
+				prediction.Pending = false;
+				return;
+			}
+
+			prediction.Pending = true;
+			prediction.Confirmed = false;
+			prediction.CameraID = camera->ID;
+			prediction.StartTime = time;
+
+			PredictionStats.Predicted++;
+		}
 	}
 }
 
@@ -868,6 +1296,7 @@ namespace Cam
 
 		gEngfuncs.pfnHookUserMsg("CamCreate", HLCamClient_OnCameraCreatedMessage);
 		gEngfuncs.pfnHookUserMsg("TrgCreate", HLCamClient_OnTriggerCreatedMessage);
+		gEngfuncs.pfnHookUserMsg("CamSync", HLCamClient_OnMapSyncMessage);
 		
 		gEngfuncs.pfnHookUserMsg("CamRem", HLCamClient_OnCameraRemovedMessage);
 		gEngfuncs.pfnHookUserMsg("TrgRem", HLCamClient_RemoveTrigger);
@@ -893,7 +1322,10 @@ namespace Cam
 
 		gEngfuncs.pfnAddCommand("hlcam_aimbeam_toggle", Commands::AimBeamToggle);
 
+		gEngfuncs.pfnAddCommand("hlcam_prediction_stats", Commands::PrintPredictionStats);
+
 		Commands::UseAimSpot = gEngfuncs.pfnRegisterVariable("hlcam_aimspot", "1", FCVAR_ARCHIVE);
+		Commands::PredictSwitches = gEngfuncs.pfnRegisterVariable("hlcam_predict", "1", FCVAR_ARCHIVE);
 
 		Tri::Init();
 	}
@@ -1007,6 +1439,41 @@ namespace Cam
 		}
 	}
 
+	void OnCalcRefdef(ref_params_s* params)
+	{
+		if (TheCamClient.InEditMode || Commands::PredictSwitches->value <= 0)
+		{
+			Prediction::Reset();
+			return;
+		}
+
+		Prediction::Update(params->simorg, gEngfuncs.GetClientTime());
+
+		auto& prediction = TheCamClient.Prediction;
+
+		if (!prediction.Pending)
+		{
+			return;
+		}
+
+		auto camera = TheCamClient.FindCameraByID(prediction.CameraID);
+
+		/*
+			The camera can have been changed since it was predicted.
+		*/
+		if (!camera || !Prediction::IsPredictable(*camera))
+		{
+			prediction.Pending = false;
+			return;
+		}
+
+		for (size_t i = 0; i < 3; i++)
+		{
+			params->vieworg[i] = camera->Position[i];
+			params->viewangles[i] = camera->Angle[i];
+		}
+	}
+
 	bool InEditMode()
 	{
 		return TheCamClient.InEditMode;
@@ -1017,12 +1484,12 @@ namespace Cam
 		return TheCamClient.EnemyPing;
 	}
 
-	const std::unordered_map<size_t, ClientTrigger>& GetAllTriggers()
+	const Utility::SlotMap<ClientTrigger>& GetAllTriggers()
 	{
 		return TheCamClient.Triggers;
 	}
 
-	const std::unordered_map<size_t, ClientCamera>& GetAllCameras()
+	const Utility::SlotMap<ClientCamera>& GetAllCameras()
 	{
 		return TheCamClient.Cameras;
 	}
@@ -2,8 +2,10 @@
 #include <vector>
 #include <unordered_map>
 #include "Shared\Shared.hpp"
+#include "Shared\Containers\SlotMap.hpp"
 
 struct cl_entity_s;
+struct ref_params_s;
 
 namespace Cam
 {
@@ -12,6 +14,11 @@ namespace Cam
 	
 	void OnUpdate();
 
+	/*
+		Moves the view to a camera switch the server has not made yet.
+	*/
+	void OnCalcRefdef(ref_params_s* params);
+
 	bool InEditMode();
 
 	struct EnemyPingData
@@ -44,6 +51,14 @@ namespace Cam
 		float Position[3];
 		float Angle[3];
 
+		/*
+			Only sent with the map, cameras made in edit mode
+			get them when it ends.
+		*/
+		Shared::CameraLookType LookType = Shared::CameraLookType::AtPlayer;
+		Shared::CameraZoomType ZoomType = Shared::CameraZoomType::None;
+		bool UseAttachment = false;
+
 		bool Selected = false;
 		bool Adjusting = false;
 		bool InPreview = false;
@@ -61,8 +76,8 @@ namespace Cam
 		bool Selected = false;
 	};
 
-	const std::unordered_map<size_t, ClientTrigger>& GetAllTriggers();
-	const std::unordered_map<size_t, ClientCamera>& GetAllCameras();
+	const Utility::SlotMap<ClientTrigger>& GetAllTriggers();
+	const Utility::SlotMap<ClientCamera>& GetAllCameras();
 
 	void GetActiveCameraPosition(float* outpos);
 }
@@ -40,6 +40,28 @@ namespace HLCamMessage
 	*/
 	AddMessage(CreateTrigger);
 
+	/*
+		Batch of existing map items sent when edit mode starts.
+
+		BYTE: Camera count
+		->	Per camera:
+		|	SHORT: ID
+		|	BYTE: Is named
+		|	COORD x 3: Position XYZ
+		|	COORD x 3: Angle XYZ
+		|	->	Is named:
+		|	|	STRING: Camera name
+		BYTE: Trigger count
+		->	Per trigger:
+		|	SHORT: ID
+		|	SHORT: Camera ID
+		|	COORD x 3: Corner 1 XYZ
+		|	COORD x 3: Corner 2 XYZ
+
+		All cameras are sent before any trigger.
+	*/
+	AddMessage(MapSync);
+
 	/*
 		SHORT: ID
 
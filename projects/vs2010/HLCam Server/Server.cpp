@@ -2,12 +2,15 @@
 #include "Shared\Shared.hpp"
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include <fstream>
 #include <string>
 #include <algorithm>
 #include <thread>
 #include <atomic>
 #include <mutex>
+#include <condition_variable>
+#include <memory>
 
 using namespace std::literals::chrono_literals;
 
@@ -17,12 +20,22 @@ using namespace std::literals::chrono_literals;
 #include "player.h"
 #include "triggers.h"
 
-#include "rapidjson\document.h"
-#include "rapidjson\stringbuffer.h"
-#include "rapidjson\prettywriter.h"
-
 #include "boost\interprocess\ipc\message_queue.hpp"
 #include "Shared\Interprocess\Interprocess.hpp"
+#include "Shared\Interprocess\Snapshot.hpp"
+#include "Shared\Spatial\AABBTree.hpp"
+#include "Shared\Spatial\BoxArray.hpp"
+#include "Shared\Spatial\BoxGraph.hpp"
+#include "Shared\Spatial\TriggerLocator.hpp"
+#include "Shared\Containers\SlotMap.hpp"
+#include "Shared\Map\MapFile.hpp"
+#include "Shared\Map\MapSchema.hpp"
+#include "Shared\Map\MapBatch.hpp"
+#include "Shared\Map\MapCheck.hpp"
+#include "Shared\Map\MapWriter.hpp"
+#include "Shared\Map\MapJournal.hpp"
+#include "Shared\Map\MapWatcher.hpp"
+#include "Shared\Threading\CommandQueue.hpp"
 
 #define CAM_EXTERN
 #include "Messages.hpp"
@@ -34,103 +47,48 @@ namespace
 {
 	namespace LocalUtility
 	{
-		/*
-			From Source Engine 2007
-		*/
-		bool IsBoxIntersectingBox(const Vector& pos1min,
-								  const Vector& pos1max,
-								  const Vector& pos2min,
-								  const Vector& pos2max)
+		Utility::AABB MakeBox(const Vector& min, const Vector& max)
 		{
-			if ((pos1min[0] > pos2max[0]) || (pos1max[0] < pos2min[0]))
-			{
-				return false;
-			}
-
-			if ((pos1min[1] > pos2max[1]) || (pos1max[1] < pos2min[1]))
-			{
-				return false;
-			}
+			Utility::AABB ret;
 
-			if ((pos1min[2] > pos2max[2]) || (pos1max[2] < pos2min[2]))
-			{
-				return false;
-			}
+			min.CopyToArray(ret.Min);
+			max.CopyToArray(ret.Max);
 
-			return true;
+			return ret;
 		}
 
-		/*
-			From http://gamedev.stackexchange.com/a/18459
-		*/
-		bool IsRayIntersectingBox(const Vector& raystart,
-								  const Vector& forward,
-								  const Vector& rayend,
-								  const Vector& boxmin,
-								  const Vector& boxmax)
+		bool SameBox(const Utility::AABB& first, const Utility::AABB& second)
 		{
-			Vector dirfrac;
-			float t;
-			// r.dir is unit direction vector of ray
-			dirfrac.x = 1.0f / forward.x;
-			dirfrac.y = 1.0f / forward.y;
-			dirfrac.z = 1.0f / forward.z;
-			// lb is the corner of AABB with minimal coordinates - left bottom, rt is maximal corner
-			// r.org is origin of ray
-			float t1 = (boxmin.x - raystart.x)*dirfrac.x;
-			float t2 = (boxmax.x - raystart.x)*dirfrac.x;
-			float t3 = (boxmin.y - raystart.y)*dirfrac.y;
-			float t4 = (boxmax.y - raystart.y)*dirfrac.y;
-			float t5 = (boxmin.z - raystart.z)*dirfrac.z;
-			float t6 = (boxmax.z - raystart.z)*dirfrac.z;
-
-			float tmin = max(max(min(t1, t2), min(t3, t4)), min(t5, t6));
-			float tmax = min(min(max(t1, t2), max(t3, t4)), max(t5, t6));
-
-			// if tmax < 0, ray (line) is intersecting AABB, but whole AABB is behing us
-			if (tmax < 0)
+			for (size_t i = 0; i < 3; i++)
 			{
-				t = tmax;
-				return false;
-			}
-
-			// if tmin > tmax, ray doesn't intersect AABB
-			if (tmin > tmax)
-			{
-				t = tmax;
-				return false;
+				if (first.Min[i] != second.Min[i] || first.Max[i] != second.Max[i])
+				{
+					return false;
+				}
 			}
 
-			t = tmin;
 			return true;
 		}
 
-		namespace FileSystem
+		Vector MakeVector(const Cam::Shared::MapVector& vector)
 		{
-			using ByteType = char;
-
-			/*
-				Modified version, changed wstring to string as HL
-				only uses ANSI, removed exceptions.
-			*/
-			std::vector<LocalUtility::FileSystem::ByteType> ReadAllBytes(const std::string& filename)
-			{
-				std::ifstream file(filename, std::ios::binary | std::ios::ate);
-
-				if (!file)
-				{
-					return {};
-				}
+			return {vector.X, vector.Y, vector.Z};
+		}
 
-				auto pos = file.tellg();
+		Vector MakeVector(const float* vector)
+		{
+			return {vector[0], vector[1], vector[2]};
+		}
 
-				std::vector<ByteType> result(pos);
+		Cam::Shared::MapVector MakeMapVector(const Vector& vector)
+		{
+			Cam::Shared::MapVector ret;
 
-				file.seekg(0, std::ios::beg);
-				file.read(result.data(), pos);
+			ret.X = vector.x;
+			ret.Y = vector.y;
+			ret.Z = vector.z;
 
-				return result;
-			}
+			return ret;
 		}
 	}
 }
@@ -158,25 +116,247 @@ namespace Cam
 
 namespace
 {
+	enum
+	{
+		MaxPlayers = 32,
+	};
+
+	/*
+		What a single player is looking through. Triggers and cameras are
+		shared by everyone, each player moves between them on their own.
+	*/
+	struct PlayerCamState
+	{
+		CBasePlayer* Player = nullptr;
+
+		/*
+			Current trigger the player is inside
+		*/
+		Utility::SlotHandle ActiveTriggerHandle;
+
+		/*
+			Current camera the view is at
+		*/
+		Utility::SlotHandle ActiveCameraHandle;
+
+		/*
+			Entity the player's view is set to. Either this player's own
+			camera entity or the shared one of a named camera.
+		*/
+		CTriggerCamera* ViewEntity = nullptr;
+
+		/*
+			Made the first time the player enters a trigger, and set up
+			again from whichever camera the player switches to.
+		*/
+		CTriggerCamera* OwnCamera = nullptr;
+
+		bool InCameraPreview = false;
+
+		/*
+			Player bounds at the last occupancy check, a player that
+			hasn't moved since doesn't need checking again.
+		*/
+		Vector LastMin;
+		Vector LastMax;
+		size_t LastIndexVersion = static_cast<size_t>(-1);
+
+		/*
+			The map is sent to the player's client in batches spread over
+			frames rather than a message per item, which overflows the
+			reliable channel on big maps. Starts when the player is first
+			updated, the client predicts camera switches with it.
+		*/
+		struct
+		{
+			bool Started = false;
+
+			std::vector<size_t> CameraIDs;
+			std::vector<size_t> TriggerIDs;
+
+			size_t NextCamera = 0;
+			size_t NextTrigger = 0;
+		} MapSync;
+	};
+
 	/*
 		Current level state, is reset every map change.
 	*/
 	struct MapCam
 	{
-		std::unordered_map<size_t, Cam::MapTrigger> Triggers;
-		std::unordered_map<size_t, Cam::MapCamera> Cameras;
+		Utility::SlotMap<Cam::MapTrigger> Triggers;
+		Utility::SlotMap<Cam::MapCamera> Cameras;
+
+		/*
+			Spatial index of all finished triggers, used to find
+			which trigger the player is in without checking every one.
+		*/
+		Utility::AABBTree TriggerTree;
+
+		/*
+			Bounds of all finished triggers by ID, kept apart from
+			the triggers for tests that only need their boxes.
+		*/
+		Utility::BoxArray TriggerBounds;
+
+		/*
+			Triggers close enough to each other that the player can walk
+			from one into the other. Edits only mark it out of date, it is
+			rebuilt once the player moves through the map again.
+		*/
+		Utility::BoxGraph TriggerGraph;
+		bool TriggerGraphDirty = true;
+
+		void BuildTriggerGraph()
+		{
+			/*
+				About how far the player can run in a couple of frames.
+			*/
+			const float margin = 32;
+
+			TriggerGraph.Build(TriggerTree, TriggerBounds, margin);
+			TriggerGraphDirty = false;
+		}
+
+		/*
+			Set when the tree came with a compiled map and
+			only the rest of the index needs to be built.
+		*/
+		bool TriggerTreeLoaded = false;
+
+		void BuildTriggerTree()
+		{
+			std::vector<std::pair<size_t, Utility::AABB>> items;
+
+			/*
+				A loaded tree whose leaves differ from the triggers would
+				have lookups miss them, it is built again instead.
+			*/
+			if (TriggerTreeLoaded)
+			{
+				for (const auto& trig : Triggers)
+				{
+					auto box = TriggerTree.FindBox(trig.ID);
+
+					if (!box || !LocalUtility::SameBox(*box, LocalUtility::MakeBox(trig.MinPos, trig.MaxPos)))
+					{
+						TriggerTreeLoaded = false;
+						break;
+					}
+				}
+			}
+
+			if (!TriggerTreeLoaded)
+			{
+				items.reserve(Triggers.GetCount());
+			}
+
+			TriggerBounds.Clear();
+
+			for (const auto& trig : Triggers)
+			{
+				auto box = LocalUtility::MakeBox(trig.MinPos, trig.MaxPos);
+
+				if (!TriggerTreeLoaded)
+				{
+					items.emplace_back(trig.ID, box);
+				}
+
+				TriggerBounds.Set(trig.ID, box);
+			}
+
+			if (!TriggerTreeLoaded)
+			{
+				TriggerTree.Build(items);
+			}
+
+			TriggerTreeLoaded = false;
+			TriggerIndexVersion++;
+
+			BuildTriggerGraph();
+		}
+
+		/*
+			Call after a trigger has changed its corners.
+		*/
+		void UpdateTriggerBounds(const Cam::MapTrigger& trigger)
+		{
+			auto box = LocalUtility::MakeBox(trigger.MinPos, trigger.MaxPos);
+
+			TriggerTree.Update(trigger.ID, box);
+			TriggerBounds.Set(trigger.ID, box);
+
+			TriggerGraphDirty = true;
+			TriggerIndexVersion++;
+		}
+
+		/*
+			Bumped whenever a trigger is added, moved or removed so
+			players standing still know to look again.
+		*/
+		size_t TriggerIndexVersion = 0;
 
 		std::string CurrentMapName;
 
 		/*
-			Current trigger the player is inside
+			Camera state of every player slot, indexed by entity index - 1.
 		*/
-		Cam::MapTrigger* ActiveTrigger = nullptr;
+		PlayerCamState PlayerStates[MaxPlayers];
 
 		/*
-			Current camera the view is at
+			Starts over if the slot now belongs to a different player.
+		*/
+		PlayerCamState& GetPlayerState(CBasePlayer* player)
+		{
+			auto& state = PlayerStates[player->entindex() - 1];
+
+			if (state.Player != player)
+			{
+				state = PlayerCamState();
+				state.Player = player;
+			}
+
+			return state;
+		}
+
+		/*
+			The player that edits the map.
+		*/
+		PlayerCamState& GetLocalState()
+		{
+			return GetPlayerState(LocalPlayer);
+		}
+
+		/*
+			Null once the item has been removed.
+		*/
+		Cam::MapTrigger* GetActiveTrigger(const PlayerCamState& state)
+		{
+			return Triggers.Get(state.ActiveTriggerHandle);
+		}
+
+		Cam::MapCamera* GetActiveCamera(const PlayerCamState& state)
+		{
+			return Cameras.Get(state.ActiveCameraHandle);
+		}
+
+		/*
+			Camera the editing player is looking through.
 		*/
-		Cam::MapCamera* ActiveCamera = nullptr;
+		Cam::MapCamera* GetLocalActiveCamera()
+		{
+			return GetActiveCamera(GetLocalState());
+		}
+
+		void SetActiveTrigger(PlayerCamState& state, const Cam::MapTrigger* trigger)
+		{
+			state.ActiveTriggerHandle = trigger ? Triggers.GetHandle(trigger->ID) : Utility::SlotHandle();
+		}
+
+		void SetActiveCamera(PlayerCamState& state, const Cam::MapCamera* camera)
+		{
+			state.ActiveCameraHandle = camera ? Cameras.GetHandle(camera->ID) : Utility::SlotHandle();
+		}
 
 		bool IsEditing = false;
 
@@ -191,8 +371,6 @@ namespace
 		int CurrentSelectionTriggerID = -1;
 		int CurrentSelectionCameraID = -1;
 
-		bool InCameraPreview = false;
-
 		bool AddingTriggerToCamera = false;
 
 		void UnHighlightAll()
@@ -218,8 +396,6 @@ namespace
 			CurrentSelectionTriggerID = -1;
 		}
 
-		bool NeedsToSendResetMessage = false;
-
 		/*
 			Current trigger the player is making, in between
 			part 1 and 2 states
@@ -232,177 +408,430 @@ namespace
 		size_t NextTriggerID = 0;
 		size_t NextCameraID = 0;
 
+		/*
+			The app has to be sent the whole map the next time edit mode starts.
+		*/
 		bool NeedsToSendMapUpdate = false;
 
-		void SendMapUpdate()
+		enum
 		{
-			if (!Cameras.empty())
-			{
-				for (const auto& camitr : Cameras)
-				{
-					const auto& cam = camitr.second;
+			/*
+				Most data the engine allows in one user message.
+			*/
+			MaxUserMessageSize = 192,
 
-					MESSAGE_BEGIN(MSG_ONE, HLCamMessage::CreateCamera, nullptr, LocalPlayer->pev);
+			/*
+				Message type and size the engine adds in front of the data.
+			*/
+			UserMessageOverhead = 2,
 
-					bool isnamed = cam.TriggerType == Cam::Shared::CameraTriggerType::ByName;
+			SyncCameraSize = 18,
+			SyncTriggerSize = 16,
 
-					WRITE_SHORT(cam.ID);
-					WRITE_BYTE(isnamed);
+			/*
+				Client stores names in 64 chars.
+			*/
+			MaxSyncNameLength = 63,
+		};
 
-					WRITE_COORD(cam.Position.x);
-					WRITE_COORD(cam.Position.y);
-					WRITE_COORD(cam.Position.z);
+		/*
+			Items are looked up again when their batch is sent, so
+			edits made meanwhile go out with them.
+		*/
+		void BeginMapUpdate(PlayerCamState& state)
+		{
+			auto& sync = state.MapSync;
 
-					WRITE_COORD(cam.Angle.x);
-					WRITE_COORD(cam.Angle.y);
-					WRITE_COORD(cam.Angle.z);
+			sync.Started = true;
 
-					if (isnamed)
-					{
-						WRITE_STRING(cam.Name.c_str());
-					}
+			sync.CameraIDs.clear();
+			sync.TriggerIDs.clear();
 
-					MESSAGE_END();
-				}
-			}
+			sync.NextCamera = 0;
+			sync.NextTrigger = 0;
 
-			if (!Triggers.empty())
+			for (const auto& cam : Cameras)
 			{
-				for (const auto& trigitr : Triggers)
-				{
-					const auto& trig = trigitr.second;
-
-					/*
-						Part 0
-					*/
-					MESSAGE_BEGIN(MSG_ONE, HLCamMessage::CreateTrigger, nullptr, LocalPlayer->pev);
-
-					WRITE_BYTE(0);
-
-					WRITE_SHORT(trig.ID);
-					WRITE_SHORT(trig.LinkedCameraID);
-
-					MESSAGE_END();
-
-					/*
-						Part 1
-					*/
-					MESSAGE_BEGIN(MSG_ONE, HLCamMessage::CreateTrigger, nullptr, LocalPlayer->pev);
-
-					WRITE_BYTE(1);
-
-					WRITE_COORD(trig.Corner1.x);
-					WRITE_COORD(trig.Corner1.y);
-					WRITE_COORD(trig.Corner1.z);
-
-					MESSAGE_END();
-
-					/*
-						Part 2
-					*/
-					MESSAGE_BEGIN(MSG_ONE, HLCamMessage::CreateTrigger, nullptr, LocalPlayer->pev);
-
-					WRITE_BYTE(2);
-
-					WRITE_COORD(trig.Corner2.x);
-					WRITE_COORD(trig.Corner2.y);
-					WRITE_COORD(trig.Corner2.z);
+				sync.CameraIDs.push_back(cam.ID);
+			}
 
-					MESSAGE_END();
-				}
+			for (const auto& trig : Triggers)
+			{
+				sync.TriggerIDs.push_back(trig.ID);
 			}
 		}
 
-		void GoFirstPerson()
+		/*
+			Adds changed items to the update being sent, or starts one.
+			The client replaces items it already has, one that has not
+			started gets them with the rest of the map.
+		*/
+		void QueueMapUpdate(PlayerCamState& state, const std::vector<size_t>& cameraids, const std::vector<size_t>& triggerids)
 		{
-			if (!LocalPlayer)
+			auto& sync = state.MapSync;
+
+			if (!sync.Started)
 			{
 				return;
 			}
 
-			if (ActiveTrigger)
-			{
-				ActiveTrigger->Active = false;
-				ActiveTrigger = nullptr;
-			}
+			sync.CameraIDs.insert(sync.CameraIDs.end(), cameraids.begin(), cameraids.end());
+			sync.TriggerIDs.insert(sync.TriggerIDs.end(), triggerids.begin(), triggerids.end());
+		}
 
-			if (ActiveCamera)
+		/*
+			Every player but "skipplayer", if any.
+		*/
+		void QueueMapUpdate(const std::vector<size_t>& cameraids, const std::vector<size_t>& triggerids, const CBasePlayer* skipplayer = nullptr)
+		{
+			for (auto& state : PlayerStates)
 			{
-				if (InCameraPreview)
+				if (state.Player && state.Player != skipplayer)
 				{
-					InCameraPreview = false;
-
-					MESSAGE_BEGIN(MSG_ONE, HLCamMessage::CameraPreview, nullptr, LocalPlayer->pev);
-
-					WRITE_SHORT(ActiveCamera->ID);
-					WRITE_BYTE(0);
-
-					MESSAGE_END();
+					QueueMapUpdate(state, cameraids, triggerids);
 				}
-
-				ActiveCamera->TargetCamera->Use(nullptr, nullptr, USE_OFF, 0);
-				ActiveCamera = nullptr;
 			}
 		}
 
-		Cam::MapTrigger* FindTriggerByID(size_t id)
+		bool IsSendingMapUpdate(const PlayerCamState& state) const
 		{
-			auto it = Triggers.find(id);
+			const auto& sync = state.MapSync;
 
-			if (it != Triggers.end())
-			{
-				return &it->second;
-			}
-		
-			return nullptr;
+			return sync.NextCamera < sync.CameraIDs.size() ||
+				   sync.NextTrigger < sync.TriggerIDs.size();
 		}
 
-		Cam::MapCamera* FindCameraByID(size_t id)
+		size_t GetSyncSize(const Cam::MapCamera& camera) const
 		{
-			auto it = Cameras.find(id);
+			size_t ret = SyncCameraSize;
 
-			if (it != Cameras.end())
+			if (camera.TriggerType == Cam::Shared::CameraTriggerType::ByName)
 			{
-				return &it->second;
+				ret += (camera.Name.size() < MaxSyncNameLength ? camera.Name.size() : MaxSyncNameLength) + 1;
 			}
 
-			return nullptr;
+			return ret;
 		}
 
-		Cam::MapCamera* GetLinkedCamera(const Cam::MapTrigger& trigger)
+		/*
+			Sends batches until "bytebudget" is used up, at least one per
+			call. All cameras go before any trigger as triggers are added
+			to their camera on the client.
+		*/
+		void SendMapUpdate(PlayerCamState& state, size_t bytebudget)
 		{
-			return FindCameraByID(trigger.LinkedCameraID);
-		}
+			auto& sync = state.MapSync;
 
-		std::vector<Cam::MapTrigger*> GetLinkedTriggers(const Cam::MapCamera& camera)
-		{
-			std::vector<Cam::MapTrigger*> ret;
+			std::vector<const Cam::MapCamera*> batchcameras;
+			std::vector<const Cam::MapTrigger*> batchtriggers;
 
-			for (auto& trigid : camera.LinkedTriggerIDs)
+			size_t sent = 0;
+
+			while (IsSendingMapUpdate(state))
 			{
-				ret.push_back(FindTriggerByID(trigid));
-			}
+				batchcameras.clear();
+				batchtriggers.clear();
 
-			return ret;
-		}
+				/*
+					Camera and trigger count.
+				*/
+				size_t batchsize = 2;
 
-		void RemoveTriggerFromID(size_t triggerid)
-		{
-			MESSAGE_BEGIN(MSG_ONE, HLCamMessage::RemoveTrigger, nullptr, LocalPlayer->pev);
-			WRITE_SHORT(triggerid);
-			MESSAGE_END();
+				auto nextcamera = sync.NextCamera;
+				auto nexttrigger = sync.NextTrigger;
 
-			if (triggerid == CurrentHighlightTriggerID)
-			{
-				UnHighlightAll();
-			}
+				while (nextcamera < sync.CameraIDs.size())
+				{
+					auto cam = Cameras.Find(sync.CameraIDs[nextcamera]);
 
-			Triggers.erase(triggerid);
-		}
+					if (!cam)
+					{
+						nextcamera++;
+						continue;
+					}
 
-		/*
-			Also removes its linked triggers if it's
-			of that type.
+					auto itemsize = GetSyncSize(*cam);
+
+					if (batchsize + itemsize > MaxUserMessageSize)
+					{
+						break;
+					}
+
+					batchsize += itemsize;
+					batchcameras.push_back(cam);
+
+					nextcamera++;
+				}
+
+				if (nextcamera == sync.CameraIDs.size())
+				{
+					while (nexttrigger < sync.TriggerIDs.size())
+					{
+						auto trig = Triggers.Find(sync.TriggerIDs[nexttrigger]);
+
+						if (!trig)
+						{
+							nexttrigger++;
+							continue;
+						}
+
+						if (batchsize + SyncTriggerSize > MaxUserMessageSize)
+						{
+							break;
+						}
+
+						batchsize += SyncTriggerSize;
+						batchtriggers.push_back(trig);
+
+						nexttrigger++;
+					}
+				}
+
+				batchsize += UserMessageOverhead;
+
+				if (sent != 0 && sent + batchsize > bytebudget)
+				{
+					break;
+				}
+
+				sync.NextCamera = nextcamera;
+				sync.NextTrigger = nexttrigger;
+
+				/*
+					Everything left had been removed.
+				*/
+				if (batchcameras.empty() && batchtriggers.empty())
+				{
+					continue;
+				}
+
+				MESSAGE_BEGIN(MSG_ONE, HLCamMessage::MapSync, nullptr, state.Player->pev);
+
+				WRITE_BYTE(batchcameras.size());
+
+				for (auto cam : batchcameras)
+				{
+					bool isnamed = cam->TriggerType == Cam::Shared::CameraTriggerType::ByName;
+
+					WRITE_SHORT(cam->ID);
+					WRITE_BYTE(isnamed);
+
+					WRITE_COORD(cam->Position.x);
+					WRITE_COORD(cam->Position.y);
+					WRITE_COORD(cam->Position.z);
+
+					WRITE_COORD(cam->Angle.x);
+					WRITE_COORD(cam->Angle.y);
+					WRITE_COORD(cam->Angle.z);
+
+					/*
+						Clients only move their view to cameras whose view
+						doesn't depend on anything but these.
+					*/
+					WRITE_BYTE(static_cast<int>(cam->LookType));
+					WRITE_BYTE(static_cast<int>(cam->ZoomType));
+					WRITE_BYTE(cam->UseAttachment);
+
+					if (isnamed)
+					{
+						WRITE_STRING(cam->Name.substr(0, MaxSyncNameLength).c_str());
+					}
+				}
+
+				WRITE_BYTE(batchtriggers.size());
+
+				for (auto trig : batchtriggers)
+				{
+					WRITE_SHORT(trig->ID);
+					WRITE_SHORT(trig->LinkedCameraID);
+
+					WRITE_COORD(trig->Corner1.x);
+					WRITE_COORD(trig->Corner1.y);
+					WRITE_COORD(trig->Corner1.z);
+
+					WRITE_COORD(trig->Corner2.x);
+					WRITE_COORD(trig->Corner2.y);
+					WRITE_COORD(trig->Corner2.z);
+				}
+
+				MESSAGE_END();
+
+				sent += batchsize;
+			}
+
+			if (!IsSendingMapUpdate(state))
+			{
+				sync.CameraIDs.clear();
+				sync.TriggerIDs.clear();
+
+				sync.NextCamera = 0;
+				sync.NextTrigger = 0;
+			}
+		}
+
+		void GoFirstPerson(PlayerCamState& state)
+		{
+			if (!state.Player)
+			{
+				return;
+			}
+
+			SetActiveTrigger(state, nullptr);
+
+			auto activecamera = GetActiveCamera(state);
+
+			if (activecamera && state.InCameraPreview)
+			{
+				MESSAGE_BEGIN(MSG_ONE, HLCamMessage::CameraPreview, nullptr, state.Player->pev);
+
+				WRITE_SHORT(activecamera->ID);
+				WRITE_BYTE(0);
+
+				MESSAGE_END();
+			}
+
+			state.InCameraPreview = false;
+
+			if (state.ViewEntity)
+			{
+				state.ViewEntity->Use(state.Player, nullptr, USE_OFF, 0);
+				state.ViewEntity = nullptr;
+			}
+
+			SetActiveCamera(state, nullptr);
+		}
+
+		Cam::MapTrigger* FindTriggerByID(size_t id)
+		{
+			return Triggers.Find(id);
+		}
+
+		Cam::MapCamera* FindCameraByID(size_t id)
+		{
+			return Cameras.Find(id);
+		}
+
+		Cam::MapCamera* GetLinkedCamera(const Cam::MapTrigger& trigger)
+		{
+			return FindCameraByID(trigger.LinkedCameraID);
+		}
+
+		std::vector<Cam::MapTrigger*> GetLinkedTriggers(const Cam::MapCamera& camera)
+		{
+			std::vector<Cam::MapTrigger*> ret;
+
+			for (auto& trigid : camera.LinkedTriggerIDs)
+			{
+				ret.push_back(FindTriggerByID(trigid));
+			}
+
+			return ret;
+		}
+
+		/*
+			Saved settings of a camera, without its triggers.
+		*/
+		Cam::Shared::MapCameraData CreateCameraData(const Cam::MapCamera& cam)
+		{
+			Cam::Shared::MapCameraData ret;
+
+			ret.ID = static_cast<uint32_t>(cam.ID);
+
+			ret.Position = LocalUtility::MakeMapVector(cam.Position);
+			ret.Angle = LocalUtility::MakeMapVector(cam.Angle);
+
+			ret.Name = cam.Name;
+
+			ret.TriggerType = cam.TriggerType;
+			ret.LookType = cam.LookType;
+			ret.PlaneType = cam.PlaneType;
+			ret.ZoomType = cam.ZoomType;
+
+			ret.FOV = cam.FOV;
+			ret.MaxSpeed = cam.MaxSpeed;
+
+			ret.ZoomTime = cam.ZoomData.ZoomTime;
+			ret.ZoomEndFOV = cam.ZoomData.EndFov;
+			ret.ZoomInterpMethod = cam.ZoomData.InterpMethod;
+
+			ret.LookTargetName = cam.LookTargetData.Name;
+
+			ret.UseAttachment = cam.UseAttachment;
+			ret.AttachmentTargetName = cam.AttachmentData.Name;
+			ret.AttachmentOffset = LocalUtility::MakeMapVector(cam.AttachmentData.Offset);
+
+			return ret;
+		}
+
+		Cam::Shared::MapTriggerData CreateTriggerData(const Cam::MapTrigger& trig)
+		{
+			Cam::Shared::MapTriggerData ret;
+
+			ret.ID = static_cast<uint32_t>(trig.ID);
+			ret.Corner1 = LocalUtility::MakeMapVector(trig.Corner1);
+			ret.Corner2 = LocalUtility::MakeMapVector(trig.Corner2);
+
+			return ret;
+		}
+
+		/*
+			Copy of everything that is saved to disk.
+		*/
+		Cam::Shared::MapData CreateMapData()
+		{
+			Cam::Shared::MapData ret;
+			ret.Cameras.reserve(Cameras.GetCount());
+
+			for (const auto& cam : Cameras)
+			{
+				auto camdata = CreateCameraData(cam);
+
+				if (cam.TriggerType == Cam::Shared::CameraTriggerType::ByUserTrigger)
+				{
+					camdata.Triggers.reserve(cam.LinkedTriggerIDs.size());
+
+					for (const auto& trigid : cam.LinkedTriggerIDs)
+					{
+						auto linkedtrig = FindTriggerByID(trigid);
+
+						if (!linkedtrig)
+						{
+							continue;
+						}
+
+						camdata.Triggers.push_back(CreateTriggerData(*linkedtrig));
+					}
+				}
+
+				ret.Cameras.push_back(std::move(camdata));
+			}
+
+			return ret;
+		}
+
+		void RemoveTriggerFromID(size_t triggerid)
+		{
+			MESSAGE_BEGIN(MSG_ALL, HLCamMessage::RemoveTrigger);
+			WRITE_SHORT(triggerid);
+			MESSAGE_END();
+
+			if (triggerid == CurrentHighlightTriggerID)
+			{
+				UnHighlightAll();
+			}
+
+			TriggerTree.Remove(triggerid);
+			TriggerBounds.Remove(triggerid);
+
+			TriggerGraphDirty = true;
+			TriggerIndexVersion++;
+
+			Triggers.Remove(triggerid);
+		}
+
+		/*
+			Also removes its linked triggers if it's
+			of that type.
 		*/
 		void RemoveCamera(Cam::MapCamera* camera)
 		{
@@ -411,14 +840,16 @@ namespace
 				return;
 			}
 
-			MESSAGE_BEGIN(MSG_ONE, HLCamMessage::RemoveCamera, nullptr, LocalPlayer->pev);
+			MESSAGE_BEGIN(MSG_ALL, HLCamMessage::RemoveCamera);
 			WRITE_SHORT(camera->ID);
 			MESSAGE_END();
 
-			if (camera == ActiveCamera)
+			for (auto& state : PlayerStates)
 			{
-				ActiveCamera->TargetCamera->Use(nullptr, nullptr, USE_OFF, 0);
-				ActiveCamera = nullptr;
+				if (state.Player && camera == GetActiveCamera(state))
+				{
+					GoFirstPerson(state);
+				}
 			}
 
 			if (camera->TargetCamera)
@@ -437,7 +868,7 @@ namespace
 				}
 			}
 
-			Cameras.erase(camera->ID);
+			Cameras.Remove(camera->ID);
 		}
 
 		Cam::Shared::StateType CurrentState = Cam::Shared::StateType::Inactive;
@@ -446,577 +877,1117 @@ namespace
 		Shared::Interprocess::Server GameServer;
 
 		/*
-			Add a function to be run in the main thread.
+			Batches from scripts, apart from the editor's connection so
+			both can be used at once. Results go to each script's own.
 		*/
-		void InvokeMessageFunction(std::function<void()>&& func);
+		Shared::Interprocess::Server ScriptServer;
 
-		std::vector<std::function<void()>> InvokeList;
+		/*
+			Add a function to be run in the main thread.
+		*/
+		template <typename Func>
+		void InvokeMessageFunction(Func&& func);
 
-		Utility::BinaryBuffer GetInterprocessTriggerInfo(const Cam::MapTrigger& trigger)
+		Cam::Shared::Schema::TriggerLink GetInterprocessTriggerInfo(const Cam::MapTrigger& trigger)
 		{
-			return Utility::BinaryBufferHelp::CreatePacket
-			(
-				trigger.ID,
-				trigger.LinkedCameraID
-			);
+			Cam::Shared::Schema::TriggerLink ret;
+
+			ret.ID = static_cast<uint32_t>(trigger.ID);
+			ret.CameraID = static_cast<uint32_t>(trigger.LinkedCameraID);
+
+			return ret;
 		}
 
-		Utility::BinaryBuffer GetInterprocessCameraInfo(const Cam::MapCamera& camera)
+		/*
+			Every camera for the app, which replaces what it had.
+		*/
+		Utility::BinaryBuffer GetInterprocessMapSnapshot()
 		{
-			Utility::BinaryBuffer ret;
+			Cam::Shared::Schema::MapSnapshot snapshot;
+			snapshot.Name = CurrentMapName;
+			snapshot.Cameras.reserve(Cameras.GetCount());
+
+			for (const auto& cam : Cameras)
+			{
+				snapshot.Cameras.push_back(GetInterprocessCameraInfo(cam));
+			}
 
-			ret << camera.ID;
+			Utility::BinaryBuffer ret;
+			Cam::Shared::Schema::EncodePacket(ret, snapshot);
 
-			ret << static_cast<unsigned char>(camera.LinkedTriggerIDs.size());
+			return ret;
+		}
 
-			for (const auto& trigid : camera.LinkedTriggerIDs)
+		/*
+			Tells the app to drop its map and sends the whole of this one
+			as a snapshot, chunks that don't fit now go out in later frames.
+			A snapshot still being sent is replaced.
+		*/
+		void SendMapReset()
+		{
+			if (!GameServer.IsStarted())
 			{
-				ret << trigid;
+				return;
 			}
 
-			ret << camera.MaxSpeed;
-			ret << camera.FOV;
+			GameServer.Write
+			(
+				Cam::Shared::Messages::Game::OnEditModeStarted,
+				Utility::BinaryBufferHelp::CreatePacket(true)
+			);
 
-			ret << camera.Position.x;
-			ret << camera.Position.y;
-			ret << camera.Position.z;
-			
-			ret << camera.Angle.x;
-			ret << camera.Angle.y;
-			ret << camera.Angle.z;
+			PendingSnapshot = std::make_unique<Shared::Interprocess::SnapshotWriter>(NextSnapshotID++, GetInterprocessMapSnapshot());
+
+			const auto& stats = PendingSnapshot->GetStats();
 
-			ret << static_cast<unsigned char>(camera.TriggerType);
-			ret << static_cast<unsigned char>(camera.LookType);
-			ret << static_cast<unsigned char>(camera.PlaneType);
-			ret << static_cast<unsigned char>(camera.ZoomType);
+			g_engfuncs.pfnAlertMessage
+			(
+				at_aiconsole,
+				"HLCAM: Map snapshot of %u cameras, %u bytes compressed to %u in %u chunks (%.2f ms)\n",
+				static_cast<unsigned int>(Cameras.GetCount()),
+				static_cast<unsigned int>(stats.Size),
+				static_cast<unsigned int>(stats.CompressedSize),
+				static_cast<unsigned int>(stats.ChunkCount),
+				stats.CompressMilliseconds
+			);
 
-			ret << static_cast<unsigned char>(camera.ZoomData.InterpMethod);
-			ret << camera.ZoomData.EndFov;
-			ret << camera.ZoomData.ZoomTime;
+			SendMapSnapshot();
+		}
 
-			if (camera.TriggerType == Cam::Shared::CameraTriggerType::ByName)
+		/*
+			Run every frame until the whole snapshot is written.
+		*/
+		void SendMapSnapshot()
+		{
+			if (!PendingSnapshot)
 			{
-				ret << camera.Name;
+				return;
 			}
 
-			if (camera.LookType == Cam::Shared::CameraLookType::AtTarget)
+			if (!GameServer.IsStarted() || PendingSnapshot->WriteChunks(GameServer, Cam::Shared::Messages::Game::OnMapSnapshot))
 			{
-				ret << camera.LookTargetData.Name;
+				PendingSnapshot.reset();
 			}
+		}
+
+		std::unique_ptr<Shared::Interprocess::SnapshotWriter> PendingSnapshot;
+		uint32_t NextSnapshotID = 0;
 
-			ret << camera.UseAttachment;
+		/*
+			Saved settings and the IDs of the linked triggers, the app
+			has no use for the trigger bounds.
+		*/
+		Cam::Shared::MapCameraData GetInterprocessCameraInfo(const Cam::MapCamera& camera)
+		{
+			auto ret = CreateCameraData(camera);
+			ret.Triggers.resize(camera.LinkedTriggerIDs.size());
 
-			if (camera.UseAttachment)
+			for (size_t i = 0; i < camera.LinkedTriggerIDs.size(); i++)
 			{
-				ret << camera.AttachmentData.Name;
-				ret << camera.AttachmentData.Offset.x;
-				ret << camera.AttachmentData.Offset.y;
-				ret << camera.AttachmentData.Offset.z;
+				ret.Triggers[i].ID = static_cast<uint32_t>(camera.LinkedTriggerIDs[i]);
 			}
 
 			return ret;
 		}
 
+		/*
+			Records for one message, in a pooled buffer sized for all of them.
+		*/
+		template <typename... Records>
+		Utility::BinaryBuffer CreateInterprocessPacket(const Records&... records)
+		{
+			auto ret = GameServer.AcquireBuffer();
+			Cam::Shared::Schema::EncodePacket(ret, records...);
+
+			return ret;
+		}
+
 		float NextAutoSaveTime;
+
+		/*
+			The camera file was changed outside the game and has
+			to be compared against what is loaded.
+		*/
+		bool MapFileChanged = false;
+
+		/*
+			Entities cameras look at or follow, found by target name once
+			instead of on every camera switch. Handles of removed entities
+			turn null on their own.
+		*/
+		std::unordered_map<std::string, EHANDLE> NamedEntities;
 	};
 
 	namespace Commands
 	{
 		cvar_t UseAutoSave = {"hlcam_autosave", "0", FCVAR_ARCHIVE};
 		cvar_t AutoSaveInterval = {"hlcam_autosave_interval", "30", FCVAR_ARCHIVE};
-	}
-
-	static std::mutex MessageInvokeMutex;
 
-	void MapCam::InvokeMessageFunction(std::function<void()>&& func)
-	{
-		std::lock_guard<std::mutex> g(MessageInvokeMutex);
-		InvokeList.emplace_back(std::move(func));
-	}
-
-	static std::thread MessageHandlerThread;
-	static std::atomic_bool ShouldCloseMessageThread{false};
-	static std::atomic_bool ShouldPauseMessageThread{false};
-	static MapCam TheCamMap;
-	
-	static Cam::RestoreData CameraRestore;
-	static bool NeedsRestore = false;
+		/*
+			Journal size in bytes after which the map is saved in full.
+		*/
+		cvar_t JournalCompactSize = {"hlcam_journal_compactsize", "65536", FCVAR_ARCHIVE};
 
-	constexpr auto DeepIdleSleepTime = 1000ms;
-	constexpr auto IdleSleepTime = 100ms;
-	constexpr auto WorkSleepTime = 1ms;
+		/*
+			Map data sent to each client per frame while it is given the map.
+		*/
+		cvar_t MapSyncBytesPerFrame = {"hlcam_sync_bytesperframe", "1024", FCVAR_ARCHIVE};
 
-	static auto MessageThreadSleepTime = IdleSleepTime;
+		/*
+			Times per second cameras that follow something correct their aim.
+		*/
+		cvar_t CameraTrackRate = {"hlcam_trackrate", "20", FCVAR_ARCHIVE};
+	}
 
-	bool EnsureInactiveState()
+	/*
+		Name from an app message, cut to the 63 characters the client
+		keeps so a task can hold it without allocating.
+	*/
+	struct MessageName
 	{
-		if (TheCamMap.CurrentState != Cam::Shared::StateType::Inactive)
+		explicit MessageName(const Utility::StringView& view)
 		{
-			g_engfuncs.pfnAlertMessage(at_console, "HLCAM: Map edit state should be inactive\n");
-			return false;
-		}
+			auto size = view.Size < sizeof(Text) - 1 ? view.Size : sizeof(Text) - 1;
 
-		return true;
-	}
+			if (size != 0)
+			{
+				std::memcpy(Text, view.Data, size);
+			}
 
-	bool EnsureEditMode()
-	{
-		if (!TheCamMap.IsEditing)
-		{
-			g_engfuncs.pfnAlertMessage(at_console, "HLCAM: Need to be in edit mode\n");
-			return false;
+			Text[size] = 0;
 		}
 
-		return true;
-	}
+		char Text[64];
+	};
 
-	void MessageHandler()
-	{
-		auto lastmessagetime = std::chrono::system_clock::now();
+	/*
+		App messages handed from the message thread to the game thread.
+		Captures are stored in place, the largest is an ID and a name.
+	*/
+	using MessageTask = Utility::InlineTask<sizeof(size_t) + sizeof(MessageName)>;
+	static Utility::SPSCQueue<MessageTask, 128> InvokeQueue;
 
-		while (!ShouldCloseMessageThread)
-		{
-			namespace Config = Shared::Interprocess::Config;
+	/*
+		Batches from the script thread, each queue has a single writer.
+	*/
+	static Utility::SPSCQueue<MessageTask, 16> ScriptQueue;
 
-			Config::MessageType message;
-			Utility::BinaryBuffer data;
+	static struct
+	{
+		size_t LastDepth = 0;
+		size_t MaxDepth = 0;
+		size_t Executed = 0;
 
-			auto res = TheCamMap.AppClient.TryRead(message, data);
+		double LastDrainTime = 0;
+		double MaxDrainTime = 0;
 
-			if (!res)
-			{
-				if (ShouldCloseMessageThread)
-				{
-					return;
-				}
+		/*
+			Times the message thread found the queue full and had to wait.
+		*/
+		std::atomic<size_t> FullWaits{0};
+	} InvokeStats;
 
-				if (ShouldPauseMessageThread)
-				{
-					while (ShouldPauseMessageThread)
-					{
-						std::this_thread::sleep_for(1ms);
-					}
-				}
+	static std::thread MessageHandlerThread;
+	static std::thread ScriptHandlerThread;
+	static std::atomic_bool ShouldCloseMessageThread{false};
 
-				auto now = std::chrono::system_clock::now();
+	/*
+		Holds the message thread between messages while the game thread
+		replaces the map, so nothing read for the old map is queued after
+		the queue was cleared. PauseMessageThreads returns once every
+		running thread has stopped.
+	*/
+	static struct
+	{
+		std::mutex Mutex;
+		std::condition_variable Changed;
 
-				std::chrono::duration<float> diff = now - lastmessagetime;
+		std::atomic_bool Requested{false};
 
-				if (diff.count() > 20)
-				{
-					MessageThreadSleepTime = DeepIdleSleepTime;
-				}
+		size_t Running = 0;
+		size_t Paused = 0;
+	} MessagePause;
 
-				std::this_thread::sleep_for(MessageThreadSleepTime);
-				continue;
-			}
+	/*
+		Called by a message thread between messages.
+	*/
+	void WaitWhilePaused()
+	{
+		if (!MessagePause.Requested)
+		{
+			return;
+		}
 
-			if (MessageThreadSleepTime != WorkSleepTime)
-			{
-				MessageThreadSleepTime = WorkSleepTime;
-			}
+		std::unique_lock<std::mutex> lock(MessagePause.Mutex);
 
-			lastmessagetime = std::chrono::system_clock::now();
+		MessagePause.Paused++;
+		MessagePause.Changed.notify_all();
 
-			namespace Message = Cam::Shared::Messages::App;
+		MessagePause.Changed.wait(lock, []
+		{
+			return !MessagePause.Requested;
+		});
 
-			switch (message)
-			{
-				case Message::OnAppShutdown:
-				{
-					break;
-				}
+		MessagePause.Paused--;
+	}
 
-				case Message::Trigger_Select:
-				{
-					auto triggerid = data.GetValue<size_t>();
+	/*
+		Only message threads wait when a queue is full, the
+		game thread empties them every frame without ever blocking.
+	*/
+	template <typename Queue, typename Func>
+	void PushMessageTask(Queue& queue, Func&& func)
+	{
+		MessageTask task(std::forward<Func>(func));
 
-					TheCamMap.InvokeMessageFunction([triggerid]
-					{
-						if (TheCamMap.CurrentSelectionTriggerID != triggerid)
-						{
-							TheCamMap.UnSelectAll();
+		if (queue.TryPush(std::move(task)))
+		{
+			return;
+		}
 
-							TheCamMap.CurrentSelectionTriggerID = triggerid;
+		InvokeStats.FullWaits++;
 
-							MESSAGE_BEGIN(MSG_ONE, HLCamMessage::ItemSelectedStart, nullptr, TheCamMap.LocalPlayer->pev);
+		while (!queue.TryPush(std::move(task)))
+		{
+			/*
+				The game thread won't empty the queue while it waits for a
+				pause, and the task is for the map that is going away.
+			*/
+			if (ShouldCloseMessageThread || MessagePause.Requested)
+			{
+				return;
+			}
 
-							WRITE_BYTE(0);
-							WRITE_SHORT(TheCamMap.CurrentSelectionTriggerID);
+			std::this_thread::sleep_for(1ms);
+		}
+	}
 
-							MESSAGE_END();
-						}
-					});
+	template <typename Func>
+	void MapCam::InvokeMessageFunction(Func&& func)
+	{
+		PushMessageTask(InvokeQueue, std::forward<Func>(func));
+	}
+	static MapCam TheCamMap;
+	
+	/*
+		Saves are serialized and written by a worker so the game never waits
+		on the disk. Outlives map changes as a save can still be running.
+	*/
+	static Cam::Shared::MapFile::AsyncWriter MapWriter;
 
-					break;
-				}
+	/*
+		Edits of the current map since its last full save, appended as each
+		edit is applied. Loading replays it over the saved map.
+	*/
+	static Cam::Shared::MapFile::JournalWriter MapJournal;
 
-				case Message::Camera_Select:
-				{
-					auto cameraid = data.GetValue<size_t>();
+	/*
+		Camera files changed outside the game are applied to the running
+		map. Our own saves are told apart by the stamp they left.
+	*/
+	static Cam::Shared::MapFile::DirectoryWatcher MapWatcher;
 
-					TheCamMap.InvokeMessageFunction([cameraid]
-					{
-						if (TheCamMap.CurrentSelectionCameraID != cameraid)
-						{
-							TheCamMap.UnSelectAll();
+	static struct
+	{
+		std::string Path;
+		Cam::Shared::MapFile::FileStamp Stamp;
+	} LastSavedFile;
 
-							TheCamMap.CurrentSelectionCameraID = cameraid;
+	static struct
+	{
+		/*
+			Time the game thread spends copying the map for a save.
+		*/
+		double LastSnapshotTime = 0;
+		double MaxSnapshotTime = 0;
+	} SaveStats;
 
-							MESSAGE_BEGIN(MSG_ONE, HLCamMessage::ItemSelectedStart, nullptr, TheCamMap.LocalPlayer->pev);
+	/*
+		How often a player's trigger was found without searching the whole map.
+	*/
+	static struct
+	{
+		/*
+			Server frames, and players in them that moved and had to be checked.
+		*/
+		size_t Passes = 0;
+		size_t PlayersChecked = 0;
+		size_t IdleSkips = 0;
 
-							WRITE_BYTE(1);
-							WRITE_SHORT(TheCamMap.CurrentSelectionCameraID);
+		Utility::TriggerLocator::Counters Lookups;
 
-							MESSAGE_END();
-						}
-					});
+		size_t GraphBuilds = 0;
+	} TriggerStats;
 
-					break;
-				}
+	/*
+		Camera target lookups, and how many of them had to walk the entity list.
+	*/
+	static struct
+	{
+		size_t CacheHits = 0;
+		size_t Scans = 0;
+	} TargetStats;
 
-				case Message::Camera_StartMoveSequence:
-				{
-					auto cameraid = data.GetValue<size_t>();
+	/*
+		Time spent in the camera code, by where it is spent. Frame values
+		are for the last server frame and go to the CSV dump if there is one.
+	*/
+	struct TimingStat
+	{
+		TimingStat(const char* name) : Name(name)
+		{
 
-					TheCamMap.InvokeMessageFunction([cameraid]
-					{
-						if (!EnsureInactiveState())
-						{
-							return;
-						}
+		}
 
-						if (TheCamMap.CurrentSelectionCameraID == cameraid)
-						{
-							TheCamMap.CurrentState = Cam::Shared::StateType::AdjustingCamera;
+		void Add(double milliseconds)
+		{
+			Calls++;
+			Total += milliseconds;
+			FrameTime += milliseconds;
 
-							MESSAGE_BEGIN(MSG_ONE, HLCamMessage::CameraAdjust, nullptr, TheCamMap.LocalPlayer->pev);
+			if (milliseconds > Max)
+			{
+				Max = milliseconds;
+			}
+		}
 
-							WRITE_BYTE(0);
-							WRITE_SHORT(cameraid);
+		const char* Name;
 
-							MESSAGE_END();
-						}
-					});
+		size_t Calls = 0;
+		double Total = 0;
+		double Max = 0;
 
-					break;
-				}
+		double FrameTime = 0;
+	};
 
-				case Message::Camera_AddTriggerToCamera:
-				{
-					auto cameraid = data.GetValue<size_t>();
+	namespace Timing
+	{
+		enum Type
+		{
+			ServerFrame,
+			PreUpdate,
+			PostUpdate,
+			MapSync,
+			MessageDrain,
+			LoadMap,
+			SaveMap,
+
+			Count,
+		};
+	}
 
-					TheCamMap.InvokeMessageFunction([cameraid]
-					{
-						if (!EnsureInactiveState())
-						{
-							return;
-						}
+	static TimingStat Timings[Timing::Count] =
+	{
+		"serverframe",
+		"preupdate",
+		"postupdate",
+		"mapsync",
+		"messagedrain",
+		"loadmap",
+		"savemap",
+	};
 
-						if (TheCamMap.CurrentSelectionCameraID == cameraid)
-						{
-							TheCamMap.AddingTriggerToCamera = true;
+	class ScopedTiming
+	{
+	public:
+		ScopedTiming(Timing::Type type) :
+			Stat(Timings[type]),
+			Start(std::chrono::steady_clock::now())
+		{
 
-							Cam::MapTrigger newtrig;
-							newtrig.ID = TheCamMap.NextTriggerID;
-							newtrig.LinkedCameraID = cameraid;
+		}
 
-							auto& newcam = TheCamMap.Cameras[cameraid];
+		~ScopedTiming()
+		{
+			Stat.Add(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count());
+		}
 
-							newcam.LinkedTriggerIDs.push_back(newtrig.ID);
+	private:
+		TimingStat& Stat;
+		std::chrono::steady_clock::time_point Start;
+	};
 
-							TheCamMap.CurrentState = Cam::Shared::StateType::NeedsToCreateTriggerCorner1;
+	/*
+		One row per server frame while hlcam_stats csv is on.
+		Message counts are those of the frame, not running totals.
+	*/
+	static struct
+	{
+		std::ofstream File;
+		std::string Path;
 
-							MESSAGE_BEGIN(MSG_ONE, HLCamMessage::CreateTrigger, nullptr, TheCamMap.LocalPlayer->pev);
+		size_t Rows = 0;
 
-							WRITE_BYTE(0);
+		Shared::Interprocess::PeerStats LastApp;
+		Shared::Interprocess::PeerStats LastGame;
 
-							WRITE_SHORT(newtrig.ID);
-							WRITE_SHORT(cameraid);
+		size_t LastExecuted = 0;
+		size_t LastFullWaits = 0;
+		size_t LastPlayersChecked = 0;
+		size_t LastTargetScans = 0;
+		Utility::TriggerLocator::Counters LastLookups;
+	} StatsDump;
 
-							MESSAGE_END();
+	/*
+		Kept apart from the map state, players are restored before the
+		map they were saved in is loaded again.
+	*/
+	static struct
+	{
+		size_t TriggerID = 0;
+		bool NeedsRestore = false;
+	} PendingRestores[MaxPlayers];
 
-							TheCamMap.CreationTriggerID = newtrig.ID;
+	/*
+		Longest a message thread waits for a message. Closing
+		and pausing wake them up right away.
+	*/
+	constexpr auto MessageWaitTime = 100ms;
 
-							TheCamMap.Triggers[TheCamMap.NextTriggerID] = std::move(newtrig);
+	void QueueMapSave();
 
-							TheCamMap.NextTriggerID++;
-						}
-					});
+	/*
+		An edit that could not be journaled is kept by saving the whole map.
+	*/
+	void CheckJournalWrite(bool success)
+	{
+		if (!success)
+		{
+			g_engfuncs.pfnAlertMessage(at_console, "HLCAM: Could not write to camera map journal, saving full map\n");
+			QueueMapSave();
+		}
+	}
 
-					break;
-				}
+	/*
+		Every edit passes through here, so it is also where it is sent to
+		the other players. The editing client is told of its own edits
+		apart, a whole item from a map update would clear its selection.
+	*/
+	void JournalCamera(const Cam::MapCamera& camera)
+	{
+		TheCamMap.QueueMapUpdate({camera.ID}, {}, TheCamMap.LocalPlayer);
 
-				case Message::SetViewToCamera:
-				{
-					auto cameraid = data.GetValue<size_t>();
+		if (MapJournal.IsOpen())
+		{
+			CheckJournalWrite(MapJournal.SetCamera(TheCamMap.CreateCameraData(camera)));
+		}
+	}
 
-					TheCamMap.InvokeMessageFunction([cameraid]
-					{
-						if (!EnsureInactiveState())
-						{
-							return;
-						}
+	void JournalTrigger(const Cam::MapTrigger& trigger)
+	{
+		TheCamMap.QueueMapUpdate({}, {trigger.ID}, TheCamMap.LocalPlayer);
 
-						if (TheCamMap.CurrentSelectionCameraID == cameraid)
-						{
-							auto& camera = TheCamMap.Cameras[cameraid];
+		if (MapJournal.IsOpen())
+		{
+			auto cameraid = static_cast<uint32_t>(trigger.LinkedCameraID);
+			CheckJournalWrite(MapJournal.SetTrigger(cameraid, TheCamMap.CreateTriggerData(trigger)));
+		}
+	}
 
-							if (TheCamMap.ActiveCamera)
-							{
-								if (TheCamMap.InCameraPreview)
-								{
-									MESSAGE_BEGIN(MSG_ONE, HLCamMessage::CameraPreview, nullptr, TheCamMap.LocalPlayer->pev);
+	void JournalCameraRemoved(size_t id)
+	{
+		if (MapJournal.IsOpen())
+		{
+			CheckJournalWrite(MapJournal.RemoveCamera(static_cast<uint32_t>(id)));
+		}
+	}
 
-									WRITE_SHORT(TheCamMap.ActiveCamera->ID);
-									WRITE_BYTE(0);
+	void JournalTriggerRemoved(size_t id)
+	{
+		if (MapJournal.IsOpen())
+		{
+			CheckJournalWrite(MapJournal.RemoveTrigger(static_cast<uint32_t>(id)));
+		}
+	}
 
-									MESSAGE_END();
-								}
+	bool EnsureInactiveState()
+	{
+		if (TheCamMap.CurrentState != Cam::Shared::StateType::Inactive)
+		{
+			g_engfuncs.pfnAlertMessage(at_console, "HLCAM: Map edit state should be inactive\n");
+			return false;
+		}
 
-								TheCamMap.ActiveCamera->TargetCamera->Use(nullptr, nullptr, USE_OFF, 0);
-							}
+		return true;
+	}
 
-							TheCamMap.ActiveCamera = &camera;
+	/*
+		New IDs only count up, they have to stay within what
+		the messages to clients can hold.
+	*/
+	bool EnsureFreeMapID(size_t nextid, const char* type)
+	{
+		if (nextid > Cam::Shared::MaxMapID)
+		{
+			g_engfuncs.pfnAlertMessage(at_console, "HLCAM: No %s IDs left, the highest is %u\n", type, Cam::Shared::MaxMapID);
+			return false;
+		}
 
-							auto usevalue = 1;
-							
-							/*
-								Named cams need a special control value that only allows us to "use" it when
-								in edit mode, otherwise it could be used at any time and reset the player view
-								any time.
-							*/
-							if (TheCamMap.ActiveCamera->TriggerType == Cam::Shared::CameraTriggerType::ByName)
-							{
-								usevalue = 100;
-							}
+		return true;
+	}
 
-							TheCamMap.ActiveCamera->TargetCamera->Use(nullptr, nullptr, USE_ON, usevalue);
+	bool EnsureEditMode()
+	{
+		if (!TheCamMap.IsEditing)
+		{
+			g_engfuncs.pfnAlertMessage(at_console, "HLCAM: Need to be in edit mode\n");
+			return false;
+		}
 
-							TheCamMap.InCameraPreview = true;
+		return true;
+	}
 
-							MESSAGE_BEGIN(MSG_ONE, HLCamMessage::CameraPreview, nullptr, TheCamMap.LocalPlayer->pev);
+	void ApplyCameraBatch(Utility::BinaryBufferView& data, bool fromscript);
 
-							WRITE_SHORT(cameraid);
-							WRITE_BYTE(1);
+	/*
+		Copied out of the connection, the whole batch
+		is made later in one go on the game thread.
+	*/
+	void QueueCameraBatch(Utility::BinaryBufferView& data, bool fromscript)
+	{
+		auto start = static_cast<const unsigned char*>(data.GetData()) + data.GetReadPosition();
+		std::vector<unsigned char> batch(start, start + (data.GetSize() - data.GetReadPosition()));
 
-							MESSAGE_END();
-						}
-					});
+		auto apply = [batch = std::move(batch), fromscript]
+		{
+			Utility::BinaryBufferView view(batch.data(), batch.size());
+			ApplyCameraBatch(view, fromscript);
+		};
+
+		if (fromscript)
+		{
+			PushMessageTask(ScriptQueue, std::move(apply));
+		}
+
+		else
+		{
+			TheCamMap.InvokeMessageFunction(std::move(apply));
+		}
+	}
+
+	void PauseMessageThreads()
+	{
+		MessagePause.Requested = true;
+		TheCamMap.AppClient.Wake();
+		TheCamMap.ScriptServer.Wake();
+
+		std::unique_lock<std::mutex> lock(MessagePause.Mutex);
+
+		MessagePause.Changed.wait(lock, []
+		{
+			return MessagePause.Paused == MessagePause.Running;
+		});
+	}
+
+	void ResumeMessageThreads()
+	{
+		{
+			std::lock_guard<std::mutex> lock(MessagePause.Mutex);
+			MessagePause.Requested = false;
+		}
+
+		MessagePause.Changed.notify_all();
+	}
+
+	/*
+		Counted as running from before it starts, a pause
+		right after starting it waits for it as well.
+	*/
+	void StartMessageThread(std::thread& thread, void(*function)())
+	{
+		{
+			std::lock_guard<std::mutex> lock(MessagePause.Mutex);
+			MessagePause.Running++;
+		}
+
+		thread = std::thread([function]
+		{
+			function();
+
+			{
+				std::lock_guard<std::mutex> lock(MessagePause.Mutex);
+				MessagePause.Running--;
+			}
+
+			MessagePause.Changed.notify_all();
+		});
+	}
+
+	/*
+		Waits on the script connection by itself, so a batch
+		is queued as soon as it is written.
+	*/
+	void ScriptHandler()
+	{
+		while (!ShouldCloseMessageThread)
+		{
+			WaitWhilePaused();
+
+			Shared::Interprocess::Config::MessageType message;
+			Utility::BinaryBufferView data;
 
+			if (!TheCamMap.ScriptServer.ReadTimed(message, data, MessageWaitTime))
+			{
+				continue;
+			}
+
+			if (message == Cam::Shared::Messages::App::Camera_ApplyBatch)
+			{
+				QueueCameraBatch(data, true);
+			}
+		}
+	}
+
+	void MessageHandler()
+	{
+		while (!ShouldCloseMessageThread)
+		{
+			namespace Config = Shared::Interprocess::Config;
+
+			WaitWhilePaused();
+
+			/*
+				Read where it lies, everything the game thread needs
+				is copied out into the functions below.
+			*/
+			Config::MessageType message;
+			Utility::BinaryBufferView data;
+
+			auto res = TheCamMap.AppClient.ReadTimed(message, data, MessageWaitTime);
+
+			if (!res)
+			{
+				continue;
+			}
+
+			namespace Message = Cam::Shared::Messages::App;
+
+			switch (message)
+			{
+				case Message::OnAppShutdown:
+				{
 					break;
 				}
 
-				case Message::SetViewToPlayer:
+				case Message::RequestMapSnapshot:
 				{
 					TheCamMap.InvokeMessageFunction([]
 					{
-						if (!EnsureInactiveState())
+						if (TheCamMap.IsEditing)
 						{
-							return;
+							TheCamMap.SendMapReset();
 						}
-
-						TheCamMap.GoFirstPerson();
 					});
 
 					break;
 				}
 
-				case Message::MoveToCamera:
+				case Message::Trigger_Select:
 				{
-					auto cameraid = data.GetValue<size_t>();
+					auto triggerid = data.GetValue<size_t>();
 
-					TheCamMap.InvokeMessageFunction([cameraid]
+					TheCamMap.InvokeMessageFunction([triggerid]
 					{
-						if (TheCamMap.CurrentState != Cam::Shared::StateType::Inactive &&
-							TheCamMap.CurrentState != Cam::Shared::StateType::AdjustingCamera)
+						if (TheCamMap.CurrentSelectionTriggerID != triggerid)
 						{
-							g_engfuncs.pfnAlertMessage(at_console, "HLCAM: Map edit state should be inactive or in camera adjust\n");
-							return;
-						}
+							TheCamMap.UnSelectAll();
 
-						if (TheCamMap.CurrentSelectionCameraID == cameraid)
-						{
-							const auto& targetcam = TheCamMap.Cameras[cameraid];
+							TheCamMap.CurrentSelectionTriggerID = triggerid;
 
-							TheCamMap.LocalPlayer->pev->origin = targetcam.Position - TheCamMap.LocalPlayer->pev->view_ofs;
+							MESSAGE_BEGIN(MSG_ONE, HLCamMessage::ItemSelectedStart, nullptr, TheCamMap.LocalPlayer->pev);
 
-							TheCamMap.LocalPlayer->pev->angles = targetcam.Angle;
-							TheCamMap.LocalPlayer->pev->v_angle = targetcam.Angle;
-							TheCamMap.LocalPlayer->pev->fixangle = 1;
+							WRITE_BYTE(0);
+							WRITE_SHORT(TheCamMap.CurrentSelectionTriggerID);
+
+							MESSAGE_END();
 						}
 					});
 
 					break;
 				}
 
-				case Message::MoveToTrigger:
+				case Message::Camera_Select:
 				{
-					auto triggerid = data.GetValue<size_t>();
-					
-					TheCamMap.InvokeMessageFunction([triggerid]
+					auto cameraid = data.GetValue<size_t>();
+
+					TheCamMap.InvokeMessageFunction([cameraid]
 					{
-						if (TheCamMap.CurrentState != Cam::Shared::StateType::Inactive &&
-							TheCamMap.CurrentState != Cam::Shared::StateType::AdjustingCamera)
+						if (TheCamMap.CurrentSelectionCameraID != cameraid)
 						{
-							g_engfuncs.pfnAlertMessage(at_console, "HLCAM: Map edit state should be inactive or in camera adjust\n");
-							return;
-						}
+							TheCamMap.UnSelectAll();
 
-						if (TheCamMap.CurrentSelectionTriggerID == triggerid)
-						{
-							const auto& targettrig = TheCamMap.Triggers[triggerid];
-							TheCamMap.LocalPlayer->pev->origin = targettrig.CenterPos;
+							TheCamMap.CurrentSelectionCameraID = cameraid;
+
+							MESSAGE_BEGIN(MSG_ONE, HLCamMessage::ItemSelectedStart, nullptr, TheCamMap.LocalPlayer->pev);
+
+							WRITE_BYTE(1);
+							WRITE_SHORT(TheCamMap.CurrentSelectionCameraID);
+
+							MESSAGE_END();
 						}
 					});
 
 					break;
 				}
 
-				case Message::Camera_ChangeFOV:
+				case Message::Camera_StartMoveSequence:
 				{
 					auto cameraid = data.GetValue<size_t>();
-					auto fov = data.GetValue<int>();
 
-					TheCamMap.InvokeMessageFunction([cameraid, fov]
+					TheCamMap.InvokeMessageFunction([cameraid]
 					{
 						if (!EnsureInactiveState())
 						{
 							return;
 						}
 
-						if (TheCamMap.CurrentSelectionCameraID != cameraid)
+						if (TheCamMap.CurrentSelectionCameraID == cameraid)
 						{
-							g_engfuncs.pfnAlertMessage(at_console, "HLCAM: No selected camera for app message\n");
-							return;
-						}
+							TheCamMap.CurrentState = Cam::Shared::StateType::AdjustingCamera;
 
-						Cam::MapCamera* endcamera;
+							MESSAGE_BEGIN(MSG_ONE, HLCamMessage::CameraAdjust, nullptr, TheCamMap.LocalPlayer->pev);
 
-						if (TheCamMap.ActiveCamera)
-						{
-							endcamera = TheCamMap.ActiveCamera;
-							endcamera->TargetCamera->SetPlayerFOV(fov);
-						}
+							WRITE_BYTE(0);
+							WRITE_SHORT(cameraid);
 
-						else
-						{
-							endcamera = &TheCamMap.Cameras[cameraid];
+							MESSAGE_END();
 						}
-
-						endcamera->FOV = fov;
-						endcamera->TargetCamera->SetFov(fov);
 					});
 
 					break;
 				}
 
-				case Message::Camera_ChangeSpeed:
+				case Message::Camera_AddTriggerToCamera:
 				{
 					auto cameraid = data.GetValue<size_t>();
-					auto speed = data.GetValue<int>();
 
-					TheCamMap.InvokeMessageFunction([cameraid, speed]
+					TheCamMap.InvokeMessageFunction([cameraid]
 					{
 						if (!EnsureInactiveState())
 						{
 							return;
 						}
 
-						if (TheCamMap.CurrentSelectionCameraID != cameraid)
+						if (!EnsureFreeMapID(TheCamMap.NextTriggerID, "trigger"))
 						{
-							g_engfuncs.pfnAlertMessage(at_console, "HLCAM: No selected camera for app message\n");
 							return;
 						}
 
-						Cam::MapCamera* endcamera;
-
-						if (TheCamMap.ActiveCamera)
+						if (TheCamMap.CurrentSelectionCameraID == cameraid)
 						{
-							endcamera = TheCamMap.ActiveCamera;
-						}
+							TheCamMap.AddingTriggerToCamera = true;
 
-						else
-						{
-							endcamera = &TheCamMap.Cameras[cameraid];
-						}
+							Cam::MapTrigger newtrig;
+							newtrig.ID = TheCamMap.NextTriggerID;
+							newtrig.LinkedCameraID = cameraid;
 
-						endcamera->MaxSpeed = speed;
-						endcamera->TargetCamera->HLCam.MaxSpeed = speed;
-					});
+							auto& newcam = TheCamMap.Cameras[cameraid];
 
-					break;
-				}
+							newcam.LinkedTriggerIDs.push_back(newtrig.ID);
 
-				case Message::Camera_ChangeLookType:
-				{
-					auto cameraid = data.GetValue<size_t>();
-					auto looktype = data.GetValue<unsigned char>();
+							TheCamMap.CurrentState = Cam::Shared::StateType::NeedsToCreateTriggerCorner1;
 
-					TheCamMap.InvokeMessageFunction([cameraid, looktype]
-					{
-						if (!EnsureInactiveState())
-						{
-							return;
-						}
+							MESSAGE_BEGIN(MSG_ONE, HLCamMessage::CreateTrigger, nullptr, TheCamMap.LocalPlayer->pev);
 
-						if (TheCamMap.CurrentSelectionCameraID != cameraid)
-						{
-							g_engfuncs.pfnAlertMessage(at_console, "HLCAM: No selected camera for app message\n");
-							return;
-						}
+							WRITE_BYTE(0);
 
-						Cam::MapCamera* endcamera;
+							WRITE_SHORT(newtrig.ID);
+							WRITE_SHORT(cameraid);
 
-						if (TheCamMap.ActiveCamera)
-						{
-							endcamera = TheCamMap.ActiveCamera;
-						}
+							MESSAGE_END();
 
-						else
-						{
-							endcamera = &TheCamMap.Cameras[cameraid];
-						}
+							TheCamMap.CreationTriggerID = newtrig.ID;
 
-						endcamera->LookType = static_cast<decltype(endcamera->LookType)>(looktype);
-						endcamera->TargetCamera->HLCam.LookType = endcamera->LookType;
+							TheCamMap.Triggers.Insert(TheCamMap.NextTriggerID, std::move(newtrig));
+
+							TheCamMap.NextTriggerID++;
+						}
 					});
 
 					break;
 				}
 
-				case Message::Camera_ChangePlaneType:
+				case Message::SetViewToCamera:
 				{
 					auto cameraid = data.GetValue<size_t>();
-					auto planetype = data.GetValue<unsigned char>();
 
-					TheCamMap.InvokeMessageFunction([cameraid, planetype]
+					TheCamMap.InvokeMessageFunction([cameraid]
 					{
 						if (!EnsureInactiveState())
 						{
 							return;
 						}
 
-						if (TheCamMap.CurrentSelectionCameraID != cameraid)
+						if (TheCamMap.CurrentSelectionCameraID == cameraid)
 						{
-							g_engfuncs.pfnAlertMessage(at_console, "HLCAM: No selected camera for app message\n");
-							return;
-						}
+							auto& camera = TheCamMap.Cameras[cameraid];
+							auto& state = TheCamMap.GetLocalState();
+							auto activecamera = TheCamMap.GetActiveCamera(state);
 
-						Cam::MapCamera* endcamera;
+							if (activecamera && state.InCameraPreview)
+							{
+								MESSAGE_BEGIN(MSG_ONE, HLCamMessage::CameraPreview, nullptr, TheCamMap.LocalPlayer->pev);
 
-						if (TheCamMap.ActiveCamera)
-						{
-							endcamera = TheCamMap.ActiveCamera;
-						}
+								WRITE_SHORT(activecamera->ID);
+								WRITE_BYTE(0);
 
-						else
-						{
-							endcamera = &TheCamMap.Cameras[cameraid];
+								MESSAGE_END();
+							}
+
+							if (state.ViewEntity)
+							{
+								state.ViewEntity->Use(TheCamMap.LocalPlayer, nullptr, USE_OFF, 0);
+							}
+
+							TheCamMap.SetActiveCamera(state, &camera);
+							state.ViewEntity = camera.TargetCamera;
+
+							auto usevalue = 1;
+							
+							/*
+								Named cams need a special control value that only allows us to "use" it when
+								in edit mode, otherwise it could be used at any time and reset the player view
+								any time.
+							*/
+							if (camera.TriggerType == Cam::Shared::CameraTriggerType::ByName)
+							{
+								usevalue = 100;
+							}
+
+							camera.TargetCamera->Use(TheCamMap.LocalPlayer, nullptr, USE_ON, usevalue);
+
+							state.InCameraPreview = true;
+
+							MESSAGE_BEGIN(MSG_ONE, HLCamMessage::CameraPreview, nullptr, TheCamMap.LocalPlayer->pev);
+
+							WRITE_SHORT(cameraid);
+							WRITE_BYTE(1);
+
+							MESSAGE_END();
+						}
+					});
+
+					break;
+				}
+
+				case Message::SetViewToPlayer:
+				{
+					TheCamMap.InvokeMessageFunction([]
+					{
+						if (!EnsureInactiveState())
+						{
+							return;
+						}
+
+						TheCamMap.GoFirstPerson(TheCamMap.GetLocalState());
+					});
+
+					break;
+				}
+
+				case Message::MoveToCamera:
+				{
+					auto cameraid = data.GetValue<size_t>();
+
+					TheCamMap.InvokeMessageFunction([cameraid]
+					{
+						if (TheCamMap.CurrentState != Cam::Shared::StateType::Inactive &&
+							TheCamMap.CurrentState != Cam::Shared::StateType::AdjustingCamera)
+						{
+							g_engfuncs.pfnAlertMessage(at_console, "HLCAM: Map edit state should be inactive or in camera adjust\n");
+							return;
+						}
+
+						if (TheCamMap.CurrentSelectionCameraID == cameraid)
+						{
+							const auto& targetcam = TheCamMap.Cameras[cameraid];
+
+							TheCamMap.LocalPlayer->pev->origin = targetcam.Position - TheCamMap.LocalPlayer->pev->view_ofs;
+
+							TheCamMap.LocalPlayer->pev->angles = targetcam.Angle;
+							TheCamMap.LocalPlayer->pev->v_angle = targetcam.Angle;
+							TheCamMap.LocalPlayer->pev->fixangle = 1;
+						}
+					});
+
+					break;
+				}
+
+				case Message::MoveToTrigger:
+				{
+					auto triggerid = data.GetValue<size_t>();
+					
+					TheCamMap.InvokeMessageFunction([triggerid]
+					{
+						if (TheCamMap.CurrentState != Cam::Shared::StateType::Inactive &&
+							TheCamMap.CurrentState != Cam::Shared::StateType::AdjustingCamera)
+						{
+							g_engfuncs.pfnAlertMessage(at_console, "HLCAM: Map edit state should be inactive or in camera adjust\n");
+							return;
+						}
+
+						if (TheCamMap.CurrentSelectionTriggerID == triggerid)
+						{
+							const auto& targettrig = TheCamMap.Triggers[triggerid];
+							TheCamMap.LocalPlayer->pev->origin = targettrig.CenterPos;
+						}
+					});
+
+					break;
+				}
+
+				case Message::Camera_ChangeFOV:
+				{
+					auto cameraid = data.GetValue<size_t>();
+					auto fov = data.GetValue<int>();
+
+					TheCamMap.InvokeMessageFunction([cameraid, fov]
+					{
+						if (!EnsureInactiveState())
+						{
+							return;
+						}
+
+						if (TheCamMap.CurrentSelectionCameraID != cameraid)
+						{
+							g_engfuncs.pfnAlertMessage(at_console, "HLCAM: No selected camera for app message\n");
+							return;
+						}
+
+						Cam::MapCamera* endcamera;
+
+						if (TheCamMap.GetLocalActiveCamera())
+						{
+							endcamera = TheCamMap.GetLocalActiveCamera();
+							endcamera->TargetCamera->SetPlayerFOV(fov);
+						}
+
+						else
+						{
+							endcamera = &TheCamMap.Cameras[cameraid];
+						}
+
+						endcamera->FOV = fov;
+						endcamera->TargetCamera->SetFov(fov);
+
+						JournalCamera(*endcamera);
+					});
+
+					break;
+				}
+
+				case Message::Camera_ChangeSpeed:
+				{
+					auto cameraid = data.GetValue<size_t>();
+					auto speed = data.GetValue<int>();
+
+					TheCamMap.InvokeMessageFunction([cameraid, speed]
+					{
+						if (!EnsureInactiveState())
+						{
+							return;
+						}
+
+						if (TheCamMap.CurrentSelectionCameraID != cameraid)
+						{
+							g_engfuncs.pfnAlertMessage(at_console, "HLCAM: No selected camera for app message\n");
+							return;
+						}
+
+						Cam::MapCamera* endcamera;
+
+						if (TheCamMap.GetLocalActiveCamera())
+						{
+							endcamera = TheCamMap.GetLocalActiveCamera();
+						}
+
+						else
+						{
+							endcamera = &TheCamMap.Cameras[cameraid];
+						}
+
+						endcamera->MaxSpeed = speed;
+						endcamera->TargetCamera->HLCam.MaxSpeed = speed;
+
+						JournalCamera(*endcamera);
+					});
+
+					break;
+				}
+
+				case Message::Camera_ChangeLookType:
+				{
+					auto cameraid = data.GetValue<size_t>();
+					auto looktype = data.GetValue<unsigned char>();
+
+					TheCamMap.InvokeMessageFunction([cameraid, looktype]
+					{
+						if (!EnsureInactiveState())
+						{
+							return;
+						}
+
+						if (TheCamMap.CurrentSelectionCameraID != cameraid)
+						{
+							g_engfuncs.pfnAlertMessage(at_console, "HLCAM: No selected camera for app message\n");
+							return;
+						}
+
+						Cam::MapCamera* endcamera;
+
+						if (TheCamMap.GetLocalActiveCamera())
+						{
+							endcamera = TheCamMap.GetLocalActiveCamera();
+						}
+
+						else
+						{
+							endcamera = &TheCamMap.Cameras[cameraid];
+						}
+
+						endcamera->LookType = static_cast<decltype(endcamera->LookType)>(looktype);
+						endcamera->TargetCamera->HLCam.LookType = endcamera->LookType;
+
+						JournalCamera(*endcamera);
+					});
+
+					break;
+				}
+
+				case Message::Camera_ChangePlaneType:
+				{
+					auto cameraid = data.GetValue<size_t>();
+					auto planetype = data.GetValue<unsigned char>();
+
+					TheCamMap.InvokeMessageFunction([cameraid, planetype]
+					{
+						if (!EnsureInactiveState())
+						{
+							return;
+						}
+
+						if (TheCamMap.CurrentSelectionCameraID != cameraid)
+						{
+							g_engfuncs.pfnAlertMessage(at_console, "HLCAM: No selected camera for app message\n");
+							return;
+						}
+
+						Cam::MapCamera* endcamera;
+
+						if (TheCamMap.GetLocalActiveCamera())
+						{
+							endcamera = TheCamMap.GetLocalActiveCamera();
+						}
+
+						else
+						{
+							endcamera = &TheCamMap.Cameras[cameraid];
 						}
 
 						endcamera->PlaneType = static_cast<decltype(endcamera->PlaneType)>(planetype);
 						endcamera->TargetCamera->HLCam.PlaneType = endcamera->PlaneType;
+
+						JournalCamera(*endcamera);
 					});
 
 					break;
@@ -1042,9 +2013,9 @@ namespace
 
 						Cam::MapCamera* endcamera;
 
-						if (TheCamMap.ActiveCamera)
+						if (TheCamMap.GetLocalActiveCamera())
 						{
-							endcamera = TheCamMap.ActiveCamera;
+							endcamera = TheCamMap.GetLocalActiveCamera();
 						}
 
 						else
@@ -1054,6 +2025,8 @@ namespace
 
 						endcamera->ZoomType = static_cast<decltype(endcamera->ZoomType)>(zoomtype);
 						endcamera->TargetCamera->HLCam.ZoomType = endcamera->ZoomType;
+
+						JournalCamera(*endcamera);
 					});
 
 					break;
@@ -1079,9 +2052,9 @@ namespace
 
 						Cam::MapCamera* endcamera;
 
-						if (TheCamMap.ActiveCamera)
+						if (TheCamMap.GetLocalActiveCamera())
 						{
-							endcamera = TheCamMap.ActiveCamera;
+							endcamera = TheCamMap.GetLocalActiveCamera();
 						}
 
 						else
@@ -1091,6 +2064,8 @@ namespace
 
 						endcamera->ZoomData.ZoomTime = time;
 						endcamera->TargetCamera->HLCam.ZoomData.ZoomTime = time;
+
+						JournalCamera(*endcamera);
 					});
 
 					break;
@@ -1116,9 +2091,9 @@ namespace
 
 						Cam::MapCamera* endcamera;
 
-						if (TheCamMap.ActiveCamera)
+						if (TheCamMap.GetLocalActiveCamera())
 						{
-							endcamera = TheCamMap.ActiveCamera;
+							endcamera = TheCamMap.GetLocalActiveCamera();
 						}
 
 						else
@@ -1128,6 +2103,8 @@ namespace
 
 						endcamera->ZoomData.EndFov = fov;
 						endcamera->TargetCamera->HLCam.ZoomData.EndFov = fov;
+
+						JournalCamera(*endcamera);
 					});
 
 					break;
@@ -1153,9 +2130,9 @@ namespace
 
 						Cam::MapCamera* endcamera;
 
-						if (TheCamMap.ActiveCamera)
+						if (TheCamMap.GetLocalActiveCamera())
 						{
-							endcamera = TheCamMap.ActiveCamera;
+							endcamera = TheCamMap.GetLocalActiveCamera();
 						}
 
 						else
@@ -1165,6 +2142,8 @@ namespace
 
 						endcamera->ZoomData.InterpMethod = static_cast<decltype(endcamera->ZoomData.InterpMethod)>(interptype);
 						endcamera->TargetCamera->HLCam.ZoomData.InterpMethod = endcamera->ZoomData.InterpMethod;
+
+						JournalCamera(*endcamera);
 					});
 
 					break;
@@ -1173,9 +2152,9 @@ namespace
 				case Message::Camera_ChangeName:
 				{
 					auto cameraid = data.GetValue<size_t>();
-					auto&& namestr = data.GetNormalString();
+					MessageName name(data.GetStringView());
 
-					TheCamMap.InvokeMessageFunction([cameraid, namestr]
+					TheCamMap.InvokeMessageFunction([cameraid, name]
 					{
 						if (!EnsureInactiveState())
 						{
@@ -1190,9 +2169,9 @@ namespace
 
 						Cam::MapCamera* endcamera;
 
-						if (TheCamMap.ActiveCamera)
+						if (TheCamMap.GetLocalActiveCamera())
 						{
-							endcamera = TheCamMap.ActiveCamera;
+							endcamera = TheCamMap.GetLocalActiveCamera();
 						}
 
 						else
@@ -1202,11 +2181,13 @@ namespace
 
 						if (endcamera->TriggerType == Cam::Shared::CameraTriggerType::ByName)
 						{
-							endcamera->Name = namestr;
-							endcamera->TargetCamera->HLCam.Name = namestr;
+							endcamera->Name = name.Text;
+							endcamera->TargetCamera->HLCam.Name = name.Text;
 
-							endcamera->TargetCamera->pev->targetname = g_engfuncs.pfnAllocString(namestr.c_str());
+							endcamera->TargetCamera->pev->targetname = g_engfuncs.pfnAllocString(name.Text);
 						}
+
+						JournalCamera(*endcamera);
 					});
 
 					break;
@@ -1215,9 +2196,9 @@ namespace
 				case Message::Camera_ChangeLookTargetName:
 				{
 					auto cameraid = data.GetValue<size_t>();
-					auto&& namestr = data.GetNormalString();
+					MessageName name(data.GetStringView());
 
-					TheCamMap.InvokeMessageFunction([cameraid, namestr]
+					TheCamMap.InvokeMessageFunction([cameraid, name]
 					{
 						if (!EnsureInactiveState())
 						{
@@ -1232,9 +2213,9 @@ namespace
 
 						Cam::MapCamera* endcamera;
 
-						if (TheCamMap.ActiveCamera)
+						if (TheCamMap.GetLocalActiveCamera())
 						{
-							endcamera = TheCamMap.ActiveCamera;
+							endcamera = TheCamMap.GetLocalActiveCamera();
 						}
 
 						else
@@ -1244,9 +2225,11 @@ namespace
 
 						if (endcamera->LookType == Cam::Shared::CameraLookType::AtTarget)
 						{
-							endcamera->LookTargetData.Name = namestr;
-							endcamera->TargetCamera->HLCam.LookTargetData.Name = namestr;
+							endcamera->LookTargetData.Name = name.Text;
+							endcamera->TargetCamera->HLCam.LookTargetData.Name = name.Text;
 						}
+
+						JournalCamera(*endcamera);
 					});
 
 					break;
@@ -1272,9 +2255,9 @@ namespace
 
 						Cam::MapCamera* endcamera;
 
-						if (TheCamMap.ActiveCamera)
+						if (TheCamMap.GetLocalActiveCamera())
 						{
-							endcamera = TheCamMap.ActiveCamera;
+							endcamera = TheCamMap.GetLocalActiveCamera();
 						}
 
 						else
@@ -1284,6 +2267,8 @@ namespace
 
 						endcamera->UseAttachment = useattachment;
 						endcamera->TargetCamera->HLCam.UseAttachment = useattachment;
+
+						JournalCamera(*endcamera);
 					});
 
 					break;
@@ -1292,9 +2277,9 @@ namespace
 				case Message::Camera_AttachmentChangeTargetName:
 				{
 					auto cameraid = data.GetValue<size_t>();
-					auto&& namestr = data.GetNormalString();
+					MessageName name(data.GetStringView());
 
-					TheCamMap.InvokeMessageFunction([cameraid, namestr]
+					TheCamMap.InvokeMessageFunction([cameraid, name]
 					{
 						if (!EnsureInactiveState())
 						{
@@ -1309,9 +2294,9 @@ namespace
 
 						Cam::MapCamera* endcamera;
 
-						if (TheCamMap.ActiveCamera)
+						if (TheCamMap.GetLocalActiveCamera())
 						{
-							endcamera = TheCamMap.ActiveCamera;
+							endcamera = TheCamMap.GetLocalActiveCamera();
 						}
 
 						else
@@ -1319,8 +2304,10 @@ namespace
 							endcamera = &TheCamMap.Cameras[cameraid];
 						}
 
-						endcamera->AttachmentData.Name = namestr;
-						endcamera->TargetCamera->HLCam.AttachmentData.Name = namestr;
+						endcamera->AttachmentData.Name = name.Text;
+						endcamera->TargetCamera->HLCam.AttachmentData.Name = name.Text;
+
+						JournalCamera(*endcamera);
 					});
 
 					break;
@@ -1350,426 +2337,1203 @@ namespace
 
 						Cam::MapCamera* endcamera;
 
-						if (TheCamMap.ActiveCamera)
-						{
-							endcamera = TheCamMap.ActiveCamera;
-						}
+						if (TheCamMap.GetLocalActiveCamera())
+						{
+							endcamera = TheCamMap.GetLocalActiveCamera();
+						}
+
+						else
+						{
+							endcamera = &TheCamMap.Cameras[cameraid];
+						}
+
+						endcamera->AttachmentData.Offset = offset;
+						endcamera->TargetCamera->HLCam.AttachmentData.Offset = offset;
+
+						JournalCamera(*endcamera);
+					});
+
+					break;
+				}
+
+				case Message::Camera_Remove:
+				{
+					auto cameraid = data.GetValue<size_t>();
+
+					TheCamMap.InvokeMessageFunction([cameraid]
+					{
+						if (!EnsureInactiveState())
+						{
+							return;
+						}
+
+						TheCamMap.RemoveCamera(&TheCamMap.Cameras[cameraid]);
+						JournalCameraRemoved(cameraid);
+					});
+
+					break;
+				}
+
+				case Message::Camera_ApplyBatch:
+				{
+					QueueCameraBatch(data, false);
+					break;
+				}
+
+				case Message::Trigger_Remove:
+				{
+					auto triggerid = data.GetValue<size_t>();
+
+					TheCamMap.InvokeMessageFunction([triggerid]
+					{
+						if (!EnsureInactiveState())
+						{
+							return;
+						}
+
+						TheCamMap.RemoveTriggerFromID(triggerid);
+						JournalTriggerRemoved(triggerid);
+					});
+
+					break;
+				}
+			}
+		}
+	}
+
+	void ResetCurrentMap()
+	{
+		PauseMessageThreads();
+
+		TheCamMap = MapCam();
+
+		/*
+			Queued edits refer to the map that is going away.
+		*/
+		InvokeQueue.Clear();
+		ScriptQueue.Clear();
+
+		MapJournal.Close();
+
+		ResumeMessageThreads();
+	}
+
+	/*
+		Creates the game entity for a camera with all of its map data set.
+	*/
+	void AddLoadedCamera(Cam::MapCamera& curcam)
+	{
+		curcam.TargetCamera = static_cast<CTriggerCamera*>(CBaseEntity::Create("trigger_camera", curcam.Position, curcam.Angle));
+
+		if (curcam.TriggerType == Cam::Shared::CameraTriggerType::ByName)
+		{
+			curcam.TargetCamera->pev->targetname = g_engfuncs.pfnAllocString(curcam.Name.c_str());
+		}
+
+		curcam.TargetCamera->SetupHLCamera(curcam);
+
+		TheCamMap.Cameras.Insert(curcam.ID, std::move(curcam));
+	}
+
+	/*
+		IDs are kept from the file so journaled edits still refer to the same items.
+	*/
+	void ClaimLoadedID(size_t id, size_t& nextid)
+	{
+		if (id >= nextid)
+		{
+			nextid = id + 1;
+		}
+	}
+
+	/*
+		Settings of a camera without its triggers or entity.
+	*/
+	Cam::MapCamera CameraFromData(const Cam::Shared::MapCameraData& camdata)
+	{
+		Cam::MapCamera ret;
+
+		ret.ID = camdata.ID;
+
+		ret.Position = LocalUtility::MakeVector(camdata.Position);
+		ret.Angle = LocalUtility::MakeVector(camdata.Angle);
+
+		ret.Name = camdata.Name;
+
+		ret.TriggerType = camdata.TriggerType;
+		ret.LookType = camdata.LookType;
+		ret.PlaneType = camdata.PlaneType;
+		ret.ZoomType = camdata.ZoomType;
+
+		ret.FOV = camdata.FOV;
+		ret.MaxSpeed = camdata.MaxSpeed;
+
+		ret.ZoomData.ZoomTime = camdata.ZoomTime;
+		ret.ZoomData.EndFov = camdata.ZoomEndFOV;
+		ret.ZoomData.InterpMethod = camdata.ZoomInterpMethod;
+
+		ret.LookTargetData.Name = camdata.LookTargetName;
+
+		ret.UseAttachment = camdata.UseAttachment;
+		ret.AttachmentData.Name = camdata.AttachmentTargetName;
+		ret.AttachmentData.Offset = LocalUtility::MakeVector(camdata.AttachmentOffset);
+
+		return ret;
+	}
+
+	Cam::MapTrigger TriggerFromData(const Cam::Shared::MapTriggerData& trigdata, size_t cameraid)
+	{
+		Cam::MapTrigger ret;
+
+		ret.Corner1 = LocalUtility::MakeVector(trigdata.Corner1);
+		ret.Corner2 = LocalUtility::MakeVector(trigdata.Corner2);
+
+		ret.SetupPositions();
+
+		ret.ID = trigdata.ID;
+		ret.LinkedCameraID = cameraid;
+
+		return ret;
+	}
+
+	void LoadMapData(const Cam::Shared::MapData& mapdata)
+	{
+		for (const auto& camdata : mapdata.Cameras)
+		{
+			auto curcam = CameraFromData(camdata);
+			ClaimLoadedID(curcam.ID, TheCamMap.NextCameraID);
+
+			for (const auto& trigdata : camdata.Triggers)
+			{
+				auto curtrig = TriggerFromData(trigdata, curcam.ID);
+				ClaimLoadedID(curtrig.ID, TheCamMap.NextTriggerID);
+
+				curcam.LinkedTriggerIDs.push_back(curtrig.ID);
+				TheCamMap.Triggers.Insert(curtrig.ID, std::move(curtrig));
+			}
+
+			AddLoadedCamera(curcam);
+		}
+	}
+
+	/*
+		Reads straight from the mapped records, trigger bounds and
+		the trigger tree were made when the map was compiled.
+	*/
+	void LoadMapData(const Cam::Shared::MapFile::BinaryMap& binarymap)
+	{
+		auto cameras = binarymap.GetCameras();
+		auto triggers = binarymap.GetTriggers();
+
+		for (size_t i = 0; i < binarymap.GetCameraCount(); i++)
+		{
+			const auto& record = cameras[i];
+
+			Cam::MapCamera curcam;
+
+			curcam.ID = record.ID;
+			ClaimLoadedID(curcam.ID, TheCamMap.NextCameraID);
+
+			curcam.LinkedTriggerIDs.reserve(record.TriggerCount);
+
+			for (size_t j = 0; j < record.TriggerCount; j++)
+			{
+				const auto& trigrecord = triggers[record.FirstTrigger + j];
+
+				Cam::MapTrigger curtrig;
+
+				curtrig.Corner1 = LocalUtility::MakeVector(trigrecord.Corner1);
+				curtrig.Corner2 = LocalUtility::MakeVector(trigrecord.Corner2);
+
+				curtrig.MinPos = LocalUtility::MakeVector(trigrecord.Min);
+				curtrig.MaxPos = LocalUtility::MakeVector(trigrecord.Max);
+				curtrig.CenterPos = LocalUtility::MakeVector(trigrecord.Center);
+
+				curtrig.ID = trigrecord.ID;
+				curtrig.LinkedCameraID = curcam.ID;
+
+				ClaimLoadedID(curtrig.ID, TheCamMap.NextTriggerID);
+
+				curcam.LinkedTriggerIDs.push_back(curtrig.ID);
+				TheCamMap.Triggers.Insert(curtrig.ID, std::move(curtrig));
+			}
+
+			curcam.Position = LocalUtility::MakeVector(record.Position);
+			curcam.Angle = LocalUtility::MakeVector(record.Angle);
+
+			curcam.Name = binarymap.GetString(record.Name);
+
+			curcam.TriggerType = static_cast<Cam::Shared::CameraTriggerType>(record.TriggerType);
+			curcam.LookType = static_cast<Cam::Shared::CameraLookType>(record.LookType);
+			curcam.PlaneType = static_cast<Cam::Shared::CameraPlaneType>(record.PlaneType);
+			curcam.ZoomType = static_cast<Cam::Shared::CameraZoomType>(record.ZoomType);
+
+			curcam.FOV = record.FOV;
+			curcam.MaxSpeed = record.MaxSpeed;
+
+			curcam.ZoomData.ZoomTime = record.ZoomTime;
+			curcam.ZoomData.EndFov = record.ZoomEndFOV;
+			curcam.ZoomData.InterpMethod = static_cast<Cam::Shared::CameraAngleType>(record.ZoomInterpMethod);
+
+			curcam.LookTargetData.Name = binarymap.GetString(record.LookTargetName);
+
+			curcam.UseAttachment = record.UseAttachment != 0;
+			curcam.AttachmentData.Name = binarymap.GetString(record.AttachmentTargetName);
+			curcam.AttachmentData.Offset = LocalUtility::MakeVector(record.AttachmentOffset);
+
+			AddLoadedCamera(curcam);
+		}
+
+		auto treenodes = binarymap.GetTreeNodes();
+		auto treenodecount = binarymap.GetTreeNodeCount();
+
+		if (treenodecount == 0)
+		{
+			return;
+		}
+
+		std::vector<Utility::AABBTree::FlatNode> nodes;
+		nodes.reserve(treenodecount);
+
+		for (size_t i = 0; i < treenodecount; i++)
+		{
+			const auto& record = treenodes[i];
+
+			Utility::AABBTree::FlatNode node;
+
+			for (size_t j = 0; j < 3; j++)
+			{
+				node.Box.Min[j] = record.Min[j];
+				node.Box.Max[j] = record.Max[j];
+			}
+
+			node.Children[0] = record.Children[0];
+			node.Children[1] = record.Children[1];
+			node.ID = record.ID;
+
+			nodes.push_back(node);
+		}
+
+		/*
+			Repeated trigger IDs collapse into one trigger here,
+			a tree with both of them would not match.
+		*/
+		TheCamMap.TriggerTreeLoaded = TheCamMap.TriggerTree.Load(nodes.data(), nodes.size()) &&
+									  TheCamMap.TriggerTree.GetCount() == TheCamMap.Triggers.GetCount();
+	}
+
+	/*
+		Forward slashes work on every platform the game runs on.
+	*/
+	const char* GetMapDirectory()
+	{
+		return "cammod/MapCams";
+	}
+
+	std::string GetMapFilePath(const std::string& mapname, const char* extension)
+	{
+		return std::string(GetMapDirectory()) + "/" + mapname + extension;
+	}
+
+	bool HasJournalRecords(const std::string& path)
+	{
+		Cam::Shared::MapFile::FileStamp stamp;
+
+		if (!Cam::Shared::MapFile::GetFileStamp(path.c_str(), stamp))
+		{
+			return false;
+		}
+
+		return stamp.Size > sizeof(Cam::Shared::MapFile::Journal::Header);
+	}
+
+	void ReplayMapJournal(const std::string& path, Cam::Shared::MapData& mapdata, const std::string& mapname)
+	{
+		auto conmessage = g_engfuncs.pfnAlertMessage;
+
+		size_t records;
+		std::string error;
+
+		/*
+			Edits before a damaged record are still applied.
+		*/
+		if (!Cam::Shared::MapFile::ReplayJournal(path.c_str(), mapdata, records, error))
+		{
+			conmessage(at_console, "HLCAM: %s for \"%s\"\n", error.c_str(), mapname.c_str());
+		}
+
+		if (records > 0)
+		{
+			conmessage(at_console, "HLCAM: Replayed %u journaled edits for \"%s\"\n", static_cast<unsigned>(records), mapname.c_str());
+		}
+	}
+
+	void LoadMapDataFromFile(const std::string& mapname)
+	{
+		/*
+			Coming back to a map that is still being saved.
+		*/
+		MapWriter.Flush();
+
+		TheCamMap.Cameras.Reserve(512);
+		TheCamMap.Triggers.Reserve(512);
+
+		auto conmessage = g_engfuncs.pfnAlertMessage;
+
+		auto jsonpath = GetMapFilePath(mapname, ".json");
+		auto binarypath = GetMapFilePath(mapname, ".hlcb");
+
+		/*
+			Edits made after the last save. The old journal is left
+			when a save did not finish and goes before the current one.
+		*/
+		auto oldjournalpath = GetMapFilePath(mapname, ".hlcj.old");
+		auto journalpath = GetMapFilePath(mapname, ".hlcj");
+
+		auto hasjournal = HasJournalRecords(oldjournalpath) || HasJournalRecords(journalpath);
+
+		Cam::Shared::MapData mapdata;
+		auto loaded = false;
+
+		/*
+			A compiled map is preferred as long as the JSON
+			has not been changed since it was compiled.
+		*/
+		Cam::Shared::MapFile::FileStamp binarystamp;
+
+		if (Cam::Shared::MapFile::GetFileStamp(binarypath.c_str(), binarystamp))
+		{
+			Cam::Shared::MapFile::BinaryMap binarymap;
+			std::string error;
+
+			if (!binarymap.Open(binarypath.c_str(), error))
+			{
+				conmessage(at_console, "HLCAM: Could not open compiled camera file for \"%s\": %s\n", mapname.c_str(), error.c_str());
+			}
+
+			else if (!binarymap.IsCurrent(jsonpath.c_str()))
+			{
+				conmessage(at_console, "HLCAM: Compiled camera file for \"%s\" is out of date\n", mapname.c_str());
+			}
+
+			else if (!hasjournal)
+			{
+				LoadMapData(binarymap);
+				return;
+			}
+
+			else
+			{
+				binarymap.ToMapData(mapdata);
+				loaded = true;
+			}
+		}
+
+		if (!loaded)
+		{
+			std::vector<char> bytes;
+
+			if (Cam::Shared::MapFile::ReadAllBytes(jsonpath.c_str(), bytes))
+			{
+				std::string error;
+
+				/*
+					Whatever was read before an error is still used.
+				*/
+				if (!Cam::Shared::MapFile::ReadJSON(bytes.data(), mapdata, error))
+				{
+					conmessage(at_console, "HLCAM: %s for \"%s\"\n", error.c_str(), mapname.c_str());
+				}
+			}
+
+			/*
+				A new map can have been edited without being saved in full yet.
+			*/
+			else if (!hasjournal)
+			{
+				conmessage(at_console, "HLCAM: No camera file for \"%s\"\n", mapname.c_str());
+				return;
+			}
+		}
+
+		ReplayMapJournal(oldjournalpath, mapdata, mapname);
+		ReplayMapJournal(journalpath, mapdata, mapname);
+
+		LoadMapData(mapdata);
+	}
+
+	void OpenMapJournal(const std::string& mapname)
+	{
+		auto path = GetMapFilePath(mapname, ".hlcj");
+
+		if (!MapJournal.Open(path.c_str()))
+		{
+			g_engfuncs.pfnAlertMessage(at_console, "HLCAM: Could not open camera map journal for \"%s\", edits are only kept by full saves\n", mapname.c_str());
+		}
+	}
+
+	/*
+		Timed as a whole, with the index and journal that go with loading.
+	*/
+	void LoadNewMap(const char* name)
+	{
+		ScopedTiming timing(Timing::LoadMap);
+
+		if (!TheCamMap.CurrentMapName.empty())
+		{
+			ResetCurrentMap();
+		}
+		
+		TheCamMap.CurrentMapName = name;
+		LoadMapDataFromFile(TheCamMap.CurrentMapName);
+
+		if (!MapWatcher.IsStarted())
+		{
+			MapWatcher.Start(GetMapDirectory());
+		}
+
+		/*
+			Opened after the replay, which has to see the journal as it was.
+		*/
+		OpenMapJournal(TheCamMap.CurrentMapName);
+
+		/*
+			Built here rather than while parsing so a partially
+			loaded file still gets an index of what was read.
+		*/
+		TheCamMap.BuildTriggerTree();
+
+		TheCamMap.NeedsToSendMapUpdate = true;
+	}
+
+	/*
+		Points the player's view at "view", which is already set up to
+		look through "camera".
+	*/
+	void SwitchPlayerView(PlayerCamState& state, Cam::MapCamera& camera, CTriggerCamera* view)
+	{
+		/*
+			Previous camera has to be told to be disabled to allow us
+			to change to a new one.
+		*/
+		if (state.ViewEntity && state.ViewEntity != view)
+		{
+			state.ViewEntity->Use(state.Player, nullptr, USE_OFF, 1);
+		}
+
+		state.ViewEntity = view;
+		TheCamMap.SetActiveCamera(state, &camera);
+
+		MESSAGE_BEGIN(MSG_ONE, HLCamMessage::CameraSwitch, nullptr, state.Player->pev);
+		WRITE_SHORT(camera.ID);
+		WRITE_COORD(camera.Position.x);
+		WRITE_COORD(camera.Position.y);
+		WRITE_COORD(camera.Position.z);
+		MESSAGE_END();
+	}
+
+	/*
+		Trigger cameras are viewed through the player's own camera entity,
+		so players in different triggers of the same map don't fight over
+		where a shared entity should look.
+	*/
+	void ActivateNewCamera(PlayerCamState& state, Cam::MapCamera* camera)
+	{
+		if (!camera || TheCamMap.GetActiveCamera(state) == camera)
+		{
+			return;
+		}
+
+		if (!state.OwnCamera)
+		{
+			auto newent = CBaseEntity::Create("trigger_camera", camera->Position, camera->Angle);
+			state.OwnCamera = static_cast<CTriggerCamera*>(newent);
+		}
+
+		auto view = state.OwnCamera;
+
+		if (state.ViewEntity == view)
+		{
+			view->Use(state.Player, nullptr, USE_OFF, 1);
+		}
+
+		view->SetupHLCamera(*camera);
+		view->pev->origin = camera->Position;
+		view->pev->angles = camera->Angle;
+
+		SwitchPlayerView(state, *camera, view);
+
+		view->Use(state.Player, nullptr, USE_ON, 1);
+	}
+
+	void PlayerEnterTrigger(PlayerCamState& state, Cam::MapTrigger& trig)
+	{
+		if (TheCamMap.GetActiveTrigger(state) == &trig)
+		{
+			return;
+		}
+
+		auto newcam = TheCamMap.GetLinkedCamera(trig);
+
+		if (!newcam)
+		{
+			g_engfuncs.pfnAlertMessage(at_console, "HLCAM: Trigger has no linked camera\n");
+			return;
+		}
+
+		ActivateNewCamera(state, newcam);
+
+		TheCamMap.SetActiveTrigger(state, &trig);
+
+		state.Player->LastTriggerID = trig.ID;
+	}
+
+	/*
+		Finds the trigger of every player in one go, once per server frame.
+	*/
+	void UpdatePlayerTriggers()
+	{
+		if (TheCamMap.TriggerGraphDirty)
+		{
+			TheCamMap.BuildTriggerGraph();
+			TriggerStats.GraphBuilds++;
+		}
+
+		Utility::TriggerLocator::Request requests[MaxPlayers];
+		PlayerCamState* states[MaxPlayers];
+		size_t requestcount = 0;
+
+		TriggerStats.Passes++;
+
+		for (int i = 1; i <= gpGlobals->maxClients && i <= MaxPlayers; i++)
+		{
+			auto player = static_cast<CBasePlayer*>(UTIL_PlayerByIndex(i));
+
+			if (!player)
+			{
+				continue;
+			}
+
+			/*
+				The editing player moves around freely.
+			*/
+			if (TheCamMap.IsEditing && player == TheCamMap.LocalPlayer)
+			{
+				continue;
+			}
+
+			auto& state = TheCamMap.GetPlayerState(player);
 
-						else
-						{
-							endcamera = &TheCamMap.Cameras[cameraid];
-						}
+			if (PendingRestores[i - 1].NeedsRestore)
+			{
+				PendingRestores[i - 1].NeedsRestore = false;
 
-						endcamera->AttachmentData.Offset = offset;
-						endcamera->TargetCamera->HLCam.AttachmentData.Offset = offset;
-					});
+				auto trig = TheCamMap.FindTriggerByID(PendingRestores[i - 1].TriggerID);
 
-					break;
+				if (trig)
+				{
+					PlayerEnterTrigger(state, *trig);
 				}
 
-				case Message::Camera_Remove:
+				else
 				{
-					auto cameraid = data.GetValue<size_t>();
+					g_engfuncs.pfnAlertMessage(at_console, "Restored trigger no longer exists\n");
+				}
+			}
 
-					TheCamMap.InvokeMessageFunction([cameraid]
-					{
-						if (!EnsureInactiveState())
-						{
-							return;
-						}
+			const auto& playerposmin = player->pev->absmin;
+			const auto& playerposmax = player->pev->absmax;
 
-						TheCamMap.RemoveCamera(&TheCamMap.Cameras[cameraid]);
-					});
+			if (state.LastIndexVersion == TheCamMap.TriggerIndexVersion &&
+				state.LastMin == playerposmin &&
+				state.LastMax == playerposmax)
+			{
+				TriggerStats.IdleSkips++;
+				continue;
+			}
 
-					break;
-				}
+			state.LastMin = playerposmin;
+			state.LastMax = playerposmax;
+			state.LastIndexVersion = TheCamMap.TriggerIndexVersion;
 
-				case Message::Trigger_Remove:
-				{
-					auto triggerid = data.GetValue<size_t>();
+			TriggerStats.PlayersChecked++;
 
-					TheCamMap.InvokeMessageFunction([triggerid]
-					{
-						if (!EnsureInactiveState())
-						{
-							return;
-						}
+			auto& request = requests[requestcount];
+			states[requestcount] = &state;
+			requestcount++;
 
-						TheCamMap.RemoveTriggerFromID(triggerid);
-					});
+			request.Box = LocalUtility::MakeBox(playerposmin, playerposmax);
 
-					break;
+			auto activetrigger = TheCamMap.GetActiveTrigger(state);
+
+			request.HasActive = activetrigger != nullptr;
+			request.ActiveID = activetrigger ? activetrigger->ID : 0;
+		}
+
+		if (requestcount == 0)
+		{
+			return;
+		}
+
+		Utility::TriggerLocator::Locate
+		(
+			TheCamMap.TriggerTree,
+			TheCamMap.TriggerBounds,
+			TheCamMap.TriggerGraph,
+			requests,
+			requestcount,
+			TriggerStats.Lookups
+		);
+
+		for (size_t i = 0; i < requestcount; i++)
+		{
+			const auto& request = requests[i];
+
+			if (request.Result == Utility::TriggerLocator::ResultType::Neighbour ||
+				request.Result == Utility::TriggerLocator::ResultType::Searched)
+			{
+				auto trig = TheCamMap.FindTriggerByID(request.FoundID);
+
+				if (trig)
+				{
+					PlayerEnterTrigger(*states[i], *trig);
 				}
 			}
 		}
 	}
 
-	void ResetCurrentMap()
+	bool SameVector(const Cam::Shared::MapVector& first, const Cam::Shared::MapVector& second)
 	{
-		ShouldPauseMessageThread = true;
+		return first.X == second.X && first.Y == second.Y && first.Z == second.Z;
+	}
 
-		TheCamMap = MapCam();
-		TheCamMap.NeedsToSendResetMessage = true;
+	bool SameVector(const Vector& first, const Vector& second)
+	{
+		return first.x == second.x && first.y == second.y && first.z == second.z;
+	}
 
-		ShouldPauseMessageThread = false;
+	/*
+		Everything but the triggers.
+	*/
+	bool SameCameraSettings(const Cam::Shared::MapCameraData& first, const Cam::Shared::MapCameraData& second)
+	{
+		return SameVector(first.Position, second.Position) &&
+			   SameVector(first.Angle, second.Angle) &&
+			   first.Name == second.Name &&
+			   first.TriggerType == second.TriggerType &&
+			   first.LookType == second.LookType &&
+			   first.PlaneType == second.PlaneType &&
+			   first.ZoomType == second.ZoomType &&
+			   first.FOV == second.FOV &&
+			   first.MaxSpeed == second.MaxSpeed &&
+			   first.ZoomTime == second.ZoomTime &&
+			   first.ZoomEndFOV == second.ZoomEndFOV &&
+			   first.ZoomInterpMethod == second.ZoomInterpMethod &&
+			   first.LookTargetName == second.LookTargetName &&
+			   first.UseAttachment == second.UseAttachment &&
+			   first.AttachmentTargetName == second.AttachmentTargetName &&
+			   SameVector(first.AttachmentOffset, second.AttachmentOffset);
 	}
 
-	void LoadMapDataFromFile(const std::string& mapname)
+	/*
+		Gives the camera's entity its new settings. Players looking through
+		their own copy of it are switched to it again to pick them up.
+	*/
+	void UpdateCameraEntity(Cam::MapCamera& camera)
 	{
-		TheCamMap.Cameras.reserve(512);
-		TheCamMap.Triggers.reserve(512);
+		auto entity = camera.TargetCamera;
 
-		std::string relativepath = "cammod\\MapCams\\" + mapname + ".json";
+		if (!entity)
+		{
+			return;
+		}
 
-		auto mapdata = LocalUtility::FileSystem::ReadAllBytes(relativepath);
+		entity->SetupHLCamera(camera);
 
-		auto conmessage = g_engfuncs.pfnAlertMessage;
+		entity->pev->origin = camera.Position;
+		entity->pev->angles = camera.Angle;
 
-		if (mapdata.empty())
+		if (camera.TriggerType == Cam::Shared::CameraTriggerType::ByName)
 		{
-			conmessage(at_console, "HLCAM: No camera file for \"%s\"\n", mapname.c_str());
-			return;
+			entity->pev->targetname = g_engfuncs.pfnAllocString(camera.Name.c_str());
 		}
 
-		mapdata.push_back(0);
-
-		const char* stringdata = mapdata.data();
+		else
+		{
+			entity->pev->targetname = 0;
+		}
 
-		rapidjson::Document document;
+		for (auto& state : TheCamMap.PlayerStates)
+		{
+			if (state.Player && state.ViewEntity && state.ViewEntity == state.OwnCamera &&
+				TheCamMap.GetActiveCamera(state) == &camera)
+			{
+				TheCamMap.SetActiveCamera(state, nullptr);
+				ActivateNewCamera(state, &camera);
+			}
+		}
+	}
 
-		document.Parse(stringdata);
+	struct MapChanges
+	{
+		/*
+			Added or changed.
+		*/
+		std::vector<size_t> CameraIDs;
+		std::vector<size_t> TriggerIDs;
 
-		const auto& entitr = document.FindMember("Entities");
+		size_t RemovedCameras = 0;
+		size_t RemovedTriggers = 0;
 
-		if (entitr == document.MemberEnd())
+		bool IsEmpty() const
 		{
-			conmessage(at_console, "HLCAM: Missing \"Entity\" array for \"%s\"\n", mapname.c_str());
-			return;
+			return CameraIDs.empty() && TriggerIDs.empty() && RemovedCameras == 0 && RemovedTriggers == 0;
 		}
+	};
 
-		for (auto entryit = entitr->value.Begin(); entryit != entitr->value.End(); ++entryit)
-		{
-			Cam::MapCamera curcam;
+	/*
+		Makes the loaded map match "mapdata" while only touching
+		items that differ, everything else keeps its entity and state.
+	*/
+	void ApplyMapChanges(const Cam::Shared::MapData& mapdata, MapChanges& changes)
+	{
+		std::unordered_set<size_t> filecameras;
+		std::unordered_set<size_t> filetriggers;
 
-			curcam.ID = TheCamMap.NextCameraID;
-			TheCamMap.NextCameraID++;
+		for (const auto& camdata : mapdata.Cameras)
+		{
+			filecameras.insert(camdata.ID);
 
-			const auto& entryval = *entryit;
+			std::vector<size_t> triggerids;
+			triggerids.reserve(camdata.Triggers.size());
 
+			for (const auto& trigdata : camdata.Triggers)
 			{
-				const auto& camit = entryval.FindMember("Camera");
-
-				if (camit == entryval.MemberEnd())
-				{
-					conmessage(at_console, "HLCAM: Missing \"Camera\" array entry for \"%s\"\n", mapname.c_str());
-					return;
-				}
+				filetriggers.insert(trigdata.ID);
+				triggerids.push_back(trigdata.ID);
 
-				const auto& camval = camit->value;
+				auto newtrig = TriggerFromData(trigdata, camdata.ID);
+				auto trigger = TheCamMap.FindTriggerByID(trigdata.ID);
 
+				if (trigger)
 				{
-					const auto& triggerit = camval.FindMember("Triggers");
-
-					if (triggerit == camval.MemberEnd())
+					if (trigger->LinkedCameraID == camdata.ID &&
+						SameVector(trigger->Corner1, newtrig.Corner1) &&
+						SameVector(trigger->Corner2, newtrig.Corner2))
 					{
-						curcam.TriggerType = Cam::Shared::CameraTriggerType::ByName;
+						continue;
 					}
 
-					else
+					/*
+						Moved to another camera.
+					*/
+					auto oldcamera = TheCamMap.FindCameraByID(trigger->LinkedCameraID);
+
+					if (oldcamera && trigger->LinkedCameraID != camdata.ID)
 					{
-						for (auto trigit = triggerit->value.Begin(); trigit != triggerit->value.End(); ++trigit)
-						{
-							const auto& trigval = *trigit;
+						auto& oldids = oldcamera->LinkedTriggerIDs;
+						oldids.erase(std::remove(oldids.begin(), oldids.end(), trigdata.ID), oldids.end());
+					}
+				}
 
-							Cam::MapTrigger curtrig;
+				ClaimLoadedID(newtrig.ID, TheCamMap.NextTriggerID);
 
-							{
-								const auto& corneritr = trigval.FindMember("Corner1");
+				auto& changedtrig = TheCamMap.Triggers.Insert(newtrig.ID, std::move(newtrig));
+				TheCamMap.UpdateTriggerBounds(changedtrig);
 
-								if (corneritr == trigval.MemberEnd())
-								{
-									conmessage(at_console, "HLCAM: Missing \"Corner1\" entry in \"Trigger\" for \"%s\"\n", mapname.c_str());
-									return;
-								}
+				changes.TriggerIDs.push_back(changedtrig.ID);
+			}
 
-								const auto& cornerval = corneritr->value;
+			auto camera = TheCamMap.FindCameraByID(camdata.ID);
 
-								curtrig.Corner1.x = cornerval[0].GetDouble();
-								curtrig.Corner1.y = cornerval[1].GetDouble();
-								curtrig.Corner1.z = cornerval[2].GetDouble();
-							}
+			if (!camera)
+			{
+				ClaimLoadedID(camdata.ID, TheCamMap.NextCameraID);
 
-							{
-								const auto& corneritr = trigval.FindMember("Corner2");
+				auto newcam = CameraFromData(camdata);
+				newcam.LinkedTriggerIDs = std::move(triggerids);
 
-								if (corneritr == trigval.MemberEnd())
-								{
-									conmessage(at_console, "HLCAM: Missing \"Corner2\" entry in \"Trigger\" for \"%s\"\n", mapname.c_str());
-									return;
-								}
+				AddLoadedCamera(newcam);
 
-								const auto& cornerval = corneritr->value;
+				changes.CameraIDs.push_back(camdata.ID);
+				continue;
+			}
 
-								curtrig.Corner2.x = cornerval[0].GetDouble();
-								curtrig.Corner2.y = cornerval[1].GetDouble();
-								curtrig.Corner2.z = cornerval[2].GetDouble();
-							}
+			camera->LinkedTriggerIDs = std::move(triggerids);
 
-							curtrig.SetupPositions();
+			if (!SameCameraSettings(TheCamMap.CreateCameraData(*camera), camdata))
+			{
+				auto updated = CameraFromData(camdata);
 
-							curtrig.ID = TheCamMap.NextTriggerID;
+				updated.LinkedTriggerIDs = std::move(camera->LinkedTriggerIDs);
+				updated.TargetCamera = camera->TargetCamera;
 
-							curtrig.LinkedCameraID = curcam.ID;
+				*camera = std::move(updated);
+				UpdateCameraEntity(*camera);
 
-							curcam.LinkedTriggerIDs.push_back(curtrig.ID);
-							TheCamMap.Triggers[TheCamMap.NextTriggerID] = std::move(curtrig);
+				changes.CameraIDs.push_back(camera->ID);
+			}
+		}
 
-							TheCamMap.NextTriggerID++;
-						}
-					}
-				}
+		/*
+			Items are moved around as others are removed, so
+			what goes is collected by ID first.
+		*/
+		std::vector<size_t> removeids;
 
-				{
-					const auto& positr = camval.FindMember("Position");
+		for (const auto& cam : TheCamMap.Cameras)
+		{
+			if (filecameras.find(cam.ID) == filecameras.end())
+			{
+				removeids.push_back(cam.ID);
+			}
+		}
 
-					if (positr == camval.MemberEnd())
-					{
-						conmessage(at_console, "HLCAM: Missing \"Position\" entry in \"Camera\" for \"%s\"\n", mapname.c_str());
-						return;
-					}
+		auto triggercount = TheCamMap.Triggers.GetCount();
 
-					const auto& posval = positr->value;
-					
-					curcam.Position.x = posval[0].GetDouble();
-					curcam.Position.y = posval[1].GetDouble();
-					curcam.Position.z = posval[2].GetDouble();
-				}
+		/*
+			Takes along the triggers that are still linked to it.
+		*/
+		for (auto id : removeids)
+		{
+			TheCamMap.RemoveCamera(TheCamMap.FindCameraByID(id));
+		}
 
-				{
-					const auto& angitr = camval.FindMember("Angle");
+		changes.RemovedCameras = removeids.size();
+		removeids.clear();
 
-					if (angitr == camval.MemberEnd())
-					{
-						conmessage(at_console, "HLCAM: Missing \"Angle\" entry in \"Camera\" for \"%s\"\n", mapname.c_str());
-						return;
-					}
+		for (const auto& trig : TheCamMap.Triggers)
+		{
+			if (filetriggers.find(trig.ID) == filetriggers.end())
+			{
+				removeids.push_back(trig.ID);
+			}
+		}
 
-					const auto& angval = angitr->value;
+		for (auto id : removeids)
+		{
+			TheCamMap.RemoveTriggerFromID(id);
+		}
 
-					curcam.Angle.x = angval[0].GetDouble();
-					curcam.Angle.y = angval[1].GetDouble();
-					curcam.Angle.z = angval[2].GetDouble();
-				}
+		changes.RemovedTriggers = triggercount - TheCamMap.Triggers.GetCount();
 
-				{
-					const auto& fovitr = camval.FindMember("FOV");
+		auto selectedcam = TheCamMap.CurrentSelectionCameraID;
+		auto selectedtrig = TheCamMap.CurrentSelectionTriggerID;
 
-					if (fovitr != camval.MemberEnd())
-					{
-						curcam.FOV = fovitr->value.GetDouble();
-					}
-				}
+		if ((selectedcam != -1 && !TheCamMap.FindCameraByID(selectedcam)) ||
+			(selectedtrig != -1 && !TheCamMap.FindTriggerByID(selectedtrig)))
+		{
+			TheCamMap.UnSelectAll();
+		}
+	}
 
-				{
-					const auto& speeditr = camval.FindMember("Speed");
+	/*
+		Every edit is made to a copy of its camera first. The map only
+		changes once all of them could be made and every camera they
+		touched is still valid, the sender gets one result either way.
+	*/
+	/*
+		The script waits on a connection it made for the batch, which
+		is gone if it stopped waiting.
+	*/
+	void SendScriptResult(const Cam::Shared::MapBatch::Result& result)
+	{
+		Shared::Interprocess::Client client;
 
-					if (speeditr != camval.MemberEnd())
-					{
-						curcam.MaxSpeed = speeditr->value.GetDouble();
-					}
-				}
+		try
+		{
+			client.Connect(Cam::Shared::MapBatch::GetResultConnectionName(result.BatchID));
+		}
 
-				{
-					const auto& looktypeitr = camval.FindMember("LookType");
+		catch (const boost::interprocess::interprocess_exception&)
+		{
+			g_engfuncs.pfnAlertMessage(at_aiconsole, "HLCAM: Script of batch %u no longer waits for the result\n", result.BatchID);
+			return;
+		}
 
-					if (looktypeitr != camval.MemberEnd())
-					{
-						curcam.LookType = Cam::Shared::CameraLookTypeFromString(looktypeitr->value.GetString());
-					}
+		auto pack = client.AcquireBuffer();
+		Cam::Shared::Schema::EncodePacket(pack, result);
 
-					{
-						if (curcam.LookType == Cam::Shared::CameraLookType::AtTarget)
-						{
-							const auto& looktargetitr = camval.FindMember("LookTargetName");
+		client.Write(Cam::Shared::Messages::Game::OnBatchApplied, std::move(pack));
+	}
 
-							if (looktargetitr != camval.MemberEnd())
-							{
-								curcam.LookTargetData.Name = looktargetitr->value.GetString();
-							}
-						}
-					}
-				}
+	void ApplyCameraBatch(Utility::BinaryBufferView& data, bool fromscript)
+	{
+		namespace MapBatch = Cam::Shared::MapBatch;
 
-				{
-					const auto& looktypeitr = camval.FindMember("PlaneType");
+		MapBatch::Result result;
 
-					if (looktypeitr != camval.MemberEnd())
-					{
-						curcam.PlaneType = Cam::Shared::CameraPlaneTypeFromString(looktypeitr->value.GetString());
-					}
-				}
+		std::vector<Cam::Shared::MapCameraData> staged;
+		std::unordered_map<uint32_t, size_t> stagedindices;
 
-				{
-					const auto& looktypeitr = camval.FindMember("TriggerType");
+		uint32_t editindex = 0;
 
-					if (looktypeitr != camval.MemberEnd())
-					{
-						curcam.TriggerType = Cam::Shared::CameraTriggerTypeFromString(looktypeitr->value.GetString());
-					}
-				}
+		auto applied = Cam::Shared::Schema::Wire::ReadRaw(data, result.BatchID);
+
+		if (!applied)
+		{
+			result.Error = "Batch has no ID";
+		}
+
+		else if (!TheCamMap.IsEditing || TheCamMap.CurrentState != Cam::Shared::StateType::Inactive)
+		{
+			applied = false;
+			result.Error = "Game is not in edit mode or is in the middle of another edit";
+		}
+
+		while (applied && data.GetReadPosition() < data.GetSize())
+		{
+			uint32_t cameraid;
 
+			if (!MapBatch::ReadCameraID(data, cameraid))
+			{
+				applied = false;
+				result.Error = "Edit is cut short";
+				break;
+			}
+
+			auto camera = TheCamMap.FindCameraByID(cameraid);
+
+			if (!camera)
+			{
+				applied = false;
+				result.Error = "No camera with ID " + std::to_string(cameraid);
+				break;
+			}
+
+			auto place = stagedindices.emplace(cameraid, staged.size());
+
+			if (place.second)
+			{
+				staged.push_back(TheCamMap.CreateCameraData(*camera));
+			}
+
+			std::string error;
+
+			if (!MapBatch::ReadEdit(data, staged[place.first->second], error))
+			{
+				applied = false;
+				result.Error = "Camera " + std::to_string(cameraid) + ": " + error;
+				break;
+			}
+
+			editindex++;
+		}
+
+		if (applied)
+		{
+			std::vector<Cam::Shared::MapFile::MapIssue> issues;
+
+			for (const auto& camdata : staged)
+			{
+				Cam::Shared::MapFile::CheckCamera(camdata, "Camera " + std::to_string(camdata.ID), issues);
+			}
+
+			for (const auto& issue : issues)
+			{
+				if (issue.Severity == Cam::Shared::MapFile::MapIssue::SeverityType::Error)
 				{
-					const auto& useattachitr = camval.FindMember("UseAttachment");
+					applied = false;
+					result.Error = issue.Message;
+					break;
+				}
+			}
+		}
 
-					if (useattachitr != camval.MemberEnd())
-					{
-						curcam.UseAttachment = useattachitr->value.GetBool();
-					}
+		if (applied)
+		{
+			std::vector<size_t> changedids;
 
-					if (curcam.UseAttachment)
-					{
-						curcam.AttachmentData.Name = camval["AttachmentTargetName"].GetString();
+			for (const auto& camdata : staged)
+			{
+				auto camera = TheCamMap.FindCameraByID(camdata.ID);
 
-						const auto& posval = camval["AttachmentOffset"];
-						curcam.AttachmentData.Offset.x = posval[0].GetDouble();
-						curcam.AttachmentData.Offset.y = posval[1].GetDouble();
-						curcam.AttachmentData.Offset.z = posval[2].GetDouble();
-					}
+				if (SameCameraSettings(TheCamMap.CreateCameraData(*camera), camdata))
+				{
+					continue;
 				}
 
+				auto updated = CameraFromData(camdata);
+
+				updated.LinkedTriggerIDs = std::move(camera->LinkedTriggerIDs);
+				updated.TargetCamera = camera->TargetCamera;
+
+				*camera = std::move(updated);
+				UpdateCameraEntity(*camera);
+
+				JournalCamera(*camera);
+				changedids.push_back(camera->ID);
+			}
+
+			result.Applied = true;
+			result.EditCount = editindex;
+			result.CameraCount = static_cast<uint32_t>(changedids.size());
+
+			if (!changedids.empty())
+			{
+				/*
+					Other players were sent the cameras as they were journaled.
+				*/
+				if (TheCamMap.LocalPlayer)
 				{
-					const auto& looktypeitr = camval.FindMember("ZoomType");
+					TheCamMap.QueueMapUpdate(TheCamMap.GetLocalState(), changedids, {});
+				}
 
-					if (looktypeitr != camval.MemberEnd())
+				/*
+					The editor only knows about edits it made itself.
+				*/
+				if (fromscript && TheCamMap.GameServer.IsStarted())
+				{
+					for (auto id : changedids)
 					{
-						curcam.ZoomType = Cam::Shared::CameraZoomTypeFromString(looktypeitr->value.GetString());
+						TheCamMap.GameServer.Write
+						(
+							Cam::Shared::Messages::Game::OnCameraChanged,
+							TheCamMap.CreateInterprocessPacket(TheCamMap.GetInterprocessCameraInfo(TheCamMap.Cameras[id]))
+						);
+					}
+				}
+			}
 
-						if (curcam.ZoomType != Cam::Shared::CameraZoomType::None &&
-							curcam.ZoomType != Cam::Shared::CameraZoomType::ZoomByDistance)
-						{
-							{
-								const auto& zoomtimeitr = camval.FindMember("ZoomTime");
+			g_engfuncs.pfnAlertMessage(at_aiconsole, "HLCAM: Batch %u made %u edits, %u cameras changed\n", result.BatchID, result.EditCount, result.CameraCount);
+		}
 
-								if (zoomtimeitr != camval.MemberEnd())
-								{
-									curcam.ZoomData.ZoomTime = zoomtimeitr->value.GetDouble();
-								}
-							}
+		else
+		{
+			result.FailedEdit = editindex;
+			g_engfuncs.pfnAlertMessage(at_console, "HLCAM: Batch %u not applied, %s\n", result.BatchID, result.Error.c_str());
+		}
+
+		if (fromscript)
+		{
+			SendScriptResult(result);
+		}
+
+		else if (TheCamMap.GameServer.IsStarted())
+		{
+			auto pack = TheCamMap.GameServer.AcquireBuffer();
+			Cam::Shared::Schema::EncodePacket(pack, result);
+
+			TheCamMap.GameServer.Write(Cam::Shared::Messages::Game::OnBatchApplied, std::move(pack));
+		}
+	}
 
-							{
-								const auto& endfovitr = camval.FindMember("ZoomEndFOV");
+	void ReloadChangedMapFile()
+	{
+		auto conmessage = g_engfuncs.pfnAlertMessage;
 
-								if (endfovitr != camval.MemberEnd())
-								{
-									curcam.ZoomData.EndFov = endfovitr->value.GetDouble();
-								}
-							}
+		auto reloadstart = std::chrono::steady_clock::now();
+		auto jsonpath = GetMapFilePath(TheCamMap.CurrentMapName, ".json");
 
-							{
-								const auto& interpitr = camval.FindMember("ZoomInterpMethod");
+		std::vector<char> bytes;
 
-								if (interpitr != camval.MemberEnd())
-								{
-									curcam.ZoomData.InterpMethod = Cam::Shared::CameraAngleTypeFromString(interpitr->value.GetString());
-								}
-							}
-						}
-					}
-				}
+		if (!Cam::Shared::MapFile::ReadAllBytes(jsonpath.c_str(), bytes))
+		{
+			return;
+		}
 
-				curcam.TargetCamera = static_cast<CTriggerCamera*>(CBaseEntity::Create("trigger_camera", curcam.Position, curcam.Angle));
+		Cam::Shared::MapData mapdata;
+		std::string error;
 
-				if (curcam.TriggerType == Cam::Shared::CameraTriggerType::ByName)
-				{
-					const auto& nameit = camval.FindMember("Name");
+		/*
+			Unlike loading, a file with errors changes nothing. It is
+			likely still being written and missing whatever follows.
+		*/
+		if (!Cam::Shared::MapFile::ReadJSON(bytes.data(), mapdata, error))
+		{
+			conmessage(at_console, "HLCAM: Changed camera file not applied, %s\n", error.c_str());
+			return;
+		}
 
-					if (nameit == camval.MemberEnd())
-					{
-						conmessage(at_console, "HLCAM: Camera triggered by name missing name in \"%s\"\n", mapname.c_str());
-						return;
-					}
+		MapChanges changes;
+		ApplyMapChanges(mapdata, changes);
 
-					curcam.Name = nameit->value.GetString();
-					
-					curcam.TargetCamera->pev->targetname = g_engfuncs.pfnAllocString(curcam.Name.c_str());
-				}
+		if (changes.IsEmpty())
+		{
+			return;
+		}
 
-				curcam.TargetCamera->SetupHLCamera(curcam);
+		TheCamMap.QueueMapUpdate(changes.CameraIDs, changes.TriggerIDs);
 
-				TheCamMap.Cameras[curcam.ID] = std::move(curcam);
-			}
+		if (TheCamMap.IsEditing)
+		{
+			TheCamMap.SendMapReset();
 		}
-	}
 
-	void LoadNewMap(const char* name)
-	{
-		if (!TheCamMap.CurrentMapName.empty())
+		/*
+			Journaled edits were made to the old file and would be
+			replayed over the new one, so they are saved away now.
+		*/
+		if (MapJournal.IsOpen() && MapJournal.GetRecordBytes() != 0)
 		{
-			ResetCurrentMap();
+			QueueMapSave();
 		}
-		
-		TheCamMap.CurrentMapName = name;
-		LoadMapDataFromFile(TheCamMap.CurrentMapName);
-		TheCamMap.NeedsToSendMapUpdate = true;
+
+		auto reloadtime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - reloadstart).count();
+
+		conmessage(at_console, "HLCAM: Applied changed camera file, %u cameras and %u triggers updated, %u cameras and %u triggers removed (%.2f ms)\n",
+				   static_cast<unsigned>(changes.CameraIDs.size()),
+				   static_cast<unsigned>(changes.TriggerIDs.size()),
+				   static_cast<unsigned>(changes.RemovedCameras),
+				   static_cast<unsigned>(changes.RemovedTriggers),
+				   reloadtime);
 	}
 
-	void ActivateNewCamera(Cam::MapCamera* camera)
+	void CheckMapFileChanges()
 	{
-		if (camera->TargetCamera)
+		if (!MapWatcher.IsStarted() || TheCamMap.CurrentMapName.empty())
 		{
-			if (TheCamMap.ActiveCamera != camera)
-			{
-				camera->TargetCamera->Use(nullptr, nullptr, USE_ON, 1);
+			return;
+		}
 
-				MESSAGE_BEGIN(MSG_ONE, HLCamMessage::CameraSwitch, nullptr, TheCamMap.LocalPlayer->pev);
-				WRITE_COORD(camera->Position.x);
-				WRITE_COORD(camera->Position.y);
-				WRITE_COORD(camera->Position.z);
-				MESSAGE_END();
+		std::vector<std::string> names;
+		MapWatcher.Poll(names);
 
-				TheCamMap.ActiveCamera = camera;
-			}
-		}
-	}
+		auto filename = TheCamMap.CurrentMapName + ".json";
 
-	void PlayerEnterTrigger(Cam::MapTrigger& trig)
-	{
-		if (!trig.Active)
+		for (const auto& name : names)
 		{
-			if (TheCamMap.ActiveTrigger)
+			if (name.empty() || name == filename)
 			{
-				TheCamMap.ActiveTrigger->Active = false;
+				TheCamMap.MapFileChanged = true;
+			}
+		}
 
-				auto oldcamera = TheCamMap.GetLinkedCamera(*TheCamMap.ActiveTrigger);
+		if (!TheCamMap.MapFileChanged)
+		{
+			return;
+		}
 
-				if (!oldcamera)
-				{
-					g_engfuncs.pfnAlertMessage(at_console, "HLCAM: Trigger has no linked camera\n");
-					return;
-				}
+		/*
+			Waits for our own saves to land so they can be recognized,
+			and for the editing player to finish what they are placing.
+		*/
+		if (MapWriter.GetStats().InFlight != 0 ||
+			!TheCamMap.LocalPlayer ||
+			TheCamMap.CurrentState != Cam::Shared::StateType::Inactive)
+		{
+			return;
+		}
 
-				if (oldcamera->TargetCamera)
-				{
-					/*
-						Previous camera has to be told to be disabled to allow us
-						to change to a new one.
-					*/
-					if (trig.LinkedCameraID != TheCamMap.ActiveTrigger->LinkedCameraID)
-					{
-						oldcamera->TargetCamera->Use(nullptr, nullptr, USE_OFF, 1);
-					}
-				}
-			}
+		TheCamMap.MapFileChanged = false;
 
-			auto newcam = TheCamMap.GetLinkedCamera(trig);
+		auto jsonpath = GetMapFilePath(TheCamMap.CurrentMapName, ".json");
 
-			trig.Active = true;
-			ActivateNewCamera(newcam);
+		Cam::Shared::MapFile::FileStamp stamp;
 
-			TheCamMap.ActiveTrigger = &trig;
+		if (!Cam::Shared::MapFile::GetFileStamp(jsonpath.c_str(), stamp))
+		{
+			return;
+		}
 
-			TheCamMap.LocalPlayer->LastTriggerID = trig.ID;
+		if (LastSavedFile.Path == jsonpath &&
+			LastSavedFile.Stamp.Size == stamp.Size &&
+			LastSavedFile.Stamp.Time == stamp.Time)
+		{
+			return;
 		}
+
+		ReloadChangedMapFile();
 	}
 }
 
@@ -1780,41 +3544,93 @@ void Cam::OnNewMap(const char* name)
 
 void Cam::Deactivate()
 {
-	ShouldPauseMessageThread = true;
-
 	for (auto& cam : TheCamMap.Cameras)
 	{
-		UTIL_Remove(cam.second.TargetCamera);
-		cam.second.TargetCamera = nullptr;
+		UTIL_Remove(cam.TargetCamera);
+		cam.TargetCamera = nullptr;
 	}
 
-	ShouldPauseMessageThread = false;
+	for (auto& state : TheCamMap.PlayerStates)
+	{
+		if (state.OwnCamera)
+		{
+			UTIL_Remove(state.OwnCamera);
+		}
+
+		state = PlayerCamState();
+	}
 }
 
 void Cam::CloseServer()
 {
 	ShouldCloseMessageThread = true;
+	TheCamMap.AppClient.Wake();
+	TheCamMap.ScriptServer.Wake();
 
 	if (MessageHandlerThread.joinable())
 	{
 		MessageHandlerThread.join();
 	}
 
+	if (ScriptHandlerThread.joinable())
+	{
+		ScriptHandlerThread.join();
+	}
+
+	MapWriter.Stop();
+	MapJournal.Close();
+	MapWatcher.Stop();
+
 	TheCamMap.GameServer.Write(Cam::Shared::Messages::Game::OnGameShutdown);
 
 	TheCamMap.GameServer.Stop();
 	TheCamMap.AppClient.Disconnect();
+
+	TheCamMap.ScriptServer.Stop();
 }
 
 void Cam::Restore(const RestoreData& data)
 {
-	CameraRestore = data;
-	NeedsRestore = true;
+	if (data.PlayerIndex < 1 || data.PlayerIndex > MaxPlayers)
+	{
+		return;
+	}
+
+	auto& pending = PendingRestores[data.PlayerIndex - 1];
+
+	pending.TriggerID = data.TriggerID;
+	pending.NeedsRestore = true;
 }
 
-void Cam::NamedCameraActivate(size_t id)
+void Cam::NamedCameraActivate(size_t id, CBaseEntity* activator)
 {
-	ActivateNewCamera(TheCamMap.FindCameraByID(id));
+	auto camera = TheCamMap.FindCameraByID(id);
+
+	if (!camera || !camera->TargetCamera)
+	{
+		return;
+	}
+
+	if (!activator || !activator->IsPlayer())
+	{
+		activator = UTIL_PlayerByIndex(1);
+
+		if (!activator)
+		{
+			return;
+		}
+	}
+
+	auto& state = TheCamMap.GetPlayerState(static_cast<CBasePlayer*>(activator));
+
+	/*
+		Named cameras are used by map entities directly, the player
+		looks through the shared entity that was used.
+	*/
+	if (TheCamMap.GetActiveCamera(state) != camera)
+	{
+		SwitchPlayerView(state, *camera, camera->TargetCamera);
+	}
 }
 
 namespace
@@ -1834,6 +3650,12 @@ namespace
 		bool isnamed = g_engfuncs.pfnCmd_Argc() == 2;
 		const char* name;
 
+		if (!EnsureFreeMapID(TheCamMap.NextCameraID, "camera") ||
+			(!isnamed && !EnsureFreeMapID(TheCamMap.NextTriggerID, "trigger")))
+		{
+			return;
+		}
+
 		if (isnamed)
 		{
 			name = g_engfuncs.pfnCmd_Argv(1);
@@ -1896,7 +3718,7 @@ namespace
 
 			TheCamMap.CreationTriggerID = newtrig.ID;
 
-			TheCamMap.Triggers[TheCamMap.NextTriggerID] = std::move(newtrig);
+			TheCamMap.Triggers.Insert(TheCamMap.NextTriggerID, std::move(newtrig));
 
 			TheCamMap.NextTriggerID++;
 		}
@@ -1913,14 +3735,62 @@ namespace
 			TheCamMap.GameServer.Write
 			(
 				Cam::Shared::Messages::Game::OnNamedCameraAdded,
-				TheCamMap.GetInterprocessCameraInfo(newcam)
+				TheCamMap.CreateInterprocessPacket(TheCamMap.GetInterprocessCameraInfo(newcam))
 			);
 		}
 
 		g_engfuncs.pfnAlertMessage(at_console, "HLCAM: Created camera with ID \"%u\"\n", TheCamMap.NextCameraID);
 
 		TheCamMap.NextCameraID++;
-		TheCamMap.Cameras[newcam.ID] = std::move(newcam);
+
+		auto& addedcam = TheCamMap.Cameras.Insert(newcam.ID, std::move(newcam));
+
+		/*
+			Trigger cameras are journaled once their trigger is finished.
+		*/
+		if (isnamed)
+		{
+			JournalCamera(addedcam);
+		}
+	}
+
+	/*
+		Scripts can't make batch edits without it, the editor works either way.
+	*/
+	void StartScriptServer(Shared::Interprocess::Server& server, const char* name)
+	{
+		try
+		{
+			server.Start(name, Shared::Interprocess::Config::TransportType::MessageQueue);
+			return;
+		}
+
+		catch (const boost::interprocess::interprocess_exception& error)
+		{
+			server.Stop();
+
+			auto code = error.get_error_code();
+
+			if (code != boost::interprocess::error_code_t::already_exists_error)
+			{
+				g_engfuncs.pfnAlertMessage(at_console, "HLCAM: Could not start \"%s\": \"%s\" (%d)\n", name, error.what(), code);
+				return;
+			}
+		}
+
+		/*
+			Left behind by a game that did not close, removed by Stop above.
+		*/
+		try
+		{
+			server.Start(name, Shared::Interprocess::Config::TransportType::MessageQueue);
+		}
+
+		catch (const boost::interprocess::interprocess_exception& error)
+		{
+			server.Stop();
+			g_engfuncs.pfnAlertMessage(at_console, "HLCAM: Could not start \"%s\": \"%s\" (%d)\n", name, error.what(), error.get_error_code());
+		}
 	}
 
 	void HLCAM_StartEdit()
@@ -1940,12 +3810,7 @@ namespace
 		MESSAGE_END();
 
 		bool needsmapupdate = TheCamMap.NeedsToSendMapUpdate;
-
-		if (TheCamMap.NeedsToSendMapUpdate)
-		{
-			TheCamMap.SendMapUpdate();
-			TheCamMap.NeedsToSendMapUpdate = false;
-		}
+		TheCamMap.NeedsToSendMapUpdate = false;
 
 		bool needsinitialize = !TheCamMap.GameServer.IsStarted();
 
@@ -1980,212 +3845,521 @@ namespace
 
 			catch (const boost::interprocess::interprocess_exception& error)
 			{
-				auto code = error.get_error_code();
+				auto code = error.get_error_code();
+
+				g_engfuncs.pfnAlertMessage(at_console, "HLCAM: Could not connect to HLCAM App Server: \"%s\" (%d)\n", error.what(), code);
+				TheCamMap.AppClient.Disconnect();
+			}
+
+			StartScriptServer(TheCamMap.ScriptServer, Cam::Shared::MapBatch::ScriptConnectionName);
+
+			ShouldCloseMessageThread = false;
+			StartMessageThread(MessageHandlerThread, &MessageHandler);
+
+			if (TheCamMap.ScriptServer.IsStarted())
+			{
+				StartMessageThread(ScriptHandlerThread, &ScriptHandler);
+			}
+		}
+
+		namespace Message = Cam::Shared::Messages::Game;
+
+		if (needsmapupdate)
+		{
+			TheCamMap.SendMapReset();
+		}
+
+		else
+		{
+			auto pack = Utility::BinaryBufferHelp::CreatePacket(false);
+
+			TheCamMap.GameServer.Write
+			(
+				Message::OnEditModeStarted,
+				std::move(pack)
+			);
+		}
+
+		TheCamMap.GoFirstPerson(TheCamMap.GetLocalState());
+	}
+
+	/*
+		Journaled edits are already on disk, the map is only saved
+		in full once replaying them would slow down loading.
+	*/
+	bool IsJournalFull()
+	{
+		return MapJournal.GetRecordBytes() > Commands::JournalCompactSize.value;
+	}
+
+	void HLCAM_StopEdit()
+	{
+		if (!EnsureEditMode())
+		{
+			return;
+		}
+
+		TheCamMap.IsEditing = false;
+
+		MESSAGE_BEGIN(MSG_ONE, HLCamMessage::MapEditStateChanged, nullptr, TheCamMap.LocalPlayer->pev);
+		WRITE_BYTE(TheCamMap.IsEditing);
+		MESSAGE_END();
+
+		TheCamMap.GameServer.Write(Cam::Shared::Messages::Game::OnEditModeStopped);
+
+		/*
+			Edits were not sent to the editing client as they were made,
+			it gets the cameras again now that nothing is selected.
+		*/
+		std::vector<size_t> cameraids;
+
+		for (const auto& cam : TheCamMap.Cameras)
+		{
+			cameraids.push_back(cam.ID);
+		}
+
+		TheCamMap.QueueMapUpdate(TheCamMap.GetLocalState(), cameraids, {});
+
+		if ((!MapJournal.IsOpen() || IsJournalFull()) && EnsureInactiveState())
+		{
+			QueueMapSave();
+		}
+	}
+
+	void HLCAM_Shutdown()
+	{
+		Cam::CloseServer();
+	}
+
+	void HLCAM_SaveMap()
+	{
+		if (!TheCamMap.IsEditing)
+		{
+			g_engfuncs.pfnAlertMessage(at_console, "HLCAM: Can only save in edit mode\n");
+			return;
+		}
+
+		if (!EnsureInactiveState())
+		{
+			return;
+		}
+
+		QueueMapSave();
+	}
+
+	/*
+		Hands a snapshot of the map to the save worker. The edits journaled
+		so far are in the snapshot, so the journal is moved aside for the
+		worker to remove once the snapshot is written.
+	*/
+	void QueueMapSave()
+	{
+		ScopedTiming timing(Timing::SaveMap);
+
+		auto snapshotstart = std::chrono::steady_clock::now();
+
+		Cam::Shared::MapFile::AsyncWriter::SaveRequest request;
+		request.Map = TheCamMap.CreateMapData();
+		request.JSONPath = GetMapFilePath(TheCamMap.CurrentMapName, ".json");
+		request.BinaryPath = GetMapFilePath(TheCamMap.CurrentMapName, ".hlcb");
+
+		if (MapJournal.IsOpen())
+		{
+			request.JournalPath = GetMapFilePath(TheCamMap.CurrentMapName, ".hlcj.old");
+		}
+
+		auto journalpath = request.JournalPath;
+
+		auto snapshottime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - snapshotstart).count();
+
+		SaveStats.LastSnapshotTime = snapshottime;
+
+		if (snapshottime > SaveStats.MaxSnapshotTime)
+		{
+			SaveStats.MaxSnapshotTime = snapshottime;
+		}
+
+		MapWriter.Queue(std::move(request));
+
+		/*
+			On failure the records stay in the current journal,
+			replaying them over the newer save changes nothing.
+		*/
+		if (MapJournal.IsOpen() && !MapJournal.Rotate(journalpath.c_str()))
+		{
+			g_engfuncs.pfnAlertMessage(at_console, "HLCAM: Could not move aside camera map journal\n");
+		}
+	}
+
+	/*
+		Reports saves the worker has finished, engine output
+		is only safe from the game thread.
+	*/
+	void ReportFinishedSaves()
+	{
+		Cam::Shared::MapFile::AsyncWriter::SaveResult result;
+
+		while (MapWriter.PopResult(result))
+		{
+			if (result.Success)
+			{
+				g_engfuncs.pfnAlertMessage(at_console, "HLCAM: Saved camera map \"%s\" (%.1f ms)\n", result.JSONPath.c_str(), result.Milliseconds);
 
-				g_engfuncs.pfnAlertMessage(at_console, "HLCAM: Could not connect to HLCAM App Server: \"%s\" (%d)\n", error.what(), code);
-				TheCamMap.AppClient.Disconnect();
+				LastSavedFile.Path = result.JSONPath;
+				Cam::Shared::MapFile::GetFileStamp(result.JSONPath.c_str(), LastSavedFile.Stamp);
 			}
 
-			ShouldCloseMessageThread = false;
-			MessageHandlerThread = std::thread(&MessageHandler);
+			else
+			{
+				g_engfuncs.pfnAlertMessage(at_console, "HLCAM: Could not write camera map \"%s\"\n", result.JSONPath.c_str());
+			}
 		}
+	}
 
-		namespace Message = Cam::Shared::Messages::Game;
+	void PrintSaveStats()
+	{
+		auto stats = MapWriter.GetStats();
+		auto finished = stats.Completed + stats.Failed;
 
-		if (needsmapupdate)
-		{
-			auto pack = Utility::BinaryBufferHelp::CreatePacket(true);
-			pack << TheCamMap.CurrentMapName;
+		auto conmessage = g_engfuncs.pfnAlertMessage;
 
-			pack << static_cast<uint16>(TheCamMap.Cameras.size());
-			for (const auto& cam : TheCamMap.Cameras)
-			{
-				pack.Append(TheCamMap.GetInterprocessCameraInfo(cam.second));
-			}
+		conmessage(at_console, "HLCAM: Saves in flight: %u, completed: %u, failed: %u, replaced while queued: %u\n",
+				   static_cast<unsigned>(stats.InFlight),
+				   static_cast<unsigned>(stats.Completed),
+				   static_cast<unsigned>(stats.Failed),
+				   static_cast<unsigned>(stats.Replaced));
 
-			TheCamMap.GameServer.Write
-			(
-				Message::OnEditModeStarted,
-				std::move(pack)
-			);
-		}
+		conmessage(at_console, "HLCAM: Save latency last: %.2f ms, average: %.2f ms, max: %.2f ms\n",
+				   stats.LastMilliseconds,
+				   finished ? stats.TotalMilliseconds / finished : 0.0,
+				   stats.MaxMilliseconds);
 
-		else
-		{
-			auto pack = Utility::BinaryBufferHelp::CreatePacket(false);
+		conmessage(at_console, "HLCAM: Snapshot time last: %.3f ms, max: %.3f ms\n",
+				   SaveStats.LastSnapshotTime,
+				   SaveStats.MaxSnapshotTime);
 
-			TheCamMap.GameServer.Write
-			(
-				Message::OnEditModeStarted,
-				std::move(pack)
-			);
+		if (MapJournal.IsOpen())
+		{
+			conmessage(at_console, "HLCAM: Journaled edits since last save: %u (%u bytes)\n",
+					   static_cast<unsigned>(MapJournal.GetRecordCount()),
+					   static_cast<unsigned>(MapJournal.GetRecordBytes()));
 		}
-
-		TheCamMap.GoFirstPerson();
 	}
 
-	void HLCAM_SaveMap();
+	void PrintQueueStats()
+	{
+		auto conmessage = g_engfuncs.pfnAlertMessage;
+
+		conmessage(at_console, "HLCAM: Message queue depth: %u/%u, last frame: %u, max: %u\n",
+				   static_cast<unsigned>(InvokeQueue.GetSize()),
+				   static_cast<unsigned>(InvokeQueue.GetCapacity()),
+				   static_cast<unsigned>(InvokeStats.LastDepth),
+				   static_cast<unsigned>(InvokeStats.MaxDepth));
 
-	void HLCAM_StopEdit()
+		conmessage(at_console, "HLCAM: Script batches waiting: %u/%u\n",
+				   static_cast<unsigned>(ScriptQueue.GetSize()),
+				   static_cast<unsigned>(ScriptQueue.GetCapacity()));
+
+		conmessage(at_console, "HLCAM: Messages run: %u, waits on full queue: %u\n",
+				   static_cast<unsigned>(InvokeStats.Executed),
+				   static_cast<unsigned>(InvokeStats.FullWaits));
+
+		conmessage(at_console, "HLCAM: Drain time last: %.3f ms, max: %.3f ms\n",
+				   InvokeStats.LastDrainTime,
+				   InvokeStats.MaxDrainTime);
+	}
+
+	void PrintTriggerStats()
 	{
-		if (!EnsureEditMode())
-		{
-			return;
-		}
+		auto conmessage = g_engfuncs.pfnAlertMessage;
 
-		TheCamMap.IsEditing = false;
+		conmessage(at_console, "HLCAM: Server frames: %u, players checked: %u, players that hadn't moved: %u\n",
+				   static_cast<unsigned>(TriggerStats.Passes),
+				   static_cast<unsigned>(TriggerStats.PlayersChecked),
+				   static_cast<unsigned>(TriggerStats.IdleSkips));
 
-		MESSAGE_BEGIN(MSG_ONE, HLCamMessage::MapEditStateChanged, nullptr, TheCamMap.LocalPlayer->pev);
-		WRITE_BYTE(TheCamMap.IsEditing);
-		MESSAGE_END();
+		const auto& lookups = TriggerStats.Lookups;
 
-		TheCamMap.GameServer.Write(Cam::Shared::Messages::Game::OnEditModeStopped);
+		auto hits = lookups.ActiveHits + lookups.NeighbourHits;
+		auto frames = hits + lookups.Misses;
+
+		conmessage(at_console, "HLCAM: Trigger lookups: %u, found nearby: %.1f%% (same trigger: %u, neighbour: %u)\n",
+				   static_cast<unsigned>(frames),
+				   frames ? 100.0 * hits / frames : 0.0,
+				   static_cast<unsigned>(lookups.ActiveHits),
+				   static_cast<unsigned>(lookups.NeighbourHits));
 
-		MessageThreadSleepTime = IdleSleepTime;
+		conmessage(at_console, "HLCAM: Whole map searches: %u, outside every trigger: %u, shared between players: %u\n",
+				   static_cast<unsigned>(lookups.Misses),
+				   static_cast<unsigned>(lookups.EmptyMisses),
+				   static_cast<unsigned>(lookups.BatchedSearches));
 
-		HLCAM_SaveMap();
+		conmessage(at_console, "HLCAM: Trigger graph links: %u, rebuilt after edits: %u\n",
+				   static_cast<unsigned>(TheCamMap.TriggerGraph.GetLinkCount()),
+				   static_cast<unsigned>(TriggerStats.GraphBuilds));
 	}
 
-	void HLCAM_Shutdown()
+	void PrintTargetStats()
 	{
-		Cam::CloseServer();
+		auto lookups = TargetStats.CacheHits + TargetStats.Scans;
+
+		g_engfuncs.pfnAlertMessage(at_console, "HLCAM: Camera target lookups: %u, entity list walks avoided: %u (%.1f%%), names known: %u\n",
+								   static_cast<unsigned>(lookups),
+								   static_cast<unsigned>(TargetStats.CacheHits),
+								   lookups ? 100.0 * TargetStats.CacheHits / lookups : 0.0,
+								   static_cast<unsigned>(TheCamMap.NamedEntities.size()));
 	}
 
-	void HLCAM_SaveMap()
+	void CloseStatsDump()
 	{
-		if (!TheCamMap.IsEditing)
+		if (!StatsDump.File.is_open())
 		{
-			g_engfuncs.pfnAlertMessage(at_console, "HLCAM: Can only save in edit mode\n");
 			return;
 		}
 
-		if (!EnsureInactiveState())
+		StatsDump.File.close();
+
+		g_engfuncs.pfnAlertMessage(at_console, "HLCAM: Wrote %u frames of stats to \"%s\"\n",
+								   static_cast<unsigned>(StatsDump.Rows),
+								   StatsDump.Path.c_str());
+	}
+
+	void OpenStatsDump(const char* path)
+	{
+		CloseStatsDump();
+
+		StatsDump.File.open(path, std::ios::trunc);
+
+		if (!StatsDump.File)
 		{
+			g_engfuncs.pfnAlertMessage(at_console, "HLCAM: Could not open \"%s\" for stats\n", path);
 			return;
 		}
 
-		rapidjson::Document document;
-		document.SetObject();
-
-		auto& alloc = document.GetAllocator();
+		StatsDump.Path = path;
+		StatsDump.Rows = 0;
 
-		rapidjson::Value root(rapidjson::kArrayType);
+		StatsDump.LastApp = TheCamMap.AppClient.GetStats();
+		StatsDump.LastGame = TheCamMap.GameServer.GetStats();
 
-		for (const auto& camitr : TheCamMap.Cameras)
-		{
-			const auto& cam = camitr.second;
+		StatsDump.LastExecuted = InvokeStats.Executed;
+		StatsDump.LastFullWaits = InvokeStats.FullWaits;
+		StatsDump.LastPlayersChecked = TriggerStats.PlayersChecked;
+		StatsDump.LastTargetScans = TargetStats.Scans;
+		StatsDump.LastLookups = TriggerStats.Lookups;
 
-			rapidjson::Value thisvalue(rapidjson::kObjectType);
+		StatsDump.File << "time";
 
-			rapidjson::Value cameraval(rapidjson::kObjectType);
+		for (const auto& timing : Timings)
+		{
+			StatsDump.File << "," << timing.Name << "_ms";
+		}
 
-			const Cam::MapTrigger* linkedtrig = nullptr;
+		StatsDump.File << ",messages_in,bytes_in,messages_out,bytes_out,failed_out,queue_in,queue_out,invoke_queue";
+		StatsDump.File << ",tasks_run,full_waits,players_checked,trigger_nearby,trigger_searches,target_scans\n";
+	}
 
-			if (cam.TriggerType == Cam::Shared::CameraTriggerType::ByUserTrigger)
-			{
-				rapidjson::Value trigarray(rapidjson::kArrayType);
+	/*
+		Called as a server frame starts, closing the one before it.
+	*/
+	void EndStatsFrame()
+	{
+		if (StatsDump.File.is_open())
+		{
+			auto app = TheCamMap.AppClient.GetStats();
+			auto game = TheCamMap.GameServer.GetStats();
 
-				for (const auto& trigid : cam.LinkedTriggerIDs)
-				{
-					linkedtrig = TheCamMap.FindTriggerByID(trigid);
+			auto& file = StatsDump.File;
 
-					rapidjson::Value trigval(rapidjson::kObjectType);
+			file << gpGlobals->time;
 
-					rapidjson::Value corn1val(rapidjson::kArrayType);
-					rapidjson::Value corn2val(rapidjson::kArrayType);
+			for (const auto& timing : Timings)
+			{
+				file << "," << timing.FrameTime;
+			}
 
-					corn1val.PushBack(linkedtrig->Corner1.x, alloc);
-					corn1val.PushBack(linkedtrig->Corner1.y, alloc);
-					corn1val.PushBack(linkedtrig->Corner1.z, alloc);
+			/*
+				Counters can have been reset in between.
+			*/
+			auto delta = [](size_t now, size_t last)
+			{
+				return now >= last ? now - last : now;
+			};
 
-					corn2val.PushBack(linkedtrig->Corner2.x, alloc);
-					corn2val.PushBack(linkedtrig->Corner2.y, alloc);
-					corn2val.PushBack(linkedtrig->Corner2.z, alloc);
+			file << "," << delta(app.MessagesRead, StatsDump.LastApp.MessagesRead);
+			file << "," << delta(app.BytesRead, StatsDump.LastApp.BytesRead);
+			file << "," << delta(game.MessagesWritten, StatsDump.LastGame.MessagesWritten);
+			file << "," << delta(game.BytesWritten, StatsDump.LastGame.BytesWritten);
+			file << "," << delta(game.FailedWrites, StatsDump.LastGame.FailedWrites);
+			file << "," << app.QueueDepth;
+			file << "," << game.QueueDepth;
+			file << "," << InvokeQueue.GetSize();
 
-					trigval.AddMember("Corner1", std::move(corn1val), alloc);
-					trigval.AddMember("Corner2", std::move(corn2val), alloc);
+			/*
+				Drain time is the messagedrain column above.
+			*/
+			const auto& lookups = TriggerStats.Lookups;
+			const auto& lastlookups = StatsDump.LastLookups;
+
+			size_t fullwaits = InvokeStats.FullWaits;
+
+			file << "," << delta(InvokeStats.Executed, StatsDump.LastExecuted);
+			file << "," << delta(fullwaits, StatsDump.LastFullWaits);
+			file << "," << delta(TriggerStats.PlayersChecked, StatsDump.LastPlayersChecked);
+			file << "," << delta(lookups.ActiveHits + lookups.NeighbourHits, lastlookups.ActiveHits + lastlookups.NeighbourHits);
+			file << "," << delta(lookups.Misses, lastlookups.Misses);
+			file << "," << delta(TargetStats.Scans, StatsDump.LastTargetScans);
+			file << "\n";
+
+			StatsDump.LastApp = app;
+			StatsDump.LastGame = game;
+
+			StatsDump.LastExecuted = InvokeStats.Executed;
+			StatsDump.LastFullWaits = fullwaits;
+			StatsDump.LastPlayersChecked = TriggerStats.PlayersChecked;
+			StatsDump.LastTargetScans = TargetStats.Scans;
+			StatsDump.LastLookups = lookups;
+			StatsDump.Rows++;
+		}
 
-					trigarray.PushBack(std::move(trigval), alloc);
-				}
+		for (auto& timing : Timings)
+		{
+			timing.FrameTime = 0;
+		}
+	}
 
-				cameraval.AddMember("Triggers", std::move(trigarray), alloc);
-			}
+	void PrintPeerStats(const char* name, const Shared::Interprocess::PeerStats& stats)
+	{
+		auto conmessage = g_engfuncs.pfnAlertMessage;
 
-			rapidjson::Value camposval(rapidjson::kArrayType);
-			rapidjson::Value camangval(rapidjson::kArrayType);
+		/*
+			Rings have no message limit, only one on bytes.
+		*/
+		if (stats.QueueByteCapacity != 0)
+		{
+			conmessage(at_console, "HLCAM: %s: queued %u (%u/%u bytes)\n",
+					   name,
+					   static_cast<unsigned>(stats.QueueDepth),
+					   static_cast<unsigned>(stats.QueueBytes),
+					   static_cast<unsigned>(stats.QueueByteCapacity));
+		}
 
-			camposval.PushBack(cam.Position.x, alloc);
-			camposval.PushBack(cam.Position.y, alloc);
-			camposval.PushBack(cam.Position.z, alloc);
+		else
+		{
+			conmessage(at_console, "HLCAM: %s: queued %u/%u\n",
+					   name,
+					   static_cast<unsigned>(stats.QueueDepth),
+					   static_cast<unsigned>(stats.QueueCapacity));
+		}
 
-			camangval.PushBack(cam.Angle.x, alloc);
-			camangval.PushBack(cam.Angle.y, alloc);
-			camangval.PushBack(cam.Angle.z, alloc);
+		conmessage(at_console, "HLCAM: %s: written: %u (%u bytes, largest %u, failed %u, %.2f ms), read: %u (%u bytes, largest %u)\n",
+				   name,
+				   static_cast<unsigned>(stats.MessagesWritten),
+				   static_cast<unsigned>(stats.BytesWritten),
+				   static_cast<unsigned>(stats.LargestWrite),
+				   static_cast<unsigned>(stats.FailedWrites),
+				   stats.WriteMilliseconds,
+				   static_cast<unsigned>(stats.MessagesRead),
+				   static_cast<unsigned>(stats.BytesRead),
+				   static_cast<unsigned>(stats.LargestRead));
+	}
 
-			using namespace Cam::Shared;
+	/*
+		hlcam_stats				Prints timings, editor message traffic, saves,
+								message tasks, trigger and target lookups
+		hlcam_stats reset		Starts counting all of them again
+		hlcam_stats csv <file>	Writes a row per server frame to "file"
+		hlcam_stats csv			Stops writing rows
+	*/
+	void HLCAM_Stats()
+	{
+		auto conmessage = g_engfuncs.pfnAlertMessage;
 
-			cameraval.AddMember("Position", std::move(camposval), alloc);
-			cameraval.AddMember("Angle", std::move(camangval), alloc);
-			cameraval.AddMember("FOV", cam.FOV, alloc);
-			cameraval.AddMember("Speed", cam.MaxSpeed, alloc);
-			cameraval.AddMember("LookType", {CameraLookTypeToString(cam.LookType), alloc}, alloc);
+		auto argc = g_engfuncs.pfnCmd_Argc();
+		std::string command = argc > 1 ? g_engfuncs.pfnCmd_Argv(1) : "";
 
-			if (cam.LookType == Cam::Shared::CameraLookType::AtTarget)
+		if (command == "reset")
+		{
+			for (auto& timing : Timings)
 			{
-				cameraval.AddMember("LookTargetName", {cam.LookTargetData.Name.c_str(), alloc}, alloc);
+				timing = TimingStat(timing.Name);
 			}
 
-			cameraval.AddMember("UseAttachment", cam.UseAttachment, alloc);
+			TheCamMap.AppClient.ResetStats();
+			TheCamMap.GameServer.ResetStats();
 
-			if (cam.UseAttachment)
-			{
-				cameraval.AddMember("AttachmentTargetName", {cam.AttachmentData.Name.c_str(), alloc}, alloc);
+			MapWriter.ResetStats();
 
-				rapidjson::Value attachpos(rapidjson::kArrayType);
+			SaveStats.LastSnapshotTime = 0;
+			SaveStats.MaxSnapshotTime = 0;
 
-				attachpos.PushBack(cam.AttachmentData.Offset.x, alloc);
-				attachpos.PushBack(cam.AttachmentData.Offset.y, alloc);
-				attachpos.PushBack(cam.AttachmentData.Offset.z, alloc);
+			/*
+				Not assigned as a whole, the wait count is atomic.
+			*/
+			InvokeStats.LastDepth = 0;
+			InvokeStats.MaxDepth = 0;
+			InvokeStats.Executed = 0;
+			InvokeStats.LastDrainTime = 0;
+			InvokeStats.MaxDrainTime = 0;
+			InvokeStats.FullWaits = 0;
 
-				cameraval.AddMember("AttachmentOffset", std::move(attachpos), alloc);
-			}
+			TriggerStats = decltype(TriggerStats)();
+			TargetStats = decltype(TargetStats)();
 
-			cameraval.AddMember("PlaneType", {CameraPlaneTypeToString(cam.PlaneType), alloc}, alloc);
-			cameraval.AddMember("TriggerType", {CameraTriggerTypeToString(cam.TriggerType), alloc}, alloc);
+			return;
+		}
 
-			if (cam.TriggerType == Cam::Shared::CameraTriggerType::ByName)
+		if (command == "csv")
+		{
+			if (argc > 2)
 			{
-				cameraval.AddMember("Name", {cam.Name.c_str(), alloc}, alloc);
+				OpenStatsDump(g_engfuncs.pfnCmd_Argv(2));
 			}
-			
-			cameraval.AddMember("ZoomType", {CameraZoomTypeToString(cam.ZoomType), alloc}, alloc);
-			cameraval.AddMember("ZoomTime", cam.ZoomData.ZoomTime, alloc);
-			cameraval.AddMember("ZoomEndFOV", cam.ZoomData.EndFov, alloc);
-			cameraval.AddMember("ZoomInterpMethod", {CameraAngleTypeToString(cam.ZoomData.InterpMethod), alloc}, alloc);
 
-			thisvalue.AddMember("Camera", std::move(cameraval), alloc);
+			else
+			{
+				CloseStatsDump();
+			}
 
-			root.PushBack(std::move(thisvalue), alloc);
+			return;
 		}
 
-		document.AddMember("Entities", std::move(root), alloc);
-
-		rapidjson::StringBuffer buffer;
-		rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
-		
-		document.Accept(writer);
+		for (const auto& timing : Timings)
+		{
+			conmessage(at_console, "HLCAM: %-12s calls: %7u, average: %.3f ms, max: %.3f ms, last frame: %.3f ms\n",
+					   timing.Name,
+					   static_cast<unsigned>(timing.Calls),
+					   timing.Calls ? timing.Total / timing.Calls : 0.0,
+					   timing.Max,
+					   timing.FrameTime);
+		}
 
-		std::string relativepath = "cammod\\MapCams\\" + TheCamMap.CurrentMapName + ".json";
+		/*
+			The app queue is read here and written by the editor, the game
+			queue the other way around.
+		*/
+		PrintPeerStats("Editor to game", TheCamMap.AppClient.GetStats());
+		PrintPeerStats("Game to editor", TheCamMap.GameServer.GetStats());
 
-		std::ofstream outfile(relativepath);
-		outfile.write(buffer.GetString(), buffer.GetSize());
+		PrintQueueStats();
+		PrintSaveStats();
+		PrintTriggerStats();
+		PrintTargetStats();
 
-		g_engfuncs.pfnAlertMessage(at_console, "HLCAM: Saved camera map for \"%s\"\n", TheCamMap.CurrentMapName.c_str());
+		if (StatsDump.File.is_open())
+		{
+			conmessage(at_console, "HLCAM: Writing frames to \"%s\" (%u so far)\n",
+					   StatsDump.Path.c_str(),
+					   static_cast<unsigned>(StatsDump.Rows));
+		}
 	}
 
 	void HLCAM_FirstPerson()
 	{
-		TheCamMap.GoFirstPerson();
+		if (TheCamMap.LocalPlayer)
+		{
+			TheCamMap.GoFirstPerson(TheCamMap.GetLocalState());
+		}
 	}
 }
 
@@ -2203,14 +4377,104 @@ void Cam::OnInit()
 
 	g_engfuncs.pfnAddServerCommand("hlcam_firstperson", HLCAM_FirstPerson);
 	g_engfuncs.pfnAddServerCommand("hlcam_savemap", HLCAM_SaveMap);
+	g_engfuncs.pfnAddServerCommand("hlcam_stats", HLCAM_Stats);
 
 	g_engfuncs.pfnCVarRegister(&Commands::UseAutoSave);
 	g_engfuncs.pfnCVarRegister(&Commands::AutoSaveInterval);
+	g_engfuncs.pfnCVarRegister(&Commands::JournalCompactSize);
+	g_engfuncs.pfnCVarRegister(&Commands::MapSyncBytesPerFrame);
+	g_engfuncs.pfnCVarRegister(&Commands::CameraTrackRate);
+}
+
+CBaseEntity* Cam::FindTargetEntity(const std::string& name)
+{
+	auto& cached = TheCamMap.NamedEntities[name];
+	CBaseEntity* entity = cached;
+
+	/*
+		Entities can be renamed by the map, so the name is checked too.
+	*/
+	if (entity &&
+		!(entity->pev->flags & FL_KILLME) &&
+		FStrEq(STRING(entity->pev->targetname), name.c_str()))
+	{
+		TargetStats.CacheHits++;
+		return entity;
+	}
+
+	TargetStats.Scans++;
+
+	/*
+		Skip worldspawn and all players.
+	*/
+	const auto startedict = g_engfuncs.pfnPEntityOfEntIndex(32);
+
+	edict_t* targetedict = FIND_ENTITY_BY_TARGETNAME(startedict, name.c_str());
+
+	if (!targetedict)
+	{
+		cached = nullptr;
+		return nullptr;
+	}
+
+	entity = CBaseEntity::Instance(targetedict);
+	cached = entity;
+
+	return entity;
 }
 
 void Cam::OnPlayerSpawn(CBasePlayer* player)
 {
-	TheCamMap.LocalPlayer = player;
+	/*
+		The listen server host edits the map, or whoever came first.
+	*/
+	if (!TheCamMap.LocalPlayer || player->entindex() == 1)
+	{
+		TheCamMap.LocalPlayer = player;
+	}
+}
+
+void Cam::OnPlayerDisconnect(CBasePlayer* player)
+{
+	auto index = player->entindex();
+
+	if (index < 1 || index > MaxPlayers)
+	{
+		return;
+	}
+
+	auto& state = TheCamMap.PlayerStates[index - 1];
+
+	if (state.OwnCamera)
+	{
+		UTIL_Remove(state.OwnCamera);
+	}
+
+	state = PlayerCamState();
+	PendingRestores[index - 1].NeedsRestore = false;
+
+	if (TheCamMap.LocalPlayer == player)
+	{
+		TheCamMap.LocalPlayer = nullptr;
+	}
+}
+
+void Cam::OnServerFrame()
+{
+	EndStatsFrame();
+
+	ScopedTiming timing(Timing::ServerFrame);
+
+	/*
+		Saves are reported first so the file watcher
+		can tell our own writes from outside ones.
+	*/
+	ReportFinishedSaves();
+	CheckMapFileChanges();
+
+	TheCamMap.SendMapSnapshot();
+
+	UpdatePlayerTriggers();
 }
 
 const char* Cam::GetLastMap()
@@ -2223,36 +4487,30 @@ bool Cam::IsInEditMode()
 	return TheCamMap.IsEditing;
 }
 
-void Cam::OnPlayerPreUpdate(CBasePlayer* player)
+float Cam::GetCameraTrackInterval()
 {
-	if (!TheCamMap.LocalPlayer)
-	{
-		TheCamMap.LocalPlayer = player;
-	}
+	auto rate = Commands::CameraTrackRate.value;
 
-	if (TheCamMap.NeedsToSendResetMessage)
+	if (rate < 1)
 	{
-		MESSAGE_BEGIN(MSG_ONE, HLCamMessage::MapReset, nullptr, TheCamMap.LocalPlayer->pev);
-		MESSAGE_END();
-
-		TheCamMap.NeedsToSendResetMessage = false;
+		rate = 1;
 	}
 
-	if (NeedsRestore)
+	if (rate > 100)
 	{
-		NeedsRestore = false;
+		rate = 100;
+	}
 
-		auto trig = TheCamMap.FindTriggerByID(CameraRestore.TriggerID);
+	return 1.0f / rate;
+}
 
-		if (trig)
-		{
-			PlayerEnterTrigger(*trig);
-		}
+void Cam::OnPlayerPreUpdate(CBasePlayer* player)
+{
+	ScopedTiming timing(Timing::PreUpdate);
 
-		else
-		{
-			g_engfuncs.pfnAlertMessage(at_console, "Restored trigger no longer exists\n");
-		}
+	if (!TheCamMap.LocalPlayer)
+	{
+		TheCamMap.LocalPlayer = player;
 	}
 
 	using StateType = Cam::Shared::StateType;
@@ -2306,6 +4564,8 @@ void Cam::OnPlayerPreUpdate(CBasePlayer* player)
 				targetcam->TargetCamera->HLCam.Position = playerpos;
 				targetcam->TargetCamera->HLCam.Angle = playerang;
 
+				JournalCamera(*targetcam);
+
 				MESSAGE_BEGIN(MSG_ONE, HLCamMessage::CameraAdjust, nullptr, TheCamMap.LocalPlayer->pev);
 				
 				WRITE_BYTE(1);
@@ -2362,29 +4622,34 @@ void Cam::OnPlayerPreUpdate(CBasePlayer* player)
 				}
 
 				creationtrig->SetupPositions();
+				TheCamMap.UpdateTriggerBounds(*creationtrig);
+
+				if (!TheCamMap.AddingTriggerToCamera && linkedcam)
+				{
+					JournalCamera(*linkedcam);
+				}
 
-				Utility::BinaryBuffer fullpack;
+				JournalTrigger(*creationtrig);
 
 				if (!TheCamMap.AddingTriggerToCamera)
 				{
-					fullpack.Append(TheCamMap.GetInterprocessCameraInfo(*linkedcam));
-					fullpack.Append(TheCamMap.GetInterprocessTriggerInfo(*creationtrig));
-
 					TheCamMap.GameServer.Write
 					(
 						Cam::Shared::Messages::Game::OnTriggerAndCameraAdded,
-						std::move(fullpack)
+						TheCamMap.CreateInterprocessPacket
+						(
+							TheCamMap.GetInterprocessCameraInfo(*linkedcam),
+							TheCamMap.GetInterprocessTriggerInfo(*creationtrig)
+						)
 					);
 				}
 				
 				else
 				{
-					fullpack.Append(TheCamMap.GetInterprocessTriggerInfo(*creationtrig));
-
 					TheCamMap.GameServer.Write
 					(
 						Cam::Shared::Messages::Game::OnTriggerAddedToCamera,
-						std::move(fullpack)
+						TheCamMap.CreateInterprocessPacket(TheCamMap.GetInterprocessTriggerInfo(*creationtrig))
 					);
 
 					TheCamMap.AddingTriggerToCamera = false;
@@ -2433,21 +4698,67 @@ void Cam::OnPlayerPreUpdate(CBasePlayer* player)
 
 void Cam::OnPlayerPostUpdate(CBasePlayer* player)
 {
+	ScopedTiming timing(Timing::PostUpdate);
+
+	/*
+		Every client gets the map, players that join late or come back
+		after a level change drop what they had and start over.
+	*/
+	auto& state = TheCamMap.GetPlayerState(player);
+
+	if (!state.MapSync.Started)
+	{
+		MESSAGE_BEGIN(MSG_ONE, HLCamMessage::MapReset, nullptr, player->pev);
+		MESSAGE_END();
+
+		TheCamMap.BeginMapUpdate(state);
+	}
+
+	if (TheCamMap.IsSendingMapUpdate(state))
+	{
+		ScopedTiming synctiming(Timing::MapSync);
+
+		auto budget = Commands::MapSyncBytesPerFrame.value;
+		TheCamMap.SendMapUpdate(state, budget > 0 ? static_cast<size_t>(budget) : 0);
+	}
+
+	/*
+		Map editing only concerns one player, the camera of every player
+		is updated in OnServerFrame.
+	*/
+	if (player != TheCamMap.LocalPlayer)
+	{
+		return;
+	}
+
 	if (IsInEditMode())
 	{
 		if (TheCamMap.CurrentState == Cam::Shared::StateType::Inactive &&
-			!TheCamMap.Triggers.empty())
+			!TheCamMap.Triggers.IsEmpty())
 		{
-			if (Commands::UseAutoSave.value > 0)
+			if (gpGlobals->time > TheCamMap.NextAutoSaveTime)
 			{
-				if (gpGlobals->time > TheCamMap.NextAutoSaveTime)
+				if (Commands::AutoSaveInterval.value < 30)
+				{
+					Commands::AutoSaveInterval.value = 30;
+				}
+
+				TheCamMap.NextAutoSaveTime = gpGlobals->time + Commands::AutoSaveInterval.value;
+
+				/*
+					With a journal every edit is already on disk, the
+					full save only compacts it once it has grown.
+				*/
+				if (MapJournal.IsOpen())
 				{
-					if (Commands::AutoSaveInterval.value < 30)
+					if (IsJournalFull())
 					{
-						Commands::AutoSaveInterval.value = 30;
+						QueueMapSave();
 					}
+				}
 
-					TheCamMap.NextAutoSaveTime = gpGlobals->time + Commands::AutoSaveInterval.value;
+				else if (Commands::UseAutoSave.value > 0)
+				{
 					HLCAM_SaveMap();
 				}
 			}
@@ -2460,49 +4771,23 @@ void Cam::OnPlayerPostUpdate(CBasePlayer* player)
 
 			const auto maxsearchdist = 512;
 
-			struct DepthInfo
-			{
-				float Distance;
-				Cam::MapTrigger* Trigger;
-			};
-
-			std::vector<DepthInfo> depthlist;
-			depthlist.reserve(TheCamMap.Triggers.size());
-
-			for (auto& trig : TheCamMap.Triggers)
-			{
-				float distance = (trig.second.CenterPos - startpos).Length2D();
-
-				if (distance > maxsearchdist)
-				{
-					continue;
-				}
-
-				DepthInfo info;
-				info.Distance = distance;
-				info.Trigger = &trig.second;
-
-				depthlist.push_back(info);
-			}
+			/*
+				Closest trigger along the aim direction, triggers behind
+				world geometry are still pickable so they can be edited.
+			*/
+			float raystart[3];
+			float raydir[3];
 
-			std::sort(depthlist.begin(), depthlist.end(), [](const DepthInfo& first, const DepthInfo& other)
-			{
-				return first.Distance < other.Distance;
-			});
+			startpos.CopyToArray(raystart);
+			aimvec.CopyToArray(raydir);
 
-			TraceResult trace;
-			UTIL_TraceLine(startpos,
-						   startpos + aimvec * maxsearchdist,
-						   ignore_monsters,
-						   ignore_glass,
-						   TheCamMap.LocalPlayer->edict(),
-						   &trace);
+			Utility::AABBTree::RayHit hit;
 
-			for (const auto& depthtrig : depthlist)
+			if (TheCamMap.TriggerTree.RayCast(raystart, raydir, maxsearchdist, hit))
 			{
-				const auto& trig = depthtrig.Trigger;
+				auto trig = TheCamMap.FindTriggerByID(hit.ID);
 
-				if (LocalUtility::IsRayIntersectingBox(startpos, aimvec, trace.vecEndPos, trig->MinPos, trig->MaxPos))
+				if (trig)
 				{
 					if (TheCamMap.CurrentHighlightTriggerID != trig->ID)
 					{
@@ -2522,7 +4807,6 @@ void Cam::OnPlayerPostUpdate(CBasePlayer* player)
 					}
 
 					lookatsomething = true;
-					break;
 				}
 			}
 
@@ -2532,32 +4816,50 @@ void Cam::OnPlayerPostUpdate(CBasePlayer* player)
 			}
 		}
 
-		if (!TheCamMap.InvokeList.empty())
+		auto depth = InvokeQueue.GetSize();
+		auto scriptdepth = ScriptQueue.GetSize();
+
+		if (depth + scriptdepth != 0)
 		{
-			std::lock_guard<std::mutex> g(MessageInvokeMutex);
+			ScopedTiming draintiming(Timing::MessageDrain);
 
-			for (auto&& func : TheCamMap.InvokeList)
+			auto drainstart = std::chrono::steady_clock::now();
+
+			/*
+				Only what was queued at the start of the frame, so a busy
+				message thread can't keep the game thread here.
+			*/
+			MessageTask task;
+
+			for (size_t i = 0; i < depth && InvokeQueue.TryPop(task); i++)
 			{
-				func();
+				task();
+				task.Reset();
 			}
 
-			TheCamMap.InvokeList.clear();
-		}
+			for (size_t i = 0; i < scriptdepth && ScriptQueue.TryPop(task); i++)
+			{
+				task();
+				task.Reset();
+			}
 
-		return;
-	}
+			depth += scriptdepth;
 
-	const auto& playerposmax = TheCamMap.LocalPlayer->pev->absmax;
-	const auto& playerposmin = TheCamMap.LocalPlayer->pev->absmin;
+			auto draintime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - drainstart).count();
 
-	for (auto& trigitr : TheCamMap.Triggers)
-	{
-		auto& trig = trigitr.second;
+			InvokeStats.LastDepth = depth;
+			InvokeStats.Executed += depth;
+			InvokeStats.LastDrainTime = draintime;
 
-		if (LocalUtility::IsBoxIntersectingBox(playerposmin, playerposmax, trig.MinPos, trig.MaxPos))
-		{
-			PlayerEnterTrigger(trig);
-			break;
+			if (depth > InvokeStats.MaxDepth)
+			{
+				InvokeStats.MaxDepth = depth;
+			}
+
+			if (draintime > InvokeStats.MaxDrainTime)
+			{
+				InvokeStats.MaxDrainTime = draintime;
+			}
 		}
 	}
 }
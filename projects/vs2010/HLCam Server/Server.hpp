@@ -7,6 +7,7 @@
 
 class CTriggerCamera;
 class CBasePlayer;
+class CBaseEntity;
 
 /*
 	Require to be global functions because of how HL
@@ -20,17 +21,32 @@ namespace Cam
 	void OnNewMap(const char* name);
 	void OnInit();
 	void OnPlayerSpawn(CBasePlayer* player);
+	void OnPlayerDisconnect(CBasePlayer* player);
+	void OnServerFrame();
 	void Deactivate();
 	void CloseServer();
 
 	struct RestoreData
 	{
+		/*
+			Entity index of the restored player.
+		*/
+		int PlayerIndex;
 		size_t TriggerID;
 	};
 
 	void Restore(const RestoreData& data);
 
-	void NamedCameraActivate(size_t id);
+	/*
+		"activator" is the player that should look through it,
+		the first player if it isn't one.
+	*/
+	void NamedCameraActivate(size_t id, CBaseEntity* activator);
+
+	/*
+		Map entity with this target name, remembered until it's removed.
+	*/
+	CBaseEntity* FindTargetEntity(const std::string& name);
 
 	/*
 		Internal output functions that we answer.
@@ -38,6 +54,11 @@ namespace Cam
 	const char* GetLastMap();
 	bool IsInEditMode();
 
+	/*
+		Seconds between thinks of cameras that follow something.
+	*/
+	float GetCameraTrackInterval();
+
 	void OnPlayerPreUpdate(CBasePlayer* player);
 	void OnPlayerPostUpdate(CBasePlayer* player);
 
@@ -115,12 +136,5 @@ namespace Cam
 		Vector CenterPos;
 
 		void SetupPositions();
-		
-		/*
-			This trigger has already been activated and
-			the player is within it. It cannot be fired
-			again until another trigger is entered.
-		*/
-		bool Active = false;
 	};
 }
@@ -2,12 +2,55 @@
 #include <string>
 #include <vector>
 #include <tuple>
-#include "Shared\String\String.hpp"
+#include "Shared/String/String.hpp"
 #include <stdint.h>
 #include <fstream>
+#include <cstring>
+#include <memory>
 
 namespace Utility
 {
+	/*
+		Characters inside a buffer that has to outlive the view,
+		not null terminated.
+	*/
+	struct StringView
+	{
+		const char* Data = nullptr;
+		size_t Size = 0;
+
+		std::string ToString() const
+		{
+			return std::string(Data, Size);
+		}
+
+		bool operator==(const char* other) const
+		{
+			return std::strlen(other) == Size && std::memcmp(Data, other, Size) == 0;
+		}
+
+		bool operator!=(const char* other) const
+		{
+			return !(*this == other);
+		}
+	};
+
+	class BinaryStreamReader;
+	class BinaryStreamWriter;
+
+	/*
+		How files are read and written in blocks.
+	*/
+	struct BinaryStreamSettings
+	{
+		size_t BlockSize = 64 * 1024;
+
+		/*
+			Reads the next block on another thread while the current one is used.
+		*/
+		bool ReadAhead = false;
+	};
+
 	/*
 		Local binary data buffer, not for use over network.
 	*/
@@ -31,20 +74,49 @@ namespace Utility
 		BinaryBuffer(const void* data, size_t length);
 		BinaryBuffer(BinaryBuffer&& other);
 		BinaryBuffer(ContainerType<ContainerDataType>&& data);
+
+		/*
+			Reads straight from the file, one read per value.
+		*/
 		BinaryBuffer(std::ifstream& fileinputstream);
 
+		/*
+			Reads from the file a block at a time.
+		*/
+		BinaryBuffer(std::ifstream& fileinputstream, const BinaryStreamSettings& settings);
+
+		/*
+			Everything written goes to the file a block at a time instead of
+			being kept, so nothing has to be saved afterwards. The rest is
+			written on Flush or destruction.
+		*/
+		BinaryBuffer(std::ofstream& fileoutputstream, const BinaryStreamSettings& settings);
+
+		~BinaryBuffer();
+
 		BinaryBuffer operator=(BinaryBuffer&& other);
 
 		void Reserve(size_t size);
 		void Resize(size_t newsize);
 
+		/*
+			Replaces the contents and keeps the memory, unlike Resize
+			the new part is not zeroed before being written over.
+		*/
+		void Assign(const void* data, size_t length);
+
 		void SetData(ContainerType<ContainerDataType>&& data);
 
 		void Append(BinaryBuffer&& other);
 		void Append(ContainerType<ContainerDataType>&& data);
 		void Append(const void* data, size_t length);
 
+		/*
+			Files too large to build in memory first can be written
+			through a buffer made from the output stream instead.
+		*/
 		void SaveToFile(std::ofstream& outputstream);
+		void Flush();
 
 		ContainerType<ContainerDataType>&& MoveData();
 
@@ -86,6 +158,11 @@ namespace Utility
 		BinaryBuffer& operator>>(std::string& data);
 		BinaryBuffer& operator>>(std::wstring& data);
 
+		/*
+			Points into the buffer, not for file input.
+		*/
+		BinaryBuffer& operator>>(StringView& data);
+
 		template <typename T>
 		inline T GetValue()
 		{
@@ -104,6 +181,11 @@ namespace Utility
 			return GetValue<std::string>();
 		}
 
+		inline StringView GetStringView()
+		{
+			return GetValue<StringView>();
+		}
+
 	private:
 		bool CanRead(size_t size);
 		size_t ReadPos = 0;
@@ -111,6 +193,11 @@ namespace Utility
 
 		std::ifstream* InputStream = nullptr;
 
+		std::unique_ptr<BinaryStreamReader> StreamReader;
+		std::unique_ptr<BinaryStreamWriter> StreamWriter;
+
+		void ReadStream(void* data, size_t size);
+
 		template <typename T>
 		inline BinaryBuffer& GenericWrite(T data)
 		{
@@ -123,11 +210,11 @@ namespace Utility
 		{
 			data = (*reinterpret_cast
 			<
-				std::add_const
+				typename std::add_const
 				<
-					std::add_pointer
+					typename std::add_pointer
 					<
-						std::remove_reference<decltype(data)>::type
+						typename std::remove_reference<decltype(data)>::type
 					>::type
 				>::type
 			>(&Data[ReadPos]));
@@ -136,6 +223,91 @@ namespace Utility
 		}
 	};
 
+	/*
+		Reads the same way as BinaryBuffer from memory someone else owns,
+		such as a message still in the interprocess ring. Nothing is copied
+		until a value is read out.
+	*/
+	class BinaryBufferView final
+	{
+	public:
+		BinaryBufferView();
+		BinaryBufferView(const void* data, size_t length);
+		BinaryBufferView(const BinaryBuffer& buffer);
+
+		void Reset(const void* data, size_t length);
+
+		const void* GetData() const;
+		size_t GetSize() const;
+
+		void SetReadPosition(size_t position);
+		size_t GetReadPosition() const;
+
+		/*
+			Moves past "size" bytes and returns where they start,
+			or null without moving if fewer than that are left.
+		*/
+		const void* ReadBytes(size_t size);
+
+		BinaryBufferView& operator>>(bool& data);
+		BinaryBufferView& operator>>(char& data);
+		BinaryBufferView& operator>>(unsigned char& data);
+		BinaryBufferView& operator>>(int16_t& data);
+		BinaryBufferView& operator>>(uint16_t& data);
+		BinaryBufferView& operator>>(int32_t& data);
+		BinaryBufferView& operator>>(uint32_t& data);
+		BinaryBufferView& operator>>(int64_t& data);
+		BinaryBufferView& operator>>(uint64_t& data);
+		BinaryBufferView& operator>>(float& data);
+		BinaryBufferView& operator>>(double& data);
+		BinaryBufferView& operator>>(std::string& data);
+		BinaryBufferView& operator>>(std::wstring& data);
+		BinaryBufferView& operator>>(StringView& data);
+
+		template <typename T>
+		inline T GetValue()
+		{
+			T ret;
+			*this >> ret;
+			return ret;
+		}
+
+		inline std::wstring GetString()
+		{
+			return GetValue<std::wstring>();
+		}
+
+		inline std::string GetNormalString()
+		{
+			return GetValue<std::string>();
+		}
+
+		inline StringView GetStringView()
+		{
+			return GetValue<StringView>();
+		}
+
+	private:
+		/*
+			Values past the end are left as they were, like BinaryBuffer.
+		*/
+		template <typename T>
+		inline BinaryBufferView& GenericRead(T& data)
+		{
+			if (ReadPos + sizeof(data) <= Size)
+			{
+				std::memcpy(&data, Data + ReadPos, sizeof(data));
+				ReadPos += sizeof(data);
+			}
+
+			return *this;
+		}
+
+		const unsigned char* Data = nullptr;
+		size_t Size = 0;
+		size_t ReadPos = 0;
+	};
+
 	namespace BinaryBufferPrivate
 	{
 		template
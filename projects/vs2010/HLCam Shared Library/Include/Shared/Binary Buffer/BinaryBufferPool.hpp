@@ -0,0 +1,63 @@
+#pragma once
+#include "Shared/Binary Buffer/BinaryBuffer.hpp"
+#include <vector>
+#include <mutex>
+
+namespace Utility
+{
+	/*
+		Buffers handed back after use keep their memory for the next
+		one, so messages built every frame stop reallocating as they grow.
+		Safe to use from any thread.
+	*/
+	class BinaryBufferPool final
+	{
+	public:
+		/*
+			Empty, with the memory of one given back earlier if there is any.
+		*/
+		BinaryBuffer Acquire()
+		{
+			std::lock_guard<std::mutex> lock(Lock);
+
+			if (Free.empty())
+			{
+				return BinaryBuffer();
+			}
+
+			BinaryBuffer ret(std::move(Free.back()));
+			Free.pop_back();
+
+			return ret;
+		}
+
+		/*
+			Buffers that never held anything have no memory worth keeping.
+		*/
+		void Release(BinaryBuffer&& buffer)
+		{
+			if (buffer.GetSize() == 0)
+			{
+				return;
+			}
+
+			buffer.Clear();
+
+			std::lock_guard<std::mutex> lock(Lock);
+
+			if (Free.size() < MaxFree)
+			{
+				Free.emplace_back(std::move(buffer));
+			}
+		}
+
+	private:
+		enum
+		{
+			MaxFree = 8,
+		};
+
+		std::mutex Lock;
+		std::vector<BinaryBuffer> Free;
+	};
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include "Shared/Binary Buffer/BinaryBuffer.hpp"
+#include <istream>
+#include <ostream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace Utility
+{
+	/*
+		Reads a stream a block at a time into one of two buffers. With
+		read ahead the other one is filled on a thread of its own while
+		this one is being read.
+	*/
+	class BinaryStreamReader final
+	{
+	public:
+		BinaryStreamReader(std::istream& stream, const BinaryStreamSettings& settings);
+		~BinaryStreamReader();
+
+		BinaryStreamReader(const BinaryStreamReader&) = delete;
+		BinaryStreamReader& operator=(const BinaryStreamReader&) = delete;
+
+		/*
+			Returns how many bytes were read, less than "size"
+			only at the end of the stream.
+		*/
+		size_t Read(void* data, size_t size);
+
+	private:
+		struct Block
+		{
+			std::vector<char> Data;
+			size_t Size = 0;
+		};
+
+		void Fill(Block& block);
+		bool NextBlock();
+
+		void ReadAheadThread();
+
+		std::istream& Stream;
+		size_t BlockSize;
+
+		Block Blocks[2];
+		size_t Current = 0;
+		size_t Position = 0;
+
+		bool ReadAhead;
+		std::thread Thread;
+		std::mutex Lock;
+		std::condition_variable Condition;
+
+		/*
+			The block that isn't current holds the next part of the stream.
+		*/
+		bool NextReady = false;
+		bool ShouldStop = false;
+	};
+
+	/*
+		Collects writes into one block and hands it to the stream when full
+		or on Flush. Flushed when destroyed.
+	*/
+	class BinaryStreamWriter final
+	{
+	public:
+		BinaryStreamWriter(std::ostream& stream, const BinaryStreamSettings& settings);
+		~BinaryStreamWriter();
+
+		BinaryStreamWriter(const BinaryStreamWriter&) = delete;
+		BinaryStreamWriter& operator=(const BinaryStreamWriter&) = delete;
+
+		void Write(const void* data, size_t size);
+		void Flush();
+
+	private:
+		std::ostream& Stream;
+
+		std::vector<char> Block;
+		size_t Size = 0;
+	};
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+
+namespace Utility
+{
+	/*
+		Blocks in the LZ4 block format, for data that is sent once and
+		has to be small more than it has to be as small as possible.
+		Only whole blocks, there is no frame or checksum around them.
+	*/
+	namespace LZ4
+	{
+		/*
+			Output size that always fits, data that can't be
+			compressed grows by a little.
+		*/
+		size_t GetMaxCompressedSize(size_t size);
+
+		/*
+			Returns the compressed size, or 0 if it would not fit in
+			"capacity". Pass less than the input size to only get
+			a result when compressing saves space.
+		*/
+		size_t Compress(const void* source, size_t size, void* dest, size_t capacity);
+
+		/*
+			"size" has to be what was compressed, returns false if the block
+			is damaged or does not decompress to exactly that many bytes.
+		*/
+		bool Decompress(const void* source, size_t sourcesize, void* dest, size_t size);
+	}
+}
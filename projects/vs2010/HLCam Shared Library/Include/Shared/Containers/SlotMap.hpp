@@ -0,0 +1,243 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace Utility
+{
+	/*
+		Reference to a slot map item that can be checked for staleness.
+		Removing the item makes every handle to it invalid, even if a new
+		item later takes the same ID.
+	*/
+	struct SlotHandle
+	{
+		size_t ID = static_cast<size_t>(-1);
+		uint32_t Generation = 0;
+
+		bool operator==(const SlotHandle& other) const
+		{
+			return ID == other.ID && Generation == other.Generation;
+		}
+
+		bool operator!=(const SlotHandle& other) const
+		{
+			return !(*this == other);
+		}
+	};
+
+	/*
+		Items keyed by small integer IDs chosen by the caller. The ID is
+		the slot index so lookups are an array access, and the items
+		themselves are packed in one array for iteration.
+
+		Item addresses change when others are inserted or removed,
+		keep a SlotHandle across edits instead of a pointer.
+	*/
+	template <typename T>
+	class SlotMap final
+	{
+	public:
+		using IDType = size_t;
+
+		using Iterator = typename std::vector<T>::iterator;
+		using ConstIterator = typename std::vector<T>::const_iterator;
+
+		/*
+			Replaces any item that already has this ID.
+		*/
+		T& Insert(IDType id, T&& item)
+		{
+			auto existing = Find(id);
+
+			if (existing)
+			{
+				*existing = std::move(item);
+				return *existing;
+			}
+
+			if (id >= Slots.size())
+			{
+				Slots.resize(id + 1);
+			}
+
+			auto& slot = Slots[id];
+			slot.DenseIndex = static_cast<uint32_t>(Items.size());
+
+			Items.push_back(std::move(item));
+			ItemIDs.push_back(id);
+
+			return Items.back();
+		}
+
+		/*
+			Default constructs the item if there is none with this ID.
+		*/
+		T& operator[](IDType id)
+		{
+			auto existing = Find(id);
+
+			if (existing)
+			{
+				return *existing;
+			}
+
+			return Insert(id, T());
+		}
+
+		T* Find(IDType id)
+		{
+			if (id >= Slots.size() || Slots[id].DenseIndex == FreeSlot)
+			{
+				return nullptr;
+			}
+
+			return &Items[Slots[id].DenseIndex];
+		}
+
+		const T* Find(IDType id) const
+		{
+			return const_cast<SlotMap*>(this)->Find(id);
+		}
+
+		bool Contains(IDType id) const
+		{
+			return Find(id) != nullptr;
+		}
+
+		/*
+			The last item is moved into the removed one's place.
+		*/
+		bool Remove(IDType id)
+		{
+			if (!Contains(id))
+			{
+				return false;
+			}
+
+			auto& slot = Slots[id];
+			auto index = slot.DenseIndex;
+			auto last = Items.size() - 1;
+
+			if (index != last)
+			{
+				Items[index] = std::move(Items[last]);
+				ItemIDs[index] = ItemIDs[last];
+
+				Slots[ItemIDs[index]].DenseIndex = index;
+			}
+
+			Items.pop_back();
+			ItemIDs.pop_back();
+
+			slot.DenseIndex = FreeSlot;
+			slot.Generation++;
+
+			return true;
+		}
+
+		/*
+			Handle to the current item with this ID, or an invalid one.
+		*/
+		SlotHandle GetHandle(IDType id) const
+		{
+			SlotHandle ret;
+
+			if (Contains(id))
+			{
+				ret.ID = id;
+				ret.Generation = Slots[id].Generation;
+			}
+
+			return ret;
+		}
+
+		T* Get(const SlotHandle& handle)
+		{
+			if (handle.ID >= Slots.size() || Slots[handle.ID].Generation != handle.Generation)
+			{
+				return nullptr;
+			}
+
+			return Find(handle.ID);
+		}
+
+		const T* Get(const SlotHandle& handle) const
+		{
+			return const_cast<SlotMap*>(this)->Get(handle);
+		}
+
+		size_t GetCount() const
+		{
+			return Items.size();
+		}
+
+		bool IsEmpty() const
+		{
+			return Items.empty();
+		}
+
+		void Reserve(size_t count)
+		{
+			Items.reserve(count);
+			ItemIDs.reserve(count);
+			Slots.reserve(count);
+		}
+
+		/*
+			Handles to the removed items stay invalid.
+		*/
+		void Clear()
+		{
+			for (auto id : ItemIDs)
+			{
+				Slots[id].DenseIndex = FreeSlot;
+				Slots[id].Generation++;
+			}
+
+			Items.clear();
+			ItemIDs.clear();
+		}
+
+		Iterator begin()
+		{
+			return Items.begin();
+		}
+
+		Iterator end()
+		{
+			return Items.end();
+		}
+
+		ConstIterator begin() const
+		{
+			return Items.begin();
+		}
+
+		ConstIterator end() const
+		{
+			return Items.end();
+		}
+
+	private:
+		enum : uint32_t
+		{
+			FreeSlot = 0xFFFFFFFF,
+		};
+
+		struct Slot
+		{
+			uint32_t DenseIndex = FreeSlot;
+			uint32_t Generation = 0;
+		};
+
+		std::vector<Slot> Slots;
+
+		/*
+			Same order, ItemIDs maps a packed item back to its slot.
+		*/
+		std::vector<T> Items;
+		std::vector<IDType> ItemIDs;
+	};
+}
@@ -1,5 +1,10 @@
 #pragma once
-#include "Shared\Binary Buffer\BinaryBuffer.hpp"
+#include "Shared/Binary Buffer/BinaryBuffer.hpp"
+#include "Shared/Binary Buffer/BinaryBufferPool.hpp"
+#include "Shared/Interprocess/SharedRing.hpp"
+#include "boost/interprocess/ipc/message_queue.hpp"
+#include <chrono>
+#include <atomic>
 
 namespace Shared
 {
@@ -14,9 +19,66 @@ namespace Shared
 			{
 				MaxMessageSize = 16384,
 				MaxSimMessages = 50,
+
+				/*
+					Bytes per direction, messages can be up to half of this.
+				*/
+				RingCapacity = 4 * 1024 * 1024,
+			};
+
+			enum class TransportType
+			{
+				MessageQueue,
+
+				/*
+					Lock free ring in shared memory, without a limit on the
+					number of messages waiting or copies in and out.
+				*/
+				SharedRing,
 			};
+
+			/*
+				What servers are started with, clients use whichever
+				the server they connect to has.
+			*/
+			const TransportType DefaultTransport = TransportType::SharedRing;
 		}
 
+		/*
+			Counted since the last ResetStats. Sizes include
+			the message type, wake signals are not counted.
+		*/
+		struct PeerStats
+		{
+			size_t MessagesWritten = 0;
+			size_t BytesWritten = 0;
+			size_t LargestWrite = 0;
+
+			/*
+				Writes dropped because the queue was full or missing.
+			*/
+			size_t FailedWrites = 0;
+
+			/*
+				Time spent handing messages to the queue.
+			*/
+			double WriteMilliseconds = 0;
+
+			size_t MessagesRead = 0;
+			size_t BytesRead = 0;
+			size_t LargestRead = 0;
+
+			/*
+				Messages waiting in the queue right now. Rings have no
+				message limit and report their capacity in bytes instead.
+			*/
+			size_t QueueDepth = 0;
+			size_t QueueCapacity = 0;
+
+			size_t QueueBytes = 0;
+			size_t QueueByteCapacity = 0;
+		};
+
 		class Peer
 		{
 		public:
@@ -29,24 +91,131 @@ namespace Shared
 			*/
 			bool Write(Config::MessageType message);
 
+			/*
+				"data" is given to the pool afterwards, build it from AcquireBuffer
+				to have its memory used again.
+			*/
 			bool Write(Config::MessageType message, Utility::BinaryBuffer&& data);
 
 			/*
-				Waits if there is nothing to read, reserves size.
+				Empty buffer with the memory of one written earlier.
+			*/
+			Utility::BinaryBuffer AcquireBuffer();
+
+			/*
+				Space for "size" bytes after the message type, written straight
+				into a ring. Returns nullptr if it does not fit right now. Nothing
+				is sent until EndWrite, which can be given a smaller size.
+			*/
+			Config::ByteType* BeginWrite(Config::MessageType message, size_t size);
+			bool EndWrite(size_t size);
+
+			/*
+				Waits if there is nothing to read. The message is copied into
+				"data", which keeps its memory between reads.
 			*/
 			bool ReadBlocking(Config::MessageType& message, Utility::BinaryBuffer& data);
 
 			/*
-				Returns false if there is nothing to read, reserves size.
+				Returns false if there is nothing to read.
 			*/
 			bool TryRead(Config::MessageType& message, Utility::BinaryBuffer& data);
 
+			/*
+				Waits up to "timeout" for a message. Returns false on timeout
+				or when woken. Without a queue it waits out the timeout so
+				loops around it don't spin.
+			*/
+			bool ReadTimed(Config::MessageType& message, Utility::BinaryBuffer& data, std::chrono::milliseconds timeout);
+
+			/*
+				Same as above without copying, "data" looks at the message where
+				it lies and is valid until the next read on this peer, which
+				lets go of it.
+			*/
+			bool TryRead(Config::MessageType& message, Utility::BinaryBufferView& data);
+			bool ReadTimed(Config::MessageType& message, Utility::BinaryBufferView& data, std::chrono::milliseconds timeout);
+
+			/*
+				The next message without the type where it lies in a ring, returns
+				false if there is nothing to read. "data" stays valid until EndPeek
+				or the next read.
+			*/
+			bool TryPeek(Config::MessageType& message, const Config::ByteType*& data, size_t& size);
+			void EndPeek();
+
+			/*
+				Makes a read waiting on this queue return, from any thread.
+				Sent as an empty message which Write never produces, if
+				nobody is waiting the next read returns false once instead.
+			*/
+			void Wake();
+
+			/*
+				Safe to call from any thread, counters of one
+				write or read may be seen half updated.
+			*/
+			PeerStats GetStats() const;
+			void ResetStats();
+
 		protected:
+			/*
+				Names of the ring's shared memory, apart from the queue's
+				which uses the plain connection point for its own.
+			*/
+			static std::string GetRingName(const std::string& connectionpoint);
+
+			bool IsOpen() const;
+
+			/*
+				Drops the queue or ring along with any message still being looked at.
+			*/
+			void Close();
+
 			std::string ConnectionPoint;
 			std::unique_ptr<boost::interprocess::message_queue> MessageQueue;
+			std::unique_ptr<SharedRing> Ring;
+
+			/*
+				A message from the last view read or peek is still in the ring.
+			*/
+			bool ViewPending = false;
 
 		private:
-			bool Write(const Utility::BinaryBuffer& data);
+			bool SendToQueue(const void* data, size_t size);
+
+			/*
+				The next whole message with its type, or nullptr if there is
+				none. Lies in the ring or ReadStaging until ReleaseView.
+			*/
+			const Config::ByteType* PeekNext(size_t& size);
+			const Config::ByteType* PeekNextTimed(size_t& size, std::chrono::milliseconds timeout);
+
+			bool CopyMessage(const Config::ByteType* source, size_t size, Config::MessageType& message, Utility::BinaryBuffer& data);
+			bool ViewMessage(const Config::ByteType* source, size_t size, Config::MessageType& message, Utility::BinaryBufferView& data);
+
+			void ReleaseView();
+
+			Utility::BinaryBufferPool Buffers;
+
+			/*
+				Message queues have nowhere to reserve or peek in, these
+				stand in for it.
+			*/
+			std::vector<Config::ByteType> WriteStaging;
+			std::vector<Config::ByteType> ReadStaging;
+
+			void CountRead(size_t size);
+
+			std::atomic<size_t> MessagesWritten{0};
+			std::atomic<size_t> BytesWritten{0};
+			std::atomic<size_t> LargestWrite{0};
+			std::atomic<size_t> FailedWrites{0};
+			std::atomic<uint64_t> WriteNanoseconds{0};
+
+			std::atomic<size_t> MessagesRead{0};
+			std::atomic<size_t> BytesRead{0};
+			std::atomic<size_t> LargestRead{0};
 		};
 
 		/*
@@ -81,7 +250,7 @@ namespace Shared
 
 			~Server();
 
-			void Start(const std::string& connectionname);
+			void Start(const std::string& connectionname, Config::TransportType transport = Config::DefaultTransport);
 			void Stop();
 			bool IsStarted() const;
 
@@ -0,0 +1,101 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <chrono>
+#include <cstdint>
+
+namespace boost
+{
+	namespace interprocess
+	{
+		class shared_memory_object;
+		class mapped_region;
+	}
+}
+
+namespace Shared
+{
+	namespace Interprocess
+	{
+		/*
+			One way stream of messages in shared memory between one writer
+			and one reader, without locks. Messages of any size up to half
+			the ring are kept whole and in order, and are written and read
+			where they lie instead of being copied in and out.
+		*/
+		class SharedRing final
+		{
+		public:
+			SharedRing();
+			~SharedRing();
+
+			/*
+				Both throw boost::interprocess::interprocess_exception like
+				message_queue does. "capacity" is in bytes and rounded up
+				to a power of two.
+			*/
+			void Create(const std::string& name, size_t capacity);
+			void Open(const std::string& name);
+
+			static bool Remove(const std::string& name);
+
+			/*
+				Space for a message of "size" bytes, or nullptr if there is not
+				enough free right now. The reader sees nothing until Commit,
+				which can be given less than was reserved.
+			*/
+			unsigned char* Reserve(size_t size);
+			void Commit(size_t size);
+
+			/*
+				The oldest message where it lies, or nullptr if there is none.
+				Stays valid and in the ring until Release.
+			*/
+			const unsigned char* Peek(size_t& size);
+			void Release();
+
+			enum class WaitResult
+			{
+				Ready,
+				Woken,
+				TimedOut,
+			};
+
+			/*
+				Waits for a message to be committed or for Wake, which can come
+				from any thread. A wake without anyone waiting is kept for the
+				next wait.
+			*/
+			WaitResult Wait(std::chrono::milliseconds timeout);
+			void Wake();
+
+			size_t GetMessageCount() const;
+			size_t GetUsedBytes() const;
+			size_t GetCapacity() const;
+			size_t GetMaxMessageSize() const;
+
+		private:
+			struct SharedHeader;
+
+			static size_t GetDataOffset();
+
+			void Map();
+			bool IsEmpty() const;
+
+			std::unique_ptr<boost::interprocess::shared_memory_object> Memory;
+			std::unique_ptr<boost::interprocess::mapped_region> Region;
+
+			SharedHeader* Header = nullptr;
+			unsigned char* Data = nullptr;
+			uint32_t Mask = 0;
+
+			/*
+				Where the reserved or peeked message starts, only the
+				writer and the reader side touch their own.
+			*/
+			uint32_t ReservePosition = 0;
+			uint32_t PeekPosition = 0;
+			uint32_t PeekSize = 0;
+		};
+	}
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include "Shared/Interprocess/Interprocess.hpp"
+#include <vector>
+#include <cstdint>
+
+namespace Shared
+{
+	namespace Interprocess
+	{
+		/*
+			Data too large for one message, compressed and sent as numbered
+			chunks of one message type. Every chunk starts with a header:
+
+				uint32 Snapshot ID
+				uint16 Chunk index
+				uint16 Chunk count
+				uint32 Uncompressed size
+				uint32 Compressed size, same as uncompressed if stored as is
+		*/
+		namespace Snapshot
+		{
+			enum
+			{
+				HeaderSize = 16,
+
+				/*
+					Compressed bytes per chunk, leaves room for the
+					header and message type in a queue message.
+				*/
+				ChunkDataSize = Config::MaxMessageSize - 64,
+			};
+
+			struct Stats
+			{
+				size_t Size = 0;
+				size_t CompressedSize = 0;
+				size_t ChunkCount = 0;
+
+				double CompressMilliseconds = 0;
+			};
+		}
+
+		class SnapshotWriter final
+		{
+		public:
+			/*
+				Compresses "data" right away, nothing is written until WriteChunks.
+			*/
+			SnapshotWriter(uint32_t id, const Utility::BinaryBuffer& data);
+
+			/*
+				Writes chunks in order until all are sent or "peer" is full.
+				Returns true once the last one is written, a chunk that did not
+				fit is written again by the next call.
+			*/
+			bool WriteChunks(Peer& peer, Config::MessageType message);
+
+			bool IsDone() const;
+			uint32_t GetID() const;
+
+			const Snapshot::Stats& GetStats() const;
+
+		private:
+			uint32_t ID;
+			uint32_t Size;
+
+			std::vector<unsigned char> Compressed;
+
+			size_t ChunkCount;
+			size_t NextChunk = 0;
+
+			Snapshot::Stats Stats;
+		};
+
+		class SnapshotReader final
+		{
+		public:
+			enum class Result
+			{
+				Incomplete,
+				Complete,
+
+				/*
+					A chunk was missing or the data was damaged, what was
+					read so far is dropped and a new snapshot is needed.
+				*/
+				Failed,
+			};
+
+			/*
+				Reads one chunk from the read position of "chunk". A chunk of
+				another snapshot drops the one being put together.
+			*/
+			Result Add(Utility::BinaryBufferView& chunk);
+
+			/*
+				Between the first chunk of a snapshot and its last.
+			*/
+			bool IsAssembling() const;
+
+			void Reset();
+
+			/*
+				The whole snapshot after Add returned Complete,
+				until the next one starts.
+			*/
+			Utility::BinaryBuffer& GetData();
+
+		private:
+			bool Assembling = false;
+
+			uint32_t ID = 0;
+			uint16_t NextChunk = 0;
+			uint16_t ChunkCount = 0;
+
+			uint32_t Size = 0;
+			uint32_t CompressedSize = 0;
+
+			std::vector<unsigned char> Compressed;
+			Utility::BinaryBuffer Data;
+		};
+	}
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include "Shared/Map/MapSchema.hpp"
+#include <string>
+
+namespace Cam
+{
+	namespace Shared
+	{
+		/*
+			Many camera edits sent as one Camera_ApplyBatch message, the game
+			makes all of them in one frame or none at all. The message holds
+			a uint32 batch ID that the answer repeats, then edits until its end:
+
+				varint	Camera ID
+				string	Field name, as in map files
+				value	Encoded as the field is in other messages
+
+			Edits are made in order, a field that only some cameras have
+			needs the field it depends on set first.
+		*/
+		namespace MapBatch
+		{
+			/*
+				Scripts have their own connection, the editor's is for the
+				editor alone. It is a message queue, which any number of
+				scripts can send to at once.
+			*/
+			const char* const ScriptConnectionName = "HLCAM_SCRIPT";
+
+			/*
+				Each script makes a connection of its own to wait for its
+				result on, so scripts never read each other's results.
+			*/
+			std::string GetResultConnectionName(uint32_t batchid);
+
+			/*
+				Sent back as OnBatchApplied.
+			*/
+			struct Result
+			{
+				uint32_t BatchID = 0;
+				bool Applied = false;
+
+				/*
+					Edits made and cameras whose settings changed by
+					them, none of either if the batch was rejected.
+				*/
+				uint32_t EditCount = 0;
+				uint32_t CameraCount = 0;
+
+				/*
+					Index of the edit that could not be made, or the number
+					of edits if each could be made but a camera was left
+					with invalid settings.
+				*/
+				uint32_t FailedEdit = 0;
+				std::string Error;
+			};
+
+			/*
+				Appends an edit with "text" read as a value of the field, as three
+				numbers for vectors and enums by their names. Returns false with
+				"error" set if the field can't be edited or the text is no value of it.
+			*/
+			bool WriteEdit(Utility::BinaryBuffer& buffer, uint32_t cameraid, const std::string& field, const std::string& text, std::string& error);
+
+			/*
+				Start of the next edit, the camera it is for has to be found
+				before the rest of it can be read with ReadEdit.
+			*/
+			bool ReadCameraID(Utility::BinaryBufferView& view, uint32_t& cameraid);
+
+			/*
+				Sets the field the edit is for in "camera". Returns false with "error"
+				set if the edit is cut short, has a value the field can't hold, or
+				is for a field the camera doesn't use with its other settings.
+			*/
+			bool ReadEdit(Utility::BinaryBufferView& view, MapCameraData& camera, std::string& error);
+		}
+
+		namespace Schema
+		{
+			template <>
+			struct Record<MapBatch::Result>
+			{
+				static const char* GetName()
+				{
+					return "BatchResult";
+				}
+
+				static bool IsRejected(const MapBatch::Result& result)
+				{
+					return !result.Applied;
+				}
+
+				template <typename Visitor>
+				static void ForEach(Visitor&& visitor)
+				{
+					using Result = MapBatch::Result;
+
+					visitor(MakeField("BatchID", &Result::BatchID));
+					visitor(MakeField("Applied", &Result::Applied));
+					visitor(MakeField("EditCount", &Result::EditCount, Varint));
+					visitor(MakeField("CameraCount", &Result::CameraCount, Varint));
+					visitor(MakeField("FailedEdit", &Result::FailedEdit, Varint, &IsRejected));
+					visitor(MakeField("Error", &Result::Error, 0, &IsRejected));
+				}
+			};
+		}
+	}
+}
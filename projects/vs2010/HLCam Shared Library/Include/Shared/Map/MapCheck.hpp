@@ -0,0 +1,61 @@
+#pragma once
+#include "Shared/Map/MapFile.hpp"
+#include <string>
+#include <vector>
+#include <unordered_set>
+
+namespace Cam
+{
+	namespace Shared
+	{
+		namespace MapFile
+		{
+			struct MapIssue
+			{
+				enum class SeverityType
+				{
+					Warning,
+					Error,
+				};
+
+				SeverityType Severity;
+
+				/*
+					Says which camera or trigger by its place in the file,
+					IDs can be missing or repeated in what is checked.
+				*/
+				std::string Message;
+			};
+
+			/*
+				Names from the entity lump of a compiled game map.
+			*/
+			struct EntityNames
+			{
+				std::unordered_set<std::string> TargetNames;
+
+				/*
+					Every other key and value. Named cameras can be fired by
+					"target" keys and multi_managers use their keys as targets,
+					so anything here may be what fires one.
+				*/
+				std::unordered_set<std::string> References;
+			};
+
+			bool ReadBSPEntityNames(const char* path, EntityNames& names, std::string& error);
+
+			/*
+				Errors in the settings of one camera on its own, without its
+				triggers or the rest of the map. "description" starts each message.
+			*/
+			void CheckCamera(const MapCameraData& camera, const std::string& description, std::vector<MapIssue>& issues);
+
+			/*
+				"map" should be read with ReadJSONUnnumbered so repeated IDs
+				are still there to be found. Look, attachment and camera names
+				are only checked against the game map when "names" is given.
+			*/
+			void CheckMap(const MapData& map, const EntityNames* names, std::vector<MapIssue>& issues);
+		}
+	}
+}
@@ -0,0 +1,288 @@
+#pragma once
+#include "Shared/Shared.hpp"
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+#include "boost/interprocess/file_mapping.hpp"
+#include "boost/interprocess/mapped_region.hpp"
+
+namespace Cam
+{
+	namespace Shared
+	{
+		/*
+			Engine independent description of a camera map, this is what
+			goes to and from disk. The game turns it into its own entities.
+		*/
+		struct MapVector
+		{
+			float X = 0;
+			float Y = 0;
+			float Z = 0;
+		};
+
+		/*
+			Cameras and triggers keep their IDs between saves so edit
+			journals can refer to them. Items without one are numbered
+			when loaded, see MapFile::AssignIDs.
+
+			The game sends IDs as shorts and indexes arrays by them,
+			anything above MaxMapID is renumbered the same way.
+		*/
+		enum : uint32_t
+		{
+			MaxMapID = 32767,
+			InvalidMapID = 0xFFFFFFFF,
+		};
+
+		struct MapTriggerData
+		{
+			uint32_t ID = InvalidMapID;
+
+			MapVector Corner1;
+			MapVector Corner2;
+		};
+
+		struct MapCameraData
+		{
+			uint32_t ID = InvalidMapID;
+
+			std::vector<MapTriggerData> Triggers;
+
+			MapVector Position;
+			MapVector Angle;
+
+			std::string Name;
+
+			CameraTriggerType TriggerType = CameraTriggerType::ByUserTrigger;
+			CameraLookType LookType = CameraLookType::AtAngle;
+			CameraPlaneType PlaneType = CameraPlaneType::Both;
+			CameraZoomType ZoomType = CameraZoomType::None;
+
+			uint32_t FOV = 90;
+			float MaxSpeed = 200;
+
+			float ZoomTime = 0.5f;
+			float ZoomEndFOV = 20.0f;
+			CameraAngleType ZoomInterpMethod = CameraAngleType::Linear;
+
+			std::string LookTargetName;
+
+			bool UseAttachment = false;
+			std::string AttachmentTargetName;
+			MapVector AttachmentOffset;
+		};
+
+		struct MapData
+		{
+			std::vector<MapCameraData> Cameras;
+		};
+
+		namespace MapFile
+		{
+			/*
+				Size and modification time of a file, stored in compiled
+				maps so they can be discarded when their source has changed.
+			*/
+			struct FileStamp
+			{
+				uint64_t Size = 0;
+				int64_t Time = 0;
+			};
+
+			bool GetFileStamp(const char* path, FileStamp& stamp);
+
+			/*
+				Reads a whole file and appends a null terminator
+				so text can be parsed straight from "bytes".
+			*/
+			bool ReadAllBytes(const char* path, std::vector<char>& bytes);
+			bool WriteAllBytes(const char* path, const char* data, size_t size);
+
+			/*
+				Parses the null terminated "Entities" JSON layout. On failure
+				"error" is set and "map" holds every camera read before it.
+			*/
+			bool ReadJSON(const char* text, MapData& map, std::string& error);
+
+			/*
+				Same as ReadJSON but IDs are kept as stored, missing
+				and repeated ones included. For tools that check them.
+			*/
+			bool ReadJSONUnnumbered(const char* text, MapData& map, std::string& error);
+			std::string WriteJSON(const MapData& map);
+
+			/*
+				Gives every camera and trigger without a unique ID, or with one
+				above MaxMapID, the next free one in file order. Maps saved before
+				IDs were stored get the same numbering the game used to give them.
+			*/
+			void AssignIDs(MapData& map);
+
+			/*
+				Compiled layout, all offsets are from the start of the file.
+				Records are 4 byte aligned and read in place from a mapped view.
+			*/
+			namespace Binary
+			{
+				enum
+				{
+					Version = 3,
+					NoString = 0xFFFFFFFF,
+				};
+
+				extern const char Magic[4];
+
+				struct Header
+				{
+					char Magic[4];
+					uint32_t Version;
+
+					uint64_t SourceSize;
+					int64_t SourceTime;
+
+					uint32_t CameraCount;
+					uint32_t CameraOffset;
+
+					uint32_t TriggerCount;
+					uint32_t TriggerOffset;
+
+					uint32_t StringsSize;
+					uint32_t StringsOffset;
+
+					/*
+						Trigger tree built when compiling, none if
+						the trigger IDs were not unique.
+					*/
+					uint32_t TreeNodeCount;
+					uint32_t TreeNodeOffset;
+				};
+
+				struct CameraRecord
+				{
+					uint32_t ID;
+
+					float Position[3];
+					float Angle[3];
+					float AttachmentOffset[3];
+
+					float MaxSpeed;
+					float ZoomTime;
+					float ZoomEndFOV;
+
+					uint32_t FOV;
+
+					/*
+						Range of this camera's triggers in the trigger table.
+					*/
+					uint32_t FirstTrigger;
+					uint32_t TriggerCount;
+
+					/*
+						Offsets into the string table, or NoString.
+					*/
+					uint32_t Name;
+					uint32_t LookTargetName;
+					uint32_t AttachmentTargetName;
+
+					uint8_t TriggerType;
+					uint8_t LookType;
+					uint8_t PlaneType;
+					uint8_t ZoomType;
+					uint8_t ZoomInterpMethod;
+					uint8_t UseAttachment;
+					uint8_t Padding[2];
+				};
+
+				/*
+					Bounds are precomputed so loading does no math.
+				*/
+				struct TriggerRecord
+				{
+					uint32_t ID;
+
+					float Corner1[3];
+					float Corner2[3];
+
+					float Min[3];
+					float Max[3];
+					float Center[3];
+
+					uint32_t CameraIndex;
+				};
+
+				/*
+					Depth first with the root first, children always
+					come after their parent. Leaves have no children.
+				*/
+				struct TreeNodeRecord
+				{
+					float Min[3];
+					float Max[3];
+
+					int32_t Children[2];
+
+					/*
+						Trigger ID of leaves.
+					*/
+					uint32_t ID;
+				};
+
+				static_assert(sizeof(Header) == 56, "Binary map header layout changed");
+				static_assert(sizeof(CameraRecord) == 84, "Binary map camera layout changed");
+				static_assert(sizeof(TriggerRecord) == 68, "Binary map trigger layout changed");
+				static_assert(sizeof(TreeNodeRecord) == 36, "Binary map tree layout changed");
+
+				/*
+					Cameras or triggers without an ID are numbered as by AssignIDs.
+				*/
+				bool Write(const MapData& map, const FileStamp& source, std::vector<char>& output);
+			}
+
+			/*
+				Read only memory mapped view of a compiled map. Records
+				are used directly from the mapping, nothing is copied.
+			*/
+			class BinaryMap final
+			{
+			public:
+				bool Open(const char* path, std::string& error);
+
+				/*
+					The source JSON is considered changed if its stamp differs,
+					a missing source leaves the compiled map as the only copy.
+				*/
+				bool IsCurrent(const char* sourcepath) const;
+
+				const Binary::Header& GetHeader() const;
+
+				const Binary::CameraRecord* GetCameras() const;
+				size_t GetCameraCount() const;
+
+				const Binary::TriggerRecord* GetTriggers() const;
+				size_t GetTriggerCount() const;
+
+				const Binary::TreeNodeRecord* GetTreeNodes() const;
+				size_t GetTreeNodeCount() const;
+
+				/*
+					Returns an empty string for NoString.
+				*/
+				const char* GetString(uint32_t offset) const;
+
+				void ToMapData(MapData& map) const;
+
+			private:
+				bool Validate(std::string& error) const;
+
+				boost::interprocess::file_mapping File;
+				boost::interprocess::mapped_region Region;
+
+				const char* Data = nullptr;
+				size_t Size = 0;
+			};
+		}
+	}
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include "Shared/Map/MapFile.hpp"
+#include <fstream>
+
+namespace Cam
+{
+	namespace Shared
+	{
+		namespace MapFile
+		{
+			/*
+				Append only log of edits made since the last full save of a map.
+				Loading replays it over that save, so an edit only costs one record.
+			*/
+			namespace Journal
+			{
+				enum
+				{
+					Version = 1,
+				};
+
+				extern const char Magic[4];
+
+				struct Header
+				{
+					char Magic[4];
+					uint32_t Version;
+				};
+
+				/*
+					Every record holds the full new state of one item, replaying
+					a record twice or over a save that already has it is harmless.
+				*/
+				enum class RecordType : uint8_t
+				{
+					SetCamera,
+					RemoveCamera,
+					SetTrigger,
+					RemoveTrigger,
+				};
+
+				/*
+					Records follow the header back to back: uint32 checksum of the
+					type and payload, uint16 payload size, uint8 type, payload.
+					A record that is cut short or does not match ends the journal.
+				*/
+				enum
+				{
+					RecordHeaderSize = 7,
+				};
+			}
+
+			class JournalWriter final
+			{
+			public:
+				/*
+					Prepares to append to the journal at "path". The file is not
+					created until the first record, a damaged tail left by a crash
+					is cut off so new records follow the last complete one.
+				*/
+				bool Open(const char* path);
+				void Close();
+
+				bool IsOpen() const;
+
+				/*
+					The camera's triggers are not written, they have their own records.
+				*/
+				bool SetCamera(const MapCameraData& camera);
+				bool RemoveCamera(uint32_t id);
+
+				bool SetTrigger(uint32_t cameraid, const MapTriggerData& trigger);
+				bool RemoveTrigger(uint32_t id);
+
+				/*
+					Moves every record to the end of "oldpath" and starts over empty.
+					Used when a save of the current state is queued, "oldpath" can
+					be removed once that save is on disk.
+				*/
+				bool Rotate(const char* oldpath);
+
+				/*
+					Records since the journal was last empty.
+				*/
+				size_t GetRecordCount() const;
+				uint64_t GetRecordBytes() const;
+
+			private:
+				bool Append(Journal::RecordType type, const void* payload, size_t size);
+
+				std::string Path;
+				std::ofstream File;
+
+				size_t RecordCount = 0;
+				uint64_t RecordBytes = 0;
+			};
+
+			/*
+				Applies every complete record in "path" to "map" in order, a missing
+				journal has no records. Returns false with "error" set if replay
+				stopped at a damaged record, everything before it is still applied.
+			*/
+			bool ReplayJournal(const char* path, MapData& map, size_t& records, std::string& error);
+		}
+	}
+}
@@ -0,0 +1,579 @@
+#pragma once
+#include "Shared/Map/MapFile.hpp"
+#include "Shared/Binary Buffer/BinaryBuffer.hpp"
+#include <type_traits>
+#include <cstring>
+
+namespace Cam
+{
+	namespace Shared
+	{
+		/*
+			The fields of every record the game, the editor and map files
+			exchange, listed once. Encoders, decoders and the JSON reader
+			and writer are all made from these lists so they can't disagree.
+		*/
+		namespace Schema
+		{
+			enum FieldFlags : unsigned
+			{
+				/*
+					Seven bits per byte, IDs and small counts take one or two.
+				*/
+				Varint = 1 << 0,
+
+				/*
+					Files without it are rejected instead of using the default.
+				*/
+				Required = 1 << 1,
+
+				/*
+					Left out of files while it holds InvalidMapID.
+				*/
+				OptionalID = 1 << 2,
+
+				/*
+					Not sent to the editor.
+				*/
+				FileOnly = 1 << 3,
+
+				/*
+					Set when the record is made, batch edits can't change it.
+				*/
+				Fixed = 1 << 4,
+			};
+
+			template <typename Owner, typename T>
+			struct Field
+			{
+				const char* Name;
+				T Owner::* Member;
+				unsigned Flags;
+
+				/*
+					Whether the field is there at all, may only look at
+					fields listed before it so decoders can tell too.
+				*/
+				bool(*When)(const Owner& owner);
+			};
+
+			template <typename Owner, typename T>
+			constexpr Field<Owner, T> MakeField(const char* name, T Owner::* member, unsigned flags = 0, bool(*when)(const Owner&) = nullptr)
+			{
+				return {name, member, flags, when};
+			}
+
+			/*
+				What the editor is told about each trigger.
+			*/
+			struct TriggerLink
+			{
+				uint32_t ID = InvalidMapID;
+				uint32_t CameraID = InvalidMapID;
+			};
+
+			/*
+				Every camera the editor is sent when it attaches
+				or the map is reset, compressed in chunks.
+			*/
+			struct MapSnapshot
+			{
+				std::string Name;
+				std::vector<MapCameraData> Cameras;
+			};
+
+			/*
+				Specialized for every record with its name in messages
+				and ForEach, which hands each field to "visitor" in order.
+			*/
+			template <typename T>
+			struct Record;
+
+			template <>
+			struct Record<MapTriggerData>
+			{
+				static const char* GetName()
+				{
+					return "Trigger";
+				}
+
+				template <typename Visitor>
+				static void ForEach(Visitor&& visitor)
+				{
+					visitor(MakeField("ID", &MapTriggerData::ID, Varint | OptionalID));
+					visitor(MakeField("Corner1", &MapTriggerData::Corner1, Required | FileOnly));
+					visitor(MakeField("Corner2", &MapTriggerData::Corner2, Required | FileOnly));
+				}
+			};
+
+			template <>
+			struct Record<MapCameraData>
+			{
+				static const char* GetName()
+				{
+					return "Camera";
+				}
+
+				static bool HasTriggers(const MapCameraData& camera)
+				{
+					return camera.TriggerType == CameraTriggerType::ByUserTrigger;
+				}
+
+				static bool HasName(const MapCameraData& camera)
+				{
+					return camera.TriggerType == CameraTriggerType::ByName;
+				}
+
+				static bool HasLookTarget(const MapCameraData& camera)
+				{
+					return camera.LookType == CameraLookType::AtTarget;
+				}
+
+				static bool HasAttachment(const MapCameraData& camera)
+				{
+					return camera.UseAttachment;
+				}
+
+				template <typename Visitor>
+				static void ForEach(Visitor&& visitor)
+				{
+					using Camera = MapCameraData;
+
+					visitor(MakeField("ID", &Camera::ID, Varint | OptionalID | Fixed));
+					visitor(MakeField("TriggerType", &Camera::TriggerType, Fixed));
+					visitor(MakeField("Triggers", &Camera::Triggers, Fixed, &HasTriggers));
+
+					visitor(MakeField("Position", &Camera::Position, Required));
+					visitor(MakeField("Angle", &Camera::Angle, Required));
+					visitor(MakeField("FOV", &Camera::FOV, Varint));
+					visitor(MakeField("Speed", &Camera::MaxSpeed));
+
+					visitor(MakeField("LookType", &Camera::LookType));
+					visitor(MakeField("LookTargetName", &Camera::LookTargetName, 0, &HasLookTarget));
+					visitor(MakeField("PlaneType", &Camera::PlaneType));
+
+					visitor(MakeField("ZoomType", &Camera::ZoomType));
+					visitor(MakeField("ZoomTime", &Camera::ZoomTime));
+					visitor(MakeField("ZoomEndFOV", &Camera::ZoomEndFOV));
+					visitor(MakeField("ZoomInterpMethod", &Camera::ZoomInterpMethod));
+
+					visitor(MakeField("Name", &Camera::Name, Required, &HasName));
+
+					visitor(MakeField("UseAttachment", &Camera::UseAttachment));
+					visitor(MakeField("AttachmentTargetName", &Camera::AttachmentTargetName, Required, &HasAttachment));
+					visitor(MakeField("AttachmentOffset", &Camera::AttachmentOffset, Required, &HasAttachment));
+				}
+			};
+
+			template <>
+			struct Record<TriggerLink>
+			{
+				static const char* GetName()
+				{
+					return "TriggerLink";
+				}
+
+				template <typename Visitor>
+				static void ForEach(Visitor&& visitor)
+				{
+					visitor(MakeField("ID", &TriggerLink::ID, Varint));
+					visitor(MakeField("CameraID", &TriggerLink::CameraID, Varint));
+				}
+			};
+
+			template <>
+			struct Record<MapSnapshot>
+			{
+				static const char* GetName()
+				{
+					return "MapSnapshot";
+				}
+
+				template <typename Visitor>
+				static void ForEach(Visitor&& visitor)
+				{
+					visitor(MakeField("Name", &MapSnapshot::Name));
+					visitor(MakeField("Cameras", &MapSnapshot::Cameras));
+				}
+			};
+
+			template <typename Owner, typename T>
+			bool IsPresent(const Field<Owner, T>& field, const Owner& owner)
+			{
+				return !field.When || field.When(owner);
+			}
+
+			template <typename Owner, typename T>
+			bool IsOnWire(const Field<Owner, T>& field, const Owner& owner)
+			{
+				return !(field.Flags & FileOnly) && IsPresent(field, owner);
+			}
+
+			/*
+				Binary layout, little endian like the rest of the messages.
+			*/
+			namespace Wire
+			{
+				inline size_t GetVarintSize(uint32_t value)
+				{
+					size_t ret = 1;
+
+					while (value >= 0x80)
+					{
+						value >>= 7;
+						ret++;
+					}
+
+					return ret;
+				}
+
+				inline void WriteVarint(Utility::BinaryBuffer& buffer, uint32_t value)
+				{
+					unsigned char bytes[5];
+					size_t count = 0;
+
+					while (value >= 0x80)
+					{
+						bytes[count++] = static_cast<unsigned char>(value | 0x80);
+						value >>= 7;
+					}
+
+					bytes[count++] = static_cast<unsigned char>(value);
+
+					buffer.Append(bytes, count);
+				}
+
+				inline bool ReadVarint(Utility::BinaryBufferView& view, uint32_t& value)
+				{
+					value = 0;
+
+					for (size_t shift = 0; shift < 35; shift += 7)
+					{
+						auto byte = static_cast<const unsigned char*>(view.ReadBytes(1));
+
+						if (!byte)
+						{
+							return false;
+						}
+
+						value |= static_cast<uint32_t>(*byte & 0x7F) << shift;
+
+						if (!(*byte & 0x80))
+						{
+							return true;
+						}
+					}
+
+					return false;
+				}
+
+				template <typename T>
+				bool ReadRaw(Utility::BinaryBufferView& view, T& value)
+				{
+					auto bytes = view.ReadBytes(sizeof(value));
+
+					if (!bytes)
+					{
+						return false;
+					}
+
+					std::memcpy(&value, bytes, sizeof(value));
+					return true;
+				}
+
+				inline size_t GetValueSize(uint32_t value, unsigned flags)
+				{
+					return (flags & Varint) ? GetVarintSize(value) : sizeof(value);
+				}
+
+				inline size_t GetValueSize(float value, unsigned /*flags*/)
+				{
+					return sizeof(value);
+				}
+
+				inline size_t GetValueSize(bool /*value*/, unsigned /*flags*/)
+				{
+					return 1;
+				}
+
+				inline size_t GetValueSize(const MapVector& /*value*/, unsigned /*flags*/)
+				{
+					return sizeof(float) * 3;
+				}
+
+				inline size_t GetValueSize(const std::string& value, unsigned /*flags*/)
+				{
+					return GetVarintSize(static_cast<uint32_t>(value.size())) + value.size();
+				}
+
+				template <typename T>
+				typename std::enable_if<std::is_enum<T>::value, size_t>::type GetValueSize(T /*value*/, unsigned /*flags*/)
+				{
+					return 1;
+				}
+
+				template <typename T>
+				size_t GetValueSize(const std::vector<T>& values, unsigned flags);
+
+				inline void WriteValue(Utility::BinaryBuffer& buffer, uint32_t value, unsigned flags)
+				{
+					if (flags & Varint)
+					{
+						WriteVarint(buffer, value);
+						return;
+					}
+
+					buffer << value;
+				}
+
+				inline void WriteValue(Utility::BinaryBuffer& buffer, float value, unsigned /*flags*/)
+				{
+					buffer << value;
+				}
+
+				inline void WriteValue(Utility::BinaryBuffer& buffer, bool value, unsigned /*flags*/)
+				{
+					buffer << value;
+				}
+
+				inline void WriteValue(Utility::BinaryBuffer& buffer, const MapVector& value, unsigned /*flags*/)
+				{
+					buffer << value.X;
+					buffer << value.Y;
+					buffer << value.Z;
+				}
+
+				inline void WriteValue(Utility::BinaryBuffer& buffer, const std::string& value, unsigned /*flags*/)
+				{
+					WriteVarint(buffer, static_cast<uint32_t>(value.size()));
+					buffer.Append(value.data(), value.size());
+				}
+
+				template <typename T>
+				typename std::enable_if<std::is_enum<T>::value>::type WriteValue(Utility::BinaryBuffer& buffer, T value, unsigned /*flags*/)
+				{
+					buffer << static_cast<unsigned char>(value);
+				}
+
+				template <typename T>
+				void WriteValue(Utility::BinaryBuffer& buffer, const std::vector<T>& values, unsigned flags);
+
+				inline bool ReadValue(Utility::BinaryBufferView& view, uint32_t& value, unsigned flags)
+				{
+					if (flags & Varint)
+					{
+						return ReadVarint(view, value);
+					}
+
+					return ReadRaw(view, value);
+				}
+
+				inline bool ReadValue(Utility::BinaryBufferView& view, float& value, unsigned /*flags*/)
+				{
+					return ReadRaw(view, value);
+				}
+
+				inline bool ReadValue(Utility::BinaryBufferView& view, bool& value, unsigned /*flags*/)
+				{
+					unsigned char byte;
+
+					if (!ReadRaw(view, byte))
+					{
+						return false;
+					}
+
+					value = byte != 0;
+					return true;
+				}
+
+				inline bool ReadValue(Utility::BinaryBufferView& view, MapVector& value, unsigned /*flags*/)
+				{
+					return ReadRaw(view, value.X) && ReadRaw(view, value.Y) && ReadRaw(view, value.Z);
+				}
+
+				inline bool ReadValue(Utility::BinaryBufferView& view, std::string& value, unsigned /*flags*/)
+				{
+					uint32_t length;
+
+					if (!ReadVarint(view, length))
+					{
+						return false;
+					}
+
+					auto chars = static_cast<const char*>(view.ReadBytes(length));
+
+					if (!chars && length != 0)
+					{
+						return false;
+					}
+
+					value.assign(chars ? chars : "", length);
+					return true;
+				}
+
+				template <typename T>
+				typename std::enable_if<std::is_enum<T>::value, bool>::type ReadValue(Utility::BinaryBufferView& view, T& value, unsigned /*flags*/)
+				{
+					unsigned char byte;
+
+					if (!ReadRaw(view, byte))
+					{
+						return false;
+					}
+
+					value = static_cast<T>(byte);
+					return true;
+				}
+
+				template <typename T>
+				bool ReadValue(Utility::BinaryBufferView& view, std::vector<T>& values, unsigned flags);
+			}
+
+			/*
+				Bytes Encode adds for "value", so a packet can be sized once.
+			*/
+			template <typename T>
+			size_t GetEncodedSize(const T& value)
+			{
+				size_t ret = 0;
+
+				Record<T>::ForEach([&value, &ret](const auto& field)
+				{
+					if (IsOnWire(field, value))
+					{
+						ret += Wire::GetValueSize(value.*field.Member, field.Flags);
+					}
+				});
+
+				return ret;
+			}
+
+			template <typename T>
+			void Encode(Utility::BinaryBuffer& buffer, const T& value)
+			{
+				Record<T>::ForEach([&buffer, &value](const auto& field)
+				{
+					if (IsOnWire(field, value))
+					{
+						Wire::WriteValue(buffer, value.*field.Member, field.Flags);
+					}
+				});
+			}
+
+			/*
+				Returns false if the data ends early, "value" then holds
+				what was read before that.
+			*/
+			template <typename T>
+			bool Decode(Utility::BinaryBufferView& view, T& value)
+			{
+				auto ret = true;
+
+				Record<T>::ForEach([&view, &value, &ret](const auto& field)
+				{
+					if (ret && IsOnWire(field, value))
+					{
+						ret = Wire::ReadValue(view, value.*field.Member, field.Flags);
+					}
+				});
+
+				return ret;
+			}
+
+			/*
+				Continues from and moves the buffer's read position.
+			*/
+			template <typename T>
+			bool Decode(Utility::BinaryBuffer& buffer, T& value)
+			{
+				auto position = buffer.GetReadPosition();
+
+				Utility::BinaryBufferView view(static_cast<const unsigned char*>(buffer.GetData()) + position, buffer.GetSize() - position);
+
+				auto ret = Decode(view, value);
+
+				buffer.SetReadPosition(position + view.GetReadPosition());
+
+				return ret;
+			}
+
+			inline size_t GetEncodedSize()
+			{
+				return 0;
+			}
+
+			template <typename T, typename... Rest>
+			size_t GetEncodedSize(const T& value, const Rest&... rest)
+			{
+				return GetEncodedSize(value) + GetEncodedSize(rest...);
+			}
+
+			/*
+				Appends every record after reserving for all of them,
+				the buffer grows at most once.
+			*/
+			template <typename... Records>
+			void EncodePacket(Utility::BinaryBuffer& buffer, const Records&... records)
+			{
+				buffer.Reserve(buffer.GetSize() + GetEncodedSize(records...));
+
+				int unused[] = {(Encode(buffer, records), 0)...};
+				(void)unused;
+			}
+
+			namespace Wire
+			{
+				template <typename T>
+				size_t GetValueSize(const std::vector<T>& values, unsigned /*flags*/)
+				{
+					auto ret = GetVarintSize(static_cast<uint32_t>(values.size()));
+
+					for (const auto& value : values)
+					{
+						ret += GetEncodedSize(value);
+					}
+
+					return ret;
+				}
+
+				template <typename T>
+				void WriteValue(Utility::BinaryBuffer& buffer, const std::vector<T>& values, unsigned /*flags*/)
+				{
+					WriteVarint(buffer, static_cast<uint32_t>(values.size()));
+
+					for (const auto& value : values)
+					{
+						Encode(buffer, value);
+					}
+				}
+
+				template <typename T>
+				bool ReadValue(Utility::BinaryBufferView& view, std::vector<T>& values, unsigned /*flags*/)
+				{
+					uint32_t count;
+
+					/*
+						Every record takes at least a byte, a larger count
+						is damage and not worth allocating for.
+					*/
+					if (!ReadVarint(view, count) || count > view.GetSize() - view.GetReadPosition())
+					{
+						return false;
+					}
+
+					values.resize(count);
+
+					for (auto& value : values)
+					{
+						if (!Decode(view, value))
+						{
+							return false;
+						}
+					}
+
+					return true;
+				}
+			}
+		}
+	}
+}
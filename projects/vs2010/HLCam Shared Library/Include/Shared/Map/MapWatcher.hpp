@@ -0,0 +1,42 @@
+#pragma once
+#include <string>
+#include <vector>
+
+namespace Cam
+{
+	namespace Shared
+	{
+		namespace MapFile
+		{
+			/*
+				Reports files that were written to or moved into a directory,
+				so camera maps edited outside the game can be picked up.
+				Only implemented with inotify on Linux, elsewhere Start fails
+				and nothing is ever reported.
+			*/
+			class DirectoryWatcher final
+			{
+			public:
+				DirectoryWatcher() = default;
+				~DirectoryWatcher();
+
+				DirectoryWatcher(const DirectoryWatcher&) = delete;
+				DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+				bool Start(const char* directory);
+				void Stop();
+				bool IsStarted() const;
+
+				/*
+					Appends names, without the directory, of files changed since
+					the last call. Never waits. An empty name means events were
+					lost and any file may have changed.
+				*/
+				void Poll(std::vector<std::string>& names);
+
+			private:
+				int Handle = -1;
+			};
+		}
+	}
+}
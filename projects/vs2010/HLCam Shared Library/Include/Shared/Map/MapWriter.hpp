@@ -0,0 +1,124 @@
+#pragma once
+#include "Shared/Map/MapFile.hpp"
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+
+namespace Cam
+{
+	namespace Shared
+	{
+		namespace MapFile
+		{
+			/*
+				Writes to a temporary file next to "path" and renames it over
+				the target, so readers see either the old or the new file.
+			*/
+			bool WriteAllBytesAtomic(const char* path, const char* data, size_t size);
+
+			/*
+				Serializes and writes map snapshots on a worker thread.
+				Snapshots for the same file that have not started writing
+				yet are replaced by newer ones.
+			*/
+			class AsyncWriter final
+			{
+			public:
+				~AsyncWriter();
+
+				struct SaveRequest
+				{
+					MapData Map;
+
+					std::string JSONPath;
+
+					/*
+						Compiled map to write after the JSON, can be empty.
+					*/
+					std::string BinaryPath;
+
+					/*
+						Journal of edits this snapshot already holds, can be empty.
+						Removed once the map is written unless a newer save of the
+						same map is queued, as that journal then has its edits too.
+					*/
+					std::string JournalPath;
+				};
+
+				void Queue(SaveRequest&& request);
+
+				struct SaveResult
+				{
+					std::string JSONPath;
+					bool Success;
+
+					/*
+						From queueing to the files being in place.
+					*/
+					double Milliseconds;
+				};
+
+				/*
+					Finished saves, to be reported on the thread that queued them.
+				*/
+				bool PopResult(SaveResult& result);
+
+				struct Stats
+				{
+					size_t InFlight = 0;
+					size_t Completed = 0;
+					size_t Failed = 0;
+					size_t Replaced = 0;
+
+					double LastMilliseconds = 0;
+					double MaxMilliseconds = 0;
+					double TotalMilliseconds = 0;
+				};
+
+				Stats GetStats() const;
+
+				/*
+					Starts counting again, saves still queued stay in flight.
+				*/
+				void ResetStats();
+
+				/*
+					Blocks until every queued save has been written.
+				*/
+				void Flush();
+
+				/*
+					Writes what is queued and stops the worker, it is
+					started again by the next call to Queue.
+				*/
+				void Stop();
+
+			private:
+				using ClockType = std::chrono::steady_clock;
+
+				struct Job
+				{
+					SaveRequest Request;
+					ClockType::time_point QueueTime;
+				};
+
+				void Worker();
+
+				mutable std::mutex Mutex;
+				std::condition_variable WorkCondition;
+				std::condition_variable IdleCondition;
+
+				std::thread WorkerThread;
+				bool ShouldStop = false;
+				bool Writing = false;
+
+				std::deque<Job> Jobs;
+				std::deque<SaveResult> Results;
+
+				Stats CurrentStats;
+			};
+		}
+	}
+}
@@ -0,0 +1,188 @@
+#pragma once
+#include "Shared/Shared.hpp"
+#include <array>
+#include <cstddef>
+#include <utility>
+
+namespace Utility
+{
+	/*
+		Curves that map a transition's progress from 0 to 1 onto how far
+		along its value is. The curved ones are sampled into tables when
+		compiling, evaluating one is a table read and a blend.
+	*/
+	namespace Easing
+	{
+		namespace Detail
+		{
+			enum
+			{
+				TableSize = 257,
+			};
+
+			/*
+				Series only needs to be good over the range the curves use,
+				0 to pi and 0 to 10 ln 2.
+			*/
+			constexpr double CosSeries(double x2, double term, int n)
+			{
+				return n > 24 ? term : term + CosSeries(x2, -term * x2 / ((2.0 * n + 1) * (2.0 * n + 2)), n + 1);
+			}
+
+			constexpr double Cos(double x)
+			{
+				return CosSeries(x * x, 1, 0);
+			}
+
+			constexpr double ExpSeries(double x, double term, int n)
+			{
+				return n > 40 ? term : term + ExpSeries(x, term * x / (n + 1), n + 1);
+			}
+
+			constexpr double Exp(double x)
+			{
+				return ExpSeries(x, 1, 0);
+			}
+
+			struct SmoothCurve
+			{
+				static constexpr double At(double time)
+				{
+					return (1.0 - Cos(time * 3.14159265358979323846)) / 2.0;
+				}
+			};
+
+			/*
+				Goes from 0 to 1 as 2^(10 time), scaled to start at 0.
+			*/
+			constexpr double ExponentialIn(double time)
+			{
+				return (Exp(time * 10.0 * 0.69314718055994530942) - 1.0) / 1023.0;
+			}
+
+			struct ExponentialCurve
+			{
+				static constexpr double At(double time)
+				{
+					return time < 0.5 ? ExponentialIn(time * 2.0) / 2.0 : 1.0 - ExponentialIn(2.0 - time * 2.0) / 2.0;
+				}
+			};
+
+			template <typename Curve, size_t... Indices>
+			constexpr std::array<float, sizeof...(Indices)> MakeTable(std::index_sequence<Indices...>)
+			{
+				return {{static_cast<float>(Curve::At(static_cast<double>(Indices) / (sizeof...(Indices) - 1)))...}};
+			}
+
+			constexpr std::array<float, TableSize> SmoothTable = MakeTable<SmoothCurve>(std::make_index_sequence<TableSize>());
+			constexpr std::array<float, TableSize> ExponentialTable = MakeTable<ExponentialCurve>(std::make_index_sequence<TableSize>());
+
+			inline float Sample(const std::array<float, TableSize>& table, float time)
+			{
+				if (time <= 0.0f)
+				{
+					return table[0];
+				}
+
+				if (time >= 1.0f)
+				{
+					return table[TableSize - 1];
+				}
+
+				auto position = time * (TableSize - 1);
+				auto index = static_cast<size_t>(position);
+				auto fraction = position - index;
+
+				return table[index] + (table[index + 1] - table[index]) * fraction;
+			}
+		}
+
+		inline float Linear(float time)
+		{
+			if (time <= 0.0f)
+			{
+				return 0.0f;
+			}
+
+			if (time >= 1.0f)
+			{
+				return 1.0f;
+			}
+
+			return time;
+		}
+
+		/*
+			Half a cosine wave, slow at both ends.
+		*/
+		inline float Smooth(float time)
+		{
+			return Detail::Sample(Detail::SmoothTable, time);
+		}
+
+		/*
+			Exponential both ways, holds back longer than Smooth
+			at the ends and moves faster through the middle.
+		*/
+		inline float Exponential(float time)
+		{
+			return Detail::Sample(Detail::ExponentialTable, time);
+		}
+
+		/*
+			Cubic Hermite curve with chosen slopes at the start and end,
+			1 and 1 is linear and 0 and 0 eases both ways. Slopes above 1
+			overshoot. It is cheaper to evaluate than to look up, so it
+			isn't kept in a table.
+		*/
+		inline float Cubic(float time, float startslope, float endslope)
+		{
+			if (time <= 0.0f)
+			{
+				return 0.0f;
+			}
+
+			if (time >= 1.0f)
+			{
+				return 1.0f;
+			}
+
+			auto a = startslope + endslope - 2.0f;
+			auto b = 3.0f - 2.0f * startslope - endslope;
+
+			return ((a * time + b) * time + startslope) * time;
+		}
+
+		inline float Ease(Cam::Shared::CameraAngleType type, float time)
+		{
+			switch (type)
+			{
+				case Cam::Shared::CameraAngleType::Linear:
+				{
+					return Linear(time);
+				}
+
+				case Cam::Shared::CameraAngleType::Smooth:
+				{
+					return Smooth(time);
+				}
+
+				case Cam::Shared::CameraAngleType::Exponential:
+				{
+					return Exponential(time);
+				}
+			}
+
+			/*
+				Out of range values from damaged files.
+			*/
+			return Linear(time);
+		}
+
+		inline float Interpolate(Cam::Shared::CameraAngleType type, float start, float end, float time)
+		{
+			auto eased = Ease(type, time);
+			return start + (end - start) * eased;
+		}
+	}
+}
@@ -1,6 +1,6 @@
 #include "Shared.hpp"
 #include <string>
-#include "Shared\String\String.hpp"
+#include "Shared/String/String.hpp"
 
 const char* Cam::Shared::CameraAngleTypeToString(CameraAngleType type)
 {
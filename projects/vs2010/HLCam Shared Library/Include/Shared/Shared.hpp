@@ -136,6 +136,17 @@ namespace Cam
 
 					MoveToCamera,
 					MoveToTrigger,
+
+					/*
+						A snapshot arrived damaged or with chunks missing.
+					*/
+					RequestMapSnapshot,
+
+					/*
+						Many camera edits made at once, see MapBatch.
+						Scripts send it on their own connection.
+					*/
+					Camera_ApplyBatch,
 				};
 			}
 
@@ -160,6 +171,23 @@ namespace Cam
 
 					OnTriggerRemoved,
 					OnCameraRemoved,
+
+					/*
+						Chunk of every camera in the map, see Schema::MapSnapshot.
+						Sent after OnEditModeStarted when the map was reset.
+					*/
+					OnMapSnapshot,
+
+					/*
+						MapBatch::Result, to whoever sent the batch.
+					*/
+					OnBatchApplied,
+
+					/*
+						Settings of a camera a script changed, as Schema's
+						MapCameraData. Its triggers stay as they were.
+					*/
+					OnCameraChanged,
 				};
 			}
 		}
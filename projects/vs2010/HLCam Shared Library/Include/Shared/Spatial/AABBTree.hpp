@@ -0,0 +1,283 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+
+namespace Utility
+{
+	struct AABB
+	{
+		float Min[3];
+		float Max[3];
+
+		bool Intersects(const AABB& other) const
+		{
+			return Min[0] <= other.Max[0] && Max[0] >= other.Min[0] &&
+				   Min[1] <= other.Max[1] && Max[1] >= other.Min[1] &&
+				   Min[2] <= other.Max[2] && Max[2] >= other.Min[2];
+		}
+
+		bool Contains(const AABB& other) const
+		{
+			return Min[0] <= other.Min[0] && Max[0] >= other.Max[0] &&
+				   Min[1] <= other.Min[1] && Max[1] >= other.Max[1] &&
+				   Min[2] <= other.Min[2] && Max[2] >= other.Max[2];
+		}
+
+		float SurfaceArea() const
+		{
+			float x = Max[0] - Min[0];
+			float y = Max[1] - Min[1];
+			float z = Max[2] - Min[2];
+
+			return 2.0f * (x * y + y * z + z * x);
+		}
+
+		static AABB Merge(const AABB& first, const AABB& other);
+	};
+
+	/*
+		Dynamic bounding volume hierarchy over boxes that are identified
+		by an external ID. Leaves can be inserted, removed and moved
+		individually, the tree is kept balanced with rotations so queries
+		stay logarithmic.
+	*/
+	class AABBTree final
+	{
+	public:
+		using IDType = size_t;
+
+		/*
+			Builds a new tree from scratch with a top down median split.
+			Much faster and of better quality than inserting one by one,
+			meant for loading a whole map.
+		*/
+		void Build(const std::vector<std::pair<IDType, AABB>>& items);
+
+		/*
+			Node of a tree stored outside of it, see Save and Load.
+			Leaves have no children.
+		*/
+		struct FlatNode
+		{
+			AABB Box;
+			int Children[2];
+			IDType ID;
+		};
+
+		/*
+			Copies the tree depth first with the root at index 0,
+			so children always come after their parent.
+		*/
+		void Save(std::vector<FlatNode>& nodes) const;
+
+		/*
+			Replaces the tree with one written by Save without redoing any
+			of the building. Returns false and leaves the tree empty if the
+			nodes do not form a single tree, a parent's box does not hold
+			its children's or an ID is used twice.
+		*/
+		bool Load(const FlatNode* nodes, size_t count);
+
+		void Insert(IDType id, const AABB& box);
+		void Remove(IDType id);
+
+		/*
+			Moves an existing leaf, or inserts it if it doesn't exist.
+		*/
+		void Update(IDType id, const AABB& box);
+
+		bool Contains(IDType id) const;
+
+		/*
+			Box of a leaf, null if there is none with this ID.
+		*/
+		const AABB* FindBox(IDType id) const;
+		size_t GetCount() const;
+		int GetHeight() const;
+
+		void Clear();
+
+		struct RayHit
+		{
+			IDType ID;
+
+			/*
+				Distance along the ray where the box is entered. If the ray
+				starts inside, where it is left or the search distance if less.
+			*/
+			float Distance;
+		};
+
+		/*
+			Finds the closest box hit by the ray within "maxdistance". A box
+			around the origin only wins if no other box is entered before
+			the ray leaves it, so boxes ahead can be picked from inside one.
+			Direction does not need to be normalized, distance is then in
+			multiples of its length. Traverses a packed 4 wide copy of the
+			tree front to back, which is refreshed here after any edits.
+		*/
+		bool RayCast(const float* origin, const float* direction, float maxdistance, RayHit& hit);
+
+		/*
+			Calls "callback(id)" for every box intersecting "box".
+			The callback returns false to stop the search.
+		*/
+		template <typename Func>
+		void QueryBox(const AABB& box, Func&& callback) const
+		{
+			if (Root == NullNode)
+			{
+				return;
+			}
+
+			NodeStack stack;
+			stack.Push(Root);
+
+			while (!stack.Empty())
+			{
+				const auto& node = Nodes[stack.Pop()];
+
+				if (!node.Box.Intersects(box))
+				{
+					continue;
+				}
+
+				if (node.IsLeaf())
+				{
+					if (!callback(node.ID))
+					{
+						return;
+					}
+
+					continue;
+				}
+
+				stack.Push(node.Children[0]);
+				stack.Push(node.Children[1]);
+			}
+		}
+
+	private:
+		enum
+		{
+			NullNode = -1,
+		};
+
+		struct Node
+		{
+			AABB Box;
+
+			int Parent = NullNode;
+			int Children[2] = {NullNode, NullNode};
+
+			/*
+				Leaf nodes have a height of 0, free nodes -1.
+			*/
+			int Height = -1;
+
+			IDType ID = 0;
+
+			bool IsLeaf() const
+			{
+				return Children[0] == NullNode;
+			}
+		};
+
+		/*
+			Traversal stack that lives on the call stack for all
+			sane tree heights and only spills to the heap beyond that.
+		*/
+		class NodeStack
+		{
+		public:
+			void Push(int node)
+			{
+				if (Count < LocalSize)
+				{
+					Local[Count++] = node;
+					return;
+				}
+
+				Spill.push_back(node);
+				Count++;
+			}
+
+			int Pop()
+			{
+				Count--;
+
+				if (Count >= LocalSize)
+				{
+					auto ret = Spill.back();
+					Spill.pop_back();
+					return ret;
+				}
+
+				return Local[Count];
+			}
+
+			bool Empty() const
+			{
+				return Count == 0;
+			}
+
+		private:
+			enum
+			{
+				LocalSize = 128,
+			};
+
+			int Local[LocalSize];
+			size_t Count = 0;
+			std::vector<int> Spill;
+		};
+
+		/*
+			Four children per node stored as structure of arrays so one
+			slab test covers all of them. Negative children are leaves,
+			indexing PackedLeafIDs with -(child + 1).
+		*/
+		struct PackedNode
+		{
+			float MinX[4];
+			float MinY[4];
+			float MinZ[4];
+			float MaxX[4];
+			float MaxY[4];
+			float MaxZ[4];
+
+			int Children[4];
+			int Count;
+		};
+
+		void BuildPacked();
+		int PackSubtree(int node);
+
+		std::vector<PackedNode> Packed;
+		std::vector<IDType> PackedLeafIDs;
+		bool PackedDirty = true;
+
+		int AllocateNode();
+		void FreeNode(int node);
+
+		void InsertLeaf(int leaf);
+		void RemoveLeaf(int leaf);
+
+		/*
+			Walks from "node" to the root fixing heights and bounds,
+			rotating where the subtrees are out of balance.
+		*/
+		void Refit(int node);
+		int Balance(int node);
+
+		int BuildRange(std::vector<int>& leaves, size_t start, size_t end);
+		void SaveSubtree(int node, std::vector<FlatNode>& nodes) const;
+
+		std::vector<Node> Nodes;
+		std::unordered_map<IDType, int> Leaves;
+
+		int Root = NullNode;
+		int FreeList = NullNode;
+	};
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include "Shared/Spatial/AABBTree.hpp"
+#include <vector>
+#include <cstddef>
+
+namespace Utility
+{
+	/*
+		Boxes stored as one array per bound and indexed by ID, so testing
+		a handful of them reads a few floats instead of whole items.
+		IDs without a box hold an inverted one that overlaps nothing.
+	*/
+	class BoxArray final
+	{
+	public:
+		void Set(size_t id, const AABB& box)
+		{
+			if (id >= MinX.size())
+			{
+				Grow(id + 1);
+			}
+
+			MinX[id] = box.Min[0];
+			MinY[id] = box.Min[1];
+			MinZ[id] = box.Min[2];
+
+			MaxX[id] = box.Max[0];
+			MaxY[id] = box.Max[1];
+			MaxZ[id] = box.Max[2];
+		}
+
+		void Remove(size_t id)
+		{
+			if (id < MinX.size())
+			{
+				MinX[id] = MinY[id] = MinZ[id] = EmptyMin();
+				MaxX[id] = MaxY[id] = MaxZ[id] = EmptyMax();
+			}
+		}
+
+		bool Contains(size_t id) const
+		{
+			return id < MinX.size() && MinX[id] <= MaxX[id];
+		}
+
+		bool Overlaps(size_t id, const AABB& box) const
+		{
+			if (id >= MinX.size())
+			{
+				return false;
+			}
+
+			return MinX[id] <= box.Max[0] && MaxX[id] >= box.Min[0] &&
+				   MinY[id] <= box.Max[1] && MaxY[id] >= box.Min[1] &&
+				   MinZ[id] <= box.Max[2] && MaxZ[id] >= box.Min[2];
+		}
+
+		AABB Get(size_t id) const
+		{
+			AABB ret;
+
+			ret.Min[0] = MinX[id];
+			ret.Min[1] = MinY[id];
+			ret.Min[2] = MinZ[id];
+
+			ret.Max[0] = MaxX[id];
+			ret.Max[1] = MaxY[id];
+			ret.Max[2] = MaxZ[id];
+
+			return ret;
+		}
+
+		/*
+			One past the highest ID that was ever set.
+		*/
+		size_t GetSize() const
+		{
+			return MinX.size();
+		}
+
+		void Clear()
+		{
+			MinX.clear();
+			MinY.clear();
+			MinZ.clear();
+
+			MaxX.clear();
+			MaxY.clear();
+			MaxZ.clear();
+		}
+
+	private:
+		static float EmptyMin()
+		{
+			return 3.402823466e+38f;
+		}
+
+		static float EmptyMax()
+		{
+			return -3.402823466e+38f;
+		}
+
+		void Grow(size_t size)
+		{
+			MinX.resize(size, EmptyMin());
+			MinY.resize(size, EmptyMin());
+			MinZ.resize(size, EmptyMin());
+
+			MaxX.resize(size, EmptyMax());
+			MaxY.resize(size, EmptyMax());
+			MaxZ.resize(size, EmptyMax());
+		}
+
+		std::vector<float> MinX;
+		std::vector<float> MinY;
+		std::vector<float> MinZ;
+
+		std::vector<float> MaxX;
+		std::vector<float> MaxY;
+		std::vector<float> MaxZ;
+	};
+}
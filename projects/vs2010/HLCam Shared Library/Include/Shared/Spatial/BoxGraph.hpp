@@ -0,0 +1,53 @@
+#pragma once
+#include "Shared/Spatial/AABBTree.hpp"
+#include "Shared/Spatial/BoxArray.hpp"
+#include <vector>
+#include <cstdint>
+
+namespace Utility
+{
+	/*
+		Which boxes touch or nearly touch each other, for searches that
+		start at a known box and expect the answer to be close to it.
+	*/
+	class BoxGraph final
+	{
+	public:
+		/*
+			Links every pair of boxes in "boxes" that are within "margin"
+			of each other, "tree" has to hold the same boxes.
+		*/
+		void Build(const AABBTree& tree, const BoxArray& boxes, float margin);
+		void Clear();
+
+		struct Range
+		{
+			const uint32_t* First;
+			const uint32_t* Last;
+
+			const uint32_t* begin() const
+			{
+				return First;
+			}
+
+			const uint32_t* end() const
+			{
+				return Last;
+			}
+		};
+
+		/*
+			Empty for IDs that had no box when the graph was built.
+		*/
+		Range GetNeighbours(size_t id) const;
+
+		size_t GetLinkCount() const;
+
+	private:
+		/*
+			Neighbours of ID "i" are Links[Offsets[i]] up to Links[Offsets[i + 1]].
+		*/
+		std::vector<uint32_t> Offsets;
+		std::vector<uint32_t> Links;
+	};
+}
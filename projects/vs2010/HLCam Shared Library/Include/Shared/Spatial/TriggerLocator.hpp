@@ -0,0 +1,72 @@
+#pragma once
+#include "Shared/Spatial/AABBTree.hpp"
+#include "Shared/Spatial/BoxArray.hpp"
+#include "Shared/Spatial/BoxGraph.hpp"
+#include <cstddef>
+
+namespace Utility
+{
+	/*
+		Finds the trigger each player is in. The trigger they were in
+		and its neighbours are tried before searching the whole tree.
+		Kept apart from the game so it can be timed without the engine.
+
+		Where several neighbours, or several triggers in the tree, hold
+		the player the one with the lowest ID is taken. The client
+		predicts switches with the same steps.
+	*/
+	namespace TriggerLocator
+	{
+		enum class ResultType
+		{
+			/*
+				Still in the trigger they were in.
+			*/
+			Active,
+
+			Neighbour,
+			Searched,
+
+			/*
+				Outside every trigger.
+			*/
+			None,
+		};
+
+		struct Request
+		{
+			AABB Box;
+
+			bool HasActive;
+			size_t ActiveID;
+
+			/*
+				Set by Locate, FoundID is the trigger for every result but None.
+			*/
+			ResultType Result;
+			size_t FoundID;
+		};
+
+		struct Counters
+		{
+			size_t ActiveHits = 0;
+			size_t NeighbourHits = 0;
+
+			/*
+				Searches of the whole tree, and how many of those found nothing.
+			*/
+			size_t Misses = 0;
+			size_t EmptyMisses = 0;
+
+			/*
+				Walks of the tree shared by several nearby players.
+			*/
+			size_t BatchedSearches = 0;
+		};
+
+		/*
+			"tree", "bounds" and "graph" have to hold the same boxes.
+		*/
+		void Locate(const AABBTree& tree, const BoxArray& bounds, const BoxGraph& graph, Request* requests, size_t count, Counters& counters);
+	}
+}
@@ -0,0 +1,212 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Utility
+{
+	/*
+		Callable that keeps its captures inside itself, creating or moving
+		one never allocates. Captures that don't fit are a compile error
+		rather than a silent fallback to the heap.
+	*/
+	template <size_t StorageSize>
+	class InlineTask final
+	{
+	public:
+		InlineTask() = default;
+
+		template <typename Func, typename = typename std::enable_if<!std::is_same<typename std::decay<Func>::type, InlineTask>::value>::type>
+		InlineTask(Func&& func)
+		{
+			using FuncType = typename std::decay<Func>::type;
+
+			static_assert(sizeof(FuncType) <= StorageSize, "Task captures too large for inline storage");
+			static_assert(alignof(FuncType) <= alignof(std::max_align_t), "Task captures over aligned");
+
+			new (&Storage) FuncType(std::forward<Func>(func));
+			Operations = &OperationsFor<FuncType>::Table;
+		}
+
+		InlineTask(InlineTask&& other)
+		{
+			MoveFrom(other);
+		}
+
+		InlineTask& operator=(InlineTask&& other)
+		{
+			if (this != &other)
+			{
+				Reset();
+				MoveFrom(other);
+			}
+
+			return *this;
+		}
+
+		InlineTask(const InlineTask&) = delete;
+		InlineTask& operator=(const InlineTask&) = delete;
+
+		~InlineTask()
+		{
+			Reset();
+		}
+
+		void operator()()
+		{
+			Operations->Invoke(&Storage);
+		}
+
+		explicit operator bool() const
+		{
+			return Operations != nullptr;
+		}
+
+		void Reset()
+		{
+			if (Operations)
+			{
+				Operations->Destroy(&Storage);
+				Operations = nullptr;
+			}
+		}
+
+	private:
+		struct OperationTable
+		{
+			void(*Invoke)(void* storage);
+			void(*Move)(void* target, void* source);
+			void(*Destroy)(void* storage);
+		};
+
+		template <typename FuncType>
+		struct OperationsFor
+		{
+			static void Invoke(void* storage)
+			{
+				(*static_cast<FuncType*>(storage))();
+			}
+
+			static void Move(void* target, void* source)
+			{
+				new (target) FuncType(std::move(*static_cast<FuncType*>(source)));
+			}
+
+			static void Destroy(void* storage)
+			{
+				static_cast<FuncType*>(storage)->~FuncType();
+			}
+
+			static const OperationTable Table;
+		};
+
+		void MoveFrom(InlineTask& other)
+		{
+			if (other.Operations)
+			{
+				other.Operations->Move(&Storage, &other.Storage);
+				Operations = other.Operations;
+
+				other.Reset();
+			}
+		}
+
+		typename std::aligned_storage<StorageSize, alignof(std::max_align_t)>::type Storage;
+		const OperationTable* Operations = nullptr;
+	};
+
+	template <size_t StorageSize>
+	template <typename FuncType>
+	const typename InlineTask<StorageSize>::OperationTable InlineTask<StorageSize>::OperationsFor<FuncType>::Table =
+	{
+		&InlineTask<StorageSize>::OperationsFor<FuncType>::Invoke,
+		&InlineTask<StorageSize>::OperationsFor<FuncType>::Move,
+		&InlineTask<StorageSize>::OperationsFor<FuncType>::Destroy,
+	};
+
+	/*
+		Fixed size ring for handing items from exactly one producer thread
+		to exactly one consumer thread. Neither side ever waits on the
+		other, pushing to a full ring or popping an empty one just fails.
+	*/
+	template <typename T, size_t Capacity>
+	class SPSCQueue final
+	{
+	public:
+		static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+		/*
+			Producer thread only.
+		*/
+		bool TryPush(T&& item)
+		{
+			auto tail = Tail.load(std::memory_order_relaxed);
+
+			if (tail - Head.load(std::memory_order_acquire) == Capacity)
+			{
+				return false;
+			}
+
+			Items[tail & (Capacity - 1)] = std::move(item);
+			Tail.store(tail + 1, std::memory_order_release);
+
+			return true;
+		}
+
+		/*
+			Consumer thread only.
+		*/
+		bool TryPop(T& item)
+		{
+			auto head = Head.load(std::memory_order_relaxed);
+
+			if (head == Tail.load(std::memory_order_acquire))
+			{
+				return false;
+			}
+
+			item = std::move(Items[head & (Capacity - 1)]);
+			Head.store(head + 1, std::memory_order_release);
+
+			return true;
+		}
+
+		/*
+			Consumer thread only, drops everything pushed so far.
+		*/
+		void Clear()
+		{
+			T item;
+
+			while (TryPop(item))
+			{
+
+			}
+		}
+
+		/*
+			Exact on the consumer thread, a lower bound anywhere else.
+		*/
+		size_t GetSize() const
+		{
+			return Tail.load(std::memory_order_acquire) - Head.load(std::memory_order_acquire);
+		}
+
+		size_t GetCapacity() const
+		{
+			return Capacity;
+		}
+
+	private:
+		T Items[Capacity];
+
+		/*
+			Kept on separate cache lines so the two threads don't
+			invalidate each other's line on every push and pop.
+		*/
+		alignas(64) std::atomic<size_t> Head{0};
+		alignas(64) std::atomic<size_t> Tail{0};
+	};
+}
@@ -1,4 +1,5 @@
-#include "Shared\Binary Buffer\BinaryBuffer.hpp"
+#include "Shared/Binary Buffer/BinaryBuffer.hpp"
+#include "Shared/Binary Buffer/BinaryStream.hpp"
 #include <iterator>
 
 namespace Utility
@@ -34,6 +35,24 @@ namespace Utility
 		
 	}
 
+	BinaryBuffer::BinaryBuffer(std::ifstream& fileinputstream, const BinaryStreamSettings& settings) :
+		InputStream(&fileinputstream),
+		StreamReader(std::make_unique<BinaryStreamReader>(fileinputstream, settings))
+	{
+
+	}
+
+	BinaryBuffer::BinaryBuffer(std::ofstream& fileoutputstream, const BinaryStreamSettings& settings) :
+		StreamWriter(std::make_unique<BinaryStreamWriter>(fileoutputstream, settings))
+	{
+
+	}
+
+	BinaryBuffer::~BinaryBuffer()
+	{
+
+	}
+
 	Utility::BinaryBuffer BinaryBuffer::operator=(BinaryBuffer&& other)
 	{
 		return {std::move(other)};
@@ -49,6 +68,14 @@ namespace Utility
 		Data.resize(newsize);
 	}
 
+	void BinaryBuffer::Assign(const void* data, size_t length)
+	{
+		auto bytes = static_cast<const ContainerDataType*>(data);
+
+		Data.assign(bytes, bytes + length);
+		ReadPos = 0;
+	}
+
 	void BinaryBuffer::SetData(BinaryBuffer::ContainerType<ContainerDataType>&& data)
 	{
 		ReadPos = 0;
@@ -57,6 +84,14 @@ namespace Utility
 
 	void BinaryBuffer::Append(BinaryBuffer&& other)
 	{
+		if (StreamWriter)
+		{
+			StreamWriter->Write(other.Data.data(), other.Data.size());
+			other.Data.clear();
+
+			return;
+		}
+
 		if (Data.empty())
 		{
 			Data = std::move(other.Data);
@@ -72,6 +107,14 @@ namespace Utility
 
 	void BinaryBuffer::Append(ContainerType<ContainerDataType>&& data)
 	{
+		if (StreamWriter)
+		{
+			StreamWriter->Write(data.data(), data.size());
+			data.clear();
+
+			return;
+		}
+
 		if (Data.empty())
 		{
 			Data = std::move(data);
@@ -87,6 +130,12 @@ namespace Utility
 
 	void BinaryBuffer::Append(const void* data, size_t length)
 	{
+		if (StreamWriter)
+		{
+			StreamWriter->Write(data, length);
+			return;
+		}
+
 		size_t insertpos = Data.size();
 		Data.resize(insertpos + length);
 		std::memcpy(&Data[insertpos], data, length);
@@ -97,6 +146,25 @@ namespace Utility
 		outputstream.write(static_cast<const char*>(GetData()), GetSize());
 	}
 
+	void BinaryBuffer::Flush()
+	{
+		if (StreamWriter)
+		{
+			StreamWriter->Flush();
+		}
+	}
+
+	void BinaryBuffer::ReadStream(void* data, size_t size)
+	{
+		if (StreamReader)
+		{
+			StreamReader->Read(data, size);
+			return;
+		}
+
+		InputStream->read(static_cast<char*>(data), size);
+	}
+
 	BinaryBuffer::ContainerType<BinaryBuffer::ContainerDataType>&& BinaryBuffer::MoveData()
 	{
 		ReadPos = 0;
@@ -180,7 +248,7 @@ namespace Utility
 	{
 		if (InputStream)
 		{
-			InputStream->read(reinterpret_cast<char*>(&data), sizeof(data));
+			ReadStream(&data, sizeof(data));
 			return *this;
 		}
 
@@ -196,7 +264,7 @@ namespace Utility
 	{
 		if (InputStream)
 		{
-			InputStream->read(reinterpret_cast<char*>(&data), sizeof(data));
+			ReadStream(&data, sizeof(data));
 			return *this;
 		}
 
@@ -212,7 +280,7 @@ namespace Utility
 	{
 		if (InputStream)
 		{
-			InputStream->read(reinterpret_cast<char*>(&data), sizeof(data));
+			ReadStream(&data, sizeof(data));
 			return *this;
 		}
 
@@ -228,7 +296,7 @@ namespace Utility
 	{
 		if (InputStream)
 		{
-			InputStream->read(reinterpret_cast<char*>(&data), sizeof(data));
+			ReadStream(&data, sizeof(data));
 			return *this;
 		}
 
@@ -244,7 +312,7 @@ namespace Utility
 	{
 		if (InputStream)
 		{
-			InputStream->read(reinterpret_cast<char*>(&data), sizeof(data));
+			ReadStream(&data, sizeof(data));
 			return *this;
 		}
 
@@ -260,7 +328,7 @@ namespace Utility
 	{
 		if (InputStream)
 		{
-			InputStream->read(reinterpret_cast<char*>(&data), sizeof(data));
+			ReadStream(&data, sizeof(data));
 			return *this;
 		}
 
@@ -276,7 +344,7 @@ namespace Utility
 	{
 		if (InputStream)
 		{
-			InputStream->read(reinterpret_cast<char*>(&data), sizeof(data));
+			ReadStream(&data, sizeof(data));
 			return *this;
 		}
 
@@ -292,7 +360,7 @@ namespace Utility
 	{
 		if (InputStream)
 		{
-			InputStream->read(reinterpret_cast<char*>(&data), sizeof(data));
+			ReadStream(&data, sizeof(data));
 			return *this;
 		}
 
@@ -308,7 +376,7 @@ namespace Utility
 	{
 		if (InputStream)
 		{
-			InputStream->read(reinterpret_cast<char*>(&data), sizeof(data));
+			ReadStream(&data, sizeof(data));
 			return *this;
 		}
 
@@ -324,7 +392,7 @@ namespace Utility
 	{
 		if (InputStream)
 		{
-			InputStream->read(reinterpret_cast<char*>(&data), sizeof(data));
+			ReadStream(&data, sizeof(data));
 			return *this;
 		}
 
@@ -349,7 +417,7 @@ namespace Utility
 		if (InputStream)
 		{
 			data.resize(length);
-			InputStream->read(&data[0], length);
+			ReadStream(&data[0], length);
 
 			return *this;
 		}
@@ -373,6 +441,24 @@ namespace Utility
 		return *this;
 	}
 
+	BinaryBuffer& BinaryBuffer::operator>>(StringView& data)
+	{
+		StringLengthType length;
+		*this >> length;
+
+		data = StringView();
+
+		if (length != 0 && CanRead(length))
+		{
+			data.Data = reinterpret_cast<const char*>(&Data[ReadPos]);
+			data.Size = length;
+
+			ReadPos += length;
+		}
+
+		return *this;
+	}
+
 	BinaryBuffer& BinaryBuffer::operator<<(bool data)
 	{
 		*this << static_cast<uint8_t>(data);
@@ -465,4 +551,165 @@ namespace Utility
 	{
 		return (ReadPos + size <= Data.size());
 	}
+
+	BinaryBufferView::BinaryBufferView()
+	{
+
+	}
+
+	BinaryBufferView::BinaryBufferView(const void* data, size_t length)
+	{
+		Reset(data, length);
+	}
+
+	BinaryBufferView::BinaryBufferView(const BinaryBuffer& buffer)
+	{
+		Reset(buffer.GetData(), buffer.GetSize());
+	}
+
+	void BinaryBufferView::Reset(const void* data, size_t length)
+	{
+		Data = static_cast<const unsigned char*>(data);
+		Size = length;
+		ReadPos = 0;
+	}
+
+	const void* BinaryBufferView::GetData() const
+	{
+		return Data;
+	}
+
+	size_t BinaryBufferView::GetSize() const
+	{
+		return Size;
+	}
+
+	void BinaryBufferView::SetReadPosition(size_t position)
+	{
+		if (position >= Size)
+		{
+			position = Size;
+		}
+
+		ReadPos = position;
+	}
+
+	size_t BinaryBufferView::GetReadPosition() const
+	{
+		return ReadPos;
+	}
+
+	const void* BinaryBufferView::ReadBytes(size_t size)
+	{
+		if (size > Size - ReadPos)
+		{
+			return nullptr;
+		}
+
+		auto ret = Data + ReadPos;
+		ReadPos += size;
+
+		return ret;
+	}
+
+	BinaryBufferView& BinaryBufferView::operator>>(bool& data)
+	{
+		uint8_t value = 0;
+		*this >> value;
+
+		data = value != 0;
+
+		return *this;
+	}
+
+	BinaryBufferView& BinaryBufferView::operator>>(char& data)
+	{
+		return GenericRead(data);
+	}
+
+	BinaryBufferView& BinaryBufferView::operator>>(unsigned char& data)
+	{
+		return GenericRead(data);
+	}
+
+	BinaryBufferView& BinaryBufferView::operator>>(int16_t& data)
+	{
+		return GenericRead(data);
+	}
+
+	BinaryBufferView& BinaryBufferView::operator>>(uint16_t& data)
+	{
+		return GenericRead(data);
+	}
+
+	BinaryBufferView& BinaryBufferView::operator>>(int32_t& data)
+	{
+		return GenericRead(data);
+	}
+
+	BinaryBufferView& BinaryBufferView::operator>>(uint32_t& data)
+	{
+		return GenericRead(data);
+	}
+
+	BinaryBufferView& BinaryBufferView::operator>>(int64_t& data)
+	{
+		return GenericRead(data);
+	}
+
+	BinaryBufferView& BinaryBufferView::operator>>(uint64_t& data)
+	{
+		return GenericRead(data);
+	}
+
+	BinaryBufferView& BinaryBufferView::operator>>(float& data)
+	{
+		return GenericRead(data);
+	}
+
+	BinaryBufferView& BinaryBufferView::operator>>(double& data)
+	{
+		return GenericRead(data);
+	}
+
+	BinaryBufferView& BinaryBufferView::operator>>(std::string& data)
+	{
+		StringView view;
+		*this >> view;
+
+		if (view.Size != 0)
+		{
+			data.assign(view.Data, view.Size);
+		}
+
+		return *this;
+	}
+
+	BinaryBufferView& BinaryBufferView::operator>>(std::wstring& data)
+	{
+		std::string str;
+		*this >> str;
+
+		data = Utility::UTF8ToWString(std::move(str));
+
+		return *this;
+	}
+
+	BinaryBufferView& BinaryBufferView::operator>>(StringView& data)
+	{
+		BinaryBuffer::StringLengthType length = 0;
+		*this >> length;
+
+		data = StringView();
+
+		if (length != 0 && ReadPos + length <= Size)
+		{
+			data.Data = reinterpret_cast<const char*>(Data + ReadPos);
+			data.Size = length;
+
+			ReadPos += length;
+		}
+
+		return *this;
+	}
 }
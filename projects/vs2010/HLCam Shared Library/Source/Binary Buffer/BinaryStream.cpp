@@ -0,0 +1,199 @@
+#include "Shared/Binary Buffer/BinaryStream.hpp"
+#include <cstring>
+
+namespace Utility
+{
+	BinaryStreamReader::BinaryStreamReader(std::istream& stream, const BinaryStreamSettings& settings) :
+		Stream(stream),
+		BlockSize(settings.BlockSize != 0 ? settings.BlockSize : 1),
+		ReadAhead(settings.ReadAhead)
+	{
+		for (auto& block : Blocks)
+		{
+			block.Data.resize(BlockSize);
+		}
+
+		Fill(Blocks[Current]);
+
+		if (ReadAhead && Blocks[Current].Size == BlockSize)
+		{
+			Thread = std::thread(&BinaryStreamReader::ReadAheadThread, this);
+		}
+	}
+
+	BinaryStreamReader::~BinaryStreamReader()
+	{
+		if (Thread.joinable())
+		{
+			{
+				std::lock_guard<std::mutex> lock(Lock);
+				ShouldStop = true;
+			}
+
+			Condition.notify_all();
+			Thread.join();
+		}
+	}
+
+	size_t BinaryStreamReader::Read(void* data, size_t size)
+	{
+		auto output = static_cast<char*>(data);
+		size_t ret = 0;
+
+		while (ret < size)
+		{
+			auto& block = Blocks[Current];
+
+			if (Position == block.Size)
+			{
+				if (!NextBlock())
+				{
+					break;
+				}
+
+				continue;
+			}
+
+			auto count = block.Size - Position;
+
+			if (count > size - ret)
+			{
+				count = size - ret;
+			}
+
+			std::memcpy(output + ret, block.Data.data() + Position, count);
+
+			Position += count;
+			ret += count;
+		}
+
+		return ret;
+	}
+
+	void BinaryStreamReader::Fill(Block& block)
+	{
+		Stream.read(block.Data.data(), BlockSize);
+		block.Size = static_cast<size_t>(Stream.gcount());
+	}
+
+	bool BinaryStreamReader::NextBlock()
+	{
+		/*
+			A short block was the last one.
+		*/
+		if (Blocks[Current].Size < BlockSize)
+		{
+			return false;
+		}
+
+		if (!ReadAhead)
+		{
+			Fill(Blocks[Current]);
+		}
+
+		else
+		{
+			std::unique_lock<std::mutex> lock(Lock);
+
+			Condition.wait(lock, [this]
+			{
+				return NextReady;
+			});
+
+			Current = 1 - Current;
+			NextReady = false;
+
+			lock.unlock();
+			Condition.notify_all();
+		}
+
+		Position = 0;
+
+		return Blocks[Current].Size != 0;
+	}
+
+	void BinaryStreamReader::ReadAheadThread()
+	{
+		while (true)
+		{
+			size_t next;
+
+			{
+				std::unique_lock<std::mutex> lock(Lock);
+
+				Condition.wait(lock, [this]
+				{
+					return ShouldStop || !NextReady;
+				});
+
+				if (ShouldStop)
+				{
+					return;
+				}
+
+				next = 1 - Current;
+			}
+
+			Fill(Blocks[next]);
+
+			auto islast = Blocks[next].Size < BlockSize;
+
+			{
+				std::lock_guard<std::mutex> lock(Lock);
+				NextReady = true;
+			}
+
+			Condition.notify_all();
+
+			if (islast)
+			{
+				return;
+			}
+		}
+	}
+
+	BinaryStreamWriter::BinaryStreamWriter(std::ostream& stream, const BinaryStreamSettings& settings) :
+		Stream(stream)
+	{
+		Block.resize(settings.BlockSize != 0 ? settings.BlockSize : 1);
+	}
+
+	BinaryStreamWriter::~BinaryStreamWriter()
+	{
+		Flush();
+	}
+
+	void BinaryStreamWriter::Write(const void* data, size_t size)
+	{
+		auto input = static_cast<const char*>(data);
+
+		/*
+			Anything larger than a block goes straight through
+			instead of being cut up and copied.
+		*/
+		if (size >= Block.size())
+		{
+			Flush();
+			Stream.write(input, size);
+
+			return;
+		}
+
+		if (Size + size > Block.size())
+		{
+			Flush();
+		}
+
+		std::memcpy(Block.data() + Size, input, size);
+		Size += size;
+	}
+
+	void BinaryStreamWriter::Flush()
+	{
+		if (Size != 0)
+		{
+			Stream.write(Block.data(), Size);
+			Size = 0;
+		}
+	}
+}
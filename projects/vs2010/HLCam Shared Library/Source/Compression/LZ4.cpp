@@ -0,0 +1,322 @@
+#include "Shared/Compression/LZ4.hpp"
+#include <cstring>
+#include <cstdint>
+
+namespace
+{
+	namespace LocalUtility
+	{
+		enum
+		{
+			MinMatch = 4,
+			MaxOffset = 65535,
+
+			/*
+				The format ends every block with literals, matches
+				stop this far from the end and start before the other.
+			*/
+			LastLiterals = 5,
+			MatchFindLimit = 12,
+
+			HashBits = 12,
+			HashSize = 1 << HashBits,
+
+			/*
+				Misses in a row before positions are skipped,
+				data that doesn't compress is passed over quickly.
+			*/
+			SkipTrigger = 6,
+		};
+
+		uint32_t Read32(const unsigned char* data)
+		{
+			uint32_t ret;
+			std::memcpy(&ret, data, sizeof(ret));
+
+			return ret;
+		}
+
+		uint32_t Hash(uint32_t sequence)
+		{
+			return (sequence * 2654435761U) >> (32 - HashBits);
+		}
+
+		/*
+			Lengths past the token's 15 continue in bytes of 255.
+		*/
+		unsigned char* WriteLength(unsigned char* dest, size_t length)
+		{
+			while (length >= 255)
+			{
+				*dest++ = 255;
+				length -= 255;
+			}
+
+			*dest++ = static_cast<unsigned char>(length);
+
+			return dest;
+		}
+
+		bool ReadLength(const unsigned char*& source, const unsigned char* end, size_t& length)
+		{
+			unsigned char byte;
+
+			do
+			{
+				if (source == end)
+				{
+					return false;
+				}
+
+				byte = *source++;
+				length += byte;
+			}
+			while (byte == 255);
+
+			return true;
+		}
+
+		/*
+			Worst case size of a sequence, so it can be checked once.
+		*/
+		size_t GetSequenceSize(size_t literals, size_t matchlength)
+		{
+			return 1 + literals / 255 + 1 + literals + 2 + matchlength / 255 + 1;
+		}
+
+		unsigned char* WriteLiterals(unsigned char* dest, unsigned char matchtoken, const unsigned char* literals, size_t count)
+		{
+			auto token = dest++;
+
+			if (count >= 15)
+			{
+				*token = static_cast<unsigned char>((15 << 4) | matchtoken);
+				dest = WriteLength(dest, count - 15);
+			}
+
+			else
+			{
+				*token = static_cast<unsigned char>((count << 4) | matchtoken);
+			}
+
+			if (count != 0)
+			{
+				std::memcpy(dest, literals, count);
+			}
+
+			return dest + count;
+		}
+	}
+}
+
+namespace Utility
+{
+	namespace LZ4
+	{
+		size_t GetMaxCompressedSize(size_t size)
+		{
+			return size + size / 255 + 16;
+		}
+
+		size_t Compress(const void* source, size_t size, void* dest, size_t capacity)
+		{
+			using namespace LocalUtility;
+
+			auto start = static_cast<const unsigned char*>(source);
+			auto end = start + size;
+
+			auto output = static_cast<unsigned char*>(dest);
+			auto outputend = output + capacity;
+
+			auto anchor = start;
+
+			if (size > MatchFindLimit)
+			{
+				auto matchlimit = end - LastLiterals;
+				auto findlimit = end - MatchFindLimit;
+
+				/*
+					Offsets from the start, entries that were never set point
+					at the start and fail the comparison like any other miss.
+				*/
+				uint32_t table[HashSize] = {};
+
+				auto current = start + 1;
+				size_t misses = 0;
+
+				while (current < findlimit)
+				{
+					auto sequence = Read32(current);
+					auto& entry = table[Hash(sequence)];
+
+					auto candidate = start + entry;
+					entry = static_cast<uint32_t>(current - start);
+
+					if (candidate >= current || current - candidate > MaxOffset || Read32(candidate) != sequence)
+					{
+						current += 1 + (misses++ >> SkipTrigger);
+						continue;
+					}
+
+					misses = 0;
+
+					/*
+						Earlier bytes that match as well join the match
+						instead of being sent as literals.
+					*/
+					while (current > anchor && candidate > start && current[-1] == candidate[-1])
+					{
+						current--;
+						candidate--;
+					}
+
+					auto matchend = current + MinMatch;
+					auto candidateend = candidate + MinMatch;
+
+					while (matchend < matchlimit && *matchend == *candidateend)
+					{
+						matchend++;
+						candidateend++;
+					}
+
+					auto literals = static_cast<size_t>(current - anchor);
+					auto matchlength = static_cast<size_t>(matchend - current) - MinMatch;
+
+					if (static_cast<size_t>(outputend - output) < GetSequenceSize(literals, matchlength))
+					{
+						return 0;
+					}
+
+					output = WriteLiterals(output, static_cast<unsigned char>(matchlength < 15 ? matchlength : 15), anchor, literals);
+
+					auto offset = static_cast<size_t>(current - candidate);
+
+					*output++ = static_cast<unsigned char>(offset);
+					*output++ = static_cast<unsigned char>(offset >> 8);
+
+					if (matchlength >= 15)
+					{
+						output = WriteLength(output, matchlength - 15);
+					}
+
+					current = matchend;
+					anchor = current;
+
+					/*
+						Positions inside a match are never hashed, one
+						near its end keeps repeats of it findable.
+					*/
+					if (current < findlimit)
+					{
+						table[Hash(Read32(current - 2))] = static_cast<uint32_t>(current - 2 - start);
+					}
+				}
+			}
+
+			auto literals = static_cast<size_t>(end - anchor);
+
+			if (static_cast<size_t>(outputend - output) < 1 + literals / 255 + 1 + literals)
+			{
+				return 0;
+			}
+
+			output = WriteLiterals(output, 0, anchor, literals);
+
+			return output - static_cast<unsigned char*>(dest);
+		}
+
+		bool Decompress(const void* source, size_t sourcesize, void* dest, size_t size)
+		{
+			using namespace LocalUtility;
+
+			auto input = static_cast<const unsigned char*>(source);
+			auto inputend = input + sourcesize;
+
+			auto start = static_cast<unsigned char*>(dest);
+			auto output = start;
+			auto outputend = start + size;
+
+			while (input < inputend)
+			{
+				auto token = *input++;
+
+				size_t literals = token >> 4;
+
+				if (literals == 15 && !ReadLength(input, inputend, literals))
+				{
+					return false;
+				}
+
+				if (literals > static_cast<size_t>(inputend - input) || literals > static_cast<size_t>(outputend - output))
+				{
+					return false;
+				}
+
+				if (literals != 0)
+				{
+					std::memcpy(output, input, literals);
+				}
+
+				input += literals;
+				output += literals;
+
+				/*
+					The last sequence has no match.
+				*/
+				if (input == inputend)
+				{
+					break;
+				}
+
+				if (inputend - input < 2)
+				{
+					return false;
+				}
+
+				size_t offset = input[0] | (input[1] << 8);
+				input += 2;
+
+				if (offset == 0 || offset > static_cast<size_t>(output - start))
+				{
+					return false;
+				}
+
+				size_t matchlength = token & 15;
+
+				if (matchlength == 15 && !ReadLength(input, inputend, matchlength))
+				{
+					return false;
+				}
+
+				matchlength += MinMatch;
+
+				if (matchlength > static_cast<size_t>(outputend - output))
+				{
+					return false;
+				}
+
+				auto match = output - offset;
+
+				/*
+					Overlapping matches repeat what they just wrote.
+				*/
+				if (offset >= matchlength)
+				{
+					std::memcpy(output, match, matchlength);
+				}
+
+				else
+				{
+					for (size_t i = 0; i < matchlength; i++)
+					{
+						output[i] = match[i];
+					}
+				}
+
+				output += matchlength;
+			}
+
+			return output == outputend;
+		}
+	}
+}
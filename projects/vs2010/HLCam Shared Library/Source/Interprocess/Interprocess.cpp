@@ -1,9 +1,12 @@
 #include <vector>
 #include <string>
 #include <memory>
-#include "boost\interprocess\ipc\message_queue.hpp"
+#include <thread>
+#include <cstring>
+#include "boost/interprocess/ipc/message_queue.hpp"
+#include "boost/date_time/posix_time/posix_time_types.hpp"
 
-#include "Shared\Interprocess\Interprocess.hpp"
+#include "Shared/Interprocess/Interprocess.hpp"
 
 namespace Shared
 {
@@ -19,21 +22,243 @@ namespace Shared
 
 		}
 
-		bool Peer::Write(const Utility::BinaryBuffer& data)
+		std::string Peer::GetRingName(const std::string& connectionpoint)
+		{
+			return connectionpoint + "_RING";
+		}
+
+		bool Peer::IsOpen() const
+		{
+			return MessageQueue || Ring;
+		}
+
+		void Peer::Close()
+		{
+			ReleaseView();
+
+			MessageQueue.reset();
+			Ring.reset();
+		}
+
+		namespace
+		{
+			/*
+				Writers racing here can only lose a larger size for
+				a moment, not worth a compare exchange loop for stats.
+			*/
+			void StoreLargest(std::atomic<size_t>& largest, size_t size)
+			{
+				if (size > largest.load(std::memory_order_relaxed))
+				{
+					largest.store(size, std::memory_order_relaxed);
+				}
+			}
+		}
+
+		bool Peer::SendToQueue(const void* data, size_t size)
 		{
 			if (!MessageQueue)
 			{
+				FailedWrites++;
 				return false;
 			}
 
-			auto res = MessageQueue->try_send(data.GetData(), data.GetSize(), 0);
+			auto writestart = std::chrono::steady_clock::now();
+
+			auto res = MessageQueue->try_send(data, size, 0);
+
+			auto writetime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - writestart).count();
+			WriteNanoseconds += writetime;
+
+			if (!res)
+			{
+				FailedWrites++;
+				return false;
+			}
+
+			MessagesWritten++;
+			BytesWritten += size;
+			StoreLargest(LargestWrite, size);
 
 			return res;
 		}
 
-		bool Peer::Write(Config::MessageType message)
+		const Config::ByteType* Peer::PeekNext(size_t& size)
+		{
+			ReleaseView();
+
+			const Config::ByteType* ret = nullptr;
+
+			if (Ring)
+			{
+				ret = Ring->Peek(size);
+			}
+
+			else if (MessageQueue)
+			{
+				/*
+					Sized once, received messages are written over what was there.
+				*/
+				if (ReadStaging.size() < Config::MaxMessageSize)
+				{
+					ReadStaging.resize(Config::MaxMessageSize);
+				}
+
+				unsigned int priority;
+
+				/*
+					Empty messages are wake signals.
+				*/
+				if (MessageQueue->try_receive(ReadStaging.data(), Config::MaxMessageSize, size, priority) && size > 0)
+				{
+					ret = ReadStaging.data();
+				}
+			}
+
+			ViewPending = ret != nullptr;
+
+			return ret;
+		}
+
+		const Config::ByteType* Peer::PeekNextTimed(size_t& size, std::chrono::milliseconds timeout)
 		{
+			if (Ring)
+			{
+				auto ret = PeekNext(size);
+
+				if (ret || Ring->Wait(timeout) != SharedRing::WaitResult::Ready)
+				{
+					return ret;
+				}
+
+				return PeekNext(size);
+			}
+
 			if (!MessageQueue)
+			{
+				std::this_thread::sleep_for(timeout);
+				return nullptr;
+			}
+
+			if (ReadStaging.size() < Config::MaxMessageSize)
+			{
+				ReadStaging.resize(Config::MaxMessageSize);
+			}
+
+			unsigned int priority;
+
+			namespace ptime = boost::posix_time;
+
+			auto endtime = ptime::microsec_clock::universal_time() + ptime::milliseconds(timeout.count());
+
+			if (!MessageQueue->timed_receive(ReadStaging.data(), Config::MaxMessageSize, size, priority, endtime) || size == 0)
+			{
+				return nullptr;
+			}
+
+			return ReadStaging.data();
+		}
+
+		bool Peer::CopyMessage(const Config::ByteType* source, size_t size, Config::MessageType& message, Utility::BinaryBuffer& data)
+		{
+			if (!source)
+			{
+				return false;
+			}
+
+			data.Assign(source, size);
+			ReleaseView();
+
+			data >> message;
+
+			CountRead(size);
+
+			return true;
+		}
+
+		bool Peer::ViewMessage(const Config::ByteType* source, size_t size, Config::MessageType& message, Utility::BinaryBufferView& data)
+		{
+			if (!source)
+			{
+				return false;
+			}
+
+			data.Reset(source, size);
+			data >> message;
+
+			CountRead(size);
+
+			return true;
+		}
+
+		void Peer::ReleaseView()
+		{
+			if (!ViewPending)
+			{
+				return;
+			}
+
+			ViewPending = false;
+
+			if (Ring)
+			{
+				Ring->Release();
+			}
+		}
+
+		void Peer::CountRead(size_t size)
+		{
+			MessagesRead++;
+			BytesRead += size;
+			StoreLargest(LargestRead, size);
+		}
+
+		PeerStats Peer::GetStats() const
+		{
+			PeerStats ret;
+
+			ret.MessagesWritten = MessagesWritten;
+			ret.BytesWritten = BytesWritten;
+			ret.LargestWrite = LargestWrite;
+			ret.FailedWrites = FailedWrites;
+			ret.WriteMilliseconds = WriteNanoseconds / 1000000.0;
+
+			ret.MessagesRead = MessagesRead;
+			ret.BytesRead = BytesRead;
+			ret.LargestRead = LargestRead;
+
+			if (MessageQueue)
+			{
+				ret.QueueDepth = MessageQueue->get_num_msg();
+				ret.QueueCapacity = MessageQueue->get_max_msg();
+			}
+
+			else if (Ring)
+			{
+				ret.QueueDepth = Ring->GetMessageCount();
+				ret.QueueBytes = Ring->GetUsedBytes();
+				ret.QueueByteCapacity = Ring->GetCapacity();
+			}
+
+			return ret;
+		}
+
+		void Peer::ResetStats()
+		{
+			MessagesWritten = 0;
+			BytesWritten = 0;
+			LargestWrite = 0;
+			FailedWrites = 0;
+			WriteNanoseconds = 0;
+
+			MessagesRead = 0;
+			BytesRead = 0;
+			LargestRead = 0;
+		}
+
+		bool Peer::Write(Config::MessageType message)
+		{
+			if (!IsOpen())
 			{
 				return false;
 			}
@@ -43,68 +268,215 @@ namespace Shared
 
 		bool Peer::Write(Config::MessageType message, Utility::BinaryBuffer&& data)
 		{
-			if (!MessageQueue)
+			if (!IsOpen())
 			{
 				return false;
 			}
 
-			Utility::BinaryBuffer alldata;
-			alldata << message;
+			/*
+				Goes straight into the ring, no buffer with the type in front.
+			*/
+			auto size = data.GetSize();
+			auto dest = BeginWrite(message, size);
 
-			if (data.GetSize() != 0)
+			if (dest && size != 0)
 			{
-				alldata.Append(std::move(data));
+				std::memcpy(dest, data.GetData(), size);
 			}
 
-			return Write(alldata);
+			Buffers.Release(std::move(data));
+
+			if (!dest)
+			{
+				return false;
+			}
+
+			return EndWrite(size);
 		}
 
-		bool Peer::ReadBlocking(Config::MessageType& message, Utility::BinaryBuffer& data)
+		Utility::BinaryBuffer Peer::AcquireBuffer()
 		{
-			if (!MessageQueue)
+			return Buffers.Acquire();
+		}
+
+		Config::ByteType* Peer::BeginWrite(Config::MessageType message, size_t size)
+		{
+			if (!IsOpen())
 			{
-				return false;
+				FailedWrites++;
+				return nullptr;
 			}
 
-			data.Resize(Config::MaxMessageSize);
+			Config::ByteType* ret;
 
-			size_t received;
-			size_t priority;
+			if (Ring)
+			{
+				auto writestart = std::chrono::steady_clock::now();
 
-			MessageQueue->receive(data.GetDataModify(), Config::MaxMessageSize, received, priority);
+				ret = Ring->Reserve(size + sizeof(message));
 
-			auto res = received > 0;
+				WriteNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - writestart).count();
 
-			if (res)
+				if (!ret)
+				{
+					FailedWrites++;
+					return nullptr;
+				}
+			}
+
+			else
 			{
-				data >> message;
-				data.Resize(received);
+				if (WriteStaging.size() < size + sizeof(message))
+				{
+					WriteStaging.resize(size + sizeof(message));
+				}
+
+				ret = WriteStaging.data();
 			}
 
-			return res;
+			ret[0] = message;
+
+			return ret + sizeof(message);
 		}
 
-		bool Peer::TryRead(Config::MessageType& message, Utility::BinaryBuffer& data)
+		bool Peer::EndWrite(size_t size)
+		{
+			auto fullsize = size + sizeof(Config::MessageType);
+
+			if (Ring)
+			{
+				auto writestart = std::chrono::steady_clock::now();
+
+				Ring->Commit(fullsize);
+
+				WriteNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - writestart).count();
+
+				MessagesWritten++;
+				BytesWritten += fullsize;
+				StoreLargest(LargestWrite, fullsize);
+
+				return true;
+			}
+
+			return SendToQueue(WriteStaging.data(), fullsize);
+		}
+
+		bool Peer::TryPeek(Config::MessageType& message, const Config::ByteType*& data, size_t& size)
+		{
+			size_t received;
+			auto source = PeekNext(received);
+
+			if (!source)
+			{
+				return false;
+			}
+
+			message = source[0];
+
+			data = source + sizeof(message);
+			size = received - sizeof(message);
+
+			CountRead(received);
+
+			return true;
+		}
+
+		void Peer::EndPeek()
+		{
+			ReleaseView();
+		}
+
+		bool Peer::ReadBlocking(Config::MessageType& message, Utility::BinaryBuffer& data)
 		{
+			size_t size;
+
+			if (Ring)
+			{
+				const Config::ByteType* source;
+
+				while (!(source = PeekNext(size)))
+				{
+					if (Ring->Wait(std::chrono::seconds(1)) == SharedRing::WaitResult::Woken)
+					{
+						return false;
+					}
+				}
+
+				return CopyMessage(source, size, message, data);
+			}
+
 			if (!MessageQueue)
 			{
 				return false;
 			}
 
-			data.Resize(Config::MaxMessageSize);
+			if (ReadStaging.size() < Config::MaxMessageSize)
+			{
+				ReadStaging.resize(Config::MaxMessageSize);
+			}
 
-			size_t received;
-			size_t priority;
+			unsigned int priority;
 
-			auto res = MessageQueue->try_receive(data.GetDataModify(), Config::MaxMessageSize, received, priority);
+			MessageQueue->receive(ReadStaging.data(), Config::MaxMessageSize, size, priority);
 
-			if (res)
+			if (size == 0)
 			{
-				data >> message;
-				data.Resize(received);
+				return false;
 			}
 
-			return res;
+			return CopyMessage(ReadStaging.data(), size, message, data);
+		}
+
+		bool Peer::TryRead(Config::MessageType& message, Utility::BinaryBuffer& data)
+		{
+			size_t size;
+			auto source = PeekNext(size);
+
+			return CopyMessage(source, size, message, data);
+		}
+
+		bool Peer::ReadTimed(Config::MessageType& message, Utility::BinaryBuffer& data, std::chrono::milliseconds timeout)
+		{
+			size_t size;
+			auto source = PeekNextTimed(size, timeout);
+
+			return CopyMessage(source, size, message, data);
+		}
+
+		bool Peer::TryRead(Config::MessageType& message, Utility::BinaryBufferView& data)
+		{
+			size_t size;
+			auto source = PeekNext(size);
+
+			return ViewMessage(source, size, message, data);
+		}
+
+		bool Peer::ReadTimed(Config::MessageType& message, Utility::BinaryBufferView& data, std::chrono::milliseconds timeout)
+		{
+			size_t size;
+			auto source = PeekNextTimed(size, timeout);
+
+			return ViewMessage(source, size, message, data);
+		}
+
+		void Peer::Wake()
+		{
+			if (Ring)
+			{
+				Ring->Wake();
+				return;
+			}
+
+			if (!MessageQueue)
+			{
+				return;
+			}
+
+			/*
+				Fails if the queue is full, nobody is waiting on it then.
+			*/
+			char unused = 0;
+			MessageQueue->try_send(&unused, 0, 0);
 		}
 
 		Client::Client()
@@ -119,21 +491,44 @@ namespace Shared
 
 		Client& Client::operator=(Client&& other)
 		{
-			if (other.MessageQueue)
+			if (other.IsOpen())
 			{
+				Close();
+
+				ViewPending = other.ViewPending;
+				other.ViewPending = false;
+
 				MessageQueue = std::move(other.MessageQueue);
+				Ring = std::move(other.Ring);
 				ConnectionPoint = std::move(other.ConnectionPoint);
 			}
 
 			return *this;
 		}
 
+		/*
+			Servers from before the ring only have a queue.
+		*/
 		void Client::Connect(const std::string& connectionpoint)
 		{
 			using namespace boost::interprocess;
 
 			ConnectionPoint = connectionpoint;
 
+			try
+			{
+				auto ring = std::make_unique<SharedRing>();
+				ring->Open(GetRingName(connectionpoint));
+
+				Ring = std::move(ring);
+				return;
+			}
+
+			catch (const interprocess_exception&)
+			{
+
+			}
+
 			MessageQueue = std::make_unique<message_queue>
 			(
 				open_only,
@@ -143,12 +538,12 @@ namespace Shared
 
 		void Client::Disconnect()
 		{
-			MessageQueue.reset();
+			Close();
 		}
 
 		bool Client::IsConnected() const
 		{
-			return MessageQueue != nullptr;
+			return IsOpen();
 		}
 
 		Server::Server()
@@ -163,9 +558,15 @@ namespace Shared
 
 		Server& Server::operator=(Server&& other)
 		{
-			if (other.MessageQueue)
+			if (other.IsOpen())
 			{
+				Close();
+
+				ViewPending = other.ViewPending;
+				other.ViewPending = false;
+
 				MessageQueue = std::move(other.MessageQueue);
+				Ring = std::move(other.Ring);
 				ConnectionPoint = std::move(other.ConnectionPoint);
 			}
 
@@ -177,12 +578,21 @@ namespace Shared
 			Stop();
 		}
 
-		void Server::Start(const std::string& connectionname)
+		void Server::Start(const std::string& connectionname, Config::TransportType transport)
 		{
 			using namespace boost::interprocess;
 
 			ConnectionPoint = connectionname;
 
+			if (transport == Config::TransportType::SharedRing)
+			{
+				auto ring = std::make_unique<SharedRing>();
+				ring->Create(GetRingName(connectionname), Config::RingCapacity);
+
+				Ring = std::move(ring);
+				return;
+			}
+
 			MessageQueue = std::make_unique<message_queue>
 			(
 				create_only,
@@ -192,15 +602,20 @@ namespace Shared
 			);
 		}
 
+		/*
+			Removes both kinds, one can be left behind by an earlier run.
+		*/
 		void Server::Stop()
 		{
 			auto res = boost::interprocess::message_queue::remove(ConnectionPoint.c_str());
-			MessageQueue.reset();
+			SharedRing::Remove(GetRingName(ConnectionPoint));
+
+			Close();
 		}
 
 		bool Server::IsStarted() const
 		{
-			return MessageQueue != nullptr;
+			return IsOpen();
 		}
 	}
 }
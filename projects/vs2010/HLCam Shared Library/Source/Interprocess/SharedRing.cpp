@@ -0,0 +1,315 @@
+#include <atomic>
+#include <cstring>
+#include <new>
+#include "boost/interprocess/shared_memory_object.hpp"
+#include "boost/interprocess/mapped_region.hpp"
+#include "boost/interprocess/sync/interprocess_semaphore.hpp"
+#include "boost/date_time/posix_time/posix_time_types.hpp"
+
+#include "Shared/Interprocess/SharedRing.hpp"
+
+namespace
+{
+	namespace LocalUtility
+	{
+		const uint32_t RingMagic = 0x474E5248;
+
+		/*
+			In place of a length where the next message did not fit
+			before the end and starts over at the front instead.
+		*/
+		const uint32_t WrapMarker = 0xFFFFFFFF;
+
+		const size_t MinCapacity = 4096;
+		const size_t MaxCapacity = 1 << 30;
+
+		/*
+			Lengths stay aligned so they can be read in one go.
+		*/
+		uint32_t GetRecordSize(size_t size)
+		{
+			return static_cast<uint32_t>(sizeof(uint32_t) + ((size + 3) & ~static_cast<size_t>(3)));
+		}
+	}
+}
+
+/*
+	Positions count bytes since creation and wrap around, each
+	side only ever moves its own. Apart on their own cache lines
+	so the two processes don't keep taking them from each other.
+*/
+struct Shared::Interprocess::SharedRing::SharedHeader
+{
+	SharedHeader(uint32_t capacity) :
+		Capacity(capacity),
+		WritePosition(0),
+		MessageCount(0),
+		ReadPosition(0),
+		ReaderWaiting(0),
+		WakePending(0),
+		Signal(0)
+	{
+
+	}
+
+	/*
+		Set last by the creator, the ring can be opened before that.
+	*/
+	std::atomic<uint32_t> Magic;
+	uint32_t Capacity;
+
+	alignas(64) std::atomic<uint32_t> WritePosition;
+	std::atomic<uint32_t> MessageCount;
+
+	alignas(64) std::atomic<uint32_t> ReadPosition;
+
+	/*
+		The writer only posts when the reader said it is about to wait.
+	*/
+	alignas(64) std::atomic<uint32_t> ReaderWaiting;
+	std::atomic<uint32_t> WakePending;
+
+	boost::interprocess::interprocess_semaphore Signal;
+};
+
+namespace Shared
+{
+	namespace Interprocess
+	{
+		SharedRing::SharedRing()
+		{
+
+		}
+
+		size_t SharedRing::GetDataOffset()
+		{
+			return (sizeof(SharedHeader) + 63) & ~static_cast<size_t>(63);
+		}
+
+		SharedRing::~SharedRing()
+		{
+			Region.reset();
+			Memory.reset();
+		}
+
+		void SharedRing::Create(const std::string& name, size_t capacity)
+		{
+			using namespace boost::interprocess;
+
+			size_t size = LocalUtility::MinCapacity;
+
+			while (size < capacity && size < LocalUtility::MaxCapacity)
+			{
+				size *= 2;
+			}
+
+			Memory = std::make_unique<shared_memory_object>(create_only, name.c_str(), read_write);
+			Memory->truncate(GetDataOffset() + size);
+
+			Map();
+
+			Header = new (Region->get_address()) SharedHeader(static_cast<uint32_t>(size));
+			Header->Magic.store(LocalUtility::RingMagic, std::memory_order_release);
+
+			Mask = Header->Capacity - 1;
+		}
+
+		void SharedRing::Open(const std::string& name)
+		{
+			using namespace boost::interprocess;
+
+			Memory = std::make_unique<shared_memory_object>(open_only, name.c_str(), read_write);
+
+			Map();
+
+			Header = static_cast<SharedHeader*>(Region->get_address());
+
+			auto capacity = Header->Capacity;
+			auto valid = Region->get_size() >= GetDataOffset() + capacity && (capacity & (capacity - 1)) == 0;
+
+			/*
+				Not created yet or something else with the same name, try again later.
+			*/
+			if (Header->Magic.load(std::memory_order_acquire) != LocalUtility::RingMagic || !valid)
+			{
+				Header = nullptr;
+				Region.reset();
+				Memory.reset();
+
+				throw interprocess_exception(error_info(not_found_error));
+			}
+
+			Mask = capacity - 1;
+		}
+
+		bool SharedRing::Remove(const std::string& name)
+		{
+			return boost::interprocess::shared_memory_object::remove(name.c_str());
+		}
+
+		void SharedRing::Map()
+		{
+			Region = std::make_unique<boost::interprocess::mapped_region>(*Memory, boost::interprocess::read_write);
+			Data = static_cast<unsigned char*>(Region->get_address()) + GetDataOffset();
+		}
+
+		unsigned char* SharedRing::Reserve(size_t size)
+		{
+			if (size > GetMaxMessageSize())
+			{
+				return nullptr;
+			}
+
+			auto write = Header->WritePosition.load(std::memory_order_relaxed);
+			auto read = Header->ReadPosition.load(std::memory_order_acquire);
+
+			auto needed = LocalUtility::GetRecordSize(size);
+			auto offset = write & Mask;
+			auto toend = Header->Capacity - offset;
+
+			uint32_t padding = needed > toend ? toend : 0;
+
+			if ((write - read) + padding + needed > Header->Capacity)
+			{
+				return nullptr;
+			}
+
+			/*
+				Free space, the reader can't see it before the next commit.
+			*/
+			if (padding != 0)
+			{
+				std::memcpy(Data + offset, &LocalUtility::WrapMarker, sizeof(uint32_t));
+				write += padding;
+			}
+
+			ReservePosition = write;
+
+			return Data + (write & Mask) + sizeof(uint32_t);
+		}
+
+		void SharedRing::Commit(size_t size)
+		{
+			auto length = static_cast<uint32_t>(size);
+			std::memcpy(Data + (ReservePosition & Mask), &length, sizeof(uint32_t));
+
+			Header->MessageCount++;
+			Header->WritePosition.store(ReservePosition + LocalUtility::GetRecordSize(size));
+
+			if (Header->ReaderWaiting.exchange(0) != 0)
+			{
+				Header->Signal.post();
+			}
+		}
+
+		const unsigned char* SharedRing::Peek(size_t& size)
+		{
+			auto read = Header->ReadPosition.load(std::memory_order_relaxed);
+			auto write = Header->WritePosition.load(std::memory_order_acquire);
+
+			if (read == write)
+			{
+				return nullptr;
+			}
+
+			uint32_t length;
+			std::memcpy(&length, Data + (read & Mask), sizeof(uint32_t));
+
+			/*
+				A marker is always followed by the message that didn't fit.
+			*/
+			if (length == LocalUtility::WrapMarker)
+			{
+				read += Header->Capacity - (read & Mask);
+				std::memcpy(&length, Data + (read & Mask), sizeof(uint32_t));
+			}
+
+			PeekPosition = read;
+			PeekSize = length;
+
+			size = length;
+			return Data + (read & Mask) + sizeof(uint32_t);
+		}
+
+		void SharedRing::Release()
+		{
+			Header->ReadPosition.store(PeekPosition + LocalUtility::GetRecordSize(PeekSize), std::memory_order_release);
+			Header->MessageCount--;
+		}
+
+		SharedRing::WaitResult SharedRing::Wait(std::chrono::milliseconds timeout)
+		{
+			namespace ptime = boost::posix_time;
+
+			auto endtime = ptime::microsec_clock::universal_time() + ptime::milliseconds(timeout.count());
+
+			/*
+				Posts left over from earlier commits or wakes make the
+				semaphore return early, so everything is checked again.
+			*/
+			while (true)
+			{
+				if (Header->WakePending.exchange(0) != 0)
+				{
+					return WaitResult::Woken;
+				}
+
+				if (!IsEmpty())
+				{
+					return WaitResult::Ready;
+				}
+
+				Header->ReaderWaiting.store(1);
+
+				if (!IsEmpty())
+				{
+					return WaitResult::Ready;
+				}
+
+				if (!Header->Signal.timed_wait(endtime))
+				{
+					if (Header->WakePending.exchange(0) != 0)
+					{
+						return WaitResult::Woken;
+					}
+
+					return IsEmpty() ? WaitResult::TimedOut : WaitResult::Ready;
+				}
+			}
+		}
+
+		void SharedRing::Wake()
+		{
+			Header->WakePending.store(1);
+			Header->Signal.post();
+		}
+
+		bool SharedRing::IsEmpty() const
+		{
+			return Header->WritePosition.load() == Header->ReadPosition.load(std::memory_order_relaxed);
+		}
+
+		size_t SharedRing::GetMessageCount() const
+		{
+			return Header->MessageCount.load(std::memory_order_relaxed);
+		}
+
+		size_t SharedRing::GetUsedBytes() const
+		{
+			return Header->WritePosition.load(std::memory_order_relaxed) - Header->ReadPosition.load(std::memory_order_relaxed);
+		}
+
+		size_t SharedRing::GetCapacity() const
+		{
+			return Header->Capacity;
+		}
+
+		size_t SharedRing::GetMaxMessageSize() const
+		{
+			/*
+				Half always fits in an empty ring wherever it was left off.
+			*/
+			return Header->Capacity / 2 - sizeof(uint32_t);
+		}
+	}
+}
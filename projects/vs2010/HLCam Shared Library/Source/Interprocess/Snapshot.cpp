@@ -0,0 +1,242 @@
+#include "boost/interprocess/ipc/message_queue.hpp"
+
+#include "Shared/Interprocess/Snapshot.hpp"
+#include "Shared/Compression/LZ4.hpp"
+#include <chrono>
+#include <cstring>
+
+namespace
+{
+	namespace LocalUtility
+	{
+		template <typename T>
+		unsigned char* WriteValue(unsigned char* dest, T value)
+		{
+			std::memcpy(dest, &value, sizeof(value));
+			return dest + sizeof(value);
+		}
+	}
+}
+
+namespace Shared
+{
+	namespace Interprocess
+	{
+		SnapshotWriter::SnapshotWriter(uint32_t id, const Utility::BinaryBuffer& data) :
+			ID(id),
+			Size(static_cast<uint32_t>(data.GetSize()))
+		{
+			auto start = std::chrono::steady_clock::now();
+
+			Compressed.resize(Utility::LZ4::GetMaxCompressedSize(Size));
+
+			/*
+				Kept as is unless compressing makes it smaller.
+			*/
+			auto compressedsize = Utility::LZ4::Compress(data.GetData(), Size, Compressed.data(), Size != 0 ? Size - 1 : 0);
+
+			if (compressedsize == 0)
+			{
+				compressedsize = Size;
+
+				if (Size != 0)
+				{
+					std::memcpy(Compressed.data(), data.GetData(), Size);
+				}
+			}
+
+			Compressed.resize(compressedsize);
+
+			/*
+				Even nothing takes a chunk, so the reader finds out.
+			*/
+			ChunkCount = (compressedsize + Snapshot::ChunkDataSize - 1) / Snapshot::ChunkDataSize;
+
+			if (ChunkCount == 0)
+			{
+				ChunkCount = 1;
+			}
+
+			Stats.Size = Size;
+			Stats.CompressedSize = compressedsize;
+			Stats.ChunkCount = ChunkCount;
+			Stats.CompressMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		bool SnapshotWriter::WriteChunks(Peer& peer, Config::MessageType message)
+		{
+			using namespace LocalUtility;
+
+			while (NextChunk < ChunkCount)
+			{
+				auto offset = NextChunk * Snapshot::ChunkDataSize;
+				auto size = Compressed.size() - offset;
+
+				if (size > Snapshot::ChunkDataSize)
+				{
+					size = Snapshot::ChunkDataSize;
+				}
+
+				auto dest = peer.BeginWrite(message, Snapshot::HeaderSize + size);
+
+				if (!dest)
+				{
+					return false;
+				}
+
+				dest = WriteValue(dest, ID);
+				dest = WriteValue(dest, static_cast<uint16_t>(NextChunk));
+				dest = WriteValue(dest, static_cast<uint16_t>(ChunkCount));
+				dest = WriteValue(dest, Size);
+				dest = WriteValue(dest, static_cast<uint32_t>(Compressed.size()));
+
+				if (size != 0)
+				{
+					std::memcpy(dest, Compressed.data() + offset, size);
+				}
+
+				if (!peer.EndWrite(Snapshot::HeaderSize + size))
+				{
+					return false;
+				}
+
+				NextChunk++;
+			}
+
+			return true;
+		}
+
+		bool SnapshotWriter::IsDone() const
+		{
+			return NextChunk == ChunkCount;
+		}
+
+		uint32_t SnapshotWriter::GetID() const
+		{
+			return ID;
+		}
+
+		const Snapshot::Stats& SnapshotWriter::GetStats() const
+		{
+			return Stats;
+		}
+
+		SnapshotReader::Result SnapshotReader::Add(Utility::BinaryBufferView& chunk)
+		{
+			uint32_t id = 0;
+			uint16_t index = 0;
+			uint16_t count = 0;
+			uint32_t size = 0;
+			uint32_t compressedsize = 0;
+
+			chunk >> id;
+			chunk >> index;
+			chunk >> count;
+			chunk >> size;
+			chunk >> compressedsize;
+
+			auto datasize = chunk.GetSize() - chunk.GetReadPosition();
+			auto data = chunk.ReadBytes(datasize);
+
+			if (!Assembling || id != ID)
+			{
+				Reset();
+
+				/*
+					Joined halfway, the rest of this one is of no use.
+				*/
+				if (index != 0)
+				{
+					return Result::Failed;
+				}
+
+				/*
+					Sizes no chunk count or compression ratio
+					could produce are damage, nothing is allocated.
+				*/
+				if (compressedsize > static_cast<size_t>(count) * Snapshot::ChunkDataSize ||
+					static_cast<uint64_t>(size) > static_cast<uint64_t>(compressedsize) * 255 + 16)
+				{
+					return Result::Failed;
+				}
+
+				Assembling = true;
+
+				ID = id;
+				ChunkCount = count;
+				Size = size;
+				CompressedSize = compressedsize;
+
+				Compressed.reserve(compressedsize);
+			}
+
+			if (index != NextChunk || count != ChunkCount || size != Size || compressedsize != CompressedSize ||
+				datasize > CompressedSize - Compressed.size())
+			{
+				Reset();
+				return Result::Failed;
+			}
+
+			if (datasize != 0)
+			{
+				auto bytes = static_cast<const unsigned char*>(data);
+				Compressed.insert(Compressed.end(), bytes, bytes + datasize);
+			}
+
+			NextChunk++;
+
+			if (NextChunk != ChunkCount)
+			{
+				return Result::Incomplete;
+			}
+
+			Assembling = false;
+
+			if (Compressed.size() != CompressedSize)
+			{
+				Reset();
+				return Result::Failed;
+			}
+
+			if (CompressedSize == Size)
+			{
+				Data.Assign(Compressed.data(), Size);
+			}
+
+			else
+			{
+				Data.Resize(Size);
+
+				if (!Utility::LZ4::Decompress(Compressed.data(), CompressedSize, Data.GetDataModify(), Size))
+				{
+					Reset();
+					return Result::Failed;
+				}
+			}
+
+			Data.SetReadPosition(0);
+
+			return Result::Complete;
+		}
+
+		bool SnapshotReader::IsAssembling() const
+		{
+			return Assembling;
+		}
+
+		void SnapshotReader::Reset()
+		{
+			Assembling = false;
+
+			NextChunk = 0;
+			ChunkCount = 0;
+
+			Compressed.clear();
+		}
+
+		Utility::BinaryBuffer& SnapshotReader::GetData()
+		{
+			return Data;
+		}
+	}
+}
@@ -0,0 +1,365 @@
+#include "Shared/Map/MapBatch.hpp"
+#include "Shared/String/String.hpp"
+#include <cstdlib>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	namespace LocalUtility
+	{
+		using namespace Cam::Shared;
+
+		const char* ToString(CameraAngleType type)
+		{
+			return CameraAngleTypeToString(type);
+		}
+
+		const char* ToString(CameraLookType type)
+		{
+			return CameraLookTypeToString(type);
+		}
+
+		const char* ToString(CameraPlaneType type)
+		{
+			return CameraPlaneTypeToString(type);
+		}
+
+		const char* ToString(CameraTriggerType type)
+		{
+			return CameraTriggerTypeToString(type);
+		}
+
+		const char* ToString(CameraZoomType type)
+		{
+			return CameraZoomTypeToString(type);
+		}
+
+		template <typename Owner, typename T>
+		bool IsEditable(const Schema::Field<Owner, T>& field)
+		{
+			return !(field.Flags & (Schema::Fixed | Schema::FileOnly));
+		}
+
+		std::string GetEditableNames()
+		{
+			std::string ret;
+
+			Schema::Record<MapCameraData>::ForEach([&ret](const auto& field)
+			{
+				if (IsEditable(field))
+				{
+					if (!ret.empty())
+					{
+						ret += ", ";
+					}
+
+					ret += field.Name;
+				}
+			});
+
+			return ret;
+		}
+
+		/*
+			Whole text only, nothing may follow the number.
+		*/
+		bool ParseText(const std::string& text, uint32_t& value)
+		{
+			if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos)
+			{
+				return false;
+			}
+
+			auto number = std::strtoull(text.c_str(), nullptr, 10);
+
+			if (number > std::numeric_limits<uint32_t>::max())
+			{
+				return false;
+			}
+
+			value = static_cast<uint32_t>(number);
+			return true;
+		}
+
+		bool ParseText(const std::string& text, float& value)
+		{
+			if (text.empty())
+			{
+				return false;
+			}
+
+			char* end;
+			value = std::strtof(text.c_str(), &end);
+
+			return *end == 0 && std::isfinite(value);
+		}
+
+		bool ParseText(const std::string& text, bool& value)
+		{
+			if (text == "1" || text == "true")
+			{
+				value = true;
+				return true;
+			}
+
+			if (text == "0" || text == "false")
+			{
+				value = false;
+				return true;
+			}
+
+			return false;
+		}
+
+		bool ParseText(const std::string& text, std::string& value)
+		{
+			value = text;
+			return true;
+		}
+
+		/*
+			Separated by spaces or commas.
+		*/
+		bool ParseText(const std::string& text, MapVector& value)
+		{
+			float* components[] = {&value.X, &value.Y, &value.Z};
+
+			const char* separators = " \t,";
+			size_t position = 0;
+
+			for (auto component : components)
+			{
+				auto start = text.find_first_not_of(separators, position);
+
+				if (start == std::string::npos)
+				{
+					return false;
+				}
+
+				position = text.find_first_of(separators, start);
+
+				if (!ParseText(text.substr(start, position - start), *component))
+				{
+					return false;
+				}
+			}
+
+			return text.find_first_not_of(separators, position) == std::string::npos;
+		}
+
+		/*
+			Every enum counts up from 0 and has a name for each value.
+		*/
+		template <typename T>
+		typename std::enable_if<std::is_enum<T>::value, bool>::type ParseText(const std::string& text, T& value)
+		{
+			for (int i = 0; ToString(static_cast<T>(i)); i++)
+			{
+				if (Utility::CompareString(ToString(static_cast<T>(i)), text.c_str()))
+				{
+					value = static_cast<T>(i);
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		template <typename T>
+		bool ParseText(const std::string& /*text*/, std::vector<T>& /*values*/)
+		{
+			return false;
+		}
+
+		template <typename T>
+		typename std::enable_if<!std::is_enum<T>::value, bool>::type IsValid(const T& /*value*/)
+		{
+			return true;
+		}
+
+		template <typename T>
+		typename std::enable_if<std::is_enum<T>::value, bool>::type IsValid(T value)
+		{
+			return ToString(value) != nullptr;
+		}
+
+		/*
+			What the text of a value should look like, for errors.
+		*/
+		const char* DescribeValue(uint32_t)
+		{
+			return "a whole number";
+		}
+
+		const char* DescribeValue(float)
+		{
+			return "a number";
+		}
+
+		const char* DescribeValue(bool)
+		{
+			return "true or false";
+		}
+
+		const char* DescribeValue(const std::string&)
+		{
+			return "text";
+		}
+
+		const char* DescribeValue(const MapVector&)
+		{
+			return "three numbers";
+		}
+
+		template <typename T>
+		typename std::enable_if<std::is_enum<T>::value, std::string>::type DescribeValue(T)
+		{
+			std::string ret = "one of ";
+
+			for (int i = 0; ToString(static_cast<T>(i)); i++)
+			{
+				if (i != 0)
+				{
+					ret += ", ";
+				}
+
+				ret += "\"";
+				ret += ToString(static_cast<T>(i));
+				ret += "\"";
+			}
+
+			return ret;
+		}
+
+		template <typename T>
+		const char* DescribeValue(const std::vector<T>&)
+		{
+			return "a list";
+		}
+
+		template <typename T>
+		bool WriteEdit(Utility::BinaryBuffer& buffer, uint32_t cameraid, const Schema::Field<MapCameraData, T>& field, const std::string& text, std::string& error)
+		{
+			T value{};
+
+			if (!ParseText(text, value))
+			{
+				error = "\"" + text + "\" is not " + std::string(DescribeValue(value)) + " for " + field.Name;
+				return false;
+			}
+
+			Schema::Wire::WriteVarint(buffer, cameraid);
+			Schema::Wire::WriteValue(buffer, std::string(field.Name), 0);
+			Schema::Wire::WriteValue(buffer, value, field.Flags);
+
+			return true;
+		}
+	}
+}
+
+std::string Cam::Shared::MapBatch::GetResultConnectionName(uint32_t batchid)
+{
+	return "HLCAM_SCRIPT_RESULT_" + std::to_string(batchid);
+}
+
+bool Cam::Shared::MapBatch::WriteEdit(Utility::BinaryBuffer& buffer, uint32_t cameraid, const std::string& field, const std::string& text, std::string& error)
+{
+	auto found = false;
+	auto ret = false;
+
+	Schema::Record<MapCameraData>::ForEach([&](const auto& schemafield)
+	{
+		if (found || field != schemafield.Name)
+		{
+			return;
+		}
+
+		found = true;
+
+		if (!LocalUtility::IsEditable(schemafield))
+		{
+			error = field + " can't be changed by a batch";
+			return;
+		}
+
+		ret = LocalUtility::WriteEdit(buffer, cameraid, schemafield, text, error);
+	});
+
+	if (!found)
+	{
+		error = "No field " + field + ", these can be changed: " + LocalUtility::GetEditableNames();
+	}
+
+	return ret;
+}
+
+bool Cam::Shared::MapBatch::ReadCameraID(Utility::BinaryBufferView& view, uint32_t& cameraid)
+{
+	return Schema::Wire::ReadVarint(view, cameraid);
+}
+
+bool Cam::Shared::MapBatch::ReadEdit(Utility::BinaryBufferView& view, MapCameraData& camera, std::string& error)
+{
+	std::string name;
+
+	if (!Schema::Wire::ReadValue(view, name, 0))
+	{
+		error = "Edit is cut short";
+		return false;
+	}
+
+	auto found = false;
+	auto ret = false;
+
+	Schema::Record<MapCameraData>::ForEach([&](const auto& field)
+	{
+		if (found || name != field.Name)
+		{
+			return;
+		}
+
+		found = true;
+
+		if (!LocalUtility::IsEditable(field))
+		{
+			error = name + " can't be changed by a batch";
+			return;
+		}
+
+		auto value = camera.*field.Member;
+
+		if (!Schema::Wire::ReadValue(view, value, field.Flags))
+		{
+			error = "Edit of " + name + " is cut short";
+			return;
+		}
+
+		if (!LocalUtility::IsValid(value))
+		{
+			error = name + " has a value out of range";
+			return;
+		}
+
+		camera.*field.Member = std::move(value);
+
+		/*
+			Looks at fields before it, which may have been
+			changed by earlier edits in the batch.
+		*/
+		if (!Schema::IsPresent(field, camera))
+		{
+			error = name + " is not used with the camera's other settings";
+			return;
+		}
+
+		ret = true;
+	});
+
+	if (!found)
+	{
+		error = "No field " + name;
+	}
+
+	return ret;
+}
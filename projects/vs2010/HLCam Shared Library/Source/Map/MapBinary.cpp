@@ -0,0 +1,678 @@
+#include "Shared/Map/MapFile.hpp"
+#include "Shared/Spatial/AABBTree.hpp"
+#include <cstring>
+#include <cmath>
+#include <fstream>
+#include <unordered_set>
+#include <unordered_map>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+namespace
+{
+	namespace LocalUtility
+	{
+		template <typename T>
+		void Append(std::vector<char>& output, const T& value)
+		{
+			auto bytes = reinterpret_cast<const char*>(&value);
+			output.insert(output.end(), bytes, bytes + sizeof(T));
+		}
+
+		void CopyVector(const Cam::Shared::MapVector& vector, float* output)
+		{
+			output[0] = vector.X;
+			output[1] = vector.Y;
+			output[2] = vector.Z;
+		}
+
+		Cam::Shared::MapVector MakeVector(const float* input)
+		{
+			Cam::Shared::MapVector ret;
+
+			ret.X = input[0];
+			ret.Y = input[1];
+			ret.Z = input[2];
+
+			return ret;
+		}
+
+		/*
+			Numbers past the highest stored one are taken first, then
+			gaps from the start once those run out.
+		*/
+		uint32_t TakeFreeID(std::unordered_set<uint32_t>& used, uint32_t& nextid)
+		{
+			if (nextid > Cam::Shared::MaxMapID)
+			{
+				nextid = 0;
+			}
+
+			while (used.find(nextid) != used.end())
+			{
+				nextid++;
+			}
+
+			used.insert(nextid);
+			return nextid++;
+		}
+
+		/*
+			Deduplicating string table, offset 0 is always the empty string.
+		*/
+		class StringTable
+		{
+		public:
+			StringTable()
+			{
+				Data.push_back(0);
+			}
+
+			uint32_t Add(const std::string& string)
+			{
+				if (string.empty())
+				{
+					return 0;
+				}
+
+				auto offset = static_cast<uint32_t>(Data.size());
+				auto result = Offsets.emplace(string, offset);
+
+				if (!result.second)
+				{
+					return result.first->second;
+				}
+
+				Data.insert(Data.end(), string.begin(), string.end());
+				Data.push_back(0);
+
+				return offset;
+			}
+
+			std::vector<char> Data;
+
+		private:
+			std::unordered_map<std::string, uint32_t> Offsets;
+		};
+
+		/*
+			Same tree the game would build on load, so it can skip doing so.
+		*/
+		bool BuildTriggerTree(const std::vector<Cam::Shared::MapFile::Binary::TriggerRecord>& triggers, std::vector<Cam::Shared::MapFile::Binary::TreeNodeRecord>& output)
+		{
+			std::vector<std::pair<Utility::AABBTree::IDType, Utility::AABB>> items;
+			std::unordered_set<uint32_t> ids;
+
+			items.reserve(triggers.size());
+			ids.reserve(triggers.size());
+
+			for (const auto& trig : triggers)
+			{
+				if (!ids.insert(trig.ID).second)
+				{
+					return false;
+				}
+
+				Utility::AABB box;
+				std::memcpy(box.Min, trig.Min, sizeof(box.Min));
+				std::memcpy(box.Max, trig.Max, sizeof(box.Max));
+
+				items.emplace_back(trig.ID, box);
+			}
+
+			Utility::AABBTree tree;
+			tree.Build(items);
+
+			std::vector<Utility::AABBTree::FlatNode> nodes;
+			tree.Save(nodes);
+
+			output.reserve(nodes.size());
+
+			for (const auto& node : nodes)
+			{
+				Cam::Shared::MapFile::Binary::TreeNodeRecord record;
+
+				std::memcpy(record.Min, node.Box.Min, sizeof(record.Min));
+				std::memcpy(record.Max, node.Box.Max, sizeof(record.Max));
+
+				record.Children[0] = node.Children[0];
+				record.Children[1] = node.Children[1];
+				record.ID = static_cast<uint32_t>(node.ID);
+
+				output.push_back(record);
+			}
+
+			return true;
+		}
+	}
+}
+
+const char Cam::Shared::MapFile::Binary::Magic[4] = {'H', 'L', 'C', 'B'};
+
+bool Cam::Shared::MapFile::GetFileStamp(const char* path, FileStamp& stamp)
+{
+	#ifdef _WIN32
+	struct _stat64 info;
+
+	if (_stat64(path, &info) != 0)
+	{
+		return false;
+	}
+	#else
+	struct stat info;
+
+	if (stat(path, &info) != 0)
+	{
+		return false;
+	}
+	#endif
+
+	stamp.Size = info.st_size;
+	stamp.Time = info.st_mtime;
+
+	return true;
+}
+
+bool Cam::Shared::MapFile::ReadAllBytes(const char* path, std::vector<char>& bytes)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+
+	if (!file)
+	{
+		return false;
+	}
+
+	auto pos = file.tellg();
+
+	if (pos < 0)
+	{
+		return false;
+	}
+
+	bytes.resize(static_cast<size_t>(pos) + 1);
+
+	file.seekg(0, std::ios::beg);
+	file.read(bytes.data(), pos);
+
+	bytes.back() = 0;
+
+	return static_cast<bool>(file);
+}
+
+bool Cam::Shared::MapFile::WriteAllBytes(const char* path, const char* data, size_t size)
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+	if (!file)
+	{
+		return false;
+	}
+
+	file.write(data, size);
+	return static_cast<bool>(file);
+}
+
+void Cam::Shared::MapFile::AssignIDs(MapData& map)
+{
+	std::unordered_set<uint32_t> usedcameras;
+	std::unordered_set<uint32_t> usedtriggers;
+
+	uint32_t nextcamera = 0;
+	uint32_t nexttrigger = 0;
+
+	/*
+		Stored IDs are claimed first so a missing one is never
+		given a number that appears later in the file.
+	*/
+	for (auto& cam : map.Cameras)
+	{
+		if (cam.ID > MaxMapID || !usedcameras.insert(cam.ID).second)
+		{
+			cam.ID = InvalidMapID;
+		}
+
+		if (cam.ID != InvalidMapID && cam.ID >= nextcamera)
+		{
+			nextcamera = cam.ID + 1;
+		}
+
+		for (auto& trig : cam.Triggers)
+		{
+			if (trig.ID > MaxMapID || !usedtriggers.insert(trig.ID).second)
+			{
+				trig.ID = InvalidMapID;
+			}
+
+			if (trig.ID != InvalidMapID && trig.ID >= nexttrigger)
+			{
+				nexttrigger = trig.ID + 1;
+			}
+		}
+	}
+
+	for (auto& cam : map.Cameras)
+	{
+		if (cam.ID == InvalidMapID)
+		{
+			cam.ID = LocalUtility::TakeFreeID(usedcameras, nextcamera);
+		}
+
+		for (auto& trig : cam.Triggers)
+		{
+			if (trig.ID == InvalidMapID)
+			{
+				trig.ID = LocalUtility::TakeFreeID(usedtriggers, nexttrigger);
+			}
+		}
+	}
+}
+
+bool Cam::Shared::MapFile::Binary::Write(const MapData& map, const FileStamp& source, std::vector<char>& output)
+{
+	for (const auto& cam : map.Cameras)
+	{
+		auto missingid = cam.ID > MaxMapID;
+
+		for (const auto& trig : cam.Triggers)
+		{
+			missingid |= trig.ID > MaxMapID;
+		}
+
+		if (missingid)
+		{
+			auto numbered = map;
+			AssignIDs(numbered);
+
+			return Write(numbered, source, output);
+		}
+	}
+
+	LocalUtility::StringTable strings;
+
+	std::vector<CameraRecord> cameras;
+	std::vector<TriggerRecord> triggers;
+
+	cameras.reserve(map.Cameras.size());
+
+	for (const auto& cam : map.Cameras)
+	{
+		CameraRecord record;
+		std::memset(&record, 0, sizeof(record));
+
+		record.ID = cam.ID;
+
+		LocalUtility::CopyVector(cam.Position, record.Position);
+		LocalUtility::CopyVector(cam.Angle, record.Angle);
+		LocalUtility::CopyVector(cam.AttachmentOffset, record.AttachmentOffset);
+
+		record.MaxSpeed = cam.MaxSpeed;
+		record.ZoomTime = cam.ZoomTime;
+		record.ZoomEndFOV = cam.ZoomEndFOV;
+		record.FOV = cam.FOV;
+
+		record.FirstTrigger = static_cast<uint32_t>(triggers.size());
+		record.TriggerCount = static_cast<uint32_t>(cam.Triggers.size());
+
+		record.Name = strings.Add(cam.Name);
+		record.LookTargetName = strings.Add(cam.LookTargetName);
+		record.AttachmentTargetName = strings.Add(cam.AttachmentTargetName);
+
+		record.TriggerType = static_cast<uint8_t>(cam.TriggerType);
+		record.LookType = static_cast<uint8_t>(cam.LookType);
+		record.PlaneType = static_cast<uint8_t>(cam.PlaneType);
+		record.ZoomType = static_cast<uint8_t>(cam.ZoomType);
+		record.ZoomInterpMethod = static_cast<uint8_t>(cam.ZoomInterpMethod);
+		record.UseAttachment = cam.UseAttachment;
+
+		for (const auto& trig : cam.Triggers)
+		{
+			TriggerRecord trigrecord;
+
+			trigrecord.ID = trig.ID;
+
+			LocalUtility::CopyVector(trig.Corner1, trigrecord.Corner1);
+			LocalUtility::CopyVector(trig.Corner2, trigrecord.Corner2);
+
+			for (size_t i = 0; i < 3; i++)
+			{
+				trigrecord.Min[i] = std::fmin(trigrecord.Corner1[i], trigrecord.Corner2[i]);
+				trigrecord.Max[i] = std::fmax(trigrecord.Corner1[i], trigrecord.Corner2[i]);
+				trigrecord.Center[i] = trigrecord.Min[i] + (trigrecord.Max[i] - trigrecord.Min[i]) / 2.0f;
+			}
+
+			trigrecord.CameraIndex = static_cast<uint32_t>(cameras.size());
+
+			triggers.push_back(trigrecord);
+		}
+
+		cameras.push_back(record);
+	}
+
+	std::vector<TreeNodeRecord> treenodes;
+	LocalUtility::BuildTriggerTree(triggers, treenodes);
+
+	/*
+		Keep the table size 4 byte aligned so a file is always whole records.
+	*/
+	while (strings.Data.size() % 4 != 0)
+	{
+		strings.Data.push_back(0);
+	}
+
+	Header header;
+	std::memset(&header, 0, sizeof(header));
+
+	std::memcpy(header.Magic, Magic, sizeof(header.Magic));
+	header.Version = Version;
+
+	header.SourceSize = source.Size;
+	header.SourceTime = source.Time;
+
+	header.CameraCount = static_cast<uint32_t>(cameras.size());
+	header.CameraOffset = sizeof(Header);
+
+	header.TriggerCount = static_cast<uint32_t>(triggers.size());
+	header.TriggerOffset = header.CameraOffset + header.CameraCount * sizeof(CameraRecord);
+
+	header.StringsSize = static_cast<uint32_t>(strings.Data.size());
+	header.StringsOffset = header.TriggerOffset + header.TriggerCount * sizeof(TriggerRecord);
+
+	header.TreeNodeCount = static_cast<uint32_t>(treenodes.size());
+	header.TreeNodeOffset = header.StringsOffset + header.StringsSize;
+
+	output.clear();
+	output.reserve(header.TreeNodeOffset + header.TreeNodeCount * sizeof(TreeNodeRecord));
+
+	LocalUtility::Append(output, header);
+
+	for (const auto& record : cameras)
+	{
+		LocalUtility::Append(output, record);
+	}
+
+	for (const auto& record : triggers)
+	{
+		LocalUtility::Append(output, record);
+	}
+
+	output.insert(output.end(), strings.Data.begin(), strings.Data.end());
+
+	for (const auto& record : treenodes)
+	{
+		LocalUtility::Append(output, record);
+	}
+
+	return true;
+}
+
+bool Cam::Shared::MapFile::BinaryMap::Open(const char* path, std::string& error)
+{
+	namespace ipc = boost::interprocess;
+
+	Data = nullptr;
+	Size = 0;
+
+	try
+	{
+		File = ipc::file_mapping(path, ipc::read_only);
+		Region = ipc::mapped_region(File, ipc::read_only);
+	}
+
+	catch (const ipc::interprocess_exception& exception)
+	{
+		error = exception.what();
+		return false;
+	}
+
+	Data = static_cast<const char*>(Region.get_address());
+	Size = Region.get_size();
+
+	if (!Validate(error))
+	{
+		Data = nullptr;
+		Size = 0;
+
+		Region = ipc::mapped_region();
+		File = ipc::file_mapping();
+
+		return false;
+	}
+
+	return true;
+}
+
+bool Cam::Shared::MapFile::BinaryMap::Validate(std::string& error) const
+{
+	if (Size < sizeof(Binary::Header))
+	{
+		error = "File too small";
+		return false;
+	}
+
+	const auto& header = GetHeader();
+
+	if (std::memcmp(header.Magic, Binary::Magic, sizeof(header.Magic)) != 0)
+	{
+		error = "Not a compiled camera map";
+		return false;
+	}
+
+	if (header.Version != Binary::Version)
+	{
+		error = "Unsupported version";
+		return false;
+	}
+
+	auto checkrange = [this](uint64_t offset, uint64_t count, uint64_t elementsize)
+	{
+		return offset % 4 == 0 && offset <= Size && count * elementsize <= Size - offset;
+	};
+
+	if (!checkrange(header.CameraOffset, header.CameraCount, sizeof(Binary::CameraRecord)) ||
+		!checkrange(header.TriggerOffset, header.TriggerCount, sizeof(Binary::TriggerRecord)) ||
+		!checkrange(header.StringsOffset, header.StringsSize, 1) ||
+		!checkrange(header.TreeNodeOffset, header.TreeNodeCount, sizeof(Binary::TreeNodeRecord)))
+	{
+		error = "Table out of range";
+		return false;
+	}
+
+	if (header.StringsSize == 0 || Data[header.StringsOffset + header.StringsSize - 1] != 0)
+	{
+		error = "Unterminated string table";
+		return false;
+	}
+
+	auto checkstring = [&header](uint32_t offset)
+	{
+		return offset == Binary::NoString || offset < header.StringsSize;
+	};
+
+	auto cameras = GetCameras();
+
+	for (size_t i = 0; i < header.CameraCount; i++)
+	{
+		const auto& cam = cameras[i];
+
+		if (cam.ID > MaxMapID)
+		{
+			error = "Camera without a valid ID";
+			return false;
+		}
+
+		if (cam.FirstTrigger > header.TriggerCount ||
+			cam.TriggerCount > header.TriggerCount - cam.FirstTrigger)
+		{
+			error = "Camera trigger range out of bounds";
+			return false;
+		}
+
+		if (!checkstring(cam.Name) ||
+			!checkstring(cam.LookTargetName) ||
+			!checkstring(cam.AttachmentTargetName))
+		{
+			error = "String offset out of bounds";
+			return false;
+		}
+
+		if (cam.TriggerType > static_cast<uint8_t>(CameraTriggerType::ByUserTrigger) ||
+			cam.LookType > static_cast<uint8_t>(CameraLookType::AtTarget) ||
+			cam.PlaneType > static_cast<uint8_t>(CameraPlaneType::Both) ||
+			cam.ZoomType > static_cast<uint8_t>(CameraZoomType::ZoomByDistance) ||
+			cam.ZoomInterpMethod > static_cast<uint8_t>(CameraAngleType::Exponential))
+		{
+			error = "Invalid camera type";
+			return false;
+		}
+	}
+
+	auto triggers = GetTriggers();
+
+	for (size_t i = 0; i < header.TriggerCount; i++)
+	{
+		if (triggers[i].ID > MaxMapID)
+		{
+			error = "Trigger without a valid ID";
+			return false;
+		}
+
+		if (triggers[i].CameraIndex >= header.CameraCount)
+		{
+			error = "Trigger camera index out of bounds";
+			return false;
+		}
+	}
+
+	/*
+		Only what could be read out of bounds is checked here,
+		the tree itself checks its shape when it is loaded.
+	*/
+	auto treenodes = GetTreeNodes();
+	auto nodecount = static_cast<int64_t>(header.TreeNodeCount);
+
+	for (size_t i = 0; i < header.TreeNodeCount; i++)
+	{
+		for (auto child : treenodes[i].Children)
+		{
+			if (child < -1 || child >= nodecount)
+			{
+				error = "Tree node index out of bounds";
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool Cam::Shared::MapFile::BinaryMap::IsCurrent(const char* sourcepath) const
+{
+	FileStamp stamp;
+
+	if (!GetFileStamp(sourcepath, stamp))
+	{
+		return true;
+	}
+
+	const auto& header = GetHeader();
+
+	return header.SourceSize == stamp.Size && header.SourceTime == stamp.Time;
+}
+
+const Cam::Shared::MapFile::Binary::Header& Cam::Shared::MapFile::BinaryMap::GetHeader() const
+{
+	return *reinterpret_cast<const Binary::Header*>(Data);
+}
+
+const Cam::Shared::MapFile::Binary::CameraRecord* Cam::Shared::MapFile::BinaryMap::GetCameras() const
+{
+	return reinterpret_cast<const Binary::CameraRecord*>(Data + GetHeader().CameraOffset);
+}
+
+size_t Cam::Shared::MapFile::BinaryMap::GetCameraCount() const
+{
+	return GetHeader().CameraCount;
+}
+
+const Cam::Shared::MapFile::Binary::TriggerRecord* Cam::Shared::MapFile::BinaryMap::GetTriggers() const
+{
+	return reinterpret_cast<const Binary::TriggerRecord*>(Data + GetHeader().TriggerOffset);
+}
+
+size_t Cam::Shared::MapFile::BinaryMap::GetTriggerCount() const
+{
+	return GetHeader().TriggerCount;
+}
+
+const Cam::Shared::MapFile::Binary::TreeNodeRecord* Cam::Shared::MapFile::BinaryMap::GetTreeNodes() const
+{
+	return reinterpret_cast<const Binary::TreeNodeRecord*>(Data + GetHeader().TreeNodeOffset);
+}
+
+size_t Cam::Shared::MapFile::BinaryMap::GetTreeNodeCount() const
+{
+	return GetHeader().TreeNodeCount;
+}
+
+const char* Cam::Shared::MapFile::BinaryMap::GetString(uint32_t offset) const
+{
+	if (offset == Binary::NoString)
+	{
+		return "";
+	}
+
+	return Data + GetHeader().StringsOffset + offset;
+}
+
+void Cam::Shared::MapFile::BinaryMap::ToMapData(MapData& map) const
+{
+	auto cameras = GetCameras();
+	auto triggers = GetTriggers();
+
+	map.Cameras.reserve(map.Cameras.size() + GetCameraCount());
+
+	for (size_t i = 0; i < GetCameraCount(); i++)
+	{
+		const auto& record = cameras[i];
+
+		MapCameraData cam;
+
+		cam.ID = record.ID;
+
+		cam.Position = LocalUtility::MakeVector(record.Position);
+		cam.Angle = LocalUtility::MakeVector(record.Angle);
+		cam.AttachmentOffset = LocalUtility::MakeVector(record.AttachmentOffset);
+
+		cam.MaxSpeed = record.MaxSpeed;
+		cam.ZoomTime = record.ZoomTime;
+		cam.ZoomEndFOV = record.ZoomEndFOV;
+		cam.FOV = record.FOV;
+
+		cam.Name = GetString(record.Name);
+		cam.LookTargetName = GetString(record.LookTargetName);
+		cam.AttachmentTargetName = GetString(record.AttachmentTargetName);
+
+		cam.TriggerType = static_cast<CameraTriggerType>(record.TriggerType);
+		cam.LookType = static_cast<CameraLookType>(record.LookType);
+		cam.PlaneType = static_cast<CameraPlaneType>(record.PlaneType);
+		cam.ZoomType = static_cast<CameraZoomType>(record.ZoomType);
+		cam.ZoomInterpMethod = static_cast<CameraAngleType>(record.ZoomInterpMethod);
+		cam.UseAttachment = record.UseAttachment != 0;
+
+		cam.Triggers.reserve(record.TriggerCount);
+
+		for (size_t j = 0; j < record.TriggerCount; j++)
+		{
+			const auto& trigrecord = triggers[record.FirstTrigger + j];
+
+			MapTriggerData trig;
+			trig.ID = trigrecord.ID;
+			trig.Corner1 = LocalUtility::MakeVector(trigrecord.Corner1);
+			trig.Corner2 = LocalUtility::MakeVector(trigrecord.Corner2);
+
+			cam.Triggers.push_back(trig);
+		}
+
+		map.Cameras.push_back(std::move(cam));
+	}
+}
@@ -0,0 +1,430 @@
+#include "Shared/Map/MapCheck.hpp"
+#include "Shared/Spatial/AABBTree.hpp"
+#include <cstring>
+#include <cmath>
+#include <unordered_map>
+
+namespace
+{
+	namespace LocalUtility
+	{
+		/*
+			Version 29 is Quake, 30 is Half-Life. Both start
+			with the entity lump and have the same header.
+		*/
+		struct BSPHeader
+		{
+			int32_t Version;
+
+			struct
+			{
+				int32_t Offset;
+				int32_t Length;
+			} Lumps[15];
+		};
+
+		/*
+			Reads the next quoted string, entity lumps have no escapes.
+		*/
+		bool ReadToken(const char*& text, const char* end, std::string& token)
+		{
+			while (text < end && *text != '"' && *text != '}')
+			{
+				text++;
+			}
+
+			if (text >= end || *text == '}')
+			{
+				return false;
+			}
+
+			auto start = ++text;
+
+			while (text < end && *text != '"')
+			{
+				text++;
+			}
+
+			if (text >= end)
+			{
+				return false;
+			}
+
+			token.assign(start, text);
+			text++;
+
+			return true;
+		}
+
+		bool IsFinite(const Cam::Shared::MapVector& vector)
+		{
+			return std::isfinite(vector.X) && std::isfinite(vector.Y) && std::isfinite(vector.Z);
+		}
+
+		Utility::AABB MakeBox(const Cam::Shared::MapTriggerData& trigger)
+		{
+			Utility::AABB ret;
+
+			const float corner1[3] = {trigger.Corner1.X, trigger.Corner1.Y, trigger.Corner1.Z};
+			const float corner2[3] = {trigger.Corner2.X, trigger.Corner2.Y, trigger.Corner2.Z};
+
+			for (size_t i = 0; i < 3; i++)
+			{
+				ret.Min[i] = std::fmin(corner1[i], corner2[i]);
+				ret.Max[i] = std::fmax(corner1[i], corner2[i]);
+			}
+
+			return ret;
+		}
+
+		/*
+			Boxes that only touch are fine, the player moves between them.
+		*/
+		bool OverlapsInside(const Utility::AABB& first, const Utility::AABB& other)
+		{
+			return first.Min[0] < other.Max[0] && first.Max[0] > other.Min[0] &&
+				   first.Min[1] < other.Max[1] && first.Max[1] > other.Min[1] &&
+				   first.Min[2] < other.Max[2] && first.Max[2] > other.Min[2];
+		}
+
+		std::string DescribeCamera(size_t index, const Cam::Shared::MapCameraData& camera)
+		{
+			auto ret = "Camera " + std::to_string(index + 1);
+
+			if (!camera.Name.empty())
+			{
+				ret += " \"" + camera.Name + "\"";
+			}
+
+			return ret;
+		}
+
+		std::string DescribeTrigger(size_t cameraindex, const Cam::Shared::MapCameraData& camera, size_t index)
+		{
+			return DescribeCamera(cameraindex, camera) + " trigger " + std::to_string(index + 1);
+		}
+
+		class IssueList
+		{
+		public:
+			IssueList(std::vector<Cam::Shared::MapFile::MapIssue>& issues) : Issues(issues)
+			{
+
+			}
+
+			void Error(const std::string& message)
+			{
+				Issues.push_back({Cam::Shared::MapFile::MapIssue::SeverityType::Error, message});
+			}
+
+			void Warning(const std::string& message)
+			{
+				Issues.push_back({Cam::Shared::MapFile::MapIssue::SeverityType::Warning, message});
+			}
+
+		private:
+			std::vector<Cam::Shared::MapFile::MapIssue>& Issues;
+		};
+	}
+}
+
+bool Cam::Shared::MapFile::ReadBSPEntityNames(const char* path, EntityNames& names, std::string& error)
+{
+	std::vector<char> bytes;
+
+	if (!ReadAllBytes(path, bytes))
+	{
+		error = "Could not read game map";
+		return false;
+	}
+
+	LocalUtility::BSPHeader header;
+
+	if (bytes.size() < sizeof(header))
+	{
+		error = "Game map too small";
+		return false;
+	}
+
+	std::memcpy(&header, bytes.data(), sizeof(header));
+
+	if (header.Version != 29 && header.Version != 30)
+	{
+		error = "Not a Half-Life game map";
+		return false;
+	}
+
+	const auto& lump = header.Lumps[0];
+	auto filesize = static_cast<int64_t>(bytes.size() - 1);
+
+	if (lump.Offset < 0 || lump.Length < 0 || lump.Offset + static_cast<int64_t>(lump.Length) > filesize)
+	{
+		error = "Entity lump out of range";
+		return false;
+	}
+
+	const char* text = bytes.data() + lump.Offset;
+	auto end = text + lump.Length;
+
+	std::vector<std::pair<std::string, std::string>> keyvalues;
+
+	while (text < end)
+	{
+		text = static_cast<const char*>(std::memchr(text, '{', end - text));
+
+		if (!text)
+		{
+			break;
+		}
+
+		text++;
+
+		keyvalues.clear();
+		std::string classname;
+
+		std::string key;
+		std::string value;
+
+		while (LocalUtility::ReadToken(text, end, key) && LocalUtility::ReadToken(text, end, value))
+		{
+			if (key == "classname")
+			{
+				classname = value;
+			}
+
+			keyvalues.emplace_back(std::move(key), std::move(value));
+		}
+
+		for (auto& pair : keyvalues)
+		{
+			if (pair.first == "targetname")
+			{
+				names.TargetNames.insert(std::move(pair.second));
+				continue;
+			}
+
+			/*
+				Fixed keys can't name anything.
+			*/
+			if (pair.first == "classname" || pair.first == "origin" || pair.first == "angles" || pair.first == "model")
+			{
+				continue;
+			}
+
+			if (classname == "multi_manager")
+			{
+				/*
+					Keys repeated in one manager get "#n" appended.
+				*/
+				auto hash = pair.first.find('#');
+				names.References.insert(pair.first.substr(0, hash));
+			}
+
+			names.References.insert(std::move(pair.second));
+		}
+	}
+
+	return true;
+}
+
+void Cam::Shared::MapFile::CheckCamera(const MapCameraData& camera, const std::string& description, std::vector<MapIssue>& issues)
+{
+	LocalUtility::IssueList report(issues);
+
+	if (!LocalUtility::IsFinite(camera.Position) || !LocalUtility::IsFinite(camera.Angle) || !LocalUtility::IsFinite(camera.AttachmentOffset) ||
+		!std::isfinite(camera.MaxSpeed) || !std::isfinite(camera.ZoomTime) || !std::isfinite(camera.ZoomEndFOV))
+	{
+		report.Error(description + " has a value that is not a number");
+	}
+
+	if (camera.FOV == 0 || camera.FOV >= 180)
+	{
+		report.Error(description + " has a field of view of " + std::to_string(camera.FOV));
+	}
+
+	if (camera.TriggerType == CameraTriggerType::ByName && camera.Name.empty())
+	{
+		report.Error(description + " is fired by name but has none");
+	}
+
+	if (camera.LookType == CameraLookType::AtTarget && camera.LookTargetName.empty())
+	{
+		report.Error(description + " looks at a target but has no target name");
+	}
+
+	if (camera.UseAttachment && camera.AttachmentTargetName.empty())
+	{
+		report.Error(description + " is attached but has no attachment target name");
+	}
+}
+
+void Cam::Shared::MapFile::CheckMap(const MapData& map, const EntityNames* names, std::vector<MapIssue>& issues)
+{
+	LocalUtility::IssueList report(issues);
+
+	std::unordered_map<uint32_t, size_t> cameraids;
+	std::unordered_map<uint32_t, std::string> triggerids;
+	std::unordered_map<std::string, size_t> cameranames;
+
+	std::vector<std::pair<Utility::AABBTree::IDType, Utility::AABB>> boxes;
+
+	/*
+		Where each box came from, by its index in "boxes".
+	*/
+	struct TriggerPlace
+	{
+		size_t CameraIndex;
+		size_t TriggerIndex;
+	};
+
+	std::vector<TriggerPlace> places;
+
+	for (size_t i = 0; i < map.Cameras.size(); i++)
+	{
+		const auto& cam = map.Cameras[i];
+		auto camdesc = LocalUtility::DescribeCamera(i, cam);
+
+		if (cam.ID != InvalidMapID && cam.ID > MaxMapID)
+		{
+			report.Error(camdesc + " has the ID " + std::to_string(cam.ID) + " above the maximum of " + std::to_string(MaxMapID) + ", it is renumbered on load");
+		}
+
+		else if (cam.ID != InvalidMapID)
+		{
+			auto result = cameraids.emplace(cam.ID, i);
+
+			if (!result.second)
+			{
+				report.Error(camdesc + " has the same ID " + std::to_string(cam.ID) + " as camera " + std::to_string(result.first->second + 1) + ", journaled edits can go to either");
+			}
+		}
+
+		CheckCamera(cam, camdesc, issues);
+
+		if (cam.TriggerType == CameraTriggerType::ByName)
+		{
+			if (!cam.Name.empty())
+			{
+				auto result = cameranames.emplace(cam.Name, i);
+
+				if (!result.second)
+				{
+					report.Warning(camdesc + " has the same name as camera " + std::to_string(result.first->second + 1) + ", both are fired together");
+				}
+
+				if (names && names->References.find(cam.Name) == names->References.end())
+				{
+					report.Warning(camdesc + " is fired by name but nothing in the game map refers to it");
+				}
+			}
+		}
+
+		else if (cam.Triggers.empty())
+		{
+			report.Warning(camdesc + " has no triggers and can't be activated");
+		}
+
+		for (size_t j = 0; j < cam.Triggers.size(); j++)
+		{
+			const auto& trig = cam.Triggers[j];
+			auto trigdesc = LocalUtility::DescribeTrigger(i, cam, j);
+
+			if (trig.ID != InvalidMapID && trig.ID > MaxMapID)
+			{
+				report.Error(trigdesc + " has the ID " + std::to_string(trig.ID) + " above the maximum of " + std::to_string(MaxMapID) + ", it is renumbered on load");
+			}
+
+			else if (trig.ID != InvalidMapID)
+			{
+				auto result = triggerids.emplace(trig.ID, trigdesc);
+
+				if (!result.second)
+				{
+					report.Error(trigdesc + " has the same ID " + std::to_string(trig.ID) + " as " + result.first->second);
+				}
+			}
+
+			if (!LocalUtility::IsFinite(trig.Corner1) || !LocalUtility::IsFinite(trig.Corner2))
+			{
+				report.Error(trigdesc + " has a corner that is not a number");
+				continue;
+			}
+
+			auto box = LocalUtility::MakeBox(trig);
+
+			if (box.Min[0] >= box.Max[0] || box.Min[1] >= box.Max[1] || box.Min[2] >= box.Max[2])
+			{
+				report.Warning(trigdesc + " is flat and has no volume");
+				continue;
+			}
+
+			boxes.emplace_back(places.size(), box);
+			places.push_back({i, j});
+		}
+	}
+
+	/*
+		Camera names are given to the camera entities, so
+		other cameras can look at them as well.
+	*/
+	auto hasentity = [names, &cameranames](const std::string& name)
+	{
+		return names->TargetNames.find(name) != names->TargetNames.end() ||
+			   cameranames.find(name) != cameranames.end();
+	};
+
+	if (names)
+	{
+		for (size_t i = 0; i < map.Cameras.size(); i++)
+		{
+			const auto& cam = map.Cameras[i];
+
+			if (cam.LookType == CameraLookType::AtTarget && !cam.LookTargetName.empty() && !hasentity(cam.LookTargetName))
+			{
+				report.Warning(LocalUtility::DescribeCamera(i, cam) + " looks at \"" + cam.LookTargetName + "\" which is not in the game map");
+			}
+
+			if (cam.UseAttachment && !cam.AttachmentTargetName.empty() && !hasentity(cam.AttachmentTargetName))
+			{
+				report.Warning(LocalUtility::DescribeCamera(i, cam) + " is attached to \"" + cam.AttachmentTargetName + "\" which is not in the game map");
+			}
+		}
+	}
+
+	/*
+		Which of two overlapping cameras is used depends on which
+		trigger the player was in first. Overlaps within one camera
+		are harmless and left alone.
+	*/
+	Utility::AABBTree tree;
+	tree.Build(boxes);
+
+	for (size_t i = 0; i < boxes.size(); i++)
+	{
+		const auto& place = places[i];
+		const auto& box = boxes[i].second;
+
+		tree.QueryBox(box, [&](Utility::AABBTree::IDType other)
+		{
+			const auto& otherplace = places[other];
+
+			if (other <= i ||
+				otherplace.CameraIndex == place.CameraIndex ||
+				!LocalUtility::OverlapsInside(box, boxes[other].second))
+			{
+				return true;
+			}
+
+			const auto& cam = map.Cameras[place.CameraIndex];
+			const auto& othercam = map.Cameras[otherplace.CameraIndex];
+
+			report.Warning
+			(
+				LocalUtility::DescribeTrigger(place.CameraIndex, cam, place.TriggerIndex) + " overlaps " +
+				LocalUtility::DescribeTrigger(otherplace.CameraIndex, othercam, otherplace.TriggerIndex)
+			);
+
+			return true;
+		});
+	}
+}
@@ -0,0 +1,421 @@
+#include "Shared/Map/MapFile.hpp"
+#include "Shared/Map/MapSchema.hpp"
+
+#include "rapidjson/document.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/prettywriter.h"
+
+namespace
+{
+	namespace LocalUtility
+	{
+		using namespace Cam::Shared;
+
+		using AllocatorType = rapidjson::Document::AllocatorType;
+
+		const char* ToString(CameraAngleType type)
+		{
+			return CameraAngleTypeToString(type);
+		}
+
+		const char* ToString(CameraLookType type)
+		{
+			return CameraLookTypeToString(type);
+		}
+
+		const char* ToString(CameraPlaneType type)
+		{
+			return CameraPlaneTypeToString(type);
+		}
+
+		const char* ToString(CameraTriggerType type)
+		{
+			return CameraTriggerTypeToString(type);
+		}
+
+		const char* ToString(CameraZoomType type)
+		{
+			return CameraZoomTypeToString(type);
+		}
+
+		void FromString(const char* string, CameraAngleType& type)
+		{
+			type = CameraAngleTypeFromString(string);
+		}
+
+		void FromString(const char* string, CameraLookType& type)
+		{
+			type = CameraLookTypeFromString(string);
+		}
+
+		void FromString(const char* string, CameraPlaneType& type)
+		{
+			type = CameraPlaneTypeFromString(string);
+		}
+
+		void FromString(const char* string, CameraTriggerType& type)
+		{
+			type = CameraTriggerTypeFromString(string);
+		}
+
+		void FromString(const char* string, CameraZoomType& type)
+		{
+			type = CameraZoomTypeFromString(string);
+		}
+
+		/*
+			A value of the wrong type reads as missing. "error" is only
+			set by records inside arrays, for their own missing fields.
+		*/
+		bool ReadValue(const rapidjson::Value& value, uint32_t& output, std::string& error)
+		{
+			if (value.IsUint())
+			{
+				output = value.GetUint();
+				return true;
+			}
+
+			/*
+				Older maps can have fractional FOVs.
+			*/
+			if (value.IsNumber() && value.GetDouble() >= 0)
+			{
+				output = static_cast<uint32_t>(value.GetDouble());
+				return true;
+			}
+
+			return false;
+		}
+
+		bool ReadValue(const rapidjson::Value& value, float& output, std::string& error)
+		{
+			if (!value.IsNumber())
+			{
+				return false;
+			}
+
+			output = static_cast<float>(value.GetDouble());
+			return true;
+		}
+
+		bool ReadValue(const rapidjson::Value& value, bool& output, std::string& error)
+		{
+			if (!value.IsBool())
+			{
+				return false;
+			}
+
+			output = value.GetBool();
+			return true;
+		}
+
+		bool ReadValue(const rapidjson::Value& value, MapVector& output, std::string& error)
+		{
+			if (!value.IsArray() || value.Size() < 3 ||
+				!value[0].IsNumber() || !value[1].IsNumber() || !value[2].IsNumber())
+			{
+				return false;
+			}
+
+			output.X = static_cast<float>(value[0].GetDouble());
+			output.Y = static_cast<float>(value[1].GetDouble());
+			output.Z = static_cast<float>(value[2].GetDouble());
+
+			return true;
+		}
+
+		bool ReadValue(const rapidjson::Value& value, std::string& output, std::string& error)
+		{
+			if (!value.IsString())
+			{
+				return false;
+			}
+
+			output.assign(value.GetString(), value.GetStringLength());
+			return true;
+		}
+
+		template <typename T>
+		typename std::enable_if<std::is_enum<T>::value, bool>::type ReadValue(const rapidjson::Value& value, T& output, std::string& error)
+		{
+			if (!value.IsString())
+			{
+				return false;
+			}
+
+			FromString(value.GetString(), output);
+			return true;
+		}
+
+		template <typename T>
+		bool ReadValue(const rapidjson::Value& value, std::vector<T>& output, std::string& error);
+
+		rapidjson::Value WriteValue(uint32_t value, AllocatorType& alloc)
+		{
+			return rapidjson::Value(value);
+		}
+
+		rapidjson::Value WriteValue(float value, AllocatorType& alloc)
+		{
+			return rapidjson::Value(value);
+		}
+
+		rapidjson::Value WriteValue(bool value, AllocatorType& alloc)
+		{
+			return rapidjson::Value(value);
+		}
+
+		rapidjson::Value WriteValue(const MapVector& vector, AllocatorType& alloc)
+		{
+			rapidjson::Value ret(rapidjson::kArrayType);
+
+			ret.PushBack(vector.X, alloc);
+			ret.PushBack(vector.Y, alloc);
+			ret.PushBack(vector.Z, alloc);
+
+			return ret;
+		}
+
+		rapidjson::Value WriteValue(const std::string& value, AllocatorType& alloc)
+		{
+			return rapidjson::Value(value.c_str(), static_cast<rapidjson::SizeType>(value.size()), alloc);
+		}
+
+		template <typename T>
+		typename std::enable_if<std::is_enum<T>::value, rapidjson::Value>::type WriteValue(T value, AllocatorType& alloc)
+		{
+			return rapidjson::Value(ToString(value), alloc);
+		}
+
+		template <typename T>
+		rapidjson::Value WriteValue(const std::vector<T>& values, AllocatorType& alloc);
+
+		/*
+			IDs are optional, maps written before they were stored have none.
+		*/
+		bool IsUnset(uint32_t value, unsigned flags)
+		{
+			return (flags & Schema::OptionalID) && value == InvalidMapID;
+		}
+
+		template <typename T>
+		bool IsUnset(const T& value, unsigned flags)
+		{
+			return false;
+		}
+
+		template <typename T>
+		bool ReadRecord(const rapidjson::Value& value, T& record, std::string& error)
+		{
+			using RecordType = Schema::Record<T>;
+
+			if (!value.IsObject())
+			{
+				error = "Malformed \"";
+				error += RecordType::GetName();
+				error += "\" entry";
+
+				return false;
+			}
+
+			auto ret = true;
+
+			RecordType::ForEach([&value, &record, &error, &ret](const auto& field)
+			{
+				if (!ret || !Schema::IsPresent(field, record))
+				{
+					return;
+				}
+
+				const auto& itr = value.FindMember(field.Name);
+
+				if (itr != value.MemberEnd() && ReadValue(itr->value, record.*field.Member, error))
+				{
+					return;
+				}
+
+				if (!error.empty())
+				{
+					ret = false;
+				}
+
+				else if (field.Flags & Schema::Required)
+				{
+					error = "Missing \"";
+					error += field.Name;
+					error += "\" entry in \"";
+					error += RecordType::GetName();
+					error += "\"";
+
+					ret = false;
+				}
+			});
+
+			return ret;
+		}
+
+		template <typename T>
+		rapidjson::Value WriteRecord(const T& record, AllocatorType& alloc)
+		{
+			rapidjson::Value ret(rapidjson::kObjectType);
+
+			Schema::Record<T>::ForEach([&record, &alloc, &ret](const auto& field)
+			{
+				const auto& value = record.*field.Member;
+
+				if (Schema::IsPresent(field, record) && !IsUnset(value, field.Flags))
+				{
+					ret.AddMember(rapidjson::StringRef(field.Name), WriteValue(value, alloc), alloc);
+				}
+			});
+
+			return ret;
+		}
+
+		template <typename T>
+		bool ReadValue(const rapidjson::Value& value, std::vector<T>& output, std::string& error)
+		{
+			if (!value.IsArray())
+			{
+				return false;
+			}
+
+			output.reserve(value.Size());
+
+			for (auto itr = value.Begin(); itr != value.End(); ++itr)
+			{
+				T entry;
+
+				if (!ReadRecord(*itr, entry, error))
+				{
+					return false;
+				}
+
+				output.push_back(std::move(entry));
+			}
+
+			return true;
+		}
+
+		template <typename T>
+		rapidjson::Value WriteValue(const std::vector<T>& values, AllocatorType& alloc)
+		{
+			rapidjson::Value ret(rapidjson::kArrayType);
+
+			for (const auto& entry : values)
+			{
+				ret.PushBack(WriteRecord(entry, alloc), alloc);
+			}
+
+			return ret;
+		}
+
+		bool ReadCamera(const rapidjson::Value& camval, MapCameraData& curcam, std::string& error)
+		{
+			/*
+				Cameras without a trigger list were named ones
+				before the trigger type was stored.
+			*/
+			if (camval.IsObject() && camval.FindMember("Triggers") == camval.MemberEnd())
+			{
+				curcam.TriggerType = CameraTriggerType::ByName;
+			}
+
+			return ReadRecord(camval, curcam, error);
+		}
+	}
+}
+
+bool Cam::Shared::MapFile::ReadJSONUnnumbered(const char* text, MapData& map, std::string& error)
+{
+	rapidjson::Document document;
+
+	document.Parse(text);
+
+	if (document.HasParseError() || !document.IsObject())
+	{
+		error = "Malformed JSON";
+		return false;
+	}
+
+	const auto& entitr = document.FindMember("Entities");
+
+	if (entitr == document.MemberEnd() || !entitr->value.IsArray())
+	{
+		error = "Missing \"Entities\" array";
+		return false;
+	}
+
+	map.Cameras.reserve(map.Cameras.size() + entitr->value.Size());
+
+	auto success = true;
+
+	for (auto entryit = entitr->value.Begin(); entryit != entitr->value.End(); ++entryit)
+	{
+		const auto& entryval = *entryit;
+
+		const auto& camit = entryval.FindMember("Camera");
+
+		if (camit == entryval.MemberEnd())
+		{
+			error = "Missing \"Camera\" array entry";
+			success = false;
+
+			break;
+		}
+
+		MapCameraData curcam;
+
+		if (!LocalUtility::ReadCamera(camit->value, curcam, error))
+		{
+			success = false;
+			break;
+		}
+
+		map.Cameras.push_back(std::move(curcam));
+	}
+
+	return success;
+}
+
+bool Cam::Shared::MapFile::ReadJSON(const char* text, MapData& map, std::string& error)
+{
+	auto success = ReadJSONUnnumbered(text, map, error);
+
+	/*
+		Also for a partial read, what was loaded is still used.
+	*/
+	AssignIDs(map);
+
+	return success;
+}
+
+std::string Cam::Shared::MapFile::WriteJSON(const MapData& map)
+{
+	rapidjson::Document document;
+	document.SetObject();
+
+	auto& alloc = document.GetAllocator();
+
+	rapidjson::Value root(rapidjson::kArrayType);
+
+	for (const auto& cam : map.Cameras)
+	{
+		rapidjson::Value thisvalue(rapidjson::kObjectType);
+
+		auto cameraval = LocalUtility::WriteRecord(cam, alloc);
+
+		thisvalue.AddMember("Camera", std::move(cameraval), alloc);
+
+		root.PushBack(std::move(thisvalue), alloc);
+	}
+
+	document.AddMember("Entities", std::move(root), alloc);
+
+	rapidjson::StringBuffer buffer;
+	rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+
+	document.Accept(writer);
+
+	return {buffer.GetString(), buffer.GetSize()};
+}
@@ -0,0 +1,731 @@
+#include "Shared/Map/MapJournal.hpp"
+#include "Shared/Map/MapWriter.hpp"
+#include "Shared/Binary Buffer/BinaryBuffer.hpp"
+#include <cstring>
+#include <cstdio>
+#include <unordered_map>
+
+namespace
+{
+	namespace LocalUtility
+	{
+		using RecordType = Cam::Shared::MapFile::Journal::RecordType;
+
+		/*
+			FNV-1a, only has to catch torn and damaged writes.
+		*/
+		uint32_t Checksum(uint8_t type, const char* data, size_t size)
+		{
+			uint32_t ret = 2166136261u;
+
+			ret = (ret ^ type) * 16777619u;
+
+			for (size_t i = 0; i < size; i++)
+			{
+				ret = (ret ^ static_cast<uint8_t>(data[i])) * 16777619u;
+			}
+
+			return ret;
+		}
+
+		void WriteVector(Utility::BinaryBuffer& buffer, const Cam::Shared::MapVector& vector)
+		{
+			buffer << vector.X;
+			buffer << vector.Y;
+			buffer << vector.Z;
+		}
+
+		void ReadVector(Utility::BinaryBuffer& buffer, Cam::Shared::MapVector& vector)
+		{
+			buffer >> vector.X;
+			buffer >> vector.Y;
+			buffer >> vector.Z;
+		}
+
+		void WriteCamera(Utility::BinaryBuffer& buffer, const Cam::Shared::MapCameraData& camera)
+		{
+			buffer << camera.ID;
+
+			WriteVector(buffer, camera.Position);
+			WriteVector(buffer, camera.Angle);
+
+			buffer << camera.Name;
+
+			buffer << static_cast<uint8_t>(camera.TriggerType);
+			buffer << static_cast<uint8_t>(camera.LookType);
+			buffer << static_cast<uint8_t>(camera.PlaneType);
+			buffer << static_cast<uint8_t>(camera.ZoomType);
+
+			buffer << camera.FOV;
+			buffer << camera.MaxSpeed;
+
+			buffer << camera.ZoomTime;
+			buffer << camera.ZoomEndFOV;
+			buffer << static_cast<uint8_t>(camera.ZoomInterpMethod);
+
+			buffer << camera.LookTargetName;
+
+			buffer << camera.UseAttachment;
+			buffer << camera.AttachmentTargetName;
+			WriteVector(buffer, camera.AttachmentOffset);
+		}
+
+		bool ReadCamera(Utility::BinaryBuffer& buffer, Cam::Shared::MapCameraData& camera)
+		{
+			using namespace Cam::Shared;
+
+			buffer >> camera.ID;
+
+			ReadVector(buffer, camera.Position);
+			ReadVector(buffer, camera.Angle);
+
+			buffer >> camera.Name;
+
+			auto triggertype = buffer.GetValue<uint8_t>();
+			auto looktype = buffer.GetValue<uint8_t>();
+			auto planetype = buffer.GetValue<uint8_t>();
+			auto zoomtype = buffer.GetValue<uint8_t>();
+
+			buffer >> camera.FOV;
+			buffer >> camera.MaxSpeed;
+
+			buffer >> camera.ZoomTime;
+			buffer >> camera.ZoomEndFOV;
+			auto interpmethod = buffer.GetValue<uint8_t>();
+
+			buffer >> camera.LookTargetName;
+
+			buffer >> camera.UseAttachment;
+			buffer >> camera.AttachmentTargetName;
+			ReadVector(buffer, camera.AttachmentOffset);
+
+			if (triggertype > static_cast<uint8_t>(CameraTriggerType::ByUserTrigger) ||
+				looktype > static_cast<uint8_t>(CameraLookType::AtTarget) ||
+				planetype > static_cast<uint8_t>(CameraPlaneType::Both) ||
+				zoomtype > static_cast<uint8_t>(CameraZoomType::ZoomByDistance) ||
+				interpmethod > static_cast<uint8_t>(CameraAngleType::Exponential))
+			{
+				return false;
+			}
+
+			camera.TriggerType = static_cast<CameraTriggerType>(triggertype);
+			camera.LookType = static_cast<CameraLookType>(looktype);
+			camera.PlaneType = static_cast<CameraPlaneType>(planetype);
+			camera.ZoomType = static_cast<CameraZoomType>(zoomtype);
+			camera.ZoomInterpMethod = static_cast<CameraAngleType>(interpmethod);
+
+			return buffer.GetReadPosition() == buffer.GetSize();
+		}
+
+		bool HasValidHeader(const std::vector<char>& bytes, size_t size)
+		{
+			namespace Journal = Cam::Shared::MapFile::Journal;
+
+			if (size < sizeof(Journal::Header))
+			{
+				return false;
+			}
+
+			Journal::Header header;
+			std::memcpy(&header, bytes.data(), sizeof(header));
+
+			return std::memcmp(header.Magic, Journal::Magic, sizeof(header.Magic)) == 0 &&
+				   header.Version == Journal::Version;
+		}
+
+		/*
+			Calls "func" with every intact record until one is damaged or "func"
+			returns false. Returns the size of the records that were accepted.
+		*/
+		template <typename Func>
+		size_t ForEachRecord(const char* data, size_t size, Func&& func)
+		{
+			namespace Journal = Cam::Shared::MapFile::Journal;
+
+			size_t pos = 0;
+
+			while (size - pos >= Journal::RecordHeaderSize)
+			{
+				uint32_t checksum;
+				uint16_t length;
+				uint8_t type;
+
+				std::memcpy(&checksum, data + pos, sizeof(checksum));
+				std::memcpy(&length, data + pos + 4, sizeof(length));
+				std::memcpy(&type, data + pos + 6, sizeof(type));
+
+				if (size - pos - Journal::RecordHeaderSize < length)
+				{
+					break;
+				}
+
+				auto payload = data + pos + Journal::RecordHeaderSize;
+
+				if (Checksum(type, payload, length) != checksum)
+				{
+					break;
+				}
+
+				if (!func(static_cast<RecordType>(type), payload, length))
+				{
+					break;
+				}
+
+				pos += Journal::RecordHeaderSize + length;
+			}
+
+			return pos;
+		}
+
+		/*
+			Applies records to a map, cameras and triggers are found by ID.
+		*/
+		class Replayer
+		{
+		public:
+			Replayer(Cam::Shared::MapData& map) :
+				Map(map)
+			{
+				BuildIndex();
+			}
+
+			bool Apply(RecordType type, const char* payload, size_t size)
+			{
+				Utility::BinaryBuffer buffer(payload, size);
+
+				switch (type)
+				{
+					case RecordType::SetCamera:
+					{
+						Cam::Shared::MapCameraData camera;
+
+						if (!ReadCamera(buffer, camera) || camera.ID > Cam::Shared::MaxMapID)
+						{
+							return false;
+						}
+
+						SetCamera(std::move(camera));
+						return true;
+					}
+
+					case RecordType::RemoveCamera:
+					{
+						auto id = buffer.GetValue<uint32_t>();
+
+						if (buffer.GetReadPosition() != buffer.GetSize())
+						{
+							return false;
+						}
+
+						RemoveCamera(id);
+						return true;
+					}
+
+					case RecordType::SetTrigger:
+					{
+						auto cameraid = buffer.GetValue<uint32_t>();
+
+						Cam::Shared::MapTriggerData trigger;
+
+						buffer >> trigger.ID;
+						ReadVector(buffer, trigger.Corner1);
+						ReadVector(buffer, trigger.Corner2);
+
+						if (buffer.GetReadPosition() != buffer.GetSize() || trigger.ID > Cam::Shared::MaxMapID)
+						{
+							return false;
+						}
+
+						SetTrigger(cameraid, trigger);
+						return true;
+					}
+
+					case RecordType::RemoveTrigger:
+					{
+						auto id = buffer.GetValue<uint32_t>();
+
+						if (buffer.GetReadPosition() != buffer.GetSize())
+						{
+							return false;
+						}
+
+						RemoveTrigger(id);
+						return true;
+					}
+				}
+
+				return false;
+			}
+
+		private:
+			void BuildIndex()
+			{
+				CameraIndex.clear();
+				TriggerCameras.clear();
+
+				for (size_t i = 0; i < Map.Cameras.size(); i++)
+				{
+					const auto& cam = Map.Cameras[i];
+
+					CameraIndex[cam.ID] = i;
+
+					for (const auto& trig : cam.Triggers)
+					{
+						TriggerCameras[trig.ID] = cam.ID;
+					}
+				}
+			}
+
+			Cam::Shared::MapCameraData* FindCamera(uint32_t id)
+			{
+				auto it = CameraIndex.find(id);
+
+				if (it == CameraIndex.end())
+				{
+					return nullptr;
+				}
+
+				return &Map.Cameras[it->second];
+			}
+
+			void SetCamera(Cam::Shared::MapCameraData&& camera)
+			{
+				auto existing = FindCamera(camera.ID);
+
+				if (existing)
+				{
+					camera.Triggers = std::move(existing->Triggers);
+					*existing = std::move(camera);
+
+					return;
+				}
+
+				CameraIndex[camera.ID] = Map.Cameras.size();
+				Map.Cameras.push_back(std::move(camera));
+			}
+
+			void RemoveCamera(uint32_t id)
+			{
+				auto it = CameraIndex.find(id);
+
+				if (it == CameraIndex.end())
+				{
+					return;
+				}
+
+				Map.Cameras.erase(Map.Cameras.begin() + it->second);
+
+				/*
+					Removals are rare next to edits, positions after
+					the removed camera have all moved down by one.
+				*/
+				BuildIndex();
+			}
+
+			void SetTrigger(uint32_t cameraid, const Cam::Shared::MapTriggerData& trigger)
+			{
+				auto camera = FindCamera(cameraid);
+
+				if (!camera)
+				{
+					return;
+				}
+
+				auto previous = TriggerCameras.find(trigger.ID);
+
+				if (previous != TriggerCameras.end() && previous->second == cameraid)
+				{
+					for (auto& trig : camera->Triggers)
+					{
+						if (trig.ID == trigger.ID)
+						{
+							trig = trigger;
+							return;
+						}
+					}
+				}
+
+				RemoveTrigger(trigger.ID);
+
+				camera->Triggers.push_back(trigger);
+				TriggerCameras[trigger.ID] = cameraid;
+			}
+
+			void RemoveTrigger(uint32_t id)
+			{
+				auto it = TriggerCameras.find(id);
+
+				if (it == TriggerCameras.end())
+				{
+					return;
+				}
+
+				auto camera = FindCamera(it->second);
+
+				if (camera)
+				{
+					auto& triggers = camera->Triggers;
+
+					for (auto trigit = triggers.begin(); trigit != triggers.end(); ++trigit)
+					{
+						if (trigit->ID == id)
+						{
+							triggers.erase(trigit);
+							break;
+						}
+					}
+				}
+
+				TriggerCameras.erase(it);
+			}
+
+			Cam::Shared::MapData& Map;
+
+			std::unordered_map<uint32_t, size_t> CameraIndex;
+			std::unordered_map<uint32_t, uint32_t> TriggerCameras;
+		};
+	}
+}
+
+const char Cam::Shared::MapFile::Journal::Magic[4] = {'H', 'L', 'C', 'J'};
+
+bool Cam::Shared::MapFile::JournalWriter::Open(const char* path)
+{
+	Close();
+
+	std::vector<char> bytes;
+
+	if (!ReadAllBytes(path, bytes))
+	{
+		Path = path;
+		return true;
+	}
+
+	/*
+		Without the null terminator ReadAllBytes adds.
+	*/
+	auto size = bytes.size() - 1;
+
+	size_t validsize = 0;
+
+	if (LocalUtility::HasValidHeader(bytes, size))
+	{
+		auto records = bytes.data() + sizeof(Journal::Header);
+
+		/*
+			Parsed the same as a replay would so a malformed record
+			is cut off too, nothing after it would ever be read.
+		*/
+		MapData scratch;
+		LocalUtility::Replayer checker(scratch);
+
+		validsize = LocalUtility::ForEachRecord(records, size - sizeof(Journal::Header), [this, &checker](Journal::RecordType type, const char* payload, size_t length)
+		{
+			if (!checker.Apply(type, payload, length))
+			{
+				return false;
+			}
+
+			RecordCount++;
+			RecordBytes += Journal::RecordHeaderSize + length;
+
+			return true;
+		});
+
+		validsize += sizeof(Journal::Header);
+	}
+
+	if (validsize != size)
+	{
+		/*
+			An unreadable header leaves nothing worth keeping.
+		*/
+		if (validsize == 0)
+		{
+			Journal::Header header;
+			std::memcpy(header.Magic, Journal::Magic, sizeof(header.Magic));
+			header.Version = Journal::Version;
+
+			bytes.resize(sizeof(header));
+			std::memcpy(bytes.data(), &header, sizeof(header));
+
+			validsize = sizeof(header);
+
+			RecordCount = 0;
+			RecordBytes = 0;
+		}
+
+		if (!WriteAllBytesAtomic(path, bytes.data(), validsize))
+		{
+			return false;
+		}
+	}
+
+	Path = path;
+	return true;
+}
+
+void Cam::Shared::MapFile::JournalWriter::Close()
+{
+	if (File.is_open())
+	{
+		File.close();
+	}
+
+	File.clear();
+
+	Path.clear();
+
+	RecordCount = 0;
+	RecordBytes = 0;
+}
+
+bool Cam::Shared::MapFile::JournalWriter::IsOpen() const
+{
+	return !Path.empty();
+}
+
+bool Cam::Shared::MapFile::JournalWriter::SetCamera(const MapCameraData& camera)
+{
+	Utility::BinaryBuffer buffer;
+	LocalUtility::WriteCamera(buffer, camera);
+
+	return Append(Journal::RecordType::SetCamera, buffer.GetData(), buffer.GetSize());
+}
+
+bool Cam::Shared::MapFile::JournalWriter::RemoveCamera(uint32_t id)
+{
+	return Append(Journal::RecordType::RemoveCamera, &id, sizeof(id));
+}
+
+bool Cam::Shared::MapFile::JournalWriter::SetTrigger(uint32_t cameraid, const MapTriggerData& trigger)
+{
+	Utility::BinaryBuffer buffer;
+
+	buffer << cameraid;
+	buffer << trigger.ID;
+	LocalUtility::WriteVector(buffer, trigger.Corner1);
+	LocalUtility::WriteVector(buffer, trigger.Corner2);
+
+	return Append(Journal::RecordType::SetTrigger, buffer.GetData(), buffer.GetSize());
+}
+
+bool Cam::Shared::MapFile::JournalWriter::RemoveTrigger(uint32_t id)
+{
+	return Append(Journal::RecordType::RemoveTrigger, &id, sizeof(id));
+}
+
+bool Cam::Shared::MapFile::JournalWriter::Append(Journal::RecordType type, const void* payload, size_t size)
+{
+	if (Path.empty() || size > 0xFFFF)
+	{
+		return false;
+	}
+
+	if (!File.is_open())
+	{
+		FileStamp stamp;
+		auto isnew = !GetFileStamp(Path.c_str(), stamp) || stamp.Size == 0;
+
+		File.clear();
+		File.open(Path, std::ios::binary | std::ios::app);
+
+		if (!File)
+		{
+			File.close();
+			return false;
+		}
+
+		if (isnew)
+		{
+			Journal::Header header;
+			std::memcpy(header.Magic, Journal::Magic, sizeof(header.Magic));
+			header.Version = Journal::Version;
+
+			File.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		}
+	}
+
+	auto data = static_cast<const char*>(payload);
+
+	auto typevalue = static_cast<uint8_t>(type);
+	auto length = static_cast<uint16_t>(size);
+	auto checksum = LocalUtility::Checksum(typevalue, data, size);
+
+	char recordheader[Journal::RecordHeaderSize];
+
+	std::memcpy(recordheader, &checksum, sizeof(checksum));
+	std::memcpy(recordheader + 4, &length, sizeof(length));
+	std::memcpy(recordheader + 6, &typevalue, sizeof(typevalue));
+
+	File.write(recordheader, sizeof(recordheader));
+	File.write(data, size);
+
+	/*
+		Handed to the OS right away so the edit survives the game crashing.
+	*/
+	File.flush();
+
+	if (!File)
+	{
+		File.close();
+		return false;
+	}
+
+	RecordCount++;
+	RecordBytes += sizeof(recordheader) + size;
+
+	return true;
+}
+
+bool Cam::Shared::MapFile::JournalWriter::Rotate(const char* oldpath)
+{
+	if (Path.empty())
+	{
+		return false;
+	}
+
+	if (File.is_open())
+	{
+		File.close();
+	}
+
+	File.clear();
+
+	if (RecordCount == 0)
+	{
+		return true;
+	}
+
+	FileStamp stamp;
+
+	if (!GetFileStamp(oldpath, stamp))
+	{
+		if (std::rename(Path.c_str(), oldpath) != 0)
+		{
+			return false;
+		}
+	}
+
+	else
+	{
+		/*
+			A save before this one has not finished. The old journal is
+			rewritten whole rather than appended to, so a damaged tail
+			in it cannot hide the records added after it.
+		*/
+		std::vector<char> current;
+		std::vector<char> old;
+
+		if (!ReadAllBytes(Path.c_str(), current) || !ReadAllBytes(oldpath, old))
+		{
+			return false;
+		}
+
+		auto currentsize = current.size() - 1;
+		auto oldsize = old.size() - 1;
+
+		if (!LocalUtility::HasValidHeader(current, currentsize))
+		{
+			return false;
+		}
+
+		size_t keep = sizeof(Journal::Header);
+
+		if (LocalUtility::HasValidHeader(old, oldsize))
+		{
+			keep += LocalUtility::ForEachRecord(old.data() + keep, oldsize - keep, [](Journal::RecordType, const char*, size_t)
+			{
+				return true;
+			});
+		}
+
+		else
+		{
+			std::memcpy(old.data(), current.data(), sizeof(Journal::Header));
+		}
+
+		old.resize(keep);
+		old.insert(old.end(), current.begin() + sizeof(Journal::Header), current.begin() + currentsize);
+
+		if (!WriteAllBytesAtomic(oldpath, old.data(), old.size()))
+		{
+			return false;
+		}
+
+		std::remove(Path.c_str());
+	}
+
+	RecordCount = 0;
+	RecordBytes = 0;
+
+	return true;
+}
+
+size_t Cam::Shared::MapFile::JournalWriter::GetRecordCount() const
+{
+	return RecordCount;
+}
+
+uint64_t Cam::Shared::MapFile::JournalWriter::GetRecordBytes() const
+{
+	return RecordBytes;
+}
+
+bool Cam::Shared::MapFile::ReplayJournal(const char* path, MapData& map, size_t& records, std::string& error)
+{
+	records = 0;
+
+	std::vector<char> bytes;
+
+	if (!ReadAllBytes(path, bytes))
+	{
+		return true;
+	}
+
+	auto size = bytes.size() - 1;
+
+	if (size == 0)
+	{
+		return true;
+	}
+
+	if (!LocalUtility::HasValidHeader(bytes, size))
+	{
+		error = "Not a camera map journal";
+		return false;
+	}
+
+	LocalUtility::Replayer replayer(map);
+
+	auto malformed = false;
+
+	auto data = bytes.data() + sizeof(Journal::Header);
+	auto datasize = size - sizeof(Journal::Header);
+
+	auto end = LocalUtility::ForEachRecord(data, datasize, [&](Journal::RecordType type, const char* payload, size_t length)
+	{
+		if (!replayer.Apply(type, payload, length))
+		{
+			malformed = true;
+			return false;
+		}
+
+		records++;
+		return true;
+	});
+
+	if (malformed)
+	{
+		error = "Malformed journal record";
+		return false;
+	}
+
+	if (end != datasize)
+	{
+		error = "Damaged journal record";
+		return false;
+	}
+
+	return true;
+}
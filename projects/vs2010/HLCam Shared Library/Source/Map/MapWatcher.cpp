@@ -0,0 +1,101 @@
+#include "Shared/Map/MapWatcher.hpp"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+Cam::Shared::MapFile::DirectoryWatcher::~DirectoryWatcher()
+{
+	Stop();
+}
+
+bool Cam::Shared::MapFile::DirectoryWatcher::Start(const char* directory)
+{
+	Stop();
+
+	#ifdef __linux__
+	Handle = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+	if (Handle < 0)
+	{
+		return false;
+	}
+
+	/*
+		Saves replace the file with a renamed temporary one, editors
+		either do the same or write in place.
+	*/
+	if (inotify_add_watch(Handle, directory, IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+	{
+		Stop();
+		return false;
+	}
+
+	return true;
+	#else
+	return false;
+	#endif
+}
+
+void Cam::Shared::MapFile::DirectoryWatcher::Stop()
+{
+	#ifdef __linux__
+	if (Handle >= 0)
+	{
+		close(Handle);
+	}
+	#endif
+
+	Handle = -1;
+}
+
+bool Cam::Shared::MapFile::DirectoryWatcher::IsStarted() const
+{
+	return Handle >= 0;
+}
+
+void Cam::Shared::MapFile::DirectoryWatcher::Poll(std::vector<std::string>& names)
+{
+	#ifdef __linux__
+	if (Handle < 0)
+	{
+		return;
+	}
+
+	alignas(inotify_event) char buffer[4096];
+
+	while (true)
+	{
+		auto size = read(Handle, buffer, sizeof(buffer));
+
+		if (size <= 0)
+		{
+			if (size < 0 && errno == EINTR)
+			{
+				continue;
+			}
+
+			break;
+		}
+
+		for (ssize_t offset = 0; offset < size;)
+		{
+			auto event = reinterpret_cast<const inotify_event*>(buffer + offset);
+
+			if (event->mask & IN_Q_OVERFLOW)
+			{
+				names.emplace_back();
+			}
+
+			else if (event->len != 0)
+			{
+				names.emplace_back(event->name);
+			}
+
+			offset += sizeof(inotify_event) + event->len;
+		}
+	}
+	#endif
+}
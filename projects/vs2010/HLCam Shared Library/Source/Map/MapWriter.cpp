@@ -0,0 +1,261 @@
+#include "Shared/Map/MapWriter.hpp"
+#include <cstdio>
+#include <fstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#endif
+
+bool Cam::Shared::MapFile::WriteAllBytesAtomic(const char* path, const char* data, size_t size)
+{
+	std::string temppath = path;
+	temppath += ".tmp";
+
+	{
+		std::ofstream file(temppath, std::ios::binary | std::ios::trunc);
+
+		if (!file)
+		{
+			return false;
+		}
+
+		file.write(data, size);
+		file.flush();
+
+		if (!file)
+		{
+			file.close();
+			std::remove(temppath.c_str());
+
+			return false;
+		}
+	}
+
+	#ifdef _WIN32
+	auto flags = MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH;
+
+	if (!MoveFileExA(temppath.c_str(), path, flags))
+	{
+		DeleteFileA(temppath.c_str());
+		return false;
+	}
+	#else
+	if (std::rename(temppath.c_str(), path) != 0)
+	{
+		std::remove(temppath.c_str());
+		return false;
+	}
+	#endif
+
+	return true;
+}
+
+Cam::Shared::MapFile::AsyncWriter::~AsyncWriter()
+{
+	Stop();
+}
+
+void Cam::Shared::MapFile::AsyncWriter::Queue(SaveRequest&& request)
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+
+	Job job;
+	job.Request = std::move(request);
+	job.QueueTime = ClockType::now();
+
+	auto replaced = false;
+
+	for (auto& pending : Jobs)
+	{
+		if (pending.Request.JSONPath == job.Request.JSONPath)
+		{
+			pending = std::move(job);
+			replaced = true;
+
+			break;
+		}
+	}
+
+	if (replaced)
+	{
+		CurrentStats.Replaced++;
+	}
+
+	else
+	{
+		Jobs.push_back(std::move(job));
+		CurrentStats.InFlight++;
+	}
+
+	if (!WorkerThread.joinable())
+	{
+		ShouldStop = false;
+		WorkerThread = std::thread(&AsyncWriter::Worker, this);
+	}
+
+	WorkCondition.notify_one();
+}
+
+bool Cam::Shared::MapFile::AsyncWriter::PopResult(SaveResult& result)
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+
+	if (Results.empty())
+	{
+		return false;
+	}
+
+	result = std::move(Results.front());
+	Results.pop_front();
+
+	return true;
+}
+
+Cam::Shared::MapFile::AsyncWriter::Stats Cam::Shared::MapFile::AsyncWriter::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	return CurrentStats;
+}
+
+void Cam::Shared::MapFile::AsyncWriter::ResetStats()
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+
+	auto inflight = CurrentStats.InFlight;
+
+	CurrentStats = Stats();
+	CurrentStats.InFlight = inflight;
+}
+
+void Cam::Shared::MapFile::AsyncWriter::Flush()
+{
+	std::unique_lock<std::mutex> lock(Mutex);
+
+	IdleCondition.wait(lock, [this]
+	{
+		return Jobs.empty() && !Writing;
+	});
+}
+
+void Cam::Shared::MapFile::AsyncWriter::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		ShouldStop = true;
+	}
+
+	WorkCondition.notify_one();
+
+	if (WorkerThread.joinable())
+	{
+		WorkerThread.join();
+	}
+}
+
+void Cam::Shared::MapFile::AsyncWriter::Worker()
+{
+	std::unique_lock<std::mutex> lock(Mutex);
+
+	while (true)
+	{
+		WorkCondition.wait(lock, [this]
+		{
+			return ShouldStop || !Jobs.empty();
+		});
+
+		/*
+			Pending saves are still written when stopping.
+		*/
+		if (Jobs.empty())
+		{
+			return;
+		}
+
+		auto job = std::move(Jobs.front());
+		Jobs.pop_front();
+
+		Writing = true;
+		lock.unlock();
+
+		const auto& request = job.Request;
+
+		auto text = WriteJSON(request.Map);
+		auto success = WriteAllBytesAtomic(request.JSONPath.c_str(), text.data(), text.size());
+
+		/*
+			Stamped with the JSON just written so both stay in sync.
+		*/
+		FileStamp stamp;
+
+		if (success && !request.BinaryPath.empty() && GetFileStamp(request.JSONPath.c_str(), stamp))
+		{
+			std::vector<char> binary;
+			Binary::Write(request.Map, stamp, binary);
+
+			success = WriteAllBytesAtomic(request.BinaryPath.c_str(), binary.data(), binary.size());
+		}
+
+		auto time = std::chrono::duration<double, std::milli>(ClockType::now() - job.QueueTime).count();
+
+		lock.lock();
+
+		if (success && !request.JournalPath.empty())
+		{
+			auto newersave = false;
+
+			for (const auto& pending : Jobs)
+			{
+				if (pending.Request.JSONPath == request.JSONPath)
+				{
+					newersave = true;
+					break;
+				}
+			}
+
+			/*
+				Done under the lock so a save queued meanwhile, which
+				moves more edits into this journal, is seen first.
+			*/
+			if (!newersave)
+			{
+				std::remove(request.JournalPath.c_str());
+			}
+		}
+
+		Writing = false;
+
+		CurrentStats.InFlight--;
+
+		if (success)
+		{
+			CurrentStats.Completed++;
+		}
+
+		else
+		{
+			CurrentStats.Failed++;
+		}
+
+		CurrentStats.LastMilliseconds = time;
+		CurrentStats.TotalMilliseconds += time;
+
+		if (time > CurrentStats.MaxMilliseconds)
+		{
+			CurrentStats.MaxMilliseconds = time;
+		}
+
+		SaveResult result;
+		result.JSONPath = request.JSONPath;
+		result.Success = success;
+		result.Milliseconds = time;
+
+		Results.push_back(std::move(result));
+
+		if (Jobs.empty())
+		{
+			IdleCondition.notify_all();
+		}
+	}
+}
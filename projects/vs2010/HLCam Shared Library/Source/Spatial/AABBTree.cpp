@@ -0,0 +1,986 @@
+#include "Shared/Spatial/AABBTree.hpp"
+#include <algorithm>
+#include <cstring>
+#include <cfloat>
+#include <cmath>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE__)
+#define HLCAM_AABBTREE_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace Utility
+{
+	AABB AABB::Merge(const AABB& first, const AABB& other)
+	{
+		AABB ret;
+
+		for (size_t i = 0; i < 3; i++)
+		{
+			ret.Min[i] = std::min(first.Min[i], other.Min[i]);
+			ret.Max[i] = std::max(first.Max[i], other.Max[i]);
+		}
+
+		return ret;
+	}
+
+	void AABBTree::Build(const std::vector<std::pair<IDType, AABB>>& items)
+	{
+		Clear();
+
+		if (items.empty())
+		{
+			return;
+		}
+
+		Nodes.reserve(items.size() * 2);
+		Leaves.reserve(items.size());
+
+		std::vector<int> leaves;
+		leaves.reserve(items.size());
+
+		for (const auto& item : items)
+		{
+			auto leaf = AllocateNode();
+
+			Nodes[leaf].Box = item.second;
+			Nodes[leaf].ID = item.first;
+			Nodes[leaf].Height = 0;
+
+			Leaves[item.first] = leaf;
+			leaves.push_back(leaf);
+		}
+
+		Root = BuildRange(leaves, 0, leaves.size());
+		Nodes[Root].Parent = NullNode;
+	}
+
+	void AABBTree::Save(std::vector<FlatNode>& nodes) const
+	{
+		nodes.clear();
+
+		if (Root == NullNode)
+		{
+			return;
+		}
+
+		nodes.reserve(Leaves.size() * 2 - 1);
+		SaveSubtree(Root, nodes);
+	}
+
+	void AABBTree::SaveSubtree(int index, std::vector<FlatNode>& nodes) const
+	{
+		const auto& node = Nodes[index];
+
+		auto flatindex = nodes.size();
+		nodes.push_back({node.Box, {NullNode, NullNode}, node.ID});
+
+		if (node.IsLeaf())
+		{
+			return;
+		}
+
+		for (size_t i = 0; i < 2; i++)
+		{
+			nodes[flatindex].Children[i] = static_cast<int>(nodes.size());
+			SaveSubtree(node.Children[i], nodes);
+		}
+	}
+
+	bool AABBTree::Load(const FlatNode* nodes, size_t count)
+	{
+		Clear();
+
+		if (count == 0)
+		{
+			return true;
+		}
+
+		Nodes.resize(count);
+		Leaves.reserve(count / 2 + 1);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			const auto& flat = nodes[i];
+			auto& node = Nodes[i];
+
+			node.Box = flat.Box;
+			node.ID = flat.ID;
+			node.Children[0] = flat.Children[0];
+			node.Children[1] = flat.Children[1];
+
+			if (node.Children[0] == NullNode && node.Children[1] == NullNode)
+			{
+				node.Height = 0;
+
+				if (!Leaves.emplace(node.ID, static_cast<int>(i)).second)
+				{
+					Clear();
+					return false;
+				}
+
+				continue;
+			}
+
+			/*
+				Children coming after their parent rules out cycles, and
+				with one parent each every node below the root is reached once.
+			*/
+			for (auto child : node.Children)
+			{
+				if (child <= static_cast<int>(i) ||
+					child >= static_cast<int>(count) ||
+					Nodes[child].Parent != NullNode)
+				{
+					Clear();
+					return false;
+				}
+
+				Nodes[child].Parent = static_cast<int>(i);
+			}
+		}
+
+		/*
+			Heights go bottom up, which is back to front. Searches skip
+			whatever is outside a parent, so it has to hold its children.
+		*/
+		for (size_t i = count; i-- > 0;)
+		{
+			auto& node = Nodes[i];
+
+			if (i != 0 && node.Parent == NullNode)
+			{
+				Clear();
+				return false;
+			}
+
+			if (!node.IsLeaf())
+			{
+				const auto& left = Nodes[node.Children[0]];
+				const auto& right = Nodes[node.Children[1]];
+
+				if (!node.Box.Contains(left.Box) || !node.Box.Contains(right.Box))
+				{
+					Clear();
+					return false;
+				}
+
+				node.Height = 1 + std::max(left.Height, right.Height);
+			}
+		}
+
+		Root = 0;
+		return true;
+	}
+
+	void AABBTree::Insert(IDType id, const AABB& box)
+	{
+		if (Contains(id))
+		{
+			Update(id, box);
+			return;
+		}
+
+		auto leaf = AllocateNode();
+
+		Nodes[leaf].Box = box;
+		Nodes[leaf].ID = id;
+		Nodes[leaf].Height = 0;
+
+		Leaves[id] = leaf;
+
+		InsertLeaf(leaf);
+	}
+
+	void AABBTree::Remove(IDType id)
+	{
+		auto it = Leaves.find(id);
+
+		if (it == Leaves.end())
+		{
+			return;
+		}
+
+		auto leaf = it->second;
+		Leaves.erase(it);
+
+		RemoveLeaf(leaf);
+		FreeNode(leaf);
+	}
+
+	void AABBTree::Update(IDType id, const AABB& box)
+	{
+		auto it = Leaves.find(id);
+
+		if (it == Leaves.end())
+		{
+			Insert(id, box);
+			return;
+		}
+
+		auto leaf = it->second;
+
+		if (std::memcmp(&Nodes[leaf].Box, &box, sizeof(box)) == 0)
+		{
+			return;
+		}
+
+		RemoveLeaf(leaf);
+		Nodes[leaf].Box = box;
+		InsertLeaf(leaf);
+	}
+
+	bool AABBTree::Contains(IDType id) const
+	{
+		return Leaves.find(id) != Leaves.end();
+	}
+
+	const AABB* AABBTree::FindBox(IDType id) const
+	{
+		auto it = Leaves.find(id);
+
+		if (it == Leaves.end())
+		{
+			return nullptr;
+		}
+
+		return &Nodes[it->second].Box;
+	}
+
+	size_t AABBTree::GetCount() const
+	{
+		return Leaves.size();
+	}
+
+	int AABBTree::GetHeight() const
+	{
+		if (Root == NullNode)
+		{
+			return 0;
+		}
+
+		return Nodes[Root].Height;
+	}
+
+	void AABBTree::Clear()
+	{
+		Nodes.clear();
+		Leaves.clear();
+
+		Root = NullNode;
+		FreeList = NullNode;
+
+		PackedDirty = true;
+	}
+
+	int AABBTree::AllocateNode()
+	{
+		if (FreeList != NullNode)
+		{
+			auto node = FreeList;
+			FreeList = Nodes[node].Parent;
+
+			Nodes[node] = Node();
+			return node;
+		}
+
+		Nodes.emplace_back();
+		return static_cast<int>(Nodes.size() - 1);
+	}
+
+	void AABBTree::FreeNode(int node)
+	{
+		/*
+			Free nodes are chained through their parent link.
+		*/
+		Nodes[node].Parent = FreeList;
+		Nodes[node].Height = -1;
+		FreeList = node;
+	}
+
+	void AABBTree::InsertLeaf(int leaf)
+	{
+		PackedDirty = true;
+
+		if (Root == NullNode)
+		{
+			Root = leaf;
+			Nodes[Root].Parent = NullNode;
+			return;
+		}
+
+		/*
+			Find the best sibling by surface area heuristic.
+		*/
+		const auto leafbox = Nodes[leaf].Box;
+		auto index = Root;
+
+		while (!Nodes[index].IsLeaf())
+		{
+			const auto& node = Nodes[index];
+
+			auto child1 = node.Children[0];
+			auto child2 = node.Children[1];
+
+			auto area = node.Box.SurfaceArea();
+			auto combinedarea = AABB::Merge(node.Box, leafbox).SurfaceArea();
+
+			/*
+				Cost of creating a new parent for this node and the new leaf,
+				and the minimum cost of pushing the leaf further down.
+			*/
+			auto cost = 2.0f * combinedarea;
+			auto inheritancecost = 2.0f * (combinedarea - area);
+
+			auto childcost = [&](int child)
+			{
+				const auto& childnode = Nodes[child];
+				auto merged = AABB::Merge(leafbox, childnode.Box).SurfaceArea();
+
+				if (childnode.IsLeaf())
+				{
+					return merged + inheritancecost;
+				}
+
+				return (merged - childnode.Box.SurfaceArea()) + inheritancecost;
+			};
+
+			auto cost1 = childcost(child1);
+			auto cost2 = childcost(child2);
+
+			if (cost < cost1 && cost < cost2)
+			{
+				break;
+			}
+
+			index = cost1 < cost2 ? child1 : child2;
+		}
+
+		auto sibling = index;
+		auto oldparent = Nodes[sibling].Parent;
+		auto newparent = AllocateNode();
+
+		Nodes[newparent].Parent = oldparent;
+		Nodes[newparent].Box = AABB::Merge(leafbox, Nodes[sibling].Box);
+		Nodes[newparent].Height = Nodes[sibling].Height + 1;
+		Nodes[newparent].Children[0] = sibling;
+		Nodes[newparent].Children[1] = leaf;
+
+		if (oldparent != NullNode)
+		{
+			auto& parentnode = Nodes[oldparent];
+
+			if (parentnode.Children[0] == sibling)
+			{
+				parentnode.Children[0] = newparent;
+			}
+
+			else
+			{
+				parentnode.Children[1] = newparent;
+			}
+		}
+
+		else
+		{
+			Root = newparent;
+		}
+
+		Nodes[sibling].Parent = newparent;
+		Nodes[leaf].Parent = newparent;
+
+		Refit(Nodes[leaf].Parent);
+	}
+
+	void AABBTree::RemoveLeaf(int leaf)
+	{
+		PackedDirty = true;
+
+		if (leaf == Root)
+		{
+			Root = NullNode;
+			return;
+		}
+
+		auto parent = Nodes[leaf].Parent;
+		auto grandparent = Nodes[parent].Parent;
+
+		auto sibling = Nodes[parent].Children[0] == leaf ?
+			Nodes[parent].Children[1] :
+			Nodes[parent].Children[0];
+
+		if (grandparent != NullNode)
+		{
+			auto& grandnode = Nodes[grandparent];
+
+			if (grandnode.Children[0] == parent)
+			{
+				grandnode.Children[0] = sibling;
+			}
+
+			else
+			{
+				grandnode.Children[1] = sibling;
+			}
+
+			Nodes[sibling].Parent = grandparent;
+			FreeNode(parent);
+
+			Refit(grandparent);
+		}
+
+		else
+		{
+			Root = sibling;
+			Nodes[sibling].Parent = NullNode;
+			FreeNode(parent);
+		}
+
+		Nodes[leaf].Parent = NullNode;
+	}
+
+	void AABBTree::Refit(int node)
+	{
+		while (node != NullNode)
+		{
+			node = Balance(node);
+
+			auto child1 = Nodes[node].Children[0];
+			auto child2 = Nodes[node].Children[1];
+
+			Nodes[node].Height = 1 + std::max(Nodes[child1].Height, Nodes[child2].Height);
+			Nodes[node].Box = AABB::Merge(Nodes[child1].Box, Nodes[child2].Box);
+
+			node = Nodes[node].Parent;
+		}
+	}
+
+	int AABBTree::Balance(int ia)
+	{
+		if (Nodes[ia].IsLeaf() || Nodes[ia].Height < 2)
+		{
+			return ia;
+		}
+
+		auto ib = Nodes[ia].Children[0];
+		auto ic = Nodes[ia].Children[1];
+
+		auto balance = Nodes[ic].Height - Nodes[ib].Height;
+
+		auto replaceinparent = [this](int parent, int oldchild, int newchild)
+		{
+			if (parent == NullNode)
+			{
+				Root = newchild;
+				return;
+			}
+
+			if (Nodes[parent].Children[0] == oldchild)
+			{
+				Nodes[parent].Children[0] = newchild;
+			}
+
+			else
+			{
+				Nodes[parent].Children[1] = newchild;
+			}
+		};
+
+		/*
+			Rotate C up
+		*/
+		if (balance > 1)
+		{
+			auto& a = Nodes[ia];
+			auto& b = Nodes[ib];
+			auto& c = Nodes[ic];
+
+			auto ifn = c.Children[0];
+			auto ig = c.Children[1];
+
+			auto& f = Nodes[ifn];
+			auto& g = Nodes[ig];
+
+			c.Children[0] = ia;
+			c.Parent = a.Parent;
+			a.Parent = ic;
+
+			replaceinparent(c.Parent, ia, ic);
+
+			if (f.Height > g.Height)
+			{
+				c.Children[1] = ifn;
+				a.Children[1] = ig;
+				g.Parent = ia;
+
+				a.Box = AABB::Merge(b.Box, g.Box);
+				c.Box = AABB::Merge(a.Box, f.Box);
+
+				a.Height = 1 + std::max(b.Height, g.Height);
+				c.Height = 1 + std::max(a.Height, f.Height);
+			}
+
+			else
+			{
+				c.Children[1] = ig;
+				a.Children[1] = ifn;
+				f.Parent = ia;
+
+				a.Box = AABB::Merge(b.Box, f.Box);
+				c.Box = AABB::Merge(a.Box, g.Box);
+
+				a.Height = 1 + std::max(b.Height, f.Height);
+				c.Height = 1 + std::max(a.Height, g.Height);
+			}
+
+			return ic;
+		}
+
+		/*
+			Rotate B up
+		*/
+		if (balance < -1)
+		{
+			auto& a = Nodes[ia];
+			auto& b = Nodes[ib];
+			auto& c = Nodes[ic];
+
+			auto id = b.Children[0];
+			auto ie = b.Children[1];
+
+			auto& d = Nodes[id];
+			auto& e = Nodes[ie];
+
+			b.Children[0] = ia;
+			b.Parent = a.Parent;
+			a.Parent = ib;
+
+			replaceinparent(b.Parent, ia, ib);
+
+			if (d.Height > e.Height)
+			{
+				b.Children[1] = id;
+				a.Children[0] = ie;
+				e.Parent = ia;
+
+				a.Box = AABB::Merge(c.Box, e.Box);
+				b.Box = AABB::Merge(a.Box, d.Box);
+
+				a.Height = 1 + std::max(c.Height, e.Height);
+				b.Height = 1 + std::max(a.Height, d.Height);
+			}
+
+			else
+			{
+				b.Children[1] = ie;
+				a.Children[0] = id;
+				d.Parent = ia;
+
+				a.Box = AABB::Merge(c.Box, d.Box);
+				b.Box = AABB::Merge(a.Box, e.Box);
+
+				a.Height = 1 + std::max(c.Height, d.Height);
+				b.Height = 1 + std::max(a.Height, e.Height);
+			}
+
+			return ib;
+		}
+
+		return ia;
+	}
+
+	int AABBTree::BuildRange(std::vector<int>& leaves, size_t start, size_t end)
+	{
+		if (end - start == 1)
+		{
+			return leaves[start];
+		}
+
+		/*
+			Split at the median centroid along the longest axis.
+		*/
+		AABB centroidbounds;
+
+		for (size_t axis = 0; axis < 3; axis++)
+		{
+			centroidbounds.Min[axis] = FLT_MAX;
+			centroidbounds.Max[axis] = -FLT_MAX;
+		}
+
+		for (size_t i = start; i < end; i++)
+		{
+			const auto& box = Nodes[leaves[i]].Box;
+
+			for (size_t axis = 0; axis < 3; axis++)
+			{
+				auto center = (box.Min[axis] + box.Max[axis]) * 0.5f;
+
+				centroidbounds.Min[axis] = std::min(centroidbounds.Min[axis], center);
+				centroidbounds.Max[axis] = std::max(centroidbounds.Max[axis], center);
+			}
+		}
+
+		size_t splitaxis = 0;
+
+		for (size_t axis = 1; axis < 3; axis++)
+		{
+			auto extent = centroidbounds.Max[axis] - centroidbounds.Min[axis];
+			auto bestextent = centroidbounds.Max[splitaxis] - centroidbounds.Min[splitaxis];
+
+			if (extent > bestextent)
+			{
+				splitaxis = axis;
+			}
+		}
+
+		auto mid = start + (end - start) / 2;
+
+		std::nth_element
+		(
+			leaves.begin() + start,
+			leaves.begin() + mid,
+			leaves.begin() + end,
+			[this, splitaxis](int first, int other)
+			{
+				const auto& firstbox = Nodes[first].Box;
+				const auto& otherbox = Nodes[other].Box;
+
+				return firstbox.Min[splitaxis] + firstbox.Max[splitaxis] <
+					   otherbox.Min[splitaxis] + otherbox.Max[splitaxis];
+			}
+		);
+
+		auto left = BuildRange(leaves, start, mid);
+		auto right = BuildRange(leaves, mid, end);
+
+		auto parent = AllocateNode();
+
+		Nodes[parent].Children[0] = left;
+		Nodes[parent].Children[1] = right;
+		Nodes[parent].Box = AABB::Merge(Nodes[left].Box, Nodes[right].Box);
+		Nodes[parent].Height = 1 + std::max(Nodes[left].Height, Nodes[right].Height);
+
+		Nodes[left].Parent = parent;
+		Nodes[right].Parent = parent;
+
+		return parent;
+	}
+
+	void AABBTree::BuildPacked()
+	{
+		Packed.clear();
+		PackedLeafIDs.clear();
+
+		PackedDirty = false;
+
+		if (Root == NullNode)
+		{
+			return;
+		}
+
+		Packed.reserve(Leaves.size() / 2 + 1);
+		PackedLeafIDs.reserve(Leaves.size());
+
+		/*
+			A lone leaf still needs a node above it to be tested.
+		*/
+		if (Nodes[Root].IsLeaf())
+		{
+			PackedNode node;
+			std::memset(&node, 0, sizeof(node));
+
+			const auto& box = Nodes[Root].Box;
+
+			node.MinX[0] = box.Min[0];
+			node.MinY[0] = box.Min[1];
+			node.MinZ[0] = box.Min[2];
+			node.MaxX[0] = box.Max[0];
+			node.MaxY[0] = box.Max[1];
+			node.MaxZ[0] = box.Max[2];
+
+			PackedLeafIDs.push_back(Nodes[Root].ID);
+
+			node.Children[0] = -1;
+			node.Count = 1;
+
+			Packed.push_back(node);
+			return;
+		}
+
+		PackSubtree(Root);
+	}
+
+	int AABBTree::PackSubtree(int index)
+	{
+		/*
+			Collapse two levels of the binary tree into one node by
+			repeatedly opening the largest internal child.
+		*/
+		int children[4] = {Nodes[index].Children[0], Nodes[index].Children[1]};
+		int count = 2;
+
+		while (count < 4)
+		{
+			auto best = -1;
+			auto bestarea = -1.0f;
+
+			for (int i = 0; i < count; i++)
+			{
+				const auto& child = Nodes[children[i]];
+
+				if (!child.IsLeaf() && child.Box.SurfaceArea() > bestarea)
+				{
+					best = i;
+					bestarea = child.Box.SurfaceArea();
+				}
+			}
+
+			if (best == -1)
+			{
+				break;
+			}
+
+			auto opened = children[best];
+
+			children[best] = Nodes[opened].Children[0];
+			children[count++] = Nodes[opened].Children[1];
+		}
+
+		auto packedindex = static_cast<int>(Packed.size());
+		Packed.emplace_back();
+
+		PackedNode node;
+
+		/*
+			Unused lanes are tested with the rest, but walks only look at
+			the first Count results. The inverted box just keeps them
+			defined, the slab test would count it as a hit.
+		*/
+		for (int i = 0; i < 4; i++)
+		{
+			node.MinX[i] = node.MinY[i] = node.MinZ[i] = FLT_MAX;
+			node.MaxX[i] = node.MaxY[i] = node.MaxZ[i] = -FLT_MAX;
+			node.Children[i] = 0;
+		}
+
+		node.Count = count;
+
+		for (int i = 0; i < count; i++)
+		{
+			const auto& child = Nodes[children[i]];
+
+			node.MinX[i] = child.Box.Min[0];
+			node.MinY[i] = child.Box.Min[1];
+			node.MinZ[i] = child.Box.Min[2];
+			node.MaxX[i] = child.Box.Max[0];
+			node.MaxY[i] = child.Box.Max[1];
+			node.MaxZ[i] = child.Box.Max[2];
+
+			if (child.IsLeaf())
+			{
+				PackedLeafIDs.push_back(child.ID);
+				node.Children[i] = -static_cast<int>(PackedLeafIDs.size());
+			}
+
+			else
+			{
+				node.Children[i] = PackSubtree(children[i]);
+			}
+		}
+
+		Packed[packedindex] = node;
+		return packedindex;
+	}
+
+	namespace
+	{
+		/*
+			Slab test of one ray against the four boxes of a packed node.
+			Writes the entry distance of each lane, 0 if the ray starts
+			inside, and where the ray leaves it, then returns a bit mask
+			of the lanes that are hit within "maxdistance".
+		*/
+		template <typename NodeType>
+		int IntersectRay4(const NodeType& node, const float* origin, const float* invdir, float maxdistance, float* entry, float* exit)
+		{
+			#ifdef HLCAM_AABBTREE_SSE
+			auto ox = _mm_set1_ps(origin[0]);
+			auto oy = _mm_set1_ps(origin[1]);
+			auto oz = _mm_set1_ps(origin[2]);
+
+			auto ix = _mm_set1_ps(invdir[0]);
+			auto iy = _mm_set1_ps(invdir[1]);
+			auto iz = _mm_set1_ps(invdir[2]);
+
+			auto t1x = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.MinX), ox), ix);
+			auto t2x = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.MaxX), ox), ix);
+			auto t1y = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.MinY), oy), iy);
+			auto t2y = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.MaxY), oy), iy);
+			auto t1z = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.MinZ), oz), iz);
+			auto t2z = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.MaxZ), oz), iz);
+
+			auto tmin = _mm_max_ps
+			(
+				_mm_max_ps(_mm_min_ps(t1x, t2x), _mm_min_ps(t1y, t2y)),
+				_mm_max_ps(_mm_min_ps(t1z, t2z), _mm_setzero_ps())
+			);
+
+			auto tmax = _mm_min_ps
+			(
+				_mm_min_ps(_mm_max_ps(t1x, t2x), _mm_max_ps(t1y, t2y)),
+				_mm_max_ps(t1z, t2z)
+			);
+
+			_mm_storeu_ps(entry, tmin);
+			_mm_storeu_ps(exit, tmax);
+
+			return _mm_movemask_ps(_mm_cmple_ps(tmin, _mm_min_ps(tmax, _mm_set1_ps(maxdistance))));
+			#else
+			int mask = 0;
+
+			for (int i = 0; i < 4; i++)
+			{
+				auto t1x = (node.MinX[i] - origin[0]) * invdir[0];
+				auto t2x = (node.MaxX[i] - origin[0]) * invdir[0];
+				auto t1y = (node.MinY[i] - origin[1]) * invdir[1];
+				auto t2y = (node.MaxY[i] - origin[1]) * invdir[1];
+				auto t1z = (node.MinZ[i] - origin[2]) * invdir[2];
+				auto t2z = (node.MaxZ[i] - origin[2]) * invdir[2];
+
+				auto tmin = std::max(std::max(std::min(t1x, t2x), std::min(t1y, t2y)), std::max(std::min(t1z, t2z), 0.0f));
+				auto tmax = std::min(std::min(std::max(t1x, t2x), std::max(t1y, t2y)), std::max(t1z, t2z));
+
+				entry[i] = tmin;
+				exit[i] = tmax;
+
+				if (tmin <= std::min(tmax, maxdistance))
+				{
+					mask |= 1 << i;
+				}
+			}
+
+			return mask;
+			#endif
+		}
+	}
+
+	bool AABBTree::RayCast(const float* origin, const float* direction, float maxdistance, RayHit& hit)
+	{
+		if (PackedDirty)
+		{
+			BuildPacked();
+		}
+
+		if (Packed.empty())
+		{
+			return false;
+		}
+
+		/*
+			Axis aligned rays would otherwise produce 0 * inf in the slab test.
+		*/
+		float invdir[3];
+
+		for (size_t i = 0; i < 3; i++)
+		{
+			auto dir = direction[i];
+
+			if (std::abs(dir) < 1e-20f)
+			{
+				dir = dir < 0 ? -1e-20f : 1e-20f;
+			}
+
+			invdir[i] = 1.0f / dir;
+		}
+
+		struct StackEntry
+		{
+			int Node;
+			float Distance;
+		};
+
+		/*
+			Every visit pushes at most 3 more entries than it pops and each
+			packed level spans at least one level of the balanced binary tree,
+			so this is far beyond any height the rotations allow.
+		*/
+		StackEntry stack[256];
+		size_t count = 0;
+
+		auto best = maxdistance;
+		auto found = false;
+
+		stack[count++] = {0, 0.0f};
+
+		while (count > 0)
+		{
+			auto cur = stack[--count];
+
+			if (cur.Distance > best)
+			{
+				continue;
+			}
+
+			const auto& node = Packed[cur.Node];
+
+			float entry[4];
+			float exit[4];
+			auto mask = IntersectRay4(node, origin, invdir, best, entry, exit);
+
+			StackEntry pending[4];
+			size_t pendingcount = 0;
+
+			for (int i = 0; i < node.Count; i++)
+			{
+				if (!(mask & (1 << i)))
+				{
+					continue;
+				}
+
+				auto child = node.Children[i];
+
+				if (child < 0)
+				{
+					/*
+						Boxes around the origin rank by where the ray leaves them,
+						otherwise one containing the origin would hide every box
+						ahead. Ties go to the box the ray is entering.
+					*/
+					auto distance = entry[i] > 0 ? entry[i] : std::min(exit[i], maxdistance);
+
+					if (distance > best || (found && distance == best && entry[i] <= 0))
+					{
+						continue;
+					}
+
+					best = distance;
+					hit.ID = PackedLeafIDs[-child - 1];
+					hit.Distance = distance;
+					found = true;
+
+					continue;
+				}
+
+				/*
+					Keep pending sorted far to near so the nearest ends up on top.
+				*/
+				auto pos = pendingcount++;
+
+				while (pos > 0 && pending[pos - 1].Distance < entry[i])
+				{
+					pending[pos] = pending[pos - 1];
+					pos--;
+				}
+
+				pending[pos] = {child, entry[i]};
+			}
+
+			for (size_t i = 0; i < pendingcount; i++)
+			{
+				stack[count++] = pending[i];
+			}
+		}
+
+		return found;
+	}
+}
@@ -0,0 +1,67 @@
+#include "Shared/Spatial/BoxGraph.hpp"
+
+namespace Utility
+{
+	void BoxGraph::Build(const AABBTree& tree, const BoxArray& boxes, float margin)
+	{
+		Clear();
+
+		auto count = boxes.GetSize();
+
+		Offsets.resize(count + 1, 0);
+
+		for (size_t id = 0; id < count; id++)
+		{
+			Offsets[id] = static_cast<uint32_t>(Links.size());
+
+			if (!boxes.Contains(id))
+			{
+				continue;
+			}
+
+			auto box = boxes.Get(id);
+
+			for (size_t i = 0; i < 3; i++)
+			{
+				box.Min[i] -= margin;
+				box.Max[i] += margin;
+			}
+
+			tree.QueryBox(box, [this, id](AABBTree::IDType other)
+			{
+				if (other != id)
+				{
+					Links.push_back(static_cast<uint32_t>(other));
+				}
+
+				return true;
+			});
+		}
+
+		Offsets[count] = static_cast<uint32_t>(Links.size());
+	}
+
+	void BoxGraph::Clear()
+	{
+		Offsets.clear();
+		Links.clear();
+	}
+
+	BoxGraph::Range BoxGraph::GetNeighbours(size_t id) const
+	{
+		Range ret = {nullptr, nullptr};
+
+		if (id + 1 < Offsets.size())
+		{
+			ret.First = Links.data() + Offsets[id];
+			ret.Last = Links.data() + Offsets[id + 1];
+		}
+
+		return ret;
+	}
+
+	size_t BoxGraph::GetLinkCount() const
+	{
+		return Links.size();
+	}
+}
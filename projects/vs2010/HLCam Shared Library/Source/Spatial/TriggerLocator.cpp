@@ -0,0 +1,161 @@
+#include "Shared/Spatial/TriggerLocator.hpp"
+#include <cmath>
+
+namespace
+{
+	namespace LocalUtility
+	{
+		using Utility::TriggerLocator::Request;
+		using Utility::TriggerLocator::ResultType;
+
+		/*
+			Larger than a couple of rooms and the shared walk visits
+			more of the tree than separate ones would.
+		*/
+		const float MaxBatchExtent = 1024;
+
+		/*
+			The order triggers are found in depends on the shape of the
+			tree and the graph, the lowest ID is the same either way.
+		*/
+		void TakeLowest(Request& request, ResultType result, size_t id)
+		{
+			if (request.Result == ResultType::None || id < request.FoundID)
+			{
+				request.Result = result;
+				request.FoundID = id;
+			}
+		}
+
+		/*
+			Fills in the trigger of every request, nearby players share
+			one walk of the tree instead of one each.
+		*/
+		void SearchTree(const Utility::AABBTree& tree, const Utility::BoxArray& bounds, Request** misses, size_t count, Utility::TriggerLocator::Counters& counters)
+		{
+			auto batchbox = misses[0]->Box;
+
+			for (size_t i = 1; i < count; i++)
+			{
+				for (size_t axis = 0; axis < 3; axis++)
+				{
+					batchbox.Min[axis] = std::fmin(batchbox.Min[axis], misses[i]->Box.Min[axis]);
+					batchbox.Max[axis] = std::fmax(batchbox.Max[axis], misses[i]->Box.Max[axis]);
+				}
+			}
+
+			bool canbatch = count > 1;
+
+			for (size_t axis = 0; axis < 3; axis++)
+			{
+				if (batchbox.Max[axis] - batchbox.Min[axis] > MaxBatchExtent)
+				{
+					canbatch = false;
+				}
+			}
+
+			if (canbatch)
+			{
+				counters.BatchedSearches++;
+
+				tree.QueryBox(batchbox, [&bounds, misses, count](size_t id)
+				{
+					for (size_t i = 0; i < count; i++)
+					{
+						auto& miss = *misses[i];
+
+						if (bounds.Overlaps(id, miss.Box))
+						{
+							TakeLowest(miss, ResultType::Searched, id);
+						}
+					}
+
+					return true;
+				});
+
+				return;
+			}
+
+			for (size_t i = 0; i < count; i++)
+			{
+				auto& miss = *misses[i];
+
+				tree.QueryBox(miss.Box, [&miss](size_t id)
+				{
+					TakeLowest(miss, ResultType::Searched, id);
+					return true;
+				});
+			}
+		}
+	}
+}
+
+void Utility::TriggerLocator::Locate(const AABBTree& tree, const BoxArray& bounds, const BoxGraph& graph, Request* requests, size_t count, Counters& counters)
+{
+	/*
+		Enough for every player the game can have, more are done in turns.
+	*/
+	const size_t maxmisses = 64;
+
+	Request* misses[maxmisses];
+	size_t misscount = 0;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		auto& request = requests[i];
+		request.Result = ResultType::None;
+
+		/*
+			The player is nearly always still in the same trigger or has walked
+			into one next to it. Staying in the current trigger while touching
+			another keeps the camera from flipping between the two.
+		*/
+		if (request.HasActive)
+		{
+			if (bounds.Overlaps(request.ActiveID, request.Box))
+			{
+				request.Result = ResultType::Active;
+				request.FoundID = request.ActiveID;
+
+				counters.ActiveHits++;
+				continue;
+			}
+
+			for (auto id : graph.GetNeighbours(request.ActiveID))
+			{
+				if (bounds.Overlaps(id, request.Box))
+				{
+					LocalUtility::TakeLowest(request, ResultType::Neighbour, id);
+				}
+			}
+
+			if (request.Result == ResultType::Neighbour)
+			{
+				counters.NeighbourHits++;
+				continue;
+			}
+		}
+
+		counters.Misses++;
+		misses[misscount++] = &request;
+
+		if (misscount == maxmisses)
+		{
+			LocalUtility::SearchTree(tree, bounds, misses, misscount, counters);
+			misscount = 0;
+		}
+	}
+
+	if (misscount != 0)
+	{
+		LocalUtility::SearchTree(tree, bounds, misses, misscount, counters);
+	}
+
+	for (size_t i = 0; i < count; i++)
+	{
+		if (requests[i].Result == ResultType::None)
+		{
+			counters.EmptyMisses++;
+		}
+	}
+}
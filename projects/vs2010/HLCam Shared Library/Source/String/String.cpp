@@ -1,6 +1,9 @@
 #include <string>
+#include <cstring>
+#include <cwchar>
+#include <locale>
 #include <codecvt>
-#include "Shared\String\String.hpp"
+#include "Shared/String/String.hpp"
 
 namespace
 {
@@ -2,6 +2,7 @@
 #include "Program\App\HLCamEditorApp.hpp"
 #include "Program\Dialogs\Main\HLCamEditorDialog.hpp"
 #include "Program\Help\ContextMenuHelper.hpp"
+#include "Shared\Map\MapSchema.hpp"
 #include "afxdialogex.h"
 
 #include <memory>
@@ -19,6 +20,17 @@ namespace
 			TryConnectToGame,
 		};
 	}
+
+	namespace WindowMessages
+	{
+		enum
+		{
+			/*
+				Writes to the game are made from the window's thread only.
+			*/
+			RequestMapSnapshot = WM_APP + 1,
+		};
+	}
 }
 
 namespace App
@@ -78,74 +90,32 @@ namespace App
 
 	HLTrigger& operator>>(Utility::BinaryBuffer& buffer, HLTrigger& trigger)
 	{
-		buffer >> trigger.ID;
-		buffer >> trigger.LinkedCameraID;
+		Cam::Shared::Schema::TriggerLink link;
+		Cam::Shared::Schema::Decode(buffer, link);
+
+		trigger.ID = link.ID;
+		trigger.LinkedCameraID = link.CameraID;
 
 		return trigger;
 	}
 
-	HLCamera& operator>>(Utility::BinaryBuffer& buffer, HLCamera& camera)
+	void SetLinkedTriggers(HLCamera& camera)
 	{
-		buffer >> camera.ID;
+		camera.LinkedTriggerIDs.clear();
+		camera.LinkedTriggerIDs.reserve(camera.Triggers.size());
 
-		auto linkedtriggerscount = buffer.GetValue<unsigned char>();
-
-		if (linkedtriggerscount > 0)
-		{
-			camera.LinkedTriggerIDs.reserve(linkedtriggerscount);
-
-			for (size_t i = 0; i < linkedtriggerscount; i++)
-			{
-				camera.LinkedTriggerIDs.push_back(buffer.GetValue<size_t>());
-			}
-
-			camera.IsSingle = false;
-		}
-
-		else
-		{
-			camera.IsSingle = true;
-		}
-
-		buffer >> camera.MaxSpeed;
-		buffer >> camera.FOV;
-
-		buffer >> camera.Position.X;
-		buffer >> camera.Position.Y;
-		buffer >> camera.Position.Z;
-
-		buffer >> camera.Angles.X;
-		buffer >> camera.Angles.Y;
-		buffer >> camera.Angles.Z;
-
-		camera.TriggerType = static_cast<decltype(camera.TriggerType)>(buffer.GetValue<unsigned char>());
-		camera.LookType = static_cast<decltype(camera.LookType)>(buffer.GetValue<unsigned char>());
-		camera.PlaneType = static_cast<decltype(camera.PlaneType)>(buffer.GetValue<unsigned char>());
-		camera.ZoomType = static_cast<decltype(camera.ZoomType)>(buffer.GetValue<unsigned char>());
-		
-		camera.ZoomInterpMethod = static_cast<decltype(camera.ZoomInterpMethod)>(buffer.GetValue<unsigned char>());
-		buffer >> camera.ZoomEndFOV;
-		buffer >> camera.ZoomTime;
-
-		if (camera.TriggerType == Cam::Shared::CameraTriggerType::ByName)
-		{
-			camera.Name = buffer.GetNormalString();
-		}
-
-		if (camera.LookType == Cam::Shared::CameraLookType::AtTarget)
+		for (const auto& trigger : camera.Triggers)
 		{
-			camera.LookTargetName = buffer.GetNormalString();
+			camera.LinkedTriggerIDs.push_back(trigger.ID);
 		}
 
-		buffer >> camera.UseAttachment;
+		camera.IsSingle = camera.LinkedTriggerIDs.empty();
+	}
 
-		if (camera.UseAttachment)
-		{
-			camera.AttachmentTargetName = buffer.GetNormalString();
-			buffer >> camera.AttachmentOffset.X;
-			buffer >> camera.AttachmentOffset.Y;
-			buffer >> camera.AttachmentOffset.Z;
-		}
+	HLCamera& operator>>(Utility::BinaryBuffer& buffer, HLCamera& camera)
+	{
+		Cam::Shared::Schema::Decode(buffer, static_cast<Cam::Shared::MapCameraData&>(camera));
+		SetLinkedTriggers(camera);
 		
 		return camera;
 	}
@@ -166,6 +136,7 @@ BEGIN_MESSAGE_MAP(HLCamEditorDialog, CDialogEx)
 	ON_NOTIFY(TVN_SELCHANGED, IDC_TREE1, &HLCamEditorDialog::OnTvnSelchangedTree1)
 	ON_BN_CLICKED(IDC_BUTTON1, &HLCamEditorDialog::OnBnClickedButton1)
 	ON_WM_TIMER()
+	ON_MESSAGE(WindowMessages::RequestMapSnapshot, &HLCamEditorDialog::OnRequestMapSnapshot)
 END_MESSAGE_MAP()
 
 BOOL HLCamEditorDialog::OnInitDialog()
@@ -444,187 +415,260 @@ void HLCamEditorDialog::DoDataExchange(CDataExchange* exchange)
 
 void HLCamEditorDialog::MessageHandler()
 {
-	constexpr auto deepidlesleeptime = 100ms;
-	constexpr auto idlesleeptime = 100ms;
-	constexpr auto worksleeptime = 1ms;
-
-	auto messagesleeptime = idlesleeptime;
+	/*
+		Closing the dialog wakes the read, the timeout only bounds a missed wake.
+	*/
+	constexpr auto messagewaittime = 500ms;
 
-	auto lastmessagetime = std::chrono::system_clock::now();
+	/*
+		Outside the loop so its memory is used again for every message.
+	*/
+	Utility::BinaryBuffer data;
 
 	while (!ShouldCloseMessageThread)
 	{
 		namespace Config = Shared::Interprocess::Config;
 
 		Config::MessageType message;
-		Utility::BinaryBuffer data;
 
-		auto res = GameClient.TryRead(message, data);
+		auto res = GameClient.ReadTimed(message, data, messagewaittime);
 
 		if (!res)
 		{
-			auto now = std::chrono::system_clock::now();
+			continue;
+		}
+
+		namespace Message = Cam::Shared::Messages::Game;
+
+		if (message == Message::OnMapSnapshot)
+		{
+			Utility::BinaryBufferView chunk(data);
+
+			auto result = MapSnapshot.Add(chunk);
+
+			if (result == Shared::Interprocess::SnapshotReader::Result::Complete)
+			{
+				ApplyMapSnapshot(MapSnapshot.GetData());
+
+				WaitingForSnapshot = false;
+
+				for (auto& deferred : DeferredMessages)
+				{
+					HandleGameMessage(deferred.first, deferred.second);
+				}
 
-			std::chrono::duration<float> diff = now - lastmessagetime;
+				DeferredMessages.clear();
+			}
 
-			if (diff.count() > 20)
+			/*
+				The next snapshot comes after a reset, which
+				covers everything that was held back.
+			*/
+			else if (result == Shared::Interprocess::SnapshotReader::Result::Failed && !SnapshotRequested)
 			{
-				messagesleeptime = deepidlesleeptime;
+				PostMessageA(WindowMessages::RequestMapSnapshot);
+				SnapshotRequested = true;
 			}
 
-			std::this_thread::sleep_for(messagesleeptime);
 			continue;
 		}
 
-		if (messagesleeptime != worksleeptime)
+		/*
+			Changes made while the snapshot is on its way are
+			applied to it once it's complete, not before.
+		*/
+		if (WaitingForSnapshot && message != Message::OnEditModeStarted)
 		{
-			messagesleeptime = worksleeptime;
+			DeferredMessages.emplace_back(message, Utility::BinaryBuffer(data.GetData(), data.GetSize()));
+			continue;
 		}
 
-		lastmessagetime = std::chrono::system_clock::now();
+		HandleGameMessage(message, data);
+	}
+}
 
-		namespace Message = Cam::Shared::Messages::Game;
+void HLCamEditorDialog::HandleGameMessage(Shared::Interprocess::Config::MessageType message, Utility::BinaryBuffer& data)
+{
+	namespace Message = Cam::Shared::Messages::Game;
 
-		switch (message)
+	switch (message)
+	{
+		case Message::OnEditModeStarted:
 		{
-			case Message::OnEditModeStarted:
-			{
-				PropertyGrid.EnableWindow(true);
-				PropertyGrid.ShowWindow(SW_SHOW);
-				TreeControl.EnableWindow(true);
-
-				auto ismapreset = data.GetValue<bool>();
+			PropertyGrid.EnableWindow(true);
+			PropertyGrid.ShowWindow(SW_SHOW);
+			TreeControl.EnableWindow(true);
 
-				if (ismapreset)
-				{
-					DisableTreeSelections = true;
+			auto ismapreset = data.GetValue<bool>();
 
-					TreeControl.SetRedraw(false);
-					TreeControl.DeleteAllItems();
-					
-					CurrentMap = App::HLMap();
+			/*
+				The cameras follow as a snapshot.
+			*/
+			if (ismapreset)
+			{
+				WaitingForSnapshot = true;
+				SnapshotRequested = false;
 
-					CurrentMap.Name = data.GetNormalString();
+				MapSnapshot.Reset();
+				DeferredMessages.clear();
+			}
 
-					auto camcount = data.GetValue<unsigned short>();
+			else
+			{
+				PropertyGrid.RedrawWindow();
+				TreeControl.RedrawWindow();
+			}
 
-					for (size_t i = 0; i < camcount; i++)
-					{
-						auto curcam = data.GetValue<App::HLCamera>();
+			break;
+		}
 
-						for (const auto& trigid : curcam.LinkedTriggerIDs)
-						{
-							App::HLTrigger newtrig;
-							newtrig.ID = trigid;
-							newtrig.LinkedCameraID = curcam.ID;
+		case Message::OnEditModeStopped:
+		{
+			PropertyGrid.EnableWindow(false);
+			TreeControl.EnableWindow(false);
 
-							CurrentMap.Triggers[trigid] = std::move(newtrig);
-						}
+			break;
+		}
 
-						CurrentMap.Cameras[curcam.ID] = std::move(curcam);
-					}
+		case Message::OnGameShutdown:
+		{
+			break;
+		}
 
-					for (auto& camitr : CurrentMap.Cameras)
-					{
-						auto& cam = camitr.second;
+		case Message::OnTriggerAndCameraAdded:
+		{
+			auto&& cam = data.GetValue<App::HLCamera>();
+			auto&& trig = data.GetValue<App::HLTrigger>();
+			AddCameraAndTrigger(std::move(cam), std::move(trig));
+			break;
+		}
 
-						if (cam.IsSingle)
-						{
-							AddSingleCameraToList(cam);
-						}
+		case Message::OnTriggerAddedToCamera:
+		{
+			auto trig = data.GetValue<App::HLTrigger>();
+			auto camera = CurrentMap.FindCameraByID(trig.LinkedCameraID);
 
-						else
-						{
-							AddCameraAndTriggerToList(cam);
-						}
-					}
+			AddTriggerToCamera(*camera, std::move(trig));
+			break;
+		}
 
-					TreeControl.SetRedraw(true);
+		case Message::OnNamedCameraAdded:
+		{
+			auto&& cam = data.GetValue<App::HLCamera>();
+			AddSingleCamera(std::move(cam));
 
-					DisableTreeSelections = false;
-				}
+			break;
+		}
 
-				else
-				{
-					PropertyGrid.RedrawWindow();
-					TreeControl.RedrawWindow();
-				}
+		/*
+			The tree stays, only the settings change.
+		*/
+		case Message::OnCameraChanged:
+		{
+			auto&& changed = data.GetValue<App::HLCamera>();
+			auto camera = CurrentMap.FindCameraByID(changed.ID);
 
+			if (!camera)
+			{
 				break;
 			}
 
-			case Message::OnEditModeStopped:
-			{
-				PropertyGrid.EnableWindow(false);
-				TreeControl.EnableWindow(false);
+			static_cast<Cam::Shared::MapCameraData&>(*camera) = std::move(changed);
 
-				messagesleeptime = idlesleeptime;
-				break;
-			}
+			auto userdata = CurrentMap.FindUserDataByID(CurrentUserDataID);
 
-			case Message::OnGameShutdown:
+			if (userdata && userdata->IsCamera && userdata->CameraID == camera->ID)
 			{
-				break;
+				ShowCameraProperties(*camera);
 			}
 
-			case Message::OnTriggerAndCameraAdded:
+			break;
+		}
+
+		case Message::OnTriggerSelected:
+		{
+			auto triggerid = data.GetValue<size_t>();				
+			auto trigger = CurrentMap.FindTriggerByID(triggerid);
+
+			if (!trigger)
 			{
-				auto&& cam = data.GetValue<App::HLCamera>();
-				auto&& trig = data.GetValue<App::HLTrigger>();
-				AddCameraAndTrigger(std::move(cam), std::move(trig));
 				break;
 			}
 
-			case Message::OnTriggerAddedToCamera:
-			{
-				auto trig = data.GetValue<App::HLTrigger>();
-				auto camera = CurrentMap.FindCameraByID(trig.LinkedCameraID);
+			TreeControl.SelectItem(trigger->TreeItem);
+			TreeControl.Expand(trigger->TreeItem, TVE_EXPAND);
 
-				AddTriggerToCamera(*camera, std::move(trig));
-				break;
-			}
+			break;
+		}
 
-			case Message::OnNamedCameraAdded:
-			{
-				auto&& cam = data.GetValue<App::HLCamera>();
-				AddSingleCamera(std::move(cam));
+		case Message::OnCameraSelected:
+		{
+			auto cameraid = data.GetValue<size_t>();
+			auto camera = CurrentMap.FindCameraByID(cameraid);
 
+			if (!camera)
+			{
 				break;
 			}
 
-			case Message::OnTriggerSelected:
-			{
-				auto triggerid = data.GetValue<size_t>();				
-				auto trigger = CurrentMap.FindTriggerByID(triggerid);
+			TreeControl.SelectItem(camera->TreeItem);
+			TreeControl.Expand(camera->TreeItem, TVE_EXPAND);
 
-				if (!trigger)
-				{
-					break;
-				}
+			break;
+		}
+	}
+}
 
-				TreeControl.SelectItem(trigger->TreeItem);
-				TreeControl.Expand(trigger->TreeItem, TVE_EXPAND);
+void HLCamEditorDialog::ApplyMapSnapshot(Utility::BinaryBuffer& data)
+{
+	Cam::Shared::Schema::MapSnapshot snapshot;
+	Cam::Shared::Schema::Decode(data, snapshot);
 
-				break;
-			}
+	DisableTreeSelections = true;
 
-			case Message::OnCameraSelected:
-			{
-				auto cameraid = data.GetValue<size_t>();
-				auto camera = CurrentMap.FindCameraByID(cameraid);
+	TreeControl.SetRedraw(false);
+	TreeControl.DeleteAllItems();
 
-				if (!camera)
-				{
-					break;
-				}
+	CurrentMap = App::HLMap();
+	CurrentMap.Name = std::move(snapshot.Name);
+
+	for (auto& camdata : snapshot.Cameras)
+	{
+		App::HLCamera curcam;
+		static_cast<Cam::Shared::MapCameraData&>(curcam) = std::move(camdata);
 
-				TreeControl.SelectItem(camera->TreeItem);
-				TreeControl.Expand(camera->TreeItem, TVE_EXPAND);
+		App::SetLinkedTriggers(curcam);
 
-				break;
-			}
+		for (const auto& trigid : curcam.LinkedTriggerIDs)
+		{
+			App::HLTrigger newtrig;
+			newtrig.ID = trigid;
+			newtrig.LinkedCameraID = curcam.ID;
+
+			CurrentMap.Triggers[trigid] = std::move(newtrig);
 		}
+
+		CurrentMap.Cameras[curcam.ID] = std::move(curcam);
 	}
+
+	for (auto& camitr : CurrentMap.Cameras)
+	{
+		auto& cam = camitr.second;
+
+		if (cam.IsSingle)
+		{
+			AddSingleCameraToList(cam);
+		}
+
+		else
+		{
+			AddCameraAndTriggerToList(cam);
+		}
+	}
+
+	TreeControl.SetRedraw(true);
+
+	DisableTreeSelections = false;
 }
 
 void HLCamEditorDialog::AddSingleCamera(App::HLCamera&& camera)
@@ -1012,7 +1056,9 @@ LRESULT HLCamEditorDialog::OnPropertyGridItemChanged(WPARAM controlid, LPARAM pr
 				)
 			);
 
-			cam->AttachmentOffset = {newvalx, newvaly, newvalz};
+			cam->AttachmentOffset.X = newvalx;
+			cam->AttachmentOffset.Y = newvaly;
+			cam->AttachmentOffset.Z = newvalz;
 		}
 	}
 
@@ -1022,6 +1068,7 @@ LRESULT HLCamEditorDialog::OnPropertyGridItemChanged(WPARAM controlid, LPARAM pr
 void HLCamEditorDialog::OnClose()
 {
 	ShouldCloseMessageThread = true;
+	GameClient.Wake();
 
 	if (MessageHandlerThread.joinable())
 	{
@@ -1207,92 +1254,7 @@ void HLCamEditorDialog::OnTvnSelchangedTree1(NMHDR *pNMHDR, LRESULT *pResult)
 				PropertyGrid.RedrawWindow();
 			}
 
-			auto camera = CurrentMap.FindCameraByID(userdata->CameraID);
-
-			auto& entries = PropertyGridEntries;
-
-			entries.Speed->SetValue(static_cast<long>(camera->MaxSpeed));
-			entries.FOV->SetValue(static_cast<long>(camera->FOV));
-
-			entries.PositionX->SetValue(camera->Position.X);
-			entries.PositionY->SetValue(camera->Position.Y);
-			entries.PositionZ->SetValue(camera->Position.Z);
-
-			entries.AngleX->SetValue(camera->Angles.X);
-			entries.AngleY->SetValue(camera->Angles.Y);
-			entries.AngleZ->SetValue(camera->Angles.Z);
-
-			entries.ActivateType->SetValue(Cam::Shared::CameraTriggerTypeToString(camera->TriggerType));
-			entries.LookType->SetValue(Cam::Shared::CameraLookTypeToString(camera->LookType));
-			entries.PlaneType->SetValue(Cam::Shared::CameraPlaneTypeToString(camera->PlaneType));
-			entries.ZoomType->SetValue(Cam::Shared::CameraZoomTypeToString(camera->ZoomType));
-
-			if (camera->ZoomType != Cam::Shared::CameraZoomType::None &&
-				camera->ZoomType != Cam::Shared::CameraZoomType::ZoomByDistance)
-			{
-				entries.ZoomEndFOV->SetValue(camera->ZoomEndFOV);
-				entries.ZoomTime->SetValue(camera->ZoomTime);
-				entries.ZoomInterpMethod->SetValue(Cam::Shared::CameraAngleTypeToString(camera->ZoomInterpMethod));
-
-				entries.ZoomEndFOV->Show();
-				entries.ZoomTime->Show();
-				entries.ZoomInterpMethod->Show();
-			}
-
-			else
-			{
-				entries.ZoomEndFOV->Show(false);
-				entries.ZoomTime->Show(false);
-				entries.ZoomInterpMethod->Show(false);
-			}
-
-			if (camera->TriggerType == Cam::Shared::CameraTriggerType::ByName)
-			{
-				entries.Name->SetValue(camera->Name.c_str());
-				entries.Name->Show();
-			}
-
-			else
-			{
-				entries.Name->Show(false);
-			}
-
-			if (camera->LookType != Cam::Shared::CameraLookType::AtAngle)
-			{
-				entries.PlaneType->Show();
-
-				if (camera->LookType == Cam::Shared::CameraLookType::AtTarget)
-				{
-					entries.LookAtTargetName->SetValue(camera->LookTargetName.c_str());
-					entries.LookAtTargetGroup->Show();
-				}
-
-				entries.Speed->Show();
-			}
-
-			else
-			{
-				entries.PlaneType->Show(false);
-				entries.LookAtTargetGroup->Show(false);
-				entries.Speed->Show(false);
-			}
-
-			if (camera->UseAttachment)
-			{
-				entries.AttachToTargetToggle->SetValue("Yes");
-				
-				entries.AttachToTargetName->SetValue(camera->AttachmentTargetName.c_str());
-				entries.AttachToTargetOffsetX->SetValue(camera->AttachmentOffset.X);
-				entries.AttachToTargetOffsetY->SetValue(camera->AttachmentOffset.Y);
-				entries.AttachToTargetOffsetZ->SetValue(camera->AttachmentOffset.Z);
-				entries.AttachToTargetGroup->Show();
-			}
-
-			else
-			{
-				entries.AttachToTargetToggle->SetValue("No");
-				entries.AttachToTargetGroup->Show(false);
-			}
+			ShowCameraProperties(*CurrentMap.FindCameraByID(userdata->CameraID));
 
 			AppServer.Write
 			(
@@ -1324,6 +1286,94 @@ void HLCamEditorDialog::OnTvnSelchangedTree1(NMHDR *pNMHDR, LRESULT *pResult)
 	*pResult = 0;
 }
 
+void HLCamEditorDialog::ShowCameraProperties(const App::HLCamera& camera)
+{
+	auto& entries = PropertyGridEntries;
+
+	entries.Speed->SetValue(static_cast<long>(camera.MaxSpeed));
+	entries.FOV->SetValue(static_cast<long>(camera.FOV));
+
+	entries.PositionX->SetValue(camera.Position.X);
+	entries.PositionY->SetValue(camera.Position.Y);
+	entries.PositionZ->SetValue(camera.Position.Z);
+
+	entries.AngleX->SetValue(camera.Angle.X);
+	entries.AngleY->SetValue(camera.Angle.Y);
+	entries.AngleZ->SetValue(camera.Angle.Z);
+
+	entries.ActivateType->SetValue(Cam::Shared::CameraTriggerTypeToString(camera.TriggerType));
+	entries.LookType->SetValue(Cam::Shared::CameraLookTypeToString(camera.LookType));
+	entries.PlaneType->SetValue(Cam::Shared::CameraPlaneTypeToString(camera.PlaneType));
+	entries.ZoomType->SetValue(Cam::Shared::CameraZoomTypeToString(camera.ZoomType));
+
+	if (camera.ZoomType != Cam::Shared::CameraZoomType::None &&
+		camera.ZoomType != Cam::Shared::CameraZoomType::ZoomByDistance)
+	{
+		entries.ZoomEndFOV->SetValue(camera.ZoomEndFOV);
+		entries.ZoomTime->SetValue(camera.ZoomTime);
+		entries.ZoomInterpMethod->SetValue(Cam::Shared::CameraAngleTypeToString(camera.ZoomInterpMethod));
+
+		entries.ZoomEndFOV->Show();
+		entries.ZoomTime->Show();
+		entries.ZoomInterpMethod->Show();
+	}
+
+	else
+	{
+		entries.ZoomEndFOV->Show(false);
+		entries.ZoomTime->Show(false);
+		entries.ZoomInterpMethod->Show(false);
+	}
+
+	if (camera.TriggerType == Cam::Shared::CameraTriggerType::ByName)
+	{
+		entries.Name->SetValue(camera.Name.c_str());
+		entries.Name->Show();
+	}
+
+	else
+	{
+		entries.Name->Show(false);
+	}
+
+	if (camera.LookType != Cam::Shared::CameraLookType::AtAngle)
+	{
+		entries.PlaneType->Show();
+
+		if (camera.LookType == Cam::Shared::CameraLookType::AtTarget)
+		{
+			entries.LookAtTargetName->SetValue(camera.LookTargetName.c_str());
+			entries.LookAtTargetGroup->Show();
+		}
+
+		entries.Speed->Show();
+	}
+
+	else
+	{
+		entries.PlaneType->Show(false);
+		entries.LookAtTargetGroup->Show(false);
+		entries.Speed->Show(false);
+	}
+
+	if (camera.UseAttachment)
+	{
+		entries.AttachToTargetToggle->SetValue("Yes");
+		
+		entries.AttachToTargetName->SetValue(camera.AttachmentTargetName.c_str());
+		entries.AttachToTargetOffsetX->SetValue(camera.AttachmentOffset.X);
+		entries.AttachToTargetOffsetY->SetValue(camera.AttachmentOffset.Y);
+		entries.AttachToTargetOffsetZ->SetValue(camera.AttachmentOffset.Z);
+		entries.AttachToTargetGroup->Show();
+	}
+
+	else
+	{
+		entries.AttachToTargetToggle->SetValue("No");
+		entries.AttachToTargetGroup->Show(false);
+	}
+}
+
 void HLCamEditorDialog::OnBnClickedButton1()
 {
 	
@@ -1353,3 +1403,9 @@ void HLCamEditorDialog::OnTimer(UINT_PTR eventid)
 
 	__super::OnTimer(eventid);
 }
+
+LRESULT HLCamEditorDialog::OnRequestMapSnapshot(WPARAM, LPARAM)
+{
+	AppServer.Write(Cam::Shared::Messages::App::RequestMapSnapshot);
+	return 0;
+}
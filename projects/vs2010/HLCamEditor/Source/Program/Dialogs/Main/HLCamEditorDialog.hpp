@@ -3,16 +3,11 @@
 #include "afxcmn.h"
 
 #include "Shared\Shared.hpp"
+#include "Shared\Map\MapFile.hpp"
+#include "Shared\Interprocess\Snapshot.hpp"
 
 namespace App
 {
-	struct Vector
-	{
-		float X;
-		float Y;
-		float Z;
-	};
-
 	struct HLTrigger
 	{
 		size_t ID;
@@ -21,35 +16,14 @@ namespace App
 		HTREEITEM TreeItem;
 	};
 
-	struct HLCamera
+	/*
+		Settings are as the game sends them, "Triggers" only has the IDs.
+	*/
+	struct HLCamera : Cam::Shared::MapCameraData
 	{
-		size_t ID;
 		bool IsSingle;
 		std::vector<size_t> LinkedTriggerIDs;
 
-		std::string Name;
-
-		Vector Position;
-		Vector Angles;
-
-		float MaxSpeed;
-		size_t FOV;
-
-		Cam::Shared::CameraTriggerType TriggerType;
-		Cam::Shared::CameraLookType LookType;
-		Cam::Shared::CameraPlaneType PlaneType;
-		Cam::Shared::CameraZoomType ZoomType;
-
-		float ZoomTime;
-		float ZoomEndFOV;
-		Cam::Shared::CameraAngleType ZoomInterpMethod;
-
-		std::string LookTargetName;
-
-		bool UseAttachment;
-		std::string AttachmentTargetName;
-		Vector AttachmentOffset;
-
 		HTREEITEM TreeItem;
 	};
 
@@ -107,6 +81,23 @@ private:
 	Shared::Interprocess::Client GameClient;
 
 	void MessageHandler();
+	void HandleGameMessage(Shared::Interprocess::Config::MessageType message, Utility::BinaryBuffer& data);
+
+	/*
+		Replaces the whole map and tree with the one in "data".
+	*/
+	void ApplyMapSnapshot(Utility::BinaryBuffer& data);
+
+	Shared::Interprocess::SnapshotReader MapSnapshot;
+
+	/*
+		From a map reset until its snapshot is complete, other
+		messages wait in DeferredMessages.
+	*/
+	bool WaitingForSnapshot = false;
+	bool SnapshotRequested = false;
+
+	std::vector<std::pair<Shared::Interprocess::Config::MessageType, Utility::BinaryBuffer>> DeferredMessages;
 
 	std::thread MessageHandlerThread;
 	std::atomic_bool ShouldCloseMessageThread{false};
@@ -131,6 +122,11 @@ private:
 	void AddTriggerToCamera(App::HLCamera& camera, App::HLTrigger&& trigger);	
 	void AddCamerasTriggersToList(App::HLCamera& camera, std::vector<size_t>& triggers);
 
+	/*
+		Fills the property grid with the settings of "camera".
+	*/
+	void ShowCameraProperties(const App::HLCamera& camera);
+
 	struct
 	{
 		CMFCPropertyGridProperty* Name;
@@ -175,4 +171,5 @@ public:
 	afx_msg void OnTvnSelchangedTree1(NMHDR *pNMHDR, LRESULT *pResult);
 	afx_msg void OnBnClickedButton1();
 	afx_msg void OnTimer(UINT_PTR eventid);
+	afx_msg LRESULT OnRequestMapSnapshot(WPARAM, LPARAM);
 };